@@ -0,0 +1,28 @@
+/**
+ * @file alloc.c
+ * @brief Heap allocation that exits on failure, see alloc.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+
+static void *Check(void *p, size_t size)
+{
+    if (!p) {
+        printf("Error: Unable to allocate %zu bytes.\n", size);
+        exit(1);
+    }
+    return p;
+}
+
+void *Allocate(size_t size)
+{
+    return Check(malloc(size ? size : 1), size);
+}
+
+void *AllocateZeroed(size_t size)
+{
+    return Check(calloc(1, size ? size : 1), size);
+}
@@ -0,0 +1,19 @@
+/**
+ * @file alloc.h
+ * @brief Heap allocation that exits on failure, shared by the weight formats of ../FLOAT and ../FIXED
+ *
+ * A size of 0 still returns a unique pointer that free accepts, so that an
+ * empty layer (a CSR matrix without nonzeros) needs no special case.
+ */
+
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include <stddef.h>
+
+// size bytes, uninitialized; exits on error
+void *Allocate(size_t size);
+// size bytes set to zero; exits on error
+void *AllocateZeroed(size_t size);
+
+#endif // ALLOC_H
@@ -0,0 +1,175 @@
+/**
+ * @file chunk_reader.c
+ * @brief Fixed-size chunks of a file region, synchronous or prefetched, see chunk_reader.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "latency.h"
+#include "chunk_reader.h"
+
+/// @brief Read size bytes at offset of the region into data, taking at least size / bytes_per_us
+static void ReadAt(chunk_reader_t *r, long offset, void *data, long size)
+{
+    unsigned long long t0 = LatencyNow(), end;
+    struct timespec ts;
+
+    if (fseek(r->file, r->start + offset, SEEK_SET) != 0 || fread(data, 1, size, r->file) != (size_t)size) {
+        printf("Error: Unable to read %ld bytes at offset %ld.\n", size, r->start + offset);
+        exit(1);
+    }
+    if (r->bytes_per_us > 0.0) {
+        // Sleep, as a thread waiting for a flash or SPI transfer would, leaving the CPU to the compute
+        end = t0 + (unsigned long long)(size * 1e3 / r->bytes_per_us);
+        ts.tv_sec = end / 1000000000ULL;
+        ts.tv_nsec = end % 1000000000ULL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+            ;
+    }
+}
+
+/// @brief Prefetch thread: fill the free buffers in turn until the end of the region, then wait for a rewind
+static void *Prefetch(void *arg)
+{
+    chunk_reader_t *r = arg;
+    long offset, size;
+    int b, generation;
+
+    pthread_mutex_lock(&r->lock);
+    for (;;) {
+        while (!r->stop && (r->next >= r->size || r->filled[r->fill] != 0))
+            pthread_cond_wait(&r->ready, &r->lock);
+        if (r->stop)
+            break;
+        b = r->fill;
+        generation = r->generation;
+        offset = r->next;
+        size = r->size - offset < r->chunk_bytes ? r->size - offset : r->chunk_bytes;
+        r->next += size;
+        r->fill ^= 1;
+        pthread_mutex_unlock(&r->lock);
+
+        ReadAt(r, offset, r->buffer[b], size);
+
+        pthread_mutex_lock(&r->lock);
+        if (generation == r->generation) {     // else rewound meanwhile, the chunk is dropped
+            r->filled[b] = size;
+            pthread_cond_broadcast(&r->ready);
+        }
+    }
+    pthread_mutex_unlock(&r->lock);
+    return NULL;
+}
+
+void ChunkReaderOpen(chunk_reader_t *r, const char *filename, long start, long size, long chunk_bytes, int prefetch,
+                     double bytes_per_us)
+{
+    int b;
+
+    memset(r, 0, sizeof(*r));
+    r->file = fopen(filename, "rb");
+    if (!r->file) {
+        printf("Error: Unable to open file %s.\n", filename);
+        exit(1);
+    }
+    setvbuf(r->file, NULL, _IONBF, 0);      // chunks go straight to the buffers
+    if (chunk_bytes < 1 || size < 0) {
+        printf("Error: Invalid chunk of %ld bytes.\n", chunk_bytes);
+        exit(1);
+    }
+    r->start = start;
+    r->size = size;
+    r->chunk_bytes = chunk_bytes;
+    r->prefetch = prefetch;
+    r->bytes_per_us = bytes_per_us;
+    for (b = 0; b < (prefetch ? 2 : 1); b++) {
+        r->buffer[b] = malloc(chunk_bytes);
+        if (!r->buffer[b]) {
+            printf("Error: Unable to allocate %ld bytes.\n", chunk_bytes);
+            exit(1);
+        }
+    }
+    if (prefetch) {
+        pthread_mutex_init(&r->lock, NULL);
+        pthread_cond_init(&r->ready, NULL);
+        if (pthread_create(&r->thread, NULL, Prefetch, r) != 0) {
+            printf("Error: Unable to start the prefetch thread.\n");
+            exit(1);
+        }
+    }
+}
+
+long ChunkReaderNext(chunk_reader_t *r, const void **data)
+{
+    unsigned long long t0 = LatencyNow();
+    long size;
+
+    if (!r->prefetch) {
+        if (r->consumed >= r->size)
+            return 0;
+        size = r->size - r->consumed < r->chunk_bytes ? r->size - r->consumed : r->chunk_bytes;
+        ReadAt(r, r->consumed, r->buffer[0], size);
+        r->consumed += size;
+        *data = r->buffer[0];
+        r->stall_ns += LatencyNow() - t0;
+        return size;
+    }
+
+    pthread_mutex_lock(&r->lock);
+    if (r->holding) {                       // the previous chunk is done with, its buffer can be refilled
+        r->filled[r->current] = 0;
+        r->current ^= 1;
+        r->holding = 0;
+        pthread_cond_broadcast(&r->ready);
+    }
+    if (r->consumed >= r->size) {
+        pthread_mutex_unlock(&r->lock);
+        return 0;
+    }
+    while (r->filled[r->current] == 0)
+        pthread_cond_wait(&r->ready, &r->lock);
+    size = r->filled[r->current];
+    r->consumed += size;
+    r->holding = 1;
+    *data = r->buffer[r->current];
+    pthread_mutex_unlock(&r->lock);
+    r->stall_ns += LatencyNow() - t0;
+    return size;
+}
+
+void ChunkReaderRewind(chunk_reader_t *r)
+{
+    if (!r->prefetch) {
+        r->consumed = 0;
+        return;
+    }
+    pthread_mutex_lock(&r->lock);
+    r->filled[0] = r->filled[1] = 0;
+    r->current = r->fill = 0;
+    r->holding = 0;
+    r->next = 0;
+    r->consumed = 0;
+    r->generation++;
+    pthread_cond_broadcast(&r->ready);
+    pthread_mutex_unlock(&r->lock);
+}
+
+void ChunkReaderClose(chunk_reader_t *r)
+{
+    if (r->prefetch) {
+        pthread_mutex_lock(&r->lock);
+        r->stop = 1;
+        pthread_cond_broadcast(&r->ready);
+        pthread_mutex_unlock(&r->lock);
+        pthread_join(r->thread, NULL);
+        pthread_mutex_destroy(&r->lock);
+        pthread_cond_destroy(&r->ready);
+    }
+    free(r->buffer[0]);
+    free(r->buffer[1]);
+    fclose(r->file);
+    memset(r, 0, sizeof(*r));
+}
@@ -0,0 +1,56 @@
+/**
+ * @file chunk_reader.h
+ * @brief Fixed-size chunks of a file region, read synchronously or prefetched by a background thread
+ *
+ * A chunk_reader_t hands out a region of a file (weights that do not fit in
+ * RAM) chunk_bytes at a time, so that the caller never holds more than one
+ * chunk, two with prefetching. Without prefetch ChunkReaderNext reads the
+ * next chunk into the buffer itself. With prefetch a thread fills the other
+ * buffer of a double buffer while the caller computes on the current one;
+ * ChunkReaderNext then only waits if the read is slower than the compute.
+ * A chunk stays valid until the next call. ChunkReaderRewind restarts the
+ * region, and the thread starts reading its first chunks at once: rewinding
+ * right after the last chunk of an inference hides them behind the layers
+ * that run before the next one. A file in the page cache reads at memory
+ * speed; bytes_per_us makes every read last as long as on a slower medium
+ * (SPI flash, SD card), sleeping the rest of the time like a thread blocked
+ * on a transfer.
+ */
+
+#ifndef CHUNK_READER_H
+#define CHUNK_READER_H
+
+#include <stdio.h>
+#include <pthread.h>
+
+typedef struct {
+    FILE           *file;
+    long            start, size;        // region of the file
+    long            chunk_bytes;
+    int             prefetch;
+    double          bytes_per_us;       // read rate of the medium emulated, 0: that of the file
+    unsigned char  *buffer[2];
+    long            filled[2];          // bytes of a chunk ready in each buffer, 0 if empty
+    long            next;               // offset in the region of the next chunk to read
+    long            consumed;           // bytes handed out since the last rewind
+    int             current;            // buffer of the next chunk handed out
+    int             fill;               // buffer of the next chunk read
+    int             holding;            // the caller still uses buffer current
+    int             generation;         // rewinds, a read started before one is dropped
+    int             stop;
+    unsigned long long stall_ns;        // time spent in ChunkReaderNext waiting for a chunk or reading it
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  ready;              // a chunk was filled or a buffer was freed
+} chunk_reader_t;
+
+// Region [start, start + size) of filename, chunk_bytes per chunk, reads no faster than bytes_per_us if > 0;
+// exits on error
+void ChunkReaderOpen(chunk_reader_t *r, const char *filename, long start, long size, long chunk_bytes, int prefetch,
+                     double bytes_per_us);
+// Next chunk in *data, its size in bytes, 0 past the end of the region
+long ChunkReaderNext(chunk_reader_t *r, const void **data);
+void ChunkReaderRewind(chunk_reader_t *r);
+void ChunkReaderClose(chunk_reader_t *r);
+
+#endif // CHUNK_READER_H
@@ -0,0 +1,19 @@
+/**
+ * @file hooks.h
+ * @brief Instrumentation hooks placed around each layer of the HLS tops
+ *
+ * LAYER_BEGIN(CONV1) / LAYER_END(CONV1) feed the perf counters (PERF_COUNTERS)
+ * and the trace (TRACE). With neither defined they expand to empty statements,
+ * so lenet_cnn and lenet_cnn_fixed are unchanged for synthesis.
+ */
+
+#ifndef HOOKS_H
+#define HOOKS_H
+
+#include "perf_counters.h"
+#include "trace.h"
+
+#define LAYER_BEGIN(layer) do { PERF_LAYER_BEGIN(PERF_##layer); TRACE_BEGIN(TRACE_##layer); } while (0)
+#define LAYER_END(layer)   do { TRACE_END(TRACE_##layer); PERF_LAYER_END(PERF_##layer); } while (0)
+
+#endif // HOOKS_H
@@ -0,0 +1,104 @@
+/**
+ * @file latency.c
+ * @brief Monotonic timing and latency histograms, see latency.h
+ */
+
+#include <time.h>
+#include <string.h>
+
+#include "latency.h"
+
+unsigned long long LatencyNow(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (unsigned long long)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+void LatencyInit(latency_hist_t *h)
+{
+    memset(h, 0, sizeof(*h));
+    h->min = ~0ULL;
+}
+
+/// @brief Bucket of v: v itself below 2^(S+1), then 2^S linear sub-buckets per octave
+static int BucketIndex(unsigned long long v)
+{
+    int e;
+
+    if (v < (2ULL << LATENCY_SUB_BITS))
+        return (int)v;
+    e = 63 - __builtin_clzll(v) - LATENCY_SUB_BITS;     // >= 1
+    return (e << LATENCY_SUB_BITS) + (int)(v >> e);
+}
+
+/// @brief Highest value that falls in bucket i
+static unsigned long long BucketHigh(int i)
+{
+    int e = (i >> LATENCY_SUB_BITS) - 1;
+
+    if (e <= 0)
+        return (unsigned long long)i;
+    return (((unsigned long long)(i - (e << LATENCY_SUB_BITS)) + 1) << e) - 1;
+}
+
+void LatencyRecord(latency_hist_t *h, unsigned long long ns)
+{
+    h->counts[BucketIndex(ns)]++;
+    h->count++;
+    h->sum += ns;
+    if (ns < h->min) h->min = ns;
+    if (ns > h->max) h->max = ns;
+}
+
+/// @brief Add the samples of src (e.g. one per thread) to dst
+void LatencyMerge(latency_hist_t *dst, const latency_hist_t *src)
+{
+    int i;
+
+    for (i = 0; i < LATENCY_NB_BUCKETS; i++)
+        dst->counts[i] += src->counts[i];
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+/// @brief Smallest recorded bucket bound below which percent % of the values lie
+unsigned long long LatencyPercentile(const latency_hist_t *h, double percent)
+{
+    unsigned long long rank, seen = 0;
+    int i;
+
+    if (h->count == 0)
+        return 0;
+    rank = (unsigned long long)(percent / 100.0 * h->count + 0.5);
+    if (rank < 1)
+        rank = 1;
+    for (i = 0; i < LATENCY_NB_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank)
+            return (BucketHigh(i) < h->max) ? BucketHigh(i) : h->max;
+    }
+    return h->max;
+}
+
+void LatencyReportHeader(FILE *out)
+{
+    fprintf(out, "%-10s %8s %8s %8s %8s %8s %8s %8s %10s\n",
+            "(us)", "min", "p50", "p90", "p99", "p99.9", "max", "mean", "per s");
+}
+
+/// @brief One line of percentiles in us, plus the rate implied by the summed latencies
+void LatencyReport(FILE *out, const char *name, const latency_hist_t *h)
+{
+    if (h->count == 0) {
+        fprintf(out, "%-10s no samples\n", name);
+        return;
+    }
+    fprintf(out, "%-10s %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %10.1f\n", name,
+            h->min / 1e3, LatencyPercentile(h, 50) / 1e3, LatencyPercentile(h, 90) / 1e3,
+            LatencyPercentile(h, 99) / 1e3, LatencyPercentile(h, 99.9) / 1e3, h->max / 1e3,
+            (double)h->sum / h->count / 1e3, h->count / (h->sum / 1e9));
+}
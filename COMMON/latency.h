@@ -0,0 +1,33 @@
+/**
+ * @file latency.h
+ * @brief Monotonic nanosecond timing and HDR-style latency histograms
+ *
+ * LatencyNow() reads CLOCK_MONOTONIC in ns. A latency_hist_t records values
+ * in log-linear buckets: exact below 2^LATENCY_SUB_BITS ns, then
+ * 2^LATENCY_SUB_BITS buckets per power of two, i.e. at most 1/64 = 1.6%
+ * relative error on any percentile, from 1 ns up to the 64-bit range,
+ * in a fixed 30 KB table with O(1) recording.
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdio.h>
+
+#define LATENCY_SUB_BITS   6
+#define LATENCY_NB_BUCKETS ((64 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+
+typedef struct {
+    unsigned long long counts[LATENCY_NB_BUCKETS];
+    unsigned long long count, sum, min, max;
+} latency_hist_t;
+
+unsigned long long LatencyNow(void);
+void LatencyInit(latency_hist_t *h);
+void LatencyRecord(latency_hist_t *h, unsigned long long ns);
+void LatencyMerge(latency_hist_t *dst, const latency_hist_t *src);
+unsigned long long LatencyPercentile(const latency_hist_t *h, double percent);
+void LatencyReportHeader(FILE *out);
+void LatencyReport(FILE *out, const char *name, const latency_hist_t *h);
+
+#endif // LATENCY_H
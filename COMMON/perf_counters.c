@@ -0,0 +1,181 @@
+/**
+ * @file perf_counters.c
+ * @brief Per-layer hardware performance counters, see perf_counters.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "perf_counters.h"
+
+static const char *layer_names[PERF_NB_LAYERS] = { "conv1", "pool1", "conv2", "pool2", "fc1", "fc2" };
+static const char *event_names[PERF_NB_EVENTS] = { "cycles", "instr", "L1D miss", "LLC miss", "br miss", "task ns" };
+
+static const struct {
+    unsigned int       type;
+    unsigned long long config;
+} events[PERF_NB_EVENTS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+};
+
+static int group_fd = -1;
+static int nb_open = 0;
+static int slot[PERF_NB_EVENTS];                // position in the group read, -1 if not available
+static unsigned long long start[PERF_NB_EVENTS];
+static unsigned long long total[PERF_NB_LAYERS][PERF_NB_EVENTS];
+static unsigned long long calls[PERF_NB_LAYERS];
+
+static int OpenEvent(int e, int leader)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = events[e].type;
+    attr.config = events[e].config;
+    attr.disabled = (leader == -1);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+}
+
+/// @brief Open the counter group, returns the number of available counters
+int PerfInit(void)
+{
+    int e, fd, err = 0;
+
+    for (e = 0; e < PERF_NB_EVENTS; e++) {
+        slot[e] = -1;
+        fd = OpenEvent(e, group_fd);
+        if (fd < 0) {
+            if (!err)
+                err = errno;
+            continue;
+        }
+        if (group_fd == -1)
+            group_fd = fd;
+        slot[e] = nb_open++;
+    }
+
+    if (group_fd == -1) {
+        printf("perf counters unavailable (%s), check /proc/sys/kernel/perf_event_paranoid\n", strerror(err));
+        return 0;
+    }
+    if (nb_open < PERF_NB_EVENTS)
+        printf("perf counters: %d of %d available (%s), missing ones reported as n/a\n",
+               nb_open, PERF_NB_EVENTS, strerror(err));
+    ioctl(group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return nb_open;
+}
+
+/// @brief One read() for the whole group: { nr, value[nr] }
+static int ReadGroup(unsigned long long values[PERF_NB_EVENTS])
+{
+    unsigned long long buf[1 + PERF_NB_EVENTS];
+    int e;
+
+    if (read(group_fd, buf, (1 + nb_open) * sizeof(buf[0])) <= 0)
+        return 0;
+    for (e = 0; e < PERF_NB_EVENTS; e++)
+        values[e] = (slot[e] >= 0) ? buf[1 + slot[e]] : 0;
+    return 1;
+}
+
+void PerfLayerBegin(int layer)
+{
+    (void)layer;
+    if (group_fd != -1)
+        ReadGroup(start);
+}
+
+void PerfLayerEnd(int layer)
+{
+    unsigned long long end[PERF_NB_EVENTS];
+    int e;
+
+    if (group_fd == -1 || !ReadGroup(end))
+        return;
+    for (e = 0; e < PERF_NB_EVENTS; e++)
+        total[layer][e] += end[e] - start[e];
+    calls[layer]++;
+}
+
+static void PrintCount(FILE *out, int e, double value)
+{
+    if (slot[e] < 0)
+        fprintf(out, " %12s", "n/a");
+    else
+        fprintf(out, " %12.0f", value);
+}
+
+static void PrintRatio(FILE *out, int e_num, int e_den, double num, double den, double scale)
+{
+    if (slot[e_num] < 0 || slot[e_den] < 0 || den == 0)
+        fprintf(out, " %8s", "n/a");
+    else
+        fprintf(out, " %8.2f", scale * num / den);
+}
+
+void PerfReport(FILE *out)
+{
+    unsigned long long sum[PERF_NB_EVENTS] = { 0 }, cumul = 0;
+    int share = (slot[PERF_CYCLES] >= 0) ? PERF_CYCLES : PERF_TASK_CLOCK;     // time share basis
+    int l, e;
+
+    if (group_fd == -1)
+        return;
+
+    for (l = 0; l < PERF_NB_LAYERS; l++)
+        for (e = 0; e < PERF_NB_EVENTS; e++)
+            sum[e] += total[l][e];
+
+    fprintf(out, "\n\n=== Hardware counters per layer call (user space) ===\n");
+    fprintf(out, "%-6s", "layer");
+    for (e = 0; e < PERF_NB_EVENTS; e++)
+        fprintf(out, " %12s", event_names[e]);
+    fprintf(out, " %8s %8s %8s\n", "IPC", "L1D MPKI", "LLC MPKI");
+    for (l = 0; l < PERF_NB_LAYERS; l++) {
+        double n = calls[l] ? (double)calls[l] : 1;
+
+        fprintf(out, "%-6s", layer_names[l]);
+        for (e = 0; e < PERF_NB_EVENTS; e++)
+            PrintCount(out, e, total[l][e] / n);
+        PrintRatio(out, PERF_INSTRUCTIONS, PERF_CYCLES, total[l][PERF_INSTRUCTIONS], total[l][PERF_CYCLES], 1);
+        PrintRatio(out, PERF_L1D_MISSES, PERF_INSTRUCTIONS, total[l][PERF_L1D_MISSES], total[l][PERF_INSTRUCTIONS], 1000);
+        PrintRatio(out, PERF_LLC_MISSES, PERF_INSTRUCTIONS, total[l][PERF_LLC_MISSES], total[l][PERF_INSTRUCTIONS], 1000);
+        fprintf(out, "\n");
+    }
+
+    fprintf(out, "\n=== Cumulative counters over %llu inferences ===\n", calls[PERF_CONV1]);
+    fprintf(out, "%-6s", "layer");
+    for (e = 0; e < PERF_NB_EVENTS; e++)
+        fprintf(out, " %12s", event_names[e]);
+    fprintf(out, " %8s %8s\n", "time%", "cumul%");
+    for (l = 0; l <= PERF_NB_LAYERS; l++) {
+        const unsigned long long *t = (l < PERF_NB_LAYERS) ? total[l] : sum;
+
+        fprintf(out, "%-6s", (l < PERF_NB_LAYERS) ? layer_names[l] : "total");
+        for (e = 0; e < PERF_NB_EVENTS; e++)
+            PrintCount(out, e, t[e]);
+        if (l < PERF_NB_LAYERS)
+            cumul += t[share];
+        PrintRatio(out, share, share, 100.0 * t[share], sum[share], 1);
+        PrintRatio(out, share, share, 100.0 * cumul, sum[share], 1);
+        fprintf(out, "\n");
+    }
+    fprintf(out, "\nLow IPC with high LLC MPKI points to a memory-bound layer, high IPC to a compute-bound one.\n");
+}
@@ -0,0 +1,56 @@
+/**
+ * @file perf_counters.h
+ * @brief Per-layer hardware performance counters (Linux perf_event_open)
+ *
+ * Built only when PERF_COUNTERS is defined (make perf in FLOAT or FIXED).
+ * Each layer call of lenet_cnn / lenet_cnn_fixed is wrapped with
+ * PERF_LAYER_BEGIN / PERF_LAYER_END, which read one counter group:
+ * cycles, instructions, L1D read misses, LLC misses and branch misses
+ * (user space only, so perf_event_paranoid <= 2 is enough), plus the task
+ * clock in ns.
+ * Without PERF_COUNTERS the hooks expand to nothing, keeping the HLS tops
+ * and the default builds unchanged.
+ *
+ * If the kernel or the CPU does not provide a counter, it is reported as
+ * n/a; if none can be opened, PerfInit() prints why and the hooks do nothing.
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdio.h>
+
+enum {
+    PERF_CONV1,
+    PERF_POOL1,
+    PERF_CONV2,
+    PERF_POOL2,
+    PERF_FC1,
+    PERF_FC2,
+    PERF_NB_LAYERS
+};
+
+enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_TASK_CLOCK,        // software event, ns: still available in VMs without a PMU
+    PERF_NB_EVENTS
+};
+
+int  PerfInit(void);
+void PerfLayerBegin(int layer);
+void PerfLayerEnd(int layer);
+void PerfReport(FILE *out);
+
+#ifdef PERF_COUNTERS
+#define PERF_LAYER_BEGIN(layer) PerfLayerBegin(layer)
+#define PERF_LAYER_END(layer)   PerfLayerEnd(layer)
+#else
+#define PERF_LAYER_BEGIN(layer)
+#define PERF_LAYER_END(layer)
+#endif
+
+#endif // PERF_COUNTERS_H
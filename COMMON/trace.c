@@ -0,0 +1,161 @@
+/**
+ * @file trace.c
+ * @brief Per-thread stage tracing, see trace.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "latency.h"
+#include "trace.h"
+
+#define TRACE_CHUNK_EVENTS 16384
+
+typedef struct {
+    unsigned long long begin, end;      // ns, CLOCK_MONOTONIC
+    int                image;
+    int                stage;
+} trace_event_t;
+
+typedef struct trace_chunk {
+    trace_event_t       events[TRACE_CHUNK_EVENTS];
+    int                 count;
+    struct trace_chunk *next;
+} trace_chunk_t;
+
+typedef struct trace_thread {
+    trace_chunk_t       *first, *last;
+    unsigned long long   open[TRACE_NB_STAGES];     // begin time of each running stage
+    int                  image;
+    int                  tid;
+    char                 name[32];
+    struct trace_thread *next;
+} trace_thread_t;
+
+static const char *stage_names[TRACE_NB_STAGES] = {
+    "read", "normalize", "conv1", "pool1", "conv2", "pool2", "fc1", "fc2",
+    "convert", "predict", "softmax", "image", "batch"
+};
+static const char *stage_categories[TRACE_NB_STAGES] = {
+    "io", "io", "layer", "layer", "layer", "layer", "layer", "layer",
+    "layer", "output", "output", "image", "batch"
+};
+
+static trace_thread_t *threads = NULL;          // lock-free list of registered threads
+static int             nb_threads = 0;
+static __thread trace_thread_t *self = NULL;
+
+static trace_chunk_t *NewChunk(void)
+{
+    trace_chunk_t *chunk = calloc(1, sizeof(trace_chunk_t));
+
+    if (!chunk) {
+        printf("Error: Unable to allocate trace buffer.\n");
+        exit(1);
+    }
+    return chunk;
+}
+
+/// @brief First event of a thread: allocate its buffer and publish it
+static trace_thread_t *Register(void)
+{
+    trace_thread_t *t = calloc(1, sizeof(trace_thread_t));
+
+    if (!t) {
+        printf("Error: Unable to allocate trace buffer.\n");
+        exit(1);
+    }
+    t->first = t->last = NewChunk();
+    t->image = -1;
+    t->tid = __atomic_add_fetch(&nb_threads, 1, __ATOMIC_RELAXED);
+    snprintf(t->name, sizeof(t->name), "thread %d", t->tid);
+    t->next = __atomic_load_n(&threads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&threads, &t->next, t, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+    self = t;
+    return t;
+}
+
+void TraceBegin(int stage)
+{
+    trace_thread_t *t = self ? self : Register();
+
+    t->open[stage] = LatencyNow();
+}
+
+void TraceEnd(int stage)
+{
+    trace_thread_t *t = self ? self : Register();
+    trace_chunk_t *c = t->last;
+    trace_event_t *e;
+
+    if (c->count == TRACE_CHUNK_EVENTS) {
+        c->next = NewChunk();
+        c = t->last = c->next;
+    }
+    e = &c->events[c->count++];
+    e->begin = t->open[stage];
+    e->end = LatencyNow();
+    e->image = t->image;
+    e->stage = stage;
+}
+
+/// @brief Image index attached to the following events of this thread, -1 for none
+void TraceSetImage(int image)
+{
+    trace_thread_t *t = self ? self : Register();
+
+    t->image = image;
+}
+
+void TraceThreadName(const char *name)
+{
+    trace_thread_t *t = self ? self : Register();
+
+    snprintf(t->name, sizeof(t->name), "%s", name);
+}
+
+/// @brief Write every recorded event as Chrome trace_event JSON, returns the number of events
+int TraceWrite(const char *filename)
+{
+    trace_thread_t *t, *list = __atomic_load_n(&threads, __ATOMIC_ACQUIRE);
+    unsigned long long origin = ~0ULL;
+    trace_chunk_t *c;
+    FILE *file;
+    int i, count = 0;
+
+    for (t = list; t; t = t->next)
+        for (c = t->first; c; c = c->next)
+            for (i = 0; i < c->count; i++)
+                if (c->events[i].begin < origin)
+                    origin = c->events[i].begin;
+
+    file = fopen(filename, "w");
+    if (!file) {
+        printf("Error: Unable to open file %s.\n", filename);
+        exit(1);
+    }
+    fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"lenet\"}}");
+    for (t = list; t; t = t->next) {
+        fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+                t->tid, t->name);
+        for (c = t->first; c; c = c->next)
+            for (i = 0; i < c->count; i++) {
+                const trace_event_t *e = &c->events[i];
+
+                fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                        "\"ts\": %.3f, \"dur\": %.3f",
+                        stage_names[e->stage], stage_categories[e->stage], t->tid,
+                        (e->begin - origin) / 1e3, (e->end - e->begin) / 1e3);
+                if (e->image >= 0)
+                    fprintf(file, ", \"args\": {\"image\": %d}", e->image);
+                fprintf(file, "}");
+                count++;
+            }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return count;
+}
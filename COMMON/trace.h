@@ -0,0 +1,50 @@
+/**
+ * @file trace.h
+ * @brief Per-thread stage tracing exported as Chrome trace_event JSON
+ *
+ * Built only when TRACE is defined (make trace in ENGINE). TRACE_BEGIN /
+ * TRACE_END record the begin and end timestamps (CLOCK_MONOTONIC) of a
+ * pipeline stage into a buffer owned by the calling thread: no lock and no
+ * shared write on the hot path, buffers only grow by per-thread chunks and
+ * are published once with a lock-free list push. TraceWrite() is called after
+ * the threads are joined and produces a file that chrome://tracing and
+ * Perfetto open directly, one track per thread.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+enum {
+    TRACE_READ,
+    TRACE_NORMALIZE,
+    TRACE_CONV1,
+    TRACE_POOL1,
+    TRACE_CONV2,
+    TRACE_POOL2,
+    TRACE_FC1,
+    TRACE_FC2,
+    TRACE_CONVERT,          // mixed precision: activations converted between two layers
+    TRACE_PREDICT,
+    TRACE_SOFTMAX,
+    TRACE_IMAGE,            // one whole classification
+    TRACE_BATCH,            // one work item of a worker thread
+    TRACE_NB_STAGES
+};
+
+void TraceBegin(int stage);
+void TraceEnd(int stage);
+void TraceSetImage(int image);
+void TraceThreadName(const char *name);
+int  TraceWrite(const char *filename);
+
+#ifdef TRACE
+#define TRACE_BEGIN(stage) TraceBegin(stage)
+#define TRACE_END(stage)   TraceEnd(stage)
+#define TRACE_IMAGE_INDEX(image) TraceSetImage(image)
+#else
+#define TRACE_BEGIN(stage)
+#define TRACE_END(stage)
+#define TRACE_IMAGE_INDEX(image)
+#endif
+
+#endif // TRACE_H
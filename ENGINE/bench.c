@@ -0,0 +1,183 @@
+/**
+ * @file bench.c
+ * @brief Kernel microbenchmark harness, see bench.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../COMMON/latency.h"
+#include "bench.h"
+
+#define BENCH_MAX_SAMPLES 1000
+
+void BenchDefaultOptions(bench_options_t *opt)
+{
+    opt->samples = 31;
+    opt->sample_ms = 2.0;
+    opt->warmup_ms = 50.0;
+    opt->filter = NULL;
+}
+
+static int CompareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/// @brief Nearest-rank percentile of a sorted array
+static double Percentile(const double *sorted, int n, double percent)
+{
+    int rank = (int)ceil(percent / 100.0 * n);
+
+    if (rank < 1)
+        rank = 1;
+    return sorted[rank - 1];
+}
+
+/// @brief Warm up, calibrate calls per sample, then time opt->samples samples
+void BenchKernel(const bench_kernel_t *k, const bench_options_t *opt, bench_stats_t *stats)
+{
+    double ns[BENCH_MAX_SAMPLES], dev[BENCH_MAX_SAMPLES];
+    unsigned long long t0, elapsed;
+    long calls = 1, c;
+    int samples = opt->samples, s;
+
+    if (samples < 1) samples = 1;
+    if (samples > BENCH_MAX_SAMPLES) samples = BENCH_MAX_SAMPLES;
+
+    // Warm-up: caches, branch predictors and clock frequency
+    t0 = LatencyNow();
+    do {
+        k->run();
+    } while (LatencyNow() - t0 < opt->warmup_ms * 1e6);
+
+    // Double the calls per sample until one sample lasts sample_ms, so the clock resolution does not matter
+    for (;;) {
+        t0 = LatencyNow();
+        for (c = 0; c < calls; c++)
+            k->run();
+        elapsed = LatencyNow() - t0;
+        if (elapsed >= opt->sample_ms * 1e6 || calls >= (1L << 30))
+            break;
+        calls *= 2;
+    }
+
+    for (s = 0; s < samples; s++) {
+        t0 = LatencyNow();
+        for (c = 0; c < calls; c++)
+            k->run();
+        ns[s] = (double)(LatencyNow() - t0) / calls;
+    }
+    qsort(ns, samples, sizeof(double), CompareDouble);
+
+    stats->ns_median = Percentile(ns, samples, 50);
+    stats->ns_min = ns[0];
+    stats->ns_p90 = Percentile(ns, samples, 90);
+    for (s = 0; s < samples; s++)
+        dev[s] = fabs(ns[s] - stats->ns_median);
+    qsort(dev, samples, sizeof(double), CompareDouble);
+    stats->mad = Percentile(dev, samples, 50) / stats->ns_median;
+    stats->calls_per_sample = calls;
+    stats->samples = samples;
+}
+
+static void RunTable(const bench_kernel_t *kernels, int count, const bench_options_t *opt,
+                     FILE *json, int *first)
+{
+    bench_stats_t st;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        const bench_kernel_t *k = &kernels[i];
+        int is_float = (strcmp(k->precision, "float") == 0);
+
+        if (opt->filter && !strstr(k->name, opt->filter))
+            continue;
+        BenchKernel(k, opt, &st);
+
+        printf("%-40s %-6s %12.1f %12.1f %12.1f %6.1f%% %10.0f %9.3f %s\n",
+               k->name, k->precision, st.ns_median, st.ns_min, st.ns_p90, 100 * st.mad,
+               k->ops, k->ops / st.ns_median, is_float ? "GFLOP/s" : "GOP/s");
+        fflush(stdout);
+
+        if (json) {
+            fprintf(json, "%s\n    {\"kernel\": \"%s\", \"precision\": \"%s\", \"ops_per_call\": %.0f, "
+                    "\"bytes_per_call\": %.0f, \"ns_median\": %.2f, \"ns_min\": %.2f, \"ns_p90\": %.2f, \"mad\": %.4f, "
+                    "\"%s\": %.4f, \"samples\": %d, \"calls_per_sample\": %ld}",
+                    *first ? "" : ",", k->name, k->precision, k->ops, k->bytes,
+                    st.ns_median, st.ns_min, st.ns_p90, st.mad,
+                    is_float ? "gflops" : "gops", k->ops / st.ns_median, st.samples, st.calls_per_sample);
+            *first = 0;
+        }
+    }
+}
+
+/// @brief Run every registered kernel, table on stdout and optional JSON
+int BenchAll(const bench_options_t *opt, FILE *json)
+{
+    const bench_kernel_t *kernels;
+    int count, first = 1;
+
+    printf("%d samples of >= %.1f ms per kernel after %.0f ms warm-up\n\n",
+           opt->samples, opt->sample_ms, opt->warmup_ms);
+    printf("%-40s %-6s %12s %12s %12s %7s %10s %9s\n",
+           "kernel", "type", "ns median", "ns min", "ns p90", "MAD", "ops/call", "G/s");
+
+    if (json)
+        fprintf(json, "{\n  \"samples\": %d,\n  \"sample_ms\": %.2f,\n  \"kernels\": [",
+                opt->samples, opt->sample_ms);
+
+    kernels = BenchFloatKernels(&count);
+    RunTable(kernels, count, opt, json, &first);
+    kernels = BenchFixedKernels(&count);
+    RunTable(kernels, count, opt, json, &first);
+
+    if (json)
+        fprintf(json, "\n  ]\n}\n");
+    return 0;
+}
+
+/// @brief Command line front end: [-s samples] [-t sample_ms] [-k kernel_filter] [-o bench.json]
+int BenchMain(int argc, char **argv)
+{
+    bench_options_t opt;
+    const char *json_filename = NULL;
+    FILE *json = NULL;
+    int k;
+
+    BenchDefaultOptions(&opt);
+    for (k = 1; k < argc; k++) {
+        if (strcmp(argv[k], "-s") == 0 && k + 1 < argc)
+            opt.samples = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-t") == 0 && k + 1 < argc)
+            opt.sample_ms = atof(argv[++k]);
+        else if (strcmp(argv[k], "-k") == 0 && k + 1 < argc)
+            opt.filter = argv[++k];
+        else if (strcmp(argv[k], "-o") == 0 && k + 1 < argc)
+            json_filename = argv[++k];
+        else {
+            printf("Usage: %s [-s samples] [-t sample_ms] [-k kernel_filter] [-o bench.json]\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    if (json_filename) {
+        json = fopen(json_filename, "w");
+        if (!json) {
+            printf("Error: Unable to open file %s.\n", json_filename);
+            exit(1);
+        }
+    }
+
+    BenchAll(&opt, json);
+
+    if (json) {
+        fclose(json);
+        printf("\nResults written to %s\n", json_filename);
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file bench.h
+ * @brief Kernel microbenchmarks: float and fixed layers run in isolation
+ *
+ * Every kernel is registered with its operation count per call, derived from
+ * the CONVx_* / POOLx_* / FCx_* dimensions (one MAC = 2 ops). The harness
+ * warms the kernel up, calibrates the number of calls per sample, then takes
+ * several samples and reports the median, min and p90 ns/call, the relative
+ * median absolute deviation, and GFLOP/s or GOP/s at the median. The byte
+ * count of each kernel (sizeof of the arrays it reads and writes) feeds the
+ * roofline report, see roofline.h.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+
+typedef struct {
+    const char *name;           // kernel function
+    const char *precision;      // "float" or "fixed"
+    double      ops;            // arithmetic operations per call
+    double      bytes;          // compulsory traffic per call: inputs, weights, biases and outputs once
+    void      (*run)(void);     // one call on the module's synthetic data
+} bench_kernel_t;
+
+typedef struct {
+    double ns_median, ns_min, ns_p90;
+    double mad;                 // median absolute deviation / median
+    long   calls_per_sample;
+    int    samples;
+} bench_stats_t;
+
+typedef struct {
+    int         samples;        // samples per kernel
+    double      sample_ms;      // minimum duration of one sample
+    double      warmup_ms;
+    const char *filter;         // run only kernels whose name contains it, NULL for all
+} bench_options_t;
+
+// Kernel tables of each precision, data initialized on first call
+const bench_kernel_t *BenchFloatKernels(int *count);
+const bench_kernel_t *BenchFixedKernels(int *count);
+
+void BenchDefaultOptions(bench_options_t *opt);
+void BenchKernel(const bench_kernel_t *k, const bench_options_t *opt, bench_stats_t *stats);
+int  BenchAll(const bench_options_t *opt, FILE *json);
+int  BenchMain(int argc, char **argv);
+
+#endif // BENCH_H
@@ -0,0 +1,279 @@
+/**
+ * @file bench_fixed.c
+ * @brief Fixed-point kernels registered for the microbenchmarks, see bench.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../FIXED/lenet_cnn_fixed.h"
+#include "bench.h"
+
+#define CONV1_MACS  (CONV1_NBOUTPUT * CONV1_HEIGHT * CONV1_WIDTH * IMG_DEPTH * CONV1_DIM * CONV1_DIM)
+#define CONV2_MACS  (CONV2_NBOUTPUT * CONV2_HEIGHT * CONV2_WIDTH * POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM)
+#define FC1_MACS    (FC1_NBOUTPUT * POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+#define FC2_MACS    (FC2_NBOUTPUT * FC1_NBOUTPUT)
+#define POOL1_OPS   (POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH * 3)      // 3 compares per 2x2 window
+#define POOL2_OPS   (POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH * 3)
+
+// Each array read or written once
+#define CONV1_BYTES (sizeof(input) + sizeof(conv1_kernel) + sizeof(conv1_bias) + sizeof(conv1_output))
+#define POOL1_BYTES (sizeof(conv1_output) + sizeof(pool1_output))
+#define CONV2_BYTES (sizeof(pool1_output) + sizeof(conv2_kernel) + sizeof(conv2_bias) + sizeof(conv2_output))
+#define POOL2_BYTES (sizeof(conv2_output) + sizeof(pool2_output))
+#define FC1_BYTES   (sizeof(pool2_output) + sizeof(fc1_kernel) + sizeof(fc1_bias) + sizeof(fc1_output))
+#define FC2_BYTES   (sizeof(fc1_output) + sizeof(fc2_kernel) + sizeof(fc2_bias) + sizeof(fc2_output))
+
+// CSR kernels: the weights kept at BENCH_CSR_DENSITY, plus row pointers and 16-bit column indexes
+#define BENCH_CSR_DENSITY 0.1
+#define CSR_BYTES(kernel, rows) (((rows) + 1) * sizeof(int) + BENCH_CSR_DENSITY * sizeof(kernel) / sizeof(short) * \
+                                 (sizeof(unsigned short) + sizeof(short)))
+#define CONV2_CSR_BYTES (sizeof(pool1_output) + CSR_BYTES(conv2_kernel, CONV2_NBOUTPUT) + sizeof(conv2_bias) + \
+                         sizeof(conv2_output))
+#define FC1_CSR_BYTES   (sizeof(pool2_output) + CSR_BYTES(fc1_kernel, FC1_NBOUTPUT) + sizeof(fc1_bias) + sizeof(fc1_output))
+
+// Clustered kernels: BENCH_CLUSTER_CENTROIDS centroids, 4-bit indexes
+#define BENCH_CLUSTER_CENTROIDS 16
+#define CLUSTER_BYTES(kernel) (BENCH_CLUSTER_CENTROIDS * sizeof(short) + sizeof(kernel) / sizeof(short) / 2)
+#define CONV2_CLUSTER_BYTES (sizeof(pool1_output) + CLUSTER_BYTES(conv2_kernel) + sizeof(conv2_bias) + sizeof(conv2_output))
+#define FC1_CLUSTER_BYTES   (sizeof(pool2_output) + CLUSTER_BYTES(fc1_kernel) + sizeof(fc1_bias) + sizeof(fc1_output))
+
+// Binarized kernels: sign bits, plus a scale and a sign sum per row
+#define XNOR_BYTES(words, rows) ((rows) * ((words) * 8 + 8))
+#define CONV2_XNOR_BYTES (sizeof(pool1_output) + XNOR_BYTES(XNOR_CONV2_WORDS, CONV2_NBOUTPUT) + sizeof(conv2_bias) + \
+                          sizeof(conv2_output))
+#define FC1_XNOR_BYTES   (sizeof(pool2_output) + XNOR_BYTES(XNOR_FC1_WORDS, FC1_NBOUTPUT) + sizeof(fc1_bias) + \
+                          sizeof(fc1_output))
+
+// Entropy-coded kernels: about log2 of the number of values Fill draws from, bits per weight
+#define HUFFMAN_BYTES(kernel, bits) (sizeof(kernel) / sizeof(short) * (bits) / 8)
+#define CONV2_HUFFMAN_BYTES (sizeof(pool1_output) + HUFFMAN_BYTES(conv2_kernel, 6) + sizeof(conv2_bias) + \
+                             sizeof(conv2_output))
+#define FC1_HUFFMAN_BYTES   (sizeof(pool2_output) + HUFFMAN_BYTES(fc1_kernel, 5) + sizeof(fc1_bias) + sizeof(fc1_output))
+
+// int8 operands: the requantized input and signed char weights
+#define CONV1_INT8_BYTES (sizeof(input) + sizeof(input_int8) + sizeof(conv1_int8) + sizeof(conv1_bias) + \
+                          sizeof(conv1_output))
+#define CONV2_INT8_BYTES (sizeof(pool1_output) + sizeof(pool1_int8) + sizeof(conv2_int8) + sizeof(conv2_bias) + \
+                          sizeof(conv2_output))
+#define FC1_INT8_BYTES   (sizeof(pool2_output) + sizeof(pool2_int8) + sizeof(fc1_int8) + sizeof(fc1_bias) + sizeof(fc1_output))
+
+// Out-of-core FC1 in chunks of BENCH_CHUNK_WEIGHTS weights, read from memory: the cost of the chunking alone
+#define BENCH_CHUNK_WEIGHTS 8192
+
+static short input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+static short input_digit[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];    // input with an empty 6-pixel margin
+static short conv1_kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+static short conv1_bias[CONV1_NBOUTPUT];
+static short conv1_output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH];
+static short pool1_output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH];
+static short conv2_kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+static short conv2_bias[CONV2_NBOUTPUT];
+static short conv2_output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH];
+static short pool2_output[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static short fc1_kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static short fc1_bias[FC1_NBOUTPUT];
+static short fc1_output[FC1_NBOUTPUT];
+static short fc2_kernel[FC2_NBOUTPUT][FC1_NBOUTPUT];
+static short fc2_bias[FC2_NBOUTPUT];
+static short fc2_output[FC2_NBOUTPUT];
+static float softmax_output[FC2_NBOUTPUT];
+static unsigned short softmax_q15[FC2_NBOUTPUT];
+static unsigned char topk_index[FC2_NBOUTPUT];
+static prediction_fixed_t prediction;
+static nonzero_list_fixed_t nonzeros;
+static csr_fixed_t conv2_csr, fc1_csr;
+static codebook_fixed_t conv2_cb, fc1_cb;
+static pow2_fixed_t conv2_pow2[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+static pow2_fixed_t fc1_pow2[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static xnor_fixed_t conv2_xnor, fc1_xnor;
+static huffman_fixed_t conv2_huffman, fc1_huffman;
+static signed char input_int8[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+static signed char conv1_int8[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];     // Q8, as conv1_kernel
+static signed char pool1_int8[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH];
+static signed char pool2_int8[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static signed char conv2_int8[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];     // Q8, as conv2_kernel
+static signed char fc1_int8[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static volatile unsigned char argmax_sink;
+
+static void Fill(short *data, int size, int lo, int hi)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+        data[i] = (short)(lo + rand() % (hi - lo + 1));
+}
+
+/// @brief CSR of a copy of dense with its 1 - BENCH_CSR_DENSITY smallest weights pruned
+static void PruneToCsr(const short *dense, int rows, int size, csr_fixed_t *csr)
+{
+    short *w = malloc(size * sizeof(short));
+
+    memcpy(w, dense, size * sizeof(short));
+    CsrPrune_fixed(w, size, 1.0f - BENCH_CSR_DENSITY);
+    CsrFromDense_fixed(w, rows, size / rows, csr);
+    free(w);
+}
+
+static void RunConv1(void)      { Conv1_28x28x1_5x5x20_1_0_fixed(input, conv1_kernel, conv1_bias, conv1_output); }
+static void RunConv1Crop(void)
+{
+    bbox_fixed_t box;
+
+    InputBoundingBox_fixed(input_digit, &box);
+    Conv1_28x28x1_5x5x20_1_0_crop_fixed(input_digit, &box, conv1_kernel, conv1_bias, conv1_output);
+}
+static void RunPool1(void)      { Pool1_24x24x20_2x2x20_2_0_fixed(conv1_output, pool1_output); }
+static void RunConv2(void)      { Conv2_12x12x20_5x5x40_1_0_fixed(pool1_output, conv2_kernel, conv2_bias, conv2_output); }
+static void RunPool2(void)      { Pool2_8x8x40_2x2x40_2_0_fixed(conv2_output, pool2_output); }
+static void RunFc1(void)        { Fc1_40_400_fixed(pool2_output, fc1_kernel, fc1_bias, fc1_output); }
+static void RunConv2Sparse(void)
+{
+    NonzeroList_fixed(&pool1_output[0][0][0], sizeof(pool1_output) / sizeof(short), &nonzeros);
+    Conv2_12x12x20_5x5x40_1_0_sparse_fixed(&nonzeros, conv2_kernel, conv2_bias, conv2_output);
+}
+static void RunFc1Sparse(void)
+{
+    NonzeroList_fixed(&pool2_output[0][0][0], sizeof(pool2_output) / sizeof(short), &nonzeros);
+    Fc1_40_400_sparse_fixed(&nonzeros, fc1_kernel, fc1_bias, fc1_output);
+}
+static void RunConv2Csr(void)   { Conv2_12x12x20_5x5x40_1_0_csr_fixed(pool1_output, &conv2_csr, conv2_bias, conv2_output); }
+static void RunFc1Csr(void)     { Fc1_40_400_csr_fixed(pool2_output, &fc1_csr, fc1_bias, fc1_output); }
+static void RunConv2Cluster(void)
+{
+    Conv2_12x12x20_5x5x40_1_0_cluster_fixed(pool1_output, &conv2_cb, conv2_bias, conv2_output);
+}
+static void RunFc1Cluster(void) { Fc1_40_400_cluster_fixed(pool2_output, &fc1_cb, fc1_bias, fc1_output); }
+static void RunConv2Pow2(void)
+{
+    Conv2_12x12x20_5x5x40_1_0_pow2_fixed(pool1_output, conv2_pow2, conv2_bias, conv2_output);
+}
+static void RunFc1Pow2(void)    { Fc1_40_400_pow2_fixed(pool2_output, fc1_pow2, fc1_bias, fc1_output); }
+static void RunConv2Xnor(void)
+{
+    Conv2_12x12x20_5x5x40_1_0_xnor_fixed(pool1_output, &conv2_xnor, conv2_bias, conv2_output);
+}
+static void RunFc1Xnor(void)    { Fc1_40_400_xnor_fixed(pool2_output, &fc1_xnor, fc1_bias, fc1_output); }
+static void RunConv2Huffman(void)
+{
+    Conv2_12x12x20_5x5x40_1_0_huffman_fixed(pool1_output, &conv2_huffman, conv2_bias, conv2_output);
+}
+static void RunFc1Huffman(void) { Fc1_40_400_huffman_fixed(pool2_output, &fc1_huffman, fc1_bias, fc1_output); }
+static void RunConv1Int8(void)
+{
+    int bits = Int8Quantize_fixed(&input[0][0][0], sizeof(input) / sizeof(short), &input_int8[0][0][0]);
+
+    Conv1_28x28x1_5x5x20_1_0_int8_fixed(input_int8, conv1_int8, conv1_bias, bits, conv1_output);
+}
+static void RunConv2Int8(void)
+{
+    int bits = Int8Quantize_fixed(&pool1_output[0][0][0], sizeof(pool1_output) / sizeof(short), &pool1_int8[0][0][0]);
+
+    Conv2_12x12x20_5x5x40_1_0_int8_fixed(pool1_int8, conv2_int8, conv2_bias, bits, conv2_output);
+}
+static void RunFc1Int8(void)
+{
+    int bits = Int8Quantize_fixed(&pool2_output[0][0][0], sizeof(pool2_output) / sizeof(short), &pool2_int8[0][0][0]);
+
+    Fc1_40_400_int8_fixed(pool2_int8, fc1_int8, fc1_bias, bits, fc1_output);
+}
+static void RunFc1Chunk(void)
+{
+    const int size = sizeof(fc1_kernel) / sizeof(short);
+    int acc[FC1_NBOUTPUT] = { 0 }, first, count;
+
+    for (first = 0; first < size; first += count) {
+        count = size - first < BENCH_CHUNK_WEIGHTS ? size - first : BENCH_CHUNK_WEIGHTS;
+        Fc1_40_400_chunk_fixed(pool2_output, &fc1_kernel[0][0][0][0] + first, first, count, acc);
+    }
+    Fc1_40_400_finish_fixed(acc, fc1_bias, fc1_output);
+}
+static void RunFc2(void)        { Fc2_400_10_fixed(fc1_output, fc2_kernel, fc2_bias, fc2_output); }
+static void RunSoftmax(void)    { Softmax_fixed(fc2_output, softmax_output); }
+static void RunSoftmaxInt(void) { Softmax_int_fixed(fc2_output, softmax_q15); }
+static void RunArgmax(void)     { argmax_sink = Argmax_fixed(fc2_output); }
+static void RunTopK(void)       { TopK_fixed(fc2_output, 3, topk_index); }
+static void RunPredict(void)    { Predict_fixed(fc2_output, &prediction); }
+
+static const bench_kernel_t kernels[] = {
+    { "Conv1_28x28x1_5x5x20_1_0_fixed",  "fixed", 2.0 * CONV1_MACS, CONV1_BYTES, RunConv1 },
+    { "Conv1_28x28x1_5x5x20_1_0_crop_fixed", "fixed", 2.0 * CONV1_MACS, CONV1_BYTES, RunConv1Crop },  // 16x16 digit
+    { "Pool1_24x24x20_2x2x20_2_0_fixed", "fixed", POOL1_OPS,        POOL1_BYTES, RunPool1 },
+    { "Conv2_12x12x20_5x5x40_1_0_fixed", "fixed", 2.0 * CONV2_MACS, CONV2_BYTES, RunConv2 },
+    { "Pool2_8x8x40_2x2x40_2_0_fixed",   "fixed", POOL2_OPS,        POOL2_BYTES, RunPool2 },
+    { "Fc1_40_400_fixed",                "fixed", 2.0 * FC1_MACS,   FC1_BYTES,   RunFc1 },
+    // Sparse kernels at the density of the synthetic data, list build included, dense-equivalent ops
+    { "Conv2_12x12x20_5x5x40_1_0_sparse_fixed", "fixed", 2.0 * CONV2_MACS, CONV2_BYTES, RunConv2Sparse },
+    { "Fc1_40_400_sparse_fixed",         "fixed", 2.0 * FC1_MACS,   FC1_BYTES,   RunFc1Sparse },
+    // Pruned weights at BENCH_CSR_DENSITY, dense-equivalent ops
+    { "Conv2_12x12x20_5x5x40_1_0_csr_fixed", "fixed", 2.0 * CONV2_MACS, CONV2_CSR_BYTES, RunConv2Csr },
+    { "Fc1_40_400_csr_fixed",            "fixed", 2.0 * FC1_MACS,   FC1_CSR_BYTES, RunFc1Csr },
+    // Weights shared on BENCH_CLUSTER_CENTROIDS centroids, dense-equivalent ops
+    { "Conv2_12x12x20_5x5x40_1_0_cluster_fixed", "fixed", 2.0 * CONV2_MACS, CONV2_CLUSTER_BYTES, RunConv2Cluster },
+    { "Fc1_40_400_cluster_fixed",        "fixed", 2.0 * FC1_MACS,   FC1_CLUSTER_BYTES, RunFc1Cluster },
+    // Two-term power-of-two weights, shifts and adds counted as the MACs they replace
+    { "Conv2_12x12x20_5x5x40_1_0_pow2_fixed", "fixed", 2.0 * CONV2_MACS, CONV2_BYTES, RunConv2Pow2 },
+    { "Fc1_40_400_pow2_fixed",           "fixed", 2.0 * FC1_MACS,   FC1_BYTES,   RunFc1Pow2 },
+    // 1-bit weights and activations, XORs and popcounts counted as the MACs they replace
+    { "Conv2_12x12x20_5x5x40_1_0_xnor_fixed", "fixed", 2.0 * CONV2_MACS, CONV2_XNOR_BYTES, RunConv2Xnor },
+    { "Fc1_40_400_xnor_fixed",           "fixed", 2.0 * FC1_MACS,   FC1_XNOR_BYTES, RunFc1Xnor },
+    // Huffman-coded weights decoded on the fly, the decode not counted in the ops
+    { "Conv2_12x12x20_5x5x40_1_0_huffman_fixed", "fixed", 2.0 * CONV2_MACS, CONV2_HUFFMAN_BYTES, RunConv2Huffman },
+    { "Fc1_40_400_huffman_fixed",        "fixed", 2.0 * FC1_MACS,   FC1_HUFFMAN_BYTES, RunFc1Huffman },
+    // int8 weights and activations, the input requantization included
+    { "Conv1_28x28x1_5x5x20_1_0_int8_fixed", "fixed", 2.0 * CONV1_MACS, CONV1_INT8_BYTES, RunConv1Int8 },
+    { "Conv2_12x12x20_5x5x40_1_0_int8_fixed", "fixed", 2.0 * CONV2_MACS, CONV2_INT8_BYTES, RunConv2Int8 },
+    { "Fc1_40_400_int8_fixed",           "fixed", 2.0 * FC1_MACS,   FC1_INT8_BYTES, RunFc1Int8 },
+    // Out-of-core FC1, the chunks in memory
+    { "Fc1_40_400_chunk_fixed",          "fixed", 2.0 * FC1_MACS,   FC1_BYTES,   RunFc1Chunk },
+    { "Fc2_400_10_fixed",                "fixed", 2.0 * FC2_MACS,   FC2_BYTES,   RunFc2 },
+    { "Softmax_fixed",                   "fixed", FC2_NBOUTPUT, sizeof(fc2_output) + sizeof(softmax_output), RunSoftmax },
+    { "Softmax_int_fixed",               "fixed", FC2_NBOUTPUT, sizeof(fc2_output) + sizeof(softmax_q15), RunSoftmaxInt },
+    { "Argmax_fixed",                    "fixed", FC2_NBOUTPUT, sizeof(fc2_output), RunArgmax },
+    { "TopK_fixed",                      "fixed", FC2_NBOUTPUT, sizeof(fc2_output) + 3, RunTopK },
+    { "Predict_fixed",                   "fixed", FC2_NBOUTPUT, sizeof(fc2_output), RunPredict },
+};
+
+const bench_kernel_t *BenchFixedKernels(int *count)
+{
+    static int initialized = 0;
+    int y, x, i;
+
+    if (!initialized) {
+        // Q8 ranges of weights.h and raw 8-bit pixels, layers chained once to get realistic inputs
+        srand(1);
+        Fill((short *)input, sizeof(input) / sizeof(short), 0, 255);
+        Fill((short *)conv1_kernel, sizeof(conv1_kernel) / sizeof(short), -128, 127);
+        Fill(conv1_bias, CONV1_NBOUTPUT, -32, 32);
+        Fill((short *)conv2_kernel, sizeof(conv2_kernel) / sizeof(short), -32, 32);
+        Fill(conv2_bias, CONV2_NBOUTPUT, -32, 32);
+        Fill((short *)fc1_kernel, sizeof(fc1_kernel) / sizeof(short), -16, 16);
+        Fill(fc1_bias, FC1_NBOUTPUT, -32, 32);
+        Fill((short *)fc2_kernel, sizeof(fc2_kernel) / sizeof(short), -32, 32);
+        Fill(fc2_bias, FC2_NBOUTPUT, -32, 32);
+        for (y = 0; y < IMG_HEIGHT; y++)
+            for (x = 0; x < IMG_WIDTH; x++)
+                input_digit[0][y][x] = (y < 6 || y >= IMG_HEIGHT - 6 || x < 6 || x >= IMG_WIDTH - 6) ? 0 : input[0][y][x];
+        PruneToCsr(&conv2_kernel[0][0][0][0], CONV2_NBOUTPUT, sizeof(conv2_kernel) / sizeof(short), &conv2_csr);
+        PruneToCsr(&fc1_kernel[0][0][0][0], FC1_NBOUTPUT, sizeof(fc1_kernel) / sizeof(short), &fc1_csr);
+        ClusterFit_fixed(&conv2_kernel[0][0][0][0], sizeof(conv2_kernel) / sizeof(short), BENCH_CLUSTER_CENTROIDS,
+                         &conv2_cb);
+        ClusterFit_fixed(&fc1_kernel[0][0][0][0], sizeof(fc1_kernel) / sizeof(short), BENCH_CLUSTER_CENTROIDS, &fc1_cb);
+        Pow2Quantize_fixed(&conv2_kernel[0][0][0][0], sizeof(conv2_kernel) / sizeof(short), 2, &conv2_pow2[0][0][0][0]);
+        Pow2Quantize_fixed(&fc1_kernel[0][0][0][0], sizeof(fc1_kernel) / sizeof(short), 2, &fc1_pow2[0][0][0][0]);
+        XnorConv2_fixed(conv2_kernel, &conv2_xnor);
+        XnorFc1_fixed(fc1_kernel, &fc1_xnor);
+        HuffmanEncode_fixed(&conv2_kernel[0][0][0][0], sizeof(conv2_kernel) / sizeof(short), &conv2_huffman);
+        HuffmanEncode_fixed(&fc1_kernel[0][0][0][0], sizeof(fc1_kernel) / sizeof(short), &fc1_huffman);
+        for (i = 0; i < (int)(sizeof(conv1_int8)); i++)
+            (&conv1_int8[0][0][0][0])[i] = (signed char)(&conv1_kernel[0][0][0][0])[i];
+        for (i = 0; i < (int)(sizeof(conv2_int8)); i++)
+            (&conv2_int8[0][0][0][0])[i] = (signed char)(&conv2_kernel[0][0][0][0])[i];
+        for (i = 0; i < (int)(sizeof(fc1_int8)); i++)
+            (&fc1_int8[0][0][0][0])[i] = (signed char)(&fc1_kernel[0][0][0][0])[i];
+        RunConv1(); RunPool1(); RunConv2(); RunPool2(); RunFc1(); RunFc2();
+        initialized = 1;
+    }
+    *count = sizeof(kernels) / sizeof(kernels[0]);
+    return kernels;
+}
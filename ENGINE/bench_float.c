@@ -0,0 +1,267 @@
+/**
+ * @file bench_float.c
+ * @brief Float kernels registered for the microbenchmarks, see bench.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../FLOAT/lenet_cnn_float.h"
+#include "bench.h"
+
+#define CONV1_MACS  (CONV1_NBOUTPUT * CONV1_HEIGHT * CONV1_WIDTH * IMG_DEPTH * CONV1_DIM * CONV1_DIM)
+#define CONV2_MACS  (CONV2_NBOUTPUT * CONV2_HEIGHT * CONV2_WIDTH * POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM)
+#define FC1_MACS    (FC1_NBOUTPUT * POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+#define FC2_MACS    (FC2_NBOUTPUT * FC1_NBOUTPUT)
+#define POOL1_OPS   (POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH * 3)      // 3 compares per 2x2 window
+#define POOL2_OPS   (POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH * 3)
+
+// Each array read or written once
+#define CONV1_BYTES (sizeof(input) + sizeof(conv1_kernel) + sizeof(conv1_bias) + sizeof(conv1_output))
+#define POOL1_BYTES (sizeof(conv1_output) + sizeof(pool1_output))
+#define CONV2_BYTES (sizeof(pool1_output) + sizeof(conv2_kernel) + sizeof(conv2_bias) + sizeof(conv2_output))
+#define POOL2_BYTES (sizeof(conv2_output) + sizeof(pool2_output))
+#define FC1_BYTES   (sizeof(pool2_output) + sizeof(fc1_kernel) + sizeof(fc1_bias) + sizeof(fc1_output))
+#define FC2_BYTES   (sizeof(fc1_output) + sizeof(fc2_kernel) + sizeof(fc2_bias) + sizeof(fc2_output))
+
+// CSR kernels: the weights kept at BENCH_CSR_DENSITY, plus row pointers and 16-bit column indexes
+#define BENCH_CSR_DENSITY 0.1
+#define CSR_BYTES(kernel, rows) (((rows) + 1) * sizeof(int) + BENCH_CSR_DENSITY * sizeof(kernel) / sizeof(float) * \
+                                 (sizeof(unsigned short) + sizeof(float)))
+#define CONV2_CSR_BYTES (sizeof(pool1_output) + CSR_BYTES(conv2_kernel, CONV2_NBOUTPUT) + sizeof(conv2_bias) + \
+                         sizeof(conv2_output))
+#define FC1_CSR_BYTES   (sizeof(pool2_output) + CSR_BYTES(fc1_kernel, FC1_NBOUTPUT) + sizeof(fc1_bias) + sizeof(fc1_output))
+
+// Clustered kernels: BENCH_CLUSTER_CENTROIDS centroids, 4-bit indexes
+#define BENCH_CLUSTER_CENTROIDS 16
+#define CLUSTER_BYTES(kernel) (BENCH_CLUSTER_CENTROIDS * sizeof(float) + sizeof(kernel) / sizeof(float) / 2)
+#define CONV2_CLUSTER_BYTES (sizeof(pool1_output) + CLUSTER_BYTES(conv2_kernel) + sizeof(conv2_bias) + sizeof(conv2_output))
+#define FC1_CLUSTER_BYTES   (sizeof(pool2_output) + CLUSTER_BYTES(fc1_kernel) + sizeof(fc1_bias) + sizeof(fc1_output))
+
+// Binarized kernels: sign bits, plus a scale and a sign sum per row
+#define XNOR_BYTES(words, rows) ((rows) * ((words) * 8 + 8))
+#define CONV2_XNOR_BYTES (sizeof(pool1_output) + XNOR_BYTES(XNOR_CONV2_WORDS, CONV2_NBOUTPUT) + sizeof(conv2_bias) + \
+                          sizeof(conv2_output))
+#define FC1_XNOR_BYTES   (sizeof(pool2_output) + XNOR_BYTES(XNOR_FC1_WORDS, FC1_NBOUTPUT) + sizeof(fc1_bias) + \
+                          sizeof(fc1_output))
+
+// Half-precision storage: kernels and activations on 2 bytes, biases float
+#define CONV2_HALF_BYTES (sizeof(pool1_half) + sizeof(conv2_kernel_fp16) + sizeof(conv2_bias) + sizeof(conv2_half))
+#define FC1_HALF_BYTES   (sizeof(pool2_half) + sizeof(fc1_kernel_fp16) + sizeof(fc1_bias) + sizeof(fc1_half))
+
+// LANES interleaved images per call: the kernel read once, the maps of every image
+#define CONV1_LANES_BYTES (sizeof(input_lanes) + sizeof(conv1_kernel) + sizeof(conv1_bias) + sizeof(conv1_lanes))
+#define POOL1_LANES_BYTES (sizeof(conv1_lanes) + sizeof(pool1_lanes))
+#define CONV2_LANES_BYTES (sizeof(pool1_lanes) + sizeof(conv2_kernel) + sizeof(conv2_bias) + sizeof(conv2_lanes))
+#define POOL2_LANES_BYTES (sizeof(conv2_lanes) + sizeof(pool2_lanes))
+#define FC1_LANES_BYTES   (sizeof(pool2_lanes) + sizeof(fc1_kernel) + sizeof(fc1_bias) + sizeof(fc1_lanes))
+#define FC2_LANES_BYTES   (sizeof(fc1_lanes) + sizeof(fc2_kernel) + sizeof(fc2_bias) + sizeof(fc2_lanes))
+
+// Low-rank FC1: factors u [400][rank] and v [rank][640]
+#define BENCH_FC1_RANK     32
+#define FC1_LOWRANK_MACS   (BENCH_FC1_RANK * (FC1_NBOUTPUT + POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH))
+#define FC1_LOWRANK_BYTES  (sizeof(pool2_output) + FC1_LOWRANK_MACS * sizeof(float) + sizeof(fc1_bias) + sizeof(fc1_output))
+
+static float input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+static float input_digit[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];    // input with an empty 6-pixel margin
+static float conv1_kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+static float conv1_bias[CONV1_NBOUTPUT];
+static float conv1_output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH];
+static float pool1_output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH];
+static float conv2_kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+static float conv2_bias[CONV2_NBOUTPUT];
+static float conv2_output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH];
+static float pool2_output[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static float fc1_kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static float fc1_bias[FC1_NBOUTPUT];
+static float fc1_output[FC1_NBOUTPUT];
+static float fc2_kernel[FC2_NBOUTPUT][FC1_NBOUTPUT];
+static float fc2_bias[FC2_NBOUTPUT];
+static float fc2_output[FC2_NBOUTPUT];
+static float softmax_output[FC2_NBOUTPUT];
+static prediction_t prediction;
+static nonzero_list_t nonzeros;
+static csr_t conv2_csr, fc1_csr;
+static codebook_t conv2_cb, fc1_cb;
+static fc1_lowrank_t fc1_lowrank;
+static xnor_t conv2_xnor, fc1_xnor;
+static half_t pool1_half[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH];
+static half_t conv2_kernel_fp16[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+static half_t conv2_kernel_bf16[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+static half_t conv2_half[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH];
+static half_t pool2_half[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static half_t fc1_kernel_fp16[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static half_t fc1_kernel_bf16[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static half_t fc1_half[FC1_NBOUTPUT];
+static float input_lanes[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH][LANES];
+static float conv1_lanes[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH][LANES];
+static float pool1_lanes[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH][LANES];
+static float conv2_lanes[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH][LANES];
+static float pool2_lanes[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH][LANES];
+static float fc1_lanes[FC1_NBOUTPUT][LANES];
+static float fc2_lanes[FC2_NBOUTPUT][LANES];
+
+static void Fill(float *data, int size, float lo, float hi)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+        data[i] = lo + (hi - lo) * rand() / (float)RAND_MAX;
+}
+
+/// @brief CSR of a copy of dense with its 1 - BENCH_CSR_DENSITY smallest weights pruned
+static void PruneToCsr(const float *dense, int rows, int size, csr_t *csr)
+{
+    float *w = malloc(size * sizeof(float));
+
+    memcpy(w, dense, size * sizeof(float));
+    CsrPrune(w, size, 1.0f - BENCH_CSR_DENSITY);
+    CsrFromDense(w, rows, size / rows, csr);
+    free(w);
+}
+
+static void RunConv1(void)   { Conv1_28x28x1_5x5x20_1_0(input, conv1_kernel, conv1_bias, conv1_output); }
+static void RunConv1Crop(void)
+{
+    bbox_t box;
+
+    InputBoundingBox(input_digit, &box);
+    Conv1_28x28x1_5x5x20_1_0_crop(input_digit, &box, conv1_kernel, conv1_bias, conv1_output);
+}
+static void RunPool1(void)   { Pool1_24x24x20_2x2x20_2_0(conv1_output, pool1_output); }
+static void RunConv2(void)   { Conv2_12x12x20_5x5x40_1_0(pool1_output, conv2_kernel, conv2_bias, conv2_output); }
+static void RunPool2(void)   { Pool2_8x8x40_2x2x40_2_0(conv2_output, pool2_output); }
+static void RunFc1(void)     { Fc1_40_400(pool2_output, fc1_kernel, fc1_bias, fc1_output); }
+static void RunConv2Sparse(void)
+{
+    NonzeroList(&pool1_output[0][0][0], sizeof(pool1_output) / sizeof(float), &nonzeros);
+    Conv2_12x12x20_5x5x40_1_0_sparse(&nonzeros, conv2_kernel, conv2_bias, conv2_output);
+}
+static void RunFc1Sparse(void)
+{
+    NonzeroList(&pool2_output[0][0][0], sizeof(pool2_output) / sizeof(float), &nonzeros);
+    Fc1_40_400_sparse(&nonzeros, fc1_kernel, fc1_bias, fc1_output);
+}
+static void RunConv2Csr(void) { Conv2_12x12x20_5x5x40_1_0_csr(pool1_output, &conv2_csr, conv2_bias, conv2_output); }
+static void RunFc1Csr(void)   { Fc1_40_400_csr(pool2_output, &fc1_csr, fc1_bias, fc1_output); }
+static void RunConv2Cluster(void)
+{
+    Conv2_12x12x20_5x5x40_1_0_cluster(pool1_output, &conv2_cb, conv2_bias, conv2_output);
+}
+static void RunFc1Cluster(void) { Fc1_40_400_cluster(pool2_output, &fc1_cb, fc1_bias, fc1_output); }
+static void RunConv2Xnor(void)
+{
+    Conv2_12x12x20_5x5x40_1_0_xnor(pool1_output, &conv2_xnor, conv2_bias, conv2_output);
+}
+static void RunFc1Xnor(void)    { Fc1_40_400_xnor(pool2_output, &fc1_xnor, fc1_bias, fc1_output); }
+static void RunConv2Fp16(void)
+{
+    Conv2_12x12x20_5x5x40_1_0_half(pool1_half, conv2_kernel_fp16, conv2_bias, conv2_half, HALF_FP16);
+}
+static void RunConv2Bf16(void)
+{
+    Conv2_12x12x20_5x5x40_1_0_half(pool1_half, conv2_kernel_bf16, conv2_bias, conv2_half, HALF_BF16);
+}
+static void RunFc1Fp16(void)    { Fc1_40_400_half(pool2_half, fc1_kernel_fp16, fc1_bias, fc1_half, HALF_FP16); }
+static void RunFc1Bf16(void)    { Fc1_40_400_half(pool2_half, fc1_kernel_bf16, fc1_bias, fc1_half, HALF_BF16); }
+static void RunConv1Lanes(void)
+{
+    Conv1_28x28x1_5x5x20_1_0_lanes(input_lanes, conv1_kernel, conv1_bias, conv1_lanes);
+}
+static void RunPool1Lanes(void) { Pool1_24x24x20_2x2x20_2_0_lanes(conv1_lanes, pool1_lanes); }
+static void RunConv2Lanes(void)
+{
+    Conv2_12x12x20_5x5x40_1_0_lanes(pool1_lanes, conv2_kernel, conv2_bias, conv2_lanes);
+}
+static void RunPool2Lanes(void) { Pool2_8x8x40_2x2x40_2_0_lanes(conv2_lanes, pool2_lanes); }
+static void RunFc1Lanes(void)   { Fc1_40_400_lanes(pool2_lanes, fc1_kernel, fc1_bias, fc1_lanes); }
+static void RunFc2Lanes(void)   { Fc2_400_10_lanes(fc1_lanes, fc2_kernel, fc2_bias, fc2_lanes); }
+static void RunFc1LowRank(void) { Fc1_40_400_lowrank(pool2_output, &fc1_lowrank, fc1_bias, fc1_output); }
+static void RunFc2(void)     { Fc2_400_10(fc1_output, fc2_kernel, fc2_bias, fc2_output); }
+static void RunSoftmax(void) { Softmax(fc2_output, softmax_output); }
+static void RunPredict(void) { Predict(fc2_output, &prediction); }
+
+static const bench_kernel_t kernels[] = {
+    { "Conv1_28x28x1_5x5x20_1_0",  "float", 2.0 * CONV1_MACS, CONV1_BYTES, RunConv1 },
+    { "Conv1_28x28x1_5x5x20_1_0_crop", "float", 2.0 * CONV1_MACS, CONV1_BYTES, RunConv1Crop },   // 16x16 digit
+    { "Pool1_24x24x20_2x2x20_2_0", "float", POOL1_OPS,        POOL1_BYTES, RunPool1 },
+    { "Conv2_12x12x20_5x5x40_1_0", "float", 2.0 * CONV2_MACS, CONV2_BYTES, RunConv2 },
+    { "Pool2_8x8x40_2x2x40_2_0",   "float", POOL2_OPS,        POOL2_BYTES, RunPool2 },
+    { "Fc1_40_400",                "float", 2.0 * FC1_MACS,   FC1_BYTES,   RunFc1 },
+    // Sparse kernels at the density of the synthetic data, list build included, dense-equivalent ops
+    { "Conv2_12x12x20_5x5x40_1_0_sparse", "float", 2.0 * CONV2_MACS, CONV2_BYTES, RunConv2Sparse },
+    { "Fc1_40_400_sparse",         "float", 2.0 * FC1_MACS,   FC1_BYTES,   RunFc1Sparse },
+    // Pruned weights at BENCH_CSR_DENSITY, dense-equivalent ops
+    { "Conv2_12x12x20_5x5x40_1_0_csr", "float", 2.0 * CONV2_MACS, CONV2_CSR_BYTES, RunConv2Csr },
+    { "Fc1_40_400_csr",            "float", 2.0 * FC1_MACS,   FC1_CSR_BYTES, RunFc1Csr },
+    // Weights shared on BENCH_CLUSTER_CENTROIDS centroids, dense-equivalent ops
+    { "Conv2_12x12x20_5x5x40_1_0_cluster", "float", 2.0 * CONV2_MACS, CONV2_CLUSTER_BYTES, RunConv2Cluster },
+    { "Fc1_40_400_cluster",        "float", 2.0 * FC1_MACS,   FC1_CLUSTER_BYTES, RunFc1Cluster },
+    // 1-bit weights and activations, XORs and popcounts counted as the MACs they replace
+    { "Conv2_12x12x20_5x5x40_1_0_xnor", "float", 2.0 * CONV2_MACS, CONV2_XNOR_BYTES, RunConv2Xnor },
+    { "Fc1_40_400_xnor",           "float", 2.0 * FC1_MACS,   FC1_XNOR_BYTES, RunFc1Xnor },
+    // fp16 / bf16 storage widened to float, the same input bits for both (the time does not depend on them)
+    { "Conv2_12x12x20_5x5x40_1_0_half", "float", 2.0 * CONV2_MACS, CONV2_HALF_BYTES, RunConv2Fp16 },
+    { "Conv2_12x12x20_5x5x40_1_0_half_bf16", "float", 2.0 * CONV2_MACS, CONV2_HALF_BYTES, RunConv2Bf16 },
+    { "Fc1_40_400_half",           "float", 2.0 * FC1_MACS,   FC1_HALF_BYTES, RunFc1Fp16 },
+    { "Fc1_40_400_half_bf16",      "float", 2.0 * FC1_MACS,   FC1_HALF_BYTES, RunFc1Bf16 },
+    // LANES images per call, ops of all of them
+    { "Conv1_28x28x1_5x5x20_1_0_lanes", "float", 2.0 * CONV1_MACS * LANES, CONV1_LANES_BYTES, RunConv1Lanes },
+    { "Pool1_24x24x20_2x2x20_2_0_lanes", "float", POOL1_OPS * LANES, POOL1_LANES_BYTES, RunPool1Lanes },
+    { "Conv2_12x12x20_5x5x40_1_0_lanes", "float", 2.0 * CONV2_MACS * LANES, CONV2_LANES_BYTES, RunConv2Lanes },
+    { "Pool2_8x8x40_2x2x40_2_0_lanes", "float", POOL2_OPS * LANES, POOL2_LANES_BYTES, RunPool2Lanes },
+    { "Fc1_40_400_lanes",          "float", 2.0 * FC1_MACS * LANES, FC1_LANES_BYTES, RunFc1Lanes },
+    { "Fc2_400_10_lanes",          "float", 2.0 * FC2_MACS * LANES, FC2_LANES_BYTES, RunFc2Lanes },
+    // Rank BENCH_FC1_RANK SVD factors, actual ops
+    { "Fc1_40_400_lowrank",        "float", 2.0 * FC1_LOWRANK_MACS, FC1_LOWRANK_BYTES, RunFc1LowRank },
+    { "Fc2_400_10",                "float", 2.0 * FC2_MACS,   FC2_BYTES,   RunFc2 },
+    { "Softmax",                   "float", FC2_NBOUTPUT,     sizeof(fc2_output) + sizeof(softmax_output),
+      RunSoftmax },                                                                 // one exp per class
+    { "Predict",                   "float", FC2_NBOUTPUT,     sizeof(fc2_output), RunPredict },  // one compare per class
+};
+
+const bench_kernel_t *BenchFloatKernels(int *count)
+{
+    static int initialized = 0;
+    int y, x;
+
+    if (!initialized) {
+        // Trained-model-like ranges, every layer is run once so its output feeds the next one
+        srand(1);
+        Fill((float *)input, sizeof(input) / sizeof(float), 0.0f, 1.0f);
+        Fill((float *)conv1_kernel, sizeof(conv1_kernel) / sizeof(float), -0.5f, 0.5f);
+        Fill(conv1_bias, CONV1_NBOUTPUT, -0.1f, 0.1f);
+        Fill((float *)conv2_kernel, sizeof(conv2_kernel) / sizeof(float), -0.1f, 0.1f);
+        Fill(conv2_bias, CONV2_NBOUTPUT, -0.1f, 0.1f);
+        Fill((float *)fc1_kernel, sizeof(fc1_kernel) / sizeof(float), -0.05f, 0.05f);
+        Fill(fc1_bias, FC1_NBOUTPUT, -0.1f, 0.1f);
+        Fill((float *)fc2_kernel, sizeof(fc2_kernel) / sizeof(float), -0.1f, 0.1f);
+        Fill(fc2_bias, FC2_NBOUTPUT, -0.1f, 0.1f);
+        for (y = 0; y < IMG_HEIGHT; y++)
+            for (x = 0; x < IMG_WIDTH; x++)
+                input_digit[0][y][x] = (y < 6 || y >= IMG_HEIGHT - 6 || x < 6 || x >= IMG_WIDTH - 6) ? 0.0f : input[0][y][x];
+        PruneToCsr(&conv2_kernel[0][0][0][0], CONV2_NBOUTPUT, sizeof(conv2_kernel) / sizeof(float), &conv2_csr);
+        PruneToCsr(&fc1_kernel[0][0][0][0], FC1_NBOUTPUT, sizeof(fc1_kernel) / sizeof(float), &fc1_csr);
+        Fc1LowRank(fc1_kernel, BENCH_FC1_RANK, &fc1_lowrank);
+        ClusterFit(&conv2_kernel[0][0][0][0], sizeof(conv2_kernel) / sizeof(float), BENCH_CLUSTER_CENTROIDS, &conv2_cb);
+        ClusterFit(&fc1_kernel[0][0][0][0], sizeof(fc1_kernel) / sizeof(float), BENCH_CLUSTER_CENTROIDS, &fc1_cb);
+        XnorConv2(conv2_kernel, &conv2_xnor);
+        XnorFc1(fc1_kernel, &fc1_xnor);
+        RunConv1(); RunPool1(); RunConv2(); RunPool2(); RunFc1(); RunFc2();
+        Fill((float *)input_lanes, sizeof(input_lanes) / sizeof(float), 0.0f, 1.0f);
+        RunConv1Lanes(); RunPool1Lanes(); RunConv2Lanes(); RunPool2Lanes(); RunFc1Lanes(); RunFc2Lanes();
+        HalfFromFloat(&conv2_kernel[0][0][0][0], &conv2_kernel_fp16[0][0][0][0],
+                      sizeof(conv2_kernel) / sizeof(float), HALF_FP16);
+        HalfFromFloat(&conv2_kernel[0][0][0][0], &conv2_kernel_bf16[0][0][0][0],
+                      sizeof(conv2_kernel) / sizeof(float), HALF_BF16);
+        HalfFromFloat(&fc1_kernel[0][0][0][0], &fc1_kernel_fp16[0][0][0][0], sizeof(fc1_kernel) / sizeof(float),
+                      HALF_FP16);
+        HalfFromFloat(&fc1_kernel[0][0][0][0], &fc1_kernel_bf16[0][0][0][0], sizeof(fc1_kernel) / sizeof(float),
+                      HALF_BF16);
+        HalfFromFloat(&pool1_output[0][0][0], &pool1_half[0][0][0], sizeof(pool1_output) / sizeof(float), HALF_FP16);
+        HalfFromFloat(&pool2_output[0][0][0], &pool2_half[0][0][0], sizeof(pool2_output) / sizeof(float), HALF_FP16);
+        initialized = 1;
+    }
+    *count = sizeof(kernels) / sizeof(kernels[0]);
+    return kernels;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file binarize.c
+ * @brief Float side of the binarized mode and its command line front end, see binarize.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../FLOAT/lenet_cnn_float.h"
+#include "../FIXED/weights_float.h"
+#include "binarize.h"
+
+static lenet_float_weights_t weights;
+static xnor_t conv2_xnor, fc1_xnor;
+static int mask = 0;
+
+void BinarizeFloat(const char *model_filename, int layers)
+{
+    static int loaded = 0;
+
+    if (!loaded) {
+        ReadFloatWeights((char *)model_filename, &weights);
+        loaded = 1;
+    }
+    XnorFree(&conv2_xnor);
+    XnorFree(&fc1_xnor);
+    mask = layers;
+    if (mask & XNOR_CONV2)
+        XnorConv2(weights.conv2_kernel, &conv2_xnor);
+    if (mask & XNOR_FC1)
+        XnorFc1(weights.fc1_kernel, &fc1_xnor);
+}
+
+static void Conv2Xnor(void *input, void *output)
+{
+    Conv2_12x12x20_5x5x40_1_0_xnor(input, &conv2_xnor, weights.conv2_bias, output);
+}
+
+static void Fc1Xnor(void *input, void *output)
+{
+    Fc1_40_400_xnor(input, &fc1_xnor, weights.fc1_bias, output);
+}
+
+void BinarizeFloatEval(const dataset_t *dataset, pipeline_reference_t *reference, xnor_result_t *result)
+{
+    pipeline_t pipeline = { PIPELINE_FLOAT, &weights, 0, NULL, NULL, NULL, NULL };
+
+    if (mask & XNOR_CONV2)
+        pipeline.conv2 = Conv2Xnor;
+    if (mask & XNOR_FC1)
+        pipeline.fc1 = Fc1Xnor;
+    PipelineEval(&pipeline, dataset, reference, &result->eval);
+    result->bytes = (mask & XNOR_CONV2 ? XnorBytes(&conv2_xnor) : (long)sizeof(weights.conv2_kernel))
+                    + (mask & XNOR_FC1 ? XnorBytes(&fc1_xnor) : (long)sizeof(weights.fc1_kernel));
+}
+
+static void PrintHeader(void)
+{
+    printf("%-9s %-6s %9s %9s %8s", "precision", "1-bit", "KB", "agree", "speedup");
+    PipelinePrintHeader();
+}
+
+static void PrintRow(const char *precision, const char *layers, const xnor_result_t *r, double ns_dense, int count)
+{
+    printf("%-9s %-6s %9.1f %8.1f%% %7.1fx", precision, layers, r->bytes / 1024.0,
+           count ? 100.0 * r->eval.same / count : 0.0, r->eval.ns_image > 0 ? ns_dense / r->eval.ns_image : 0.0);
+    PipelinePrintColumns(&r->eval, count);
+}
+
+/// @brief Command line front end: [-m model] [-d dir] [-n max_images]
+int XnorMain(int argc, char **argv)
+{
+    const char *model = ENGINE_DEFAULT_MODEL, *dir = ENGINE_DEFAULT_DATASET;
+    const char *layers[4] = { "dense", "Conv2", "FC1", "both" };     // by XNOR_CONV2 | XNOR_FC1 mask
+    pipeline_reference_t reference;
+    int max_images = -1, k;
+    xnor_result_t dense_result, r;
+    dataset_t dataset;
+
+    for (k = 1; k < argc; k++) {
+        if (strcmp(argv[k], "-m") == 0 && k + 1 < argc)
+            model = argv[++k];
+        else if (strcmp(argv[k], "-d") == 0 && k + 1 < argc)
+            dir = argv[++k];
+        else if (strcmp(argv[k], "-n") == 0 && k + 1 < argc)
+            max_images = atoi(argv[++k]);
+        else {
+            printf("Usage: %s [-m model] [-d dir] [-n max_images]\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    DatasetLoad(dir, max_images, &dataset);
+    PipelineReferenceInit(&reference, dataset.count);
+    printf("Binarized Conv2 and FC1 (1-bit weights and activations, XOR + popcount), %d images, 1 thread\n",
+           dataset.count);
+    printf("agree: same class as the dense float pipeline, speedup: against the dense pipeline of the same "
+           "precision\n\n");
+    PrintHeader();
+
+    // The dense float run records the reference
+    BinarizeFloat(model, 0);
+    BinarizeFloatEval(&dataset, &reference, &dense_result);
+    PrintRow("float", layers[0], &dense_result, dense_result.eval.ns_image, dataset.count);
+    for (k = 1; k < 4; k++) {
+        BinarizeFloat(model, k);
+        BinarizeFloatEval(&dataset, &reference, &r);
+        PrintRow("float", layers[k], &r, dense_result.eval.ns_image, dataset.count);
+    }
+    BinarizeFloat(model, 0);
+
+    for (k = 0; k < 4; k++) {
+        BinarizeFixed(k);
+        BinarizeFixedEval(&dataset, &reference, &r);
+        if (k == 0)
+            dense_result = r;
+        PrintRow("fixed", layers[k], &r, dense_result.eval.ns_image, dataset.count);
+    }
+    BinarizeFixed(0);
+
+    PipelineReferenceFree(&reference);
+    DatasetFree(&dataset);
+    return 0;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file binarize.h
+ * @brief Binarized Conv2 and FC1: accuracy and throughput of the XNOR-popcount mode against the dense builds
+ *
+ * Conv2 and FC1 run on 1-bit weights and activations (../FLOAT/xnor.c,
+ * ../FIXED/xnor_fixed.c): each row is the signs of its weights times their
+ * mean magnitude, each layer input is cut at its mean on two levels, and a
+ * dot product is an XOR and a popcount per 64 weights. Conv1, the pools and
+ * FC2 stay dense, in float or in Q8, for accuracy. The test set runs
+ * through the per-layer harness (pipeline.h), in the dense float and fixed
+ * pipelines and in both with Conv2, FC1 and both layers binarized, so that
+ * the loss of each layer shows, each run compared with the dense float one.
+ * No retraining:
+ * the accuracy is that of the trained weights binarized as they are.
+ */
+
+#ifndef BINARIZE_H
+#define BINARIZE_H
+
+#include "pipeline.h"
+
+#define XNOR_CONV2 1                    // layer masks of BinarizeFloat / BinarizeFixed
+#define XNOR_FC1   2
+
+typedef struct {
+    long              bytes;            // Conv2 + FC1 weight storage
+    pipeline_result_t eval;
+} xnor_result_t;
+
+// Binarize the layers of mask (XNOR_CONV2 | XNOR_FC1) of the float model (loaded on first call), the
+// others dense; 0 restores the dense model. Eval compares with reference, recorded by its first run
+void BinarizeFloat(const char *model_filename, int mask);
+void BinarizeFloatEval(const dataset_t *dataset, pipeline_reference_t *reference, xnor_result_t *result);
+
+// Same on the Q8 weights of weights.h (binarize_fixed.c)
+void BinarizeFixed(int mask);
+void BinarizeFixedEval(const dataset_t *dataset, pipeline_reference_t *reference, xnor_result_t *result);
+
+int XnorMain(int argc, char **argv);
+
+#endif // BINARIZE_H
@@ -0,0 +1,47 @@
+/**
+ * @file binarize_fixed.c
+ * @brief Fixed-point side of the binarized mode: the Q8 weights of weights.h, see binarize.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../FIXED/lenet_cnn_fixed.h"
+#include "binarize.h"
+
+static xnor_fixed_t conv2_xnor, fc1_xnor;
+static int mask = 0;
+
+void BinarizeFixed(int layers)
+{
+    XnorFree_fixed(&conv2_xnor);
+    XnorFree_fixed(&fc1_xnor);
+    mask = layers;
+    if (mask & XNOR_CONV2)
+        XnorConv2_fixed(CONV2_KERNEL, &conv2_xnor);
+    if (mask & XNOR_FC1)
+        XnorFc1_fixed(FC1_KERNEL, &fc1_xnor);
+}
+
+static void Conv2Xnor(void *input, void *output)
+{
+    Conv2_12x12x20_5x5x40_1_0_xnor_fixed(input, &conv2_xnor, CONV2_BIAS, output);
+}
+
+static void Fc1Xnor(void *input, void *output)
+{
+    Fc1_40_400_xnor_fixed(input, &fc1_xnor, FC1_BIAS, output);
+}
+
+void BinarizeFixedEval(const dataset_t *dataset, pipeline_reference_t *reference, xnor_result_t *result)
+{
+    pipeline_t pipeline = { PIPELINE_FIXED, NULL, 0, NULL, NULL, NULL, NULL };
+
+    if (mask & XNOR_CONV2)
+        pipeline.conv2 = Conv2Xnor;
+    if (mask & XNOR_FC1)
+        pipeline.fc1 = Fc1Xnor;
+    PipelineEval(&pipeline, dataset, reference, &result->eval);
+    result->bytes = (mask & XNOR_CONV2 ? XnorBytes_fixed(&conv2_xnor) : (long)sizeof(CONV2_KERNEL))
+                    + (mask & XNOR_FC1 ? XnorBytes_fixed(&fc1_xnor) : (long)sizeof(FC1_KERNEL));
+}
@@ -0,0 +1,220 @@
+/**
+ * @file clustering.c
+ * @brief Float side of the weight clustering sweep and its command line front end, see clustering.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../FLOAT/lenet_cnn_float.h"
+#include "../FIXED/weights_float.h"
+#include "clustering.h"
+
+#define CONV2_WEIGHTS (CONV2_NBOUTPUT * POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM)
+#define FC1_WEIGHTS   (FC1_NBOUTPUT * POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+#define CLUSTER_MAX_SWEEP 32
+
+static lenet_float_weights_t weights;
+static codebook_t conv2_cb, fc1_cb;
+static int dense = 1;
+
+/// @brief Sum of the squared differences between the dense weights and their centroids
+static double SquaredError(const float *w, const codebook_t *cb)
+{
+    double sum = 0.0, d;
+    int i;
+
+    for (i = 0; i < cb->size; i++) {
+        d = (double)w[i] - cb->centroid[CLUSTER_INDEX(cb, i)];
+        sum += d * d;
+    }
+    return sum;
+}
+
+void ClusterFloat(const char *model_filename, int nb_centroids)
+{
+    static int loaded = 0;
+
+    if (!loaded) {
+        ReadFloatWeights((char *)model_filename, &weights);
+        loaded = 1;
+    }
+    ClusterFree(&conv2_cb);
+    ClusterFree(&fc1_cb);
+    dense = (nb_centroids <= 0);
+    if (dense)
+        return;
+
+    ClusterFit(&weights.conv2_kernel[0][0][0][0], CONV2_WEIGHTS, nb_centroids, &conv2_cb);
+    ClusterFit(&weights.fc1_kernel[0][0][0][0], FC1_WEIGHTS, nb_centroids, &fc1_cb);
+}
+
+static void Conv2Cluster(void *input, void *output)
+{
+    Conv2_12x12x20_5x5x40_1_0_cluster(input, &conv2_cb, weights.conv2_bias, output);
+}
+
+static void Fc1Cluster(void *input, void *output)
+{
+    Fc1_40_400_cluster(input, &fc1_cb, weights.fc1_bias, output);
+}
+
+void ClusterFloatEval(const dataset_t *dataset, cluster_result_t *result)
+{
+    pipeline_t pipeline = { PIPELINE_FLOAT, &weights, 0, NULL, NULL, NULL, NULL };
+    long other = sizeof(weights) - sizeof(weights.conv2_kernel) - sizeof(weights.fc1_kernel);
+
+    if (!dense) {
+        pipeline.conv2 = Conv2Cluster;
+        pipeline.fc1 = Fc1Cluster;
+    }
+    PipelineEval(&pipeline, dataset, NULL, &result->eval);
+    if (dense) {
+        result->bytes = sizeof(weights.conv2_kernel) + sizeof(weights.fc1_kernel);
+        result->rms_error = 0.0;
+    } else {
+        result->bytes = ClusterBytes(&conv2_cb) + ClusterBytes(&fc1_cb);
+        result->rms_error = sqrt((SquaredError(&weights.conv2_kernel[0][0][0][0], &conv2_cb)
+                                  + SquaredError(&weights.fc1_kernel[0][0][0][0], &fc1_cb))
+                                 / (CONV2_WEIGHTS + FC1_WEIGHTS));
+    }
+    result->model_bytes = result->bytes + other;
+}
+
+void ClusterFloatWrite(FILE *file)
+{
+    ClusterWrite(file, &conv2_cb);
+    ClusterWrite(file, &fc1_cb);
+}
+
+void ClusterFloatRead(FILE *file)
+{
+    ClusterFree(&conv2_cb);
+    ClusterFree(&fc1_cb);
+    ClusterRead(file, &conv2_cb);
+    ClusterRead(file, &fc1_cb);
+    if (conv2_cb.size != CONV2_WEIGHTS || fc1_cb.size != FC1_WEIGHTS) {
+        printf("Error: Codebooks do not match the Conv2 and FC1 dimensions.\n");
+        exit(1);
+    }
+    dense = 0;
+}
+
+static void PrintHeader(const char *precision)
+{
+    printf("%-6s %9s %4s %12s %9s %8s %9s", precision, "centroids", "bits", "Conv2+FC1 KB", "model KB", "smaller",
+           "rms err");
+    PipelinePrintHeader();
+}
+
+static void PrintRow(const char *centroids, int bits, const cluster_result_t *r, long float_bytes, int count)
+{
+    printf("%-6s %9s %4d %12.1f %9.1f %7.1fx %9.5f", "", centroids, bits, r->bytes / 1024.0, r->model_bytes / 1024.0,
+           (double)float_bytes / r->model_bytes, r->rms_error);
+    PipelinePrintColumns(&r->eval, count);
+}
+
+/// @brief Command line front end: [-m model] [-d dir] [-n max_images] [-k centroids,...] [-t target] [-o model.cbk]
+int ClusterMain(int argc, char **argv)
+{
+    const char *model = ENGINE_DEFAULT_MODEL, *dir = ENGINE_DEFAULT_DATASET, *output = NULL;
+    char sweep_list[256] = CLUSTER_DEFAULT_SWEEP, *token;
+    int sweep[CLUSTER_MAX_SWEEP], target = CLUSTER_DEFAULT_TARGET;
+    int max_images = -1, nb_sweep = 0, k;
+    long float_bytes;
+    cluster_result_t r;
+    dataset_t dataset;
+    char label[16];
+    FILE *file;
+
+    for (k = 1; k < argc; k++) {
+        if (strcmp(argv[k], "-m") == 0 && k + 1 < argc)
+            model = argv[++k];
+        else if (strcmp(argv[k], "-d") == 0 && k + 1 < argc)
+            dir = argv[++k];
+        else if (strcmp(argv[k], "-n") == 0 && k + 1 < argc)
+            max_images = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-k") == 0 && k + 1 < argc)
+            snprintf(sweep_list, sizeof(sweep_list), "%s", argv[++k]);
+        else if (strcmp(argv[k], "-t") == 0 && k + 1 < argc)
+            target = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-o") == 0 && k + 1 < argc)
+            output = argv[++k];
+        else {
+            printf("Usage: %s [-m model] [-d dir] [-n max_images] [-k centroids,...] [-t target] [-o model.cbk]\n",
+                   argv[0]);
+            exit(1);
+        }
+    }
+    for (token = strtok(sweep_list, ","); token && nb_sweep < CLUSTER_MAX_SWEEP; token = strtok(NULL, ","))
+        sweep[nb_sweep++] = atoi(token);
+    for (k = 0; k <= nb_sweep; k++) {
+        int n = k < nb_sweep ? sweep[k] : target;
+
+        if (n < 2 || n > CLUSTER_MAX_CENTROIDS) {
+            printf("Error: %d centroids out of [2, %d].\n", n, CLUSTER_MAX_CENTROIDS);
+            exit(1);
+        }
+    }
+
+    DatasetLoad(dir, max_images, &dataset);
+    printf("K-means weight sharing of Conv2 (%d weights) and FC1 (%d weights), %d images, 1 thread\n\n",
+           CONV2_WEIGHTS, FC1_WEIGHTS, dataset.count);
+
+    PrintHeader("float");
+    ClusterFloat(model, 0);
+    ClusterFloatEval(&dataset, &r);
+    float_bytes = r.model_bytes;
+    PrintRow("dense", 32, &r, float_bytes, dataset.count);
+    for (k = 0; k < nb_sweep; k++) {
+        ClusterFloat(model, sweep[k]);
+        ClusterFloatEval(&dataset, &r);
+        snprintf(label, sizeof(label), "%d", sweep[k]);
+        PrintRow(label, sweep[k] <= 16 ? 4 : 8, &r, float_bytes, dataset.count);
+    }
+
+    printf("\n");
+    PrintHeader("fixed");
+    ClusterFixed(0);
+    ClusterFixedEval(&dataset, &r);
+    PrintRow("dense", 16, &r, float_bytes, dataset.count);
+    for (k = 0; k < nb_sweep; k++) {
+        ClusterFixed(sweep[k]);
+        ClusterFixedEval(&dataset, &r);
+        snprintf(label, sizeof(label), "%d", sweep[k]);
+        PrintRow(label, sweep[k] <= 16 ? 4 : 8, &r, float_bytes, dataset.count);
+    }
+
+    if (output) {
+        file = fopen(output, "wb");
+        if (!file) {
+            printf("Error: Unable to open file %s.\n", output);
+            exit(1);
+        }
+        ClusterFloat(model, target);
+        ClusterFixed(target);
+        ClusterFloatWrite(file);
+        ClusterFixedWrite(file);
+        fclose(file);
+
+        // Read back what was written and evaluate it again
+        file = fopen(output, "rb");
+        if (!file) {
+            printf("Error: Unable to open file %s.\n", output);
+            exit(1);
+        }
+        ClusterFloatRead(file);
+        ClusterFixedRead(file);
+        fclose(file);
+        printf("\nCodebooks of %d centroids written to %s, read back:\n", target, output);
+        ClusterFloatEval(&dataset, &r);
+        printf("  float: %d errors, Conv2 + FC1 %.1f KB\n", r.eval.errors, r.bytes / 1024.0);
+        ClusterFixedEval(&dataset, &r);
+        printf("  fixed: %d errors, Conv2 + FC1 %.1f KB\n", r.eval.errors, r.bytes / 1024.0);
+    }
+
+    DatasetFree(&dataset);
+    return 0;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file clustering.h
+ * @brief K-means weight sharing of Conv2 and FC1: codebook size / accuracy / latency sweep and export
+ *
+ * For each codebook size k, the weights of Conv2 and of FC1 are clustered
+ * layer by layer on k shared values (1-D k-means, ../FLOAT/cluster.c,
+ * ../FIXED/cluster_fixed.c), in the float model and in the Q8 weights of
+ * weights.h separately. Each weight is then stored as the index of its
+ * centroid: 4 bits up to 16 centroids, 8 bits up to 256. The test set runs
+ * through the clustered kernels in the per-layer harness (pipeline.h); the
+ * other layers stay dense. No retraining. The
+ * codebooks of the chosen size can be written to a file (float Conv2, float
+ * FC1, fixed Conv2, fixed FC1) and are read back and evaluated again.
+ */
+
+#ifndef CLUSTERING_H
+#define CLUSTERING_H
+
+#include <stdio.h>
+
+#include "pipeline.h"
+
+#define CLUSTER_DEFAULT_SWEEP  "4,8,16,32,64,256"
+#define CLUSTER_DEFAULT_TARGET 16
+
+typedef struct {
+    long   bytes;                       // Conv2 + FC1 weight storage
+    long   model_bytes;                 // whole model, the other layers and the biases dense
+    double rms_error;                   // RMS of the weight change over Conv2 + FC1, in weight units
+    pipeline_result_t eval;
+} cluster_result_t;
+
+// Cluster the float model (loaded on first call) on nb_centroids values, or restore the dense kernels when 0
+void ClusterFloat(const char *model_filename, int nb_centroids);
+void ClusterFloatEval(const dataset_t *dataset, cluster_result_t *result);
+void ClusterFloatWrite(FILE *file);
+void ClusterFloatRead(FILE *file);
+
+// Same on the Q8 weights of weights.h (clustering_fixed.c)
+void ClusterFixed(int nb_centroids);
+void ClusterFixedEval(const dataset_t *dataset, cluster_result_t *result);
+void ClusterFixedWrite(FILE *file);
+void ClusterFixedRead(FILE *file);
+
+int ClusterMain(int argc, char **argv);
+
+#endif // CLUSTERING_H
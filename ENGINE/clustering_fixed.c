@@ -0,0 +1,95 @@
+/**
+ * @file clustering_fixed.c
+ * @brief Fixed-point side of the weight clustering sweep: the Q8 weights of weights.h, see clustering.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "../FIXED/lenet_cnn_fixed.h"
+#include "clustering.h"
+
+#define CONV2_WEIGHTS (CONV2_NBOUTPUT * POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM)
+#define FC1_WEIGHTS   (FC1_NBOUTPUT * POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+
+static codebook_fixed_t conv2_cb, fc1_cb;
+static int dense = 1;
+
+/// @brief Sum of the squared differences between the dense Q8 weights and their centroids
+static double SquaredError(const short *w, const codebook_fixed_t *cb)
+{
+    double sum = 0.0, d;
+    int i;
+
+    for (i = 0; i < cb->size; i++) {
+        d = w[i] - cb->centroid[CLUSTER_INDEX(cb, i)];
+        sum += d * d;
+    }
+    return sum;
+}
+
+void ClusterFixed(int nb_centroids)
+{
+    ClusterFree_fixed(&conv2_cb);
+    ClusterFree_fixed(&fc1_cb);
+    dense = (nb_centroids <= 0);
+    if (dense)
+        return;
+
+    ClusterFit_fixed(&CONV2_KERNEL[0][0][0][0], CONV2_WEIGHTS, nb_centroids, &conv2_cb);
+    ClusterFit_fixed(&FC1_KERNEL[0][0][0][0], FC1_WEIGHTS, nb_centroids, &fc1_cb);
+}
+
+static void Conv2Cluster(void *input, void *output)
+{
+    Conv2_12x12x20_5x5x40_1_0_cluster_fixed(input, &conv2_cb, CONV2_BIAS, output);
+}
+
+static void Fc1Cluster(void *input, void *output)
+{
+    Fc1_40_400_cluster_fixed(input, &fc1_cb, FC1_BIAS, output);
+}
+
+void ClusterFixedEval(const dataset_t *dataset, cluster_result_t *result)
+{
+    pipeline_t pipeline = { PIPELINE_FIXED, NULL, 0, NULL, NULL, NULL, NULL };
+    long other = sizeof(CONV1_KERNEL) + sizeof(CONV1_BIAS) + sizeof(CONV2_BIAS) + sizeof(FC1_BIAS)
+                 + sizeof(FC2_KERNEL) + sizeof(FC2_BIAS);
+
+    if (!dense) {
+        pipeline.conv2 = Conv2Cluster;
+        pipeline.fc1 = Fc1Cluster;
+    }
+    PipelineEval(&pipeline, dataset, NULL, &result->eval);
+    if (dense) {
+        result->bytes = sizeof(CONV2_KERNEL) + sizeof(FC1_KERNEL);
+        result->rms_error = 0.0;
+    } else {
+        // In weight units, as the float side
+        result->bytes = ClusterBytes_fixed(&conv2_cb) + ClusterBytes_fixed(&fc1_cb);
+        result->rms_error = sqrt((SquaredError(&CONV2_KERNEL[0][0][0][0], &conv2_cb)
+                                  + SquaredError(&FC1_KERNEL[0][0][0][0], &fc1_cb))
+                                 / (CONV2_WEIGHTS + FC1_WEIGHTS)) / (1 << FIXED_POINT);
+    }
+    result->model_bytes = result->bytes + other;
+}
+
+void ClusterFixedWrite(FILE *file)
+{
+    ClusterWrite_fixed(file, &conv2_cb);
+    ClusterWrite_fixed(file, &fc1_cb);
+}
+
+void ClusterFixedRead(FILE *file)
+{
+    ClusterFree_fixed(&conv2_cb);
+    ClusterFree_fixed(&fc1_cb);
+    ClusterRead_fixed(file, &conv2_cb);
+    ClusterRead_fixed(file, &fc1_cb);
+    if (conv2_cb.size != CONV2_WEIGHTS || fc1_cb.size != FC1_WEIGHTS) {
+        printf("Error: Codebooks do not match the Conv2 and FC1 dimensions.\n");
+        exit(1);
+    }
+    dense = 0;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file dataset.c
+ * @brief MNIST test set loader of the inference engine, see engine.h
+ *
+ * Everything is read into memory before any timing starts. The raw
+ * t10k-images-idx3-ubyte file is used when present (one read); otherwise
+ * the per-image PGM files of the original drivers are read.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../FLOAT/lenet_cnn_float.h"
+#include "engine.h"
+
+#define LABELS_FILE "t10k-labels-idx1-ubyte"
+#define IMAGES_FILE "t10k-images-idx3-ubyte"
+
+void DatasetLoad(const char *dir, int max_images, dataset_t *dataset)
+{
+    char filename[256];
+    FILE *file;
+    long size;
+    int m;
+
+    snprintf(filename, sizeof(filename), "%s/%s", dir, LABELS_FILE);
+    file = fopen(filename, "rb");
+    if (!file) {
+        printf("Error: Unable to open file %s.\n", filename);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file) - 8;             // 8 header bytes
+    if (size < 0)
+        size = 0;
+    if (max_images >= 0 && size > max_images)
+        size = max_images;
+    dataset->count = (int)size;
+    dataset->labels = malloc(size + 1);
+    dataset->images = malloc((size + 1) * ENGINE_IMG_SIZE);
+    if (!dataset->labels || !dataset->images) {
+        printf("Error: Unable to allocate %ld images.\n", size);
+        exit(1);
+    }
+    fseek(file, 8, SEEK_SET);
+    dataset->count = (int)fread(dataset->labels, 1, size, file);
+    fclose(file);
+
+    snprintf(filename, sizeof(filename), "%s/%s", dir, IMAGES_FILE);
+    file = fopen(filename, "rb");
+    if (file) {
+        fseek(file, 16, SEEK_SET);      // 16 header bytes
+        m = (int)fread(dataset->images, ENGINE_IMG_SIZE, dataset->count, file);
+        fclose(file);
+        if (m < dataset->count)
+            dataset->count = m;
+        return;
+    }
+    for (m = 0; m < dataset->count; m++) {
+        snprintf(filename, sizeof(filename), "%s/%s[%05d].pgm", dir, IMAGES_FILE, m);
+        ReadPgmFile(filename, dataset->images + (size_t)m * ENGINE_IMG_SIZE);
+    }
+}
+
+/// @brief One 28x28 PGM image, e.g. for lenet classify
+void DatasetReadImage(const char *filename, unsigned char pixels[ENGINE_IMG_SIZE])
+{
+    ReadPgmFile((char *)filename, pixels);
+}
+
+void DatasetFree(dataset_t *dataset)
+{
+    free(dataset->images);
+    free(dataset->labels);
+    dataset->images = dataset->labels = NULL;
+    dataset->count = 0;
+}
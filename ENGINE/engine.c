@@ -0,0 +1,118 @@
+/**
+ * @file engine.c
+ * @brief Precision dispatch of the inference engine, see engine.h
+ */
+
+#include <string.h>
+
+#include "engine.h"
+
+static const char *precision_names[PRECISION_NB] = { "float", "fixed", "cascade", "mixed", "lanes" };
+static const char *layer_precision_names[LAYER_PRECISION_NB] = { "fp32", "fp16", "int16", "int8" };
+static float cascade_margin = ENGINE_DEFAULT_CASCADE_MARGIN;
+static layer_precision_t layers[ENGINE_NB_LAYERS];     // LAYER_FP32, the float model
+
+/// @brief Returns 0 and sets *precision if name is known, -1 otherwise
+int PrecisionFromName(const char *name, precision_t *precision)
+{
+    int p;
+
+    for (p = 0; p < PRECISION_NB; p++)
+        if (strcmp(name, precision_names[p]) == 0) {
+            *precision = (precision_t)p;
+            return 0;
+        }
+    return -1;
+}
+
+const char *PrecisionName(precision_t precision)
+{
+    return precision_names[precision];
+}
+
+int LayersFromString(const char *list, layer_precision_t parsed[ENGINE_NB_LAYERS])
+{
+    char name[16];
+    int l, p, n;
+
+    for (l = 0; l < ENGINE_NB_LAYERS; l++) {
+        n = (int)strcspn(list, ",");
+        if (n == 0 || n >= (int)sizeof(name))
+            return -1;
+        memcpy(name, list, n);
+        name[n] = '\0';
+        for (p = 0; p < LAYER_PRECISION_NB && strcmp(name, layer_precision_names[p]) != 0; p++)
+            ;
+        if (p == LAYER_PRECISION_NB)
+            return -1;
+        parsed[l] = (layer_precision_t)p;
+        list += n;
+        if (*list == ',')
+            list++;
+        else if (l != ENGINE_NB_LAYERS - 1)
+            return -1;
+    }
+    return *list == '\0' ? 0 : -1;
+}
+
+const char *LayerPrecisionName(layer_precision_t precision)
+{
+    return layer_precision_names[precision];
+}
+
+/// @brief Load what the precision needs, call before the classification threads start
+void EngineInit(const char *model_filename, precision_t precision)
+{
+    if (precision == PRECISION_FLOAT || precision == PRECISION_CASCADE || precision == PRECISION_LANES)
+        EngineFloatInit(model_filename);
+    if (precision == PRECISION_MIXED)
+        EngineMixedInit(model_filename);
+}
+
+/// @brief Fixed top-2 margin under which the cascade escalates to float, set before the threads start
+void EngineSetCascadeMargin(float margin)
+{
+    cascade_margin = margin;
+}
+
+/// @brief Precision of each layer of the mixed precision, Conv1 first; can change between evaluations
+void EngineSetLayers(const layer_precision_t precisions[ENGINE_NB_LAYERS])
+{
+    memcpy(layers, precisions, sizeof(layers));
+}
+
+/// @brief Cheap fixed pipeline first, float only for the ambiguous images
+static void EngineCascadeClassify(const unsigned char *pixels, engine_prediction_t *pred, float *probs)
+{
+    EngineFixedClassify(pixels, pred, probs);
+    if (pred->margin < cascade_margin) {
+        EngineFloatClassify(pixels, pred, probs);
+        pred->escalated = 1;
+    }
+}
+
+void EngineClassify(precision_t precision, const unsigned char *pixels, engine_prediction_t *pred,
+                    float probs[ENGINE_NB_CLASSES])
+{
+    switch (precision) {
+    case PRECISION_FLOAT: EngineFloatClassify(pixels, pred, probs); break;
+    case PRECISION_FIXED: EngineFixedClassify(pixels, pred, probs); break;
+    case PRECISION_CASCADE: EngineCascadeClassify(pixels, pred, probs); break;
+    case PRECISION_MIXED: EngineMixedClassify(layers, pixels, pred, probs); break;
+    case PRECISION_LANES: EngineFloatClassifyLanes(pixels, 1, pred, probs); break;
+    default: break;
+    }
+}
+
+void EngineClassifyBatch(precision_t precision, const unsigned char *pixels, int count, engine_prediction_t *preds)
+{
+    int m, n;
+
+    for (m = 0; m < count; m += n) {
+        n = precision == PRECISION_LANES ? (count - m < ENGINE_LANES ? count - m : ENGINE_LANES) : 1;
+        if (precision == PRECISION_LANES)
+            EngineFloatClassifyLanes(pixels + (long)m * ENGINE_IMG_SIZE, n, &preds[m], NULL);
+        else
+            EngineClassify(precision, pixels + (long)m * ENGINE_IMG_SIZE, &preds[m], NULL);
+    }
+}
@@ -0,0 +1,114 @@
+/**
+ * @file engine.h
+ * @brief Host inference engine running the float and fixed LeNet-5 pipelines
+ *
+ * Runs the layers of the HLS tops (lenet_cnn, lenet_cnn_fixed) behind one call
+ * taking raw 8-bit pixels, so the drivers do not depend on either pipeline's
+ * headers. The tops stay dense for synthesis; the host passes crop Conv1 to
+ * the bounding box of the input pixels and switch Conv2 and FC1 to their
+ * sparse kernels when the input density is below CONV2_SPARSE_DENSITY /
+ * FC1_SPARSE_DENSITY, and count both per thread (EngineFloatDensity,
+ * EngineFixedDensity).
+ * The float weights are read from the HDF5 model on first use; the fixed
+ * pipeline uses the Q8 weights compiled from weights.h.
+ * The cascade precision runs the fixed pipeline first and escalates to the
+ * float one only when the fixed top-2 margin is below a threshold.
+ * The float FC1 can run as two thin products of its truncated SVD, the
+ * factorization done once at load time (EngineSetFc1Rank).
+ * The mixed precision runs each layer in its own precision, fp32, fp16,
+ * int16 (Q8 shorts) or int8, all quantized from the float model at load
+ * time, and converts the activations between layers (EngineSetLayers).
+ * The lanes precision runs the float model on ENGINE_LANES images at once,
+ * interleaved so that each SIMD lane holds a different image, with the
+ * predictions of float (EngineClassifyBatch).
+ * EngineClassify() only reads shared data and can run in parallel threads.
+ */
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#define ENGINE_IMG_SIZE    (28 * 28)
+#define ENGINE_NB_CLASSES  10
+#define ENGINE_DEFAULT_MODEL   "../FLOAT/lenet_weights.weights.h5"
+#define ENGINE_DEFAULT_DATASET "mnist"
+#define ENGINE_DEFAULT_CASCADE_MARGIN 1.0f     // fixed logit units
+#define ENGINE_FC1_MAX_RANK 400                 // min(400, 640): full-rank FC1 factors
+#define ENGINE_NB_LAYERS   4                    // mixed precision: Conv1 + Pool1, Conv2 + Pool2, FC1, FC2
+#define ENGINE_DEFAULT_LAYERS "fp32,fp32,fp32,fp32"
+#ifdef __AVX512F__
+#define ENGINE_LANES       16                   // lanes precision: images per call, LANES of lenet_cnn_float.h
+#else
+#define ENGINE_LANES       8
+#endif
+
+typedef enum {
+    PRECISION_FLOAT,
+    PRECISION_FIXED,
+    PRECISION_CASCADE,          // fixed, float when the fixed margin is low
+    PRECISION_MIXED,            // one precision per layer, see EngineSetLayers
+    PRECISION_LANES,            // float, ENGINE_LANES images interleaved in the SIMD lanes
+    PRECISION_NB
+} precision_t;
+
+typedef enum {
+    LAYER_FP32,
+    LAYER_FP16,
+    LAYER_INT16,                // Q8 shorts, the _fixed kernels
+    LAYER_INT8,                 // int8 weights and inputs, Q8 outputs
+    LAYER_PRECISION_NB
+} layer_precision_t;
+
+typedef struct {
+    unsigned char number;
+    float         margin;       // top-2 logit margin, in logit units for both precisions
+    unsigned char escalated;    // cascade only: the float pipeline gave this prediction
+} engine_prediction_t;
+
+// Activation density seen by the float or the fixed host pass in the calling thread
+typedef struct {
+    long conv1_values, conv1_positions; // Conv1 output positions per filter, inside the bounding box
+    long conv2_images, conv2_sparse;    // images through Conv2, through its sparse kernel
+    long pool1_values, pool1_nonzeros;  // Conv2 input entries, nonzero ones
+    long fc1_images, fc1_sparse;        // same for FC1, the low-rank one not counted
+    long pool2_values, pool2_nonzeros;
+} engine_density_t;
+
+typedef struct {
+    int            count;
+    unsigned char *images;      // [count][ENGINE_IMG_SIZE]
+    unsigned char *labels;      // [count]
+} dataset_t;
+
+int         PrecisionFromName(const char *name, precision_t *precision);
+const char *PrecisionName(precision_t precision);
+// Comma-separated layer precisions (fp32, fp16, int16, int8), Conv1 first; returns 0 if valid, -1 otherwise
+int         LayersFromString(const char *list, layer_precision_t layers[ENGINE_NB_LAYERS]);
+const char *LayerPrecisionName(layer_precision_t precision);
+
+void EngineInit(const char *model_filename, precision_t precision);
+void EngineSetCascadeMargin(float margin);
+void EngineSetFc1Rank(int rank);
+void EngineSetLayers(const layer_precision_t layers[ENGINE_NB_LAYERS]);
+float EngineFc1RankError(void);
+void EngineClassify(precision_t precision, const unsigned char *pixels, engine_prediction_t *pred,
+                    float probs[ENGINE_NB_CLASSES]);
+// count consecutive images [count][ENGINE_IMG_SIZE]: ENGINE_LANES per call with lanes, one by one otherwise
+void EngineClassifyBatch(precision_t precision, const unsigned char *pixels, int count, engine_prediction_t *preds);
+
+// Per-precision back ends (engine_float.c, engine_fixed.c), probs may be NULL
+void EngineFloatInit(const char *model_filename);
+void EngineFloatClassify(const unsigned char *pixels, engine_prediction_t *pred, float *probs);
+void EngineFloatClassifyLanes(const unsigned char *pixels, int count, engine_prediction_t *preds, float *probs);
+void EngineFixedClassify(const unsigned char *pixels, engine_prediction_t *pred, float *probs);
+void EngineFloatDensity(engine_density_t *density);
+void EngineFixedDensity(engine_density_t *density);
+void EngineMixedInit(const char *model_filename);
+void EngineMixedClassify(const layer_precision_t layers[ENGINE_NB_LAYERS], const unsigned char *pixels,
+                         engine_prediction_t *pred, float *probs);
+
+// MNIST test set: raw idx3 file if present in dir, else one PGM file per image (dataset.c)
+void DatasetLoad(const char *dir, int max_images, dataset_t *dataset);
+void DatasetFree(dataset_t *dataset);
+void DatasetReadImage(const char *filename, unsigned char pixels[ENGINE_IMG_SIZE]);
+
+#endif // ENGINE_H
@@ -0,0 +1,105 @@
+/**
+ * @file engine_fixed.c
+ * @brief Fixed-point back end of the inference engine: the layers of lenet_cnn_fixed + Predict_fixed, Conv1
+ *        cropped to the input bounding box, Conv2 and FC1 sparse on sparse inputs
+ */
+
+#include "../FIXED/lenet_cnn_fixed.h"
+#include "../COMMON/trace.h"
+#include "engine.h"
+
+_Static_assert(ENGINE_IMG_SIZE == IMG_DEPTH * IMG_HEIGHT * IMG_WIDTH, "image size");
+_Static_assert(ENGINE_NB_CLASSES == FC2_NBOUTPUT, "number of classes");
+
+#define POOL1_SIZE (POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH)
+#define POOL2_SIZE (POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+
+static __thread engine_density_t density;
+
+void EngineFixedDensity(engine_density_t *stats)
+{
+    *stats = density;
+}
+
+/// @brief The layers of lenet_cnn_fixed, Conv1 on the input bounding box, Conv2 and FC1 dense or sparse from the
+///        density of their input. The HLS top stays dense for synthesis
+static void LenetCnnHost_fixed(short input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH], short output[FC2_NBOUTPUT])
+{
+    short conv1_output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH];
+    short pool1_output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH];
+    short conv2_output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH];
+    short pool2_output[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+    short fc1_output[FC1_NBOUTPUT];
+    nonzero_list_fixed_t nonzeros;
+    bbox_fixed_t box;
+
+    // Empty background: full dot products only around the digit's bounding box
+    TRACE_BEGIN(TRACE_CONV1);
+    InputBoundingBox_fixed(input, &box);
+    density.conv1_positions += Conv1_28x28x1_5x5x20_1_0_crop_fixed(input, &box, CONV1_KERNEL, CONV1_BIAS,
+                                                                   conv1_output);
+    density.conv1_values += CONV1_HEIGHT * CONV1_WIDTH;
+    TRACE_END(TRACE_CONV1);
+    TRACE_BEGIN(TRACE_POOL1);
+    Pool1_24x24x20_2x2x20_2_0_fixed(conv1_output, pool1_output);
+    TRACE_END(TRACE_POOL1);
+
+    // Dense or sparse kernel from the density of the ReLU / max-pool output (identical results)
+    TRACE_BEGIN(TRACE_CONV2);
+    density.conv2_images++;
+    density.pool1_values += POOL1_SIZE;
+    density.pool1_nonzeros += NonzeroList_fixed(&pool1_output[0][0][0], POOL1_SIZE, &nonzeros);
+    if (nonzeros.count < CONV2_SPARSE_DENSITY_FIXED * POOL1_SIZE) {
+        Conv2_12x12x20_5x5x40_1_0_sparse_fixed(&nonzeros, CONV2_KERNEL, CONV2_BIAS, conv2_output);
+        density.conv2_sparse++;
+    } else
+        Conv2_12x12x20_5x5x40_1_0_fixed(pool1_output, CONV2_KERNEL, CONV2_BIAS, conv2_output);
+    TRACE_END(TRACE_CONV2);
+    TRACE_BEGIN(TRACE_POOL2);
+    Pool2_8x8x40_2x2x40_2_0_fixed(conv2_output, pool2_output);
+    TRACE_END(TRACE_POOL2);
+
+    TRACE_BEGIN(TRACE_FC1);
+    density.fc1_images++;
+    density.pool2_values += POOL2_SIZE;
+    density.pool2_nonzeros += NonzeroList_fixed(&pool2_output[0][0][0], POOL2_SIZE, &nonzeros);
+    if (nonzeros.count < FC1_SPARSE_DENSITY_FIXED * POOL2_SIZE) {
+        Fc1_40_400_sparse_fixed(&nonzeros, FC1_KERNEL, FC1_BIAS, fc1_output);
+        density.fc1_sparse++;
+    } else
+        Fc1_40_400_fixed(pool2_output, FC1_KERNEL, FC1_BIAS, fc1_output);
+    TRACE_END(TRACE_FC1);
+    TRACE_BEGIN(TRACE_FC2);
+    Fc2_400_10_fixed(fc1_output, FC2_KERNEL, FC2_BIAS, output);
+    TRACE_END(TRACE_FC2);
+}
+
+void EngineFixedClassify(const unsigned char *pixels, engine_prediction_t *pred, float *probs)
+{
+    short input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+    short output[FC2_NBOUTPUT];
+    unsigned short q15[FC2_NBOUTPUT];
+    prediction_fixed_t p;
+    int i;
+
+    // Same as the fixed driver's NormalizeImg: raw pixels, no scaling
+    TRACE_BEGIN(TRACE_NORMALIZE);
+    for (i = 0; i < ENGINE_IMG_SIZE; i++)
+        ((short *)input)[i] = pixels[i];
+    TRACE_END(TRACE_NORMALIZE);
+
+    LenetCnnHost_fixed(input, output);
+    TRACE_BEGIN(TRACE_PREDICT);
+    Predict_fixed(output, &p);
+    TRACE_END(TRACE_PREDICT);
+    pred->number = p.number;
+    pred->margin = SHORT2FLOAT(p.margin);
+    pred->escalated = 0;
+    if (probs) {
+        TRACE_BEGIN(TRACE_SOFTMAX);
+        Softmax_int_fixed(output, q15);
+        TRACE_END(TRACE_SOFTMAX);
+        for (i = 0; i < FC2_NBOUTPUT; i++)
+            probs[i] = (float)q15[i] / SOFTMAX_Q15_ONE;
+    }
+}
@@ -0,0 +1,198 @@
+/**
+ * @file engine_float.c
+ * @brief Float back end of the inference engine: NormalizeImg + the layers of lenet_cnn + Predict, Conv1 cropped
+ *        to the input bounding box, Conv2 and FC1 sparse on sparse inputs, or the _lanes kernels on ENGINE_LANES
+ *        images at once
+ */
+
+#include "../FLOAT/lenet_cnn_float.h"
+#include "../FIXED/weights_float.h"
+#include "../COMMON/trace.h"
+#include "engine.h"
+
+_Static_assert(ENGINE_IMG_SIZE == IMG_DEPTH * IMG_HEIGHT * IMG_WIDTH, "image size");
+_Static_assert(ENGINE_NB_CLASSES == FC2_NBOUTPUT, "number of classes");
+_Static_assert(ENGINE_LANES == LANES, "images per lanes call");
+
+#define POOL1_SIZE (POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH)
+#define POOL2_SIZE (POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+
+// Interleaved maps of the lanes precision, 0.6 MB with 8 lanes: per thread, off the stack
+typedef struct {
+    float input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH][LANES];
+    float conv1_output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH][LANES];
+    float pool1_output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH][LANES];
+    float conv2_output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH][LANES];
+    float pool2_output[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH][LANES];
+    float fc1_output[FC1_NBOUTPUT][LANES];
+    float output[FC2_NBOUTPUT][LANES];
+} lanes_maps_t;
+
+static lenet_float_weights_t weights;
+static int loaded = 0;
+static int fc1_rank = 0;                    // 0: dense FC1
+static fc1_lowrank_t fc1_lowrank;
+static float fc1_rank_error = 0.0f;
+static __thread engine_density_t density;
+
+/// @brief Load-time transform: FC1 replaced by the factors of its rank-fc1_rank truncated SVD
+static void FactorizeFc1(void)
+{
+    Fc1LowRankFree(&fc1_lowrank);
+    fc1_rank_error = 0.0f;
+    if (fc1_rank > 0)
+        fc1_rank_error = Fc1LowRank(weights.fc1_kernel, fc1_rank, &fc1_lowrank);
+}
+
+void EngineFloatInit(const char *model_filename)
+{
+    if (!loaded) {
+        ReadFloatWeights((char *)model_filename, &weights);
+        loaded = 1;
+        FactorizeFc1();
+    }
+}
+
+/// @brief Run FC1 as rank-r SVD factors (0: dense), set before the threads start; refactorizes a loaded model
+void EngineSetFc1Rank(int rank)
+{
+    fc1_rank = rank > 0 ? rank : 0;
+    if (loaded)
+        FactorizeFc1();
+}
+
+/// @brief ||W - U_r V_r|| / ||W|| (Frobenius) of the FC1 factors in use, 0 when FC1 is dense
+float EngineFc1RankError(void)
+{
+    return fc1_rank_error;
+}
+
+void EngineFloatDensity(engine_density_t *stats)
+{
+    *stats = density;
+}
+
+/// @brief The layers of lenet_cnn, Conv1 on the input bounding box, Conv2 and FC1 dense or sparse from the
+///        density of their input, FC1 low-rank when factorized. The HLS top stays dense for synthesis
+static void LenetCnnHost(float input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH], float output[FC2_NBOUTPUT])
+{
+    float conv1_output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH];
+    float pool1_output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH];
+    float conv2_output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH];
+    float pool2_output[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+    float fc1_output[FC1_NBOUTPUT];
+    nonzero_list_t nonzeros;
+    bbox_t box;
+
+    // Empty background: full dot products only around the digit's bounding box
+    TRACE_BEGIN(TRACE_CONV1);
+    InputBoundingBox(input, &box);
+    density.conv1_positions += Conv1_28x28x1_5x5x20_1_0_crop(input, &box, weights.conv1_kernel,
+                                                             weights.conv1_bias, conv1_output);
+    density.conv1_values += CONV1_HEIGHT * CONV1_WIDTH;
+    TRACE_END(TRACE_CONV1);
+    TRACE_BEGIN(TRACE_POOL1);
+    Pool1_24x24x20_2x2x20_2_0(conv1_output, pool1_output);
+    TRACE_END(TRACE_POOL1);
+
+    // Dense or sparse kernel from the density of the ReLU / max-pool output (identical results)
+    TRACE_BEGIN(TRACE_CONV2);
+    density.conv2_images++;
+    density.pool1_values += POOL1_SIZE;
+    density.pool1_nonzeros += NonzeroList(&pool1_output[0][0][0], POOL1_SIZE, &nonzeros);
+    if (nonzeros.count < CONV2_SPARSE_DENSITY * POOL1_SIZE) {
+        Conv2_12x12x20_5x5x40_1_0_sparse(&nonzeros, weights.conv2_kernel, weights.conv2_bias, conv2_output);
+        density.conv2_sparse++;
+    } else
+        Conv2_12x12x20_5x5x40_1_0(pool1_output, weights.conv2_kernel, weights.conv2_bias, conv2_output);
+    TRACE_END(TRACE_CONV2);
+    TRACE_BEGIN(TRACE_POOL2);
+    Pool2_8x8x40_2x2x40_2_0(conv2_output, pool2_output);
+    TRACE_END(TRACE_POOL2);
+
+    TRACE_BEGIN(TRACE_FC1);
+    if (fc1_lowrank.rank > 0)
+        Fc1_40_400_lowrank(pool2_output, &fc1_lowrank, weights.fc1_bias, fc1_output);   // dense input, no list
+    else {
+        density.fc1_images++;
+        density.pool2_values += POOL2_SIZE;
+        density.pool2_nonzeros += NonzeroList(&pool2_output[0][0][0], POOL2_SIZE, &nonzeros);
+        if (nonzeros.count < FC1_SPARSE_DENSITY * POOL2_SIZE) {
+            Fc1_40_400_sparse(&nonzeros, weights.fc1_kernel, weights.fc1_bias, fc1_output);
+            density.fc1_sparse++;
+        } else
+            Fc1_40_400(pool2_output, weights.fc1_kernel, weights.fc1_bias, fc1_output);
+    }
+    TRACE_END(TRACE_FC1);
+    TRACE_BEGIN(TRACE_FC2);
+    Fc2_400_10(fc1_output, weights.fc2_kernel, weights.fc2_bias, output);
+    TRACE_END(TRACE_FC2);
+}
+
+void EngineFloatClassify(const unsigned char *pixels, engine_prediction_t *pred, float *probs)
+{
+    float input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+    float output[FC2_NBOUTPUT];
+    prediction_t p;
+
+    TRACE_BEGIN(TRACE_NORMALIZE);
+    NormalizeImg((unsigned char *)pixels, (float *)input, IMG_WIDTH, IMG_HEIGHT);
+    TRACE_END(TRACE_NORMALIZE);
+    LenetCnnHost(input, output);
+    TRACE_BEGIN(TRACE_PREDICT);
+    Predict(output, &p);
+    TRACE_END(TRACE_PREDICT);
+    pred->number = p.number;
+    pred->margin = p.margin;
+    pred->escalated = 0;
+    if (probs) {
+        TRACE_BEGIN(TRACE_SOFTMAX);
+        Softmax(output, probs);
+        TRACE_END(TRACE_SOFTMAX);
+    }
+}
+
+/// @brief count images (1 to ENGINE_LANES) in one pass of the _lanes kernels, FC1 dense whatever the rank set
+/// @param probs [count][ENGINE_NB_CLASSES], or NULL
+void EngineFloatClassifyLanes(const unsigned char *pixels, int count, engine_prediction_t *preds, float *probs)
+{
+    static __thread lanes_maps_t m;
+    float output[FC2_NBOUTPUT];
+    prediction_t p;
+    int l, k;
+
+    TRACE_BEGIN(TRACE_NORMALIZE);
+    LanesInterleave(pixels, count, m.input);
+    TRACE_END(TRACE_NORMALIZE);
+    TRACE_BEGIN(TRACE_CONV1);
+    Conv1_28x28x1_5x5x20_1_0_lanes(m.input, weights.conv1_kernel, weights.conv1_bias, m.conv1_output);
+    TRACE_END(TRACE_CONV1);
+    TRACE_BEGIN(TRACE_POOL1);
+    Pool1_24x24x20_2x2x20_2_0_lanes(m.conv1_output, m.pool1_output);
+    TRACE_END(TRACE_POOL1);
+    TRACE_BEGIN(TRACE_CONV2);
+    Conv2_12x12x20_5x5x40_1_0_lanes(m.pool1_output, weights.conv2_kernel, weights.conv2_bias, m.conv2_output);
+    TRACE_END(TRACE_CONV2);
+    TRACE_BEGIN(TRACE_POOL2);
+    Pool2_8x8x40_2x2x40_2_0_lanes(m.conv2_output, m.pool2_output);
+    TRACE_END(TRACE_POOL2);
+    TRACE_BEGIN(TRACE_FC1);
+    Fc1_40_400_lanes(m.pool2_output, weights.fc1_kernel, weights.fc1_bias, m.fc1_output);
+    TRACE_END(TRACE_FC1);
+    TRACE_BEGIN(TRACE_FC2);
+    Fc2_400_10_lanes(m.fc1_output, weights.fc2_kernel, weights.fc2_bias, m.output);
+    TRACE_END(TRACE_FC2);
+
+    TRACE_BEGIN(TRACE_PREDICT);
+    for (l = 0; l < count; l++) {
+        for (k = 0; k < FC2_NBOUTPUT; k++)
+            output[k] = m.output[k][l];
+        Predict(output, &p);
+        preds[l].number = p.number;
+        preds[l].margin = p.margin;
+        preds[l].escalated = 0;
+        if (probs)
+            Softmax(output, probs + l * FC2_NBOUTPUT);
+    }
+    TRACE_END(TRACE_PREDICT);
+}
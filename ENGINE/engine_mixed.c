@@ -0,0 +1,51 @@
+/**
+ * @file engine_mixed.c
+ * @brief Mixed-precision back end of the inference engine: per-layer dispatch and conversions, see mixed.h
+ */
+
+#include "../COMMON/trace.h"
+#include "engine.h"
+#include "mixed.h"
+
+// Format each layer precision reads and writes
+static const tensor_format_t layer_format[LAYER_PRECISION_NB] = { TENSOR_FP32, TENSOR_FP16, TENSOR_Q8, TENSOR_Q8 };
+#ifdef TRACE
+static const int layer_stage[ENGINE_NB_LAYERS] = { TRACE_CONV1, TRACE_CONV2, TRACE_FC1, TRACE_FC2 };
+#endif
+
+void EngineMixedInit(const char *model_filename)
+{
+    MixedFloatInit(model_filename);
+    MixedFixedInit(model_filename);
+}
+
+void EngineMixedClassify(const layer_precision_t layers[ENGINE_NB_LAYERS], const unsigned char *pixels,
+                         engine_prediction_t *pred, float *probs)
+{
+    mixed_tensor_t a, b, *input = &a, *output = &b, *swap;
+    int l;
+
+    TRACE_BEGIN(TRACE_NORMALIZE);
+    MixedFloatInput(pixels, input);
+    TRACE_END(TRACE_NORMALIZE);
+
+    for (l = 0; l < ENGINE_NB_LAYERS; l++) {
+        if (input->format != layer_format[layers[l]]) {
+            TRACE_BEGIN(TRACE_CONVERT);
+            MixedConvert(input, layer_format[layers[l]], output);
+            TRACE_END(TRACE_CONVERT);
+            swap = input, input = output, output = swap;
+        }
+        TRACE_BEGIN(layer_stage[l]);
+        if (layers[l] == LAYER_FP32 || layers[l] == LAYER_FP16)
+            MixedFloatLayer(l, layers[l], input, output);
+        else
+            MixedFixedLayer(l, layers[l], input, output);
+        TRACE_END(layer_stage[l]);
+        swap = input, input = output, output = swap;
+    }
+
+    TRACE_BEGIN(TRACE_PREDICT);
+    MixedFloatPredict(input, pred, probs);
+    TRACE_END(TRACE_PREDICT);
+}
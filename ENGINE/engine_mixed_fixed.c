@@ -0,0 +1,147 @@
+/**
+ * @file engine_mixed_fixed.c
+ * @brief Fixed side of the mixed precision: int16 and int8 layers on the float model quantized, see mixed.h
+ */
+
+#include <math.h>
+
+#include "../FIXED/lenet_cnn_fixed.h"
+#include "../FIXED/weights_float.h"
+#include "engine.h"
+#include "mixed.h"
+
+_Static_assert(MIXED_Q8_ONE == (1 << FIXED_POINT), "Q8 scale");
+
+#define INT8_MAX_BITS 14                // finest weight scale tried
+
+// Q8 kernels of the int16 layers, Q8 biases of both int16 and int8 layers
+static short conv1_q8[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+static short conv2_q8[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+static short fc1_q8[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static short fc2_q8[FC2_NBOUTPUT][FC1_NBOUTPUT];
+static short conv1_bias[CONV1_NBOUTPUT], conv2_bias[CONV2_NBOUTPUT], fc1_bias[FC1_NBOUTPUT], fc2_bias[FC2_NBOUTPUT];
+
+// int8 kernels, layer l at 2^kernel_bits[l]
+static signed char conv1_int8[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+static signed char conv2_int8[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+static signed char fc1_int8[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static signed char fc2_int8[FC2_NBOUTPUT][FC1_NBOUTPUT];
+static int kernel_bits[ENGINE_NB_LAYERS];
+static int loaded = 0;
+
+/// @brief Q8 of each weight, rounded and saturated
+static void QuantizeQ8(const float *weights, int size, short *q8)
+{
+    float q;
+    int i;
+
+    for (i = 0; i < size; i++) {
+        q = rintf(weights[i] * (1 << FIXED_POINT));
+        q8[i] = (short)(q > 32767.0f ? 32767 : q < -32768.0f ? -32768 : q);
+    }
+}
+
+/// @brief Weights on signed chars at the finest power-of-two scale that holds the largest, returns its bits
+static int QuantizeInt8(const float *weights, int size, signed char *q)
+{
+    float max = 0.0f;
+    int i, bits;
+
+    for (i = 0; i < size; i++)
+        max = fabsf(weights[i]) > max ? fabsf(weights[i]) : max;
+    for (bits = INT8_MAX_BITS; bits > 0 && rintf(max * (1 << bits)) > 127.0f; bits--)
+        ;
+    for (i = 0; i < size; i++)
+        q[i] = (signed char)fmaxf(-127.0f, fminf(127.0f, rintf(weights[i] * (1 << bits))));
+    return bits;
+}
+
+void MixedFixedInit(const char *model_filename)
+{
+    static lenet_float_weights_t w;
+
+    if (loaded)
+        return;
+    ReadFloatWeights((char *)model_filename, &w);
+    QuantizeQ8(&w.conv1_kernel[0][0][0][0], sizeof(conv1_q8) / sizeof(short), &conv1_q8[0][0][0][0]);
+    QuantizeQ8(&w.conv2_kernel[0][0][0][0], sizeof(conv2_q8) / sizeof(short), &conv2_q8[0][0][0][0]);
+    QuantizeQ8(&w.fc1_kernel[0][0][0][0], sizeof(fc1_q8) / sizeof(short), &fc1_q8[0][0][0][0]);
+    QuantizeQ8(&w.fc2_kernel[0][0], sizeof(fc2_q8) / sizeof(short), &fc2_q8[0][0]);
+    QuantizeQ8(w.conv1_bias, CONV1_NBOUTPUT, conv1_bias);
+    QuantizeQ8(w.conv2_bias, CONV2_NBOUTPUT, conv2_bias);
+    QuantizeQ8(w.fc1_bias, FC1_NBOUTPUT, fc1_bias);
+    QuantizeQ8(w.fc2_bias, FC2_NBOUTPUT, fc2_bias);
+    kernel_bits[0] = QuantizeInt8(&w.conv1_kernel[0][0][0][0], sizeof(conv1_int8), &conv1_int8[0][0][0][0]);
+    kernel_bits[1] = QuantizeInt8(&w.conv2_kernel[0][0][0][0], sizeof(conv2_int8), &conv2_int8[0][0][0][0]);
+    kernel_bits[2] = QuantizeInt8(&w.fc1_kernel[0][0][0][0], sizeof(fc1_int8), &fc1_int8[0][0][0][0]);
+    kernel_bits[3] = QuantizeInt8(&w.fc2_kernel[0][0], sizeof(fc2_int8), &fc2_int8[0][0]);
+    loaded = 1;
+}
+
+static void Int16Layer(int layer, const mixed_tensor_t *input, mixed_tensor_t *output)
+{
+    short conv1_output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH];
+    short conv2_output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH];
+    void *in = (void *)input->data.q, *out = output->data.q;
+
+    switch (layer) {
+    case 0:
+        Conv1_28x28x1_5x5x20_1_0_fixed(in, conv1_q8, conv1_bias, conv1_output);
+        Pool1_24x24x20_2x2x20_2_0_fixed(conv1_output, out);
+        output->size = POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH;
+        break;
+    case 1:
+        Conv2_12x12x20_5x5x40_1_0_fixed(in, conv2_q8, conv2_bias, conv2_output);
+        Pool2_8x8x40_2x2x40_2_0_fixed(conv2_output, out);
+        output->size = POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH;
+        break;
+    case 2:
+        Fc1_40_400_fixed(in, fc1_q8, fc1_bias, out);
+        output->size = FC1_NBOUTPUT;
+        break;
+    default:
+        // Signed logits, as those of the float layers
+        Fc2_400_10_linear_fixed(in, fc2_q8, fc2_bias, out);
+        output->size = FC2_NBOUTPUT;
+        break;
+    }
+}
+
+static void Int8Layer(int layer, const mixed_tensor_t *input, mixed_tensor_t *output)
+{
+    short conv1_output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH];
+    short conv2_output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH];
+    signed char in[MIXED_MAX_TENSOR];
+    void *out = output->data.q;
+    int shift = Int8Quantize_fixed(input->data.q, input->size, in) + kernel_bits[layer] - FIXED_POINT;
+
+    switch (layer) {
+    case 0:
+        Conv1_28x28x1_5x5x20_1_0_int8_fixed((void *)in, conv1_int8, conv1_bias, shift, conv1_output);
+        Pool1_24x24x20_2x2x20_2_0_fixed(conv1_output, out);
+        output->size = POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH;
+        break;
+    case 1:
+        Conv2_12x12x20_5x5x40_1_0_int8_fixed((void *)in, conv2_int8, conv2_bias, shift, conv2_output);
+        Pool2_8x8x40_2x2x40_2_0_fixed(conv2_output, out);
+        output->size = POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH;
+        break;
+    case 2:
+        Fc1_40_400_int8_fixed((void *)in, fc1_int8, fc1_bias, shift, out);
+        output->size = FC1_NBOUTPUT;
+        break;
+    default:
+        Fc2_400_10_int8_fixed(in, fc2_int8, fc2_bias, shift, out);
+        output->size = FC2_NBOUTPUT;
+        break;
+    }
+}
+
+void MixedFixedLayer(int layer, layer_precision_t precision, const mixed_tensor_t *input, mixed_tensor_t *output)
+{
+    if (precision == LAYER_INT8)
+        Int8Layer(layer, input, output);
+    else
+        Int16Layer(layer, input, output);
+    output->format = TENSOR_Q8;
+}
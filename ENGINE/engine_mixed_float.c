@@ -0,0 +1,179 @@
+/**
+ * @file engine_mixed_float.c
+ * @brief Float side of the mixed precision: fp32 and fp16 layers, tensor conversions, see mixed.h
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "../FLOAT/lenet_cnn_float.h"
+#include "../FIXED/weights_float.h"
+#include "engine.h"
+#include "mixed.h"
+
+_Static_assert(MIXED_MAX_TENSOR == POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH, "largest tensor");
+_Static_assert(sizeof(half_t) == sizeof(unsigned short), "half storage");
+
+static lenet_float_weights_t weights;
+static half_t conv1_kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+static half_t conv2_kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+static half_t fc1_kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static half_t fc2_kernel[FC2_NBOUTPUT][FC1_NBOUTPUT];
+static int loaded = 0;
+
+void MixedFloatInit(const char *model_filename)
+{
+    if (loaded)
+        return;
+    ReadFloatWeights((char *)model_filename, &weights);
+    HalfFromFloat(&weights.conv1_kernel[0][0][0][0], &conv1_kernel[0][0][0][0],
+                  sizeof(conv1_kernel) / sizeof(half_t), HALF_FP16);
+    HalfFromFloat(&weights.conv2_kernel[0][0][0][0], &conv2_kernel[0][0][0][0],
+                  sizeof(conv2_kernel) / sizeof(half_t), HALF_FP16);
+    HalfFromFloat(&weights.fc1_kernel[0][0][0][0], &fc1_kernel[0][0][0][0], sizeof(fc1_kernel) / sizeof(half_t),
+                  HALF_FP16);
+    HalfFromFloat(&weights.fc2_kernel[0][0], &fc2_kernel[0][0], sizeof(fc2_kernel) / sizeof(half_t), HALF_FP16);
+    loaded = 1;
+}
+
+void MixedFloatInput(const unsigned char *pixels, mixed_tensor_t *output)
+{
+    NormalizeImg((unsigned char *)pixels, output->data.f, IMG_WIDTH, IMG_HEIGHT);
+    output->format = TENSOR_FP32;
+    output->size = IMG_DEPTH * IMG_HEIGHT * IMG_WIDTH;
+}
+
+/// @brief Q8 of x, rounded and saturated
+static short FloatToQ8(float x)
+{
+    float q = rintf(x * MIXED_Q8_ONE);
+
+    return (short)(q > 32767.0f ? 32767 : q < -32768.0f ? -32768 : q);
+}
+
+/// @brief input in format, through float when neither side is float
+void MixedConvert(const mixed_tensor_t *input, tensor_format_t format, mixed_tensor_t *output)
+{
+    float buffer[MIXED_MAX_TENSOR];
+    const float *f = buffer;
+    int i, size = input->size;
+
+    if (input->format == TENSOR_FP32)
+        f = input->data.f;
+    else if (input->format == TENSOR_FP16)
+        HalfToFloat(input->data.h, buffer, size, HALF_FP16);
+    else
+        for (i = 0; i < size; i++)
+            buffer[i] = input->data.q[i] / MIXED_Q8_ONE;
+
+    if (format == TENSOR_FP32)
+        memcpy(output->data.f, f, size * sizeof(float));
+    else if (format == TENSOR_FP16)
+        HalfFromFloat(f, output->data.h, size, HALF_FP16);
+    else
+        for (i = 0; i < size; i++)
+            output->data.q[i] = FloatToQ8(f[i]);
+    output->format = format;
+    output->size = size;
+}
+
+static void Fp32Layer(int layer, const mixed_tensor_t *input, mixed_tensor_t *output)
+{
+    float conv1_output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH];
+    float conv2_output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH];
+    void *in = (void *)input->data.f, *out = output->data.f;
+
+    switch (layer) {
+    case 0:
+        Conv1_28x28x1_5x5x20_1_0(in, weights.conv1_kernel, weights.conv1_bias, conv1_output);
+        Pool1_24x24x20_2x2x20_2_0(conv1_output, out);
+        output->size = POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH;
+        break;
+    case 1:
+        Conv2_12x12x20_5x5x40_1_0(in, weights.conv2_kernel, weights.conv2_bias, conv2_output);
+        Pool2_8x8x40_2x2x40_2_0(conv2_output, out);
+        output->size = POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH;
+        break;
+    case 2:
+        Fc1_40_400(in, weights.fc1_kernel, weights.fc1_bias, out);
+        output->size = FC1_NBOUTPUT;
+        break;
+    default:
+        Fc2_400_10(in, weights.fc2_kernel, weights.fc2_bias, out);
+        output->size = FC2_NBOUTPUT;
+        break;
+    }
+    output->format = TENSOR_FP32;
+}
+
+static void Fp16Layer(int layer, const mixed_tensor_t *input, mixed_tensor_t *output)
+{
+    half_t conv1_output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH];
+    half_t conv2_output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH];
+    const void *in = input->data.h;
+    void *out = output->data.h;
+
+    output->format = TENSOR_FP16;
+    switch (layer) {
+    case 0:
+        Conv1_28x28x1_5x5x20_1_0_half(in, conv1_kernel, weights.conv1_bias, conv1_output, HALF_FP16);
+        Pool1_24x24x20_2x2x20_2_0_half(conv1_output, out);
+        output->size = POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH;
+        break;
+    case 1:
+        Conv2_12x12x20_5x5x40_1_0_half(in, conv2_kernel, weights.conv2_bias, conv2_output, HALF_FP16);
+        Pool2_8x8x40_2x2x40_2_0_half(conv2_output, out);
+        output->size = POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH;
+        break;
+    case 2:
+        Fc1_40_400_half(in, fc1_kernel, weights.fc1_bias, out, HALF_FP16);
+        output->size = FC1_NBOUTPUT;
+        break;
+    default:
+        // Float logits, as those of the fp32 layer
+        Fc2_400_10_half(in, fc2_kernel, weights.fc2_bias, output->data.f, HALF_FP16);
+        output->format = TENSOR_FP32;
+        output->size = FC2_NBOUTPUT;
+        break;
+    }
+}
+
+void MixedFloatLayer(int layer, layer_precision_t precision, const mixed_tensor_t *input, mixed_tensor_t *output)
+{
+    if (precision == LAYER_FP16)
+        Fp16Layer(layer, input, output);
+    else
+        Fp32Layer(layer, input, output);
+}
+
+void MixedFloatPredict(const mixed_tensor_t *logits, engine_prediction_t *pred, float *probs)
+{
+    mixed_tensor_t output;
+    float *f = (float *)logits->data.f;
+    prediction_t p;
+
+    if (logits->format != TENSOR_FP32) {
+        MixedConvert(logits, TENSOR_FP32, &output);
+        f = output.data.f;
+    }
+    Predict(f, &p);
+    pred->number = p.number;
+    pred->margin = p.margin;
+    pred->escalated = 0;
+    if (probs)
+        Softmax(f, probs);
+}
+
+/// @brief Bytes of the kernel and the biases of a layer in a precision: float biases for fp32 and fp16, Q8 else
+long MixedWeightBytes(int layer, layer_precision_t precision)
+{
+    static const long kernel_size[ENGINE_NB_LAYERS] = {
+        sizeof(weights.conv1_kernel) / sizeof(float), sizeof(weights.conv2_kernel) / sizeof(float),
+        sizeof(weights.fc1_kernel) / sizeof(float), sizeof(weights.fc2_kernel) / sizeof(float)
+    };
+    static const long bias_size[ENGINE_NB_LAYERS] = { CONV1_NBOUTPUT, CONV2_NBOUTPUT, FC1_NBOUTPUT, FC2_NBOUTPUT };
+    static const int kernel_bytes[LAYER_PRECISION_NB] = { sizeof(float), sizeof(half_t), sizeof(short), 1 };
+    static const int bias_bytes[LAYER_PRECISION_NB] = { sizeof(float), sizeof(float), sizeof(short), sizeof(short) };
+
+    return kernel_size[layer] * kernel_bytes[precision] + bias_size[layer] * bias_bytes[precision];
+}
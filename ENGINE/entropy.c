@@ -0,0 +1,238 @@
+/**
+ * @file entropy.c
+ * @brief Entropy-coded weight ROM of the fixed model and its command line front end, see entropy.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../FIXED/lenet_cnn_fixed.h"
+#include "../COMMON/alloc.h"
+#include "../COMMON/latency.h"
+#include "pipeline.h"
+#include "entropy.h"
+
+#define ENTROPY_DECODE_RUNS 20
+
+// Layers decoded once at load time
+static short conv1_kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+static short conv1_bias[CONV1_NBOUTPUT];
+static short conv2_bias[CONV2_NBOUTPUT];
+static short fc1_bias[FC1_NBOUTPUT];
+static short fc2_kernel[FC2_NBOUTPUT][FC1_NBOUTPUT];
+static short fc2_bias[FC2_NBOUTPUT];
+static short decoded[FC1_NBOUTPUT * POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH];
+
+typedef struct {
+    const char *name;
+    const short *dense;                 // in weights.h
+    int size;
+    short *ram;                         // decoded at load time, NULL for the layers decoded on the fly
+} entropy_layer_t;
+
+static const entropy_layer_t layers[] = {
+    { "Conv1",   &CONV1_KERNEL[0][0][0][0], sizeof(CONV1_KERNEL) / sizeof(short), &conv1_kernel[0][0][0][0] },
+    { "Conv1 b", CONV1_BIAS, CONV1_NBOUTPUT, conv1_bias },
+    { "Conv2",   &CONV2_KERNEL[0][0][0][0], sizeof(CONV2_KERNEL) / sizeof(short), NULL },
+    { "Conv2 b", CONV2_BIAS, CONV2_NBOUTPUT, conv2_bias },
+    { "FC1",     &FC1_KERNEL[0][0][0][0], sizeof(FC1_KERNEL) / sizeof(short), NULL },
+    { "FC1 b",   FC1_BIAS, FC1_NBOUTPUT, fc1_bias },
+    { "FC2",     &FC2_KERNEL[0][0], sizeof(FC2_KERNEL) / sizeof(short), &fc2_kernel[0][0] },
+    { "FC2 b",   FC2_BIAS, FC2_NBOUTPUT, fc2_bias },
+};
+#define NB_LAYERS   ((int)(sizeof(layers) / sizeof(layers[0])))
+#define LAYER_CONV2 2
+#define LAYER_FC1   4
+
+static huffman_fixed_t rom[NB_LAYERS];
+
+/// @brief Decode the small layers of the ROM into RAM
+static void LoadRom(void)
+{
+    huffman_stream_fixed_t stream;
+    int l;
+
+    for (l = 0; l < NB_LAYERS; l++) {
+        if (rom[l].size != layers[l].size) {
+            printf("Error: Layer %s has %d weights, %d expected.\n", layers[l].name, rom[l].size, layers[l].size);
+            exit(1);
+        }
+        if (layers[l].ram) {
+            HuffmanStreamInit_fixed(&rom[l], &stream);
+            HuffmanStreamRead_fixed(&stream, layers[l].ram, layers[l].size);
+        }
+    }
+}
+
+static void Conv1Rom(void *input, void *output)
+{
+    bbox_fixed_t box;
+
+    InputBoundingBox_fixed(input, &box);
+    Conv1_28x28x1_5x5x20_1_0_crop_fixed(input, &box, conv1_kernel, conv1_bias, output);
+}
+
+static void Conv2Huffman(void *input, void *output)
+{
+    Conv2_12x12x20_5x5x40_1_0_huffman_fixed(input, &rom[LAYER_CONV2], conv2_bias, output);
+}
+
+static void Fc1Huffman(void *input, void *output)
+{
+    Fc1_40_400_huffman_fixed(input, &rom[LAYER_FC1], fc1_bias, output);
+}
+
+static void Fc2Rom(void *input, void *output)
+{
+    Fc2_400_10_fixed(input, fc2_kernel, fc2_bias, output);
+}
+
+/// @brief Test set through the dense (coded = 0) or the coded layers, compared with the dense run
+static void Eval(const dataset_t *dataset, int coded, pipeline_reference_t *reference, pipeline_result_t *result)
+{
+    pipeline_t pipeline = { PIPELINE_FIXED, NULL, 0, NULL, NULL, NULL, NULL };
+
+    if (coded) {
+        pipeline.conv1 = Conv1Rom;
+        pipeline.conv2 = Conv2Huffman;
+        pipeline.fc1 = Fc1Huffman;
+        pipeline.fc2 = Fc2Rom;
+    }
+    PipelineEval(&pipeline, dataset, reference, result);
+}
+
+/// @brief Mean ns to decode a whole coded layer
+static double DecodeTime(const huffman_fixed_t *code)
+{
+    huffman_stream_fixed_t stream;
+    unsigned long long t0;
+    int r;
+
+    t0 = LatencyNow();
+    for (r = 0; r < ENTROPY_DECODE_RUNS; r++) {
+        HuffmanStreamInit_fixed(code, &stream);
+        HuffmanStreamRead_fixed(&stream, decoded, code->size);
+    }
+    return (double)(LatencyNow() - t0) / ENTROPY_DECODE_RUNS;
+}
+
+/// @brief Distinct values and zeroth-order entropy in bits per weight
+static double Entropy(const short *weights, int size, int *distinct)
+{
+    int *histogram = AllocateZeroed(65536 * sizeof(int));
+    double h = 0.0, p;
+    int i;
+
+    for (i = 0; i < size; i++)
+        histogram[weights[i] + 32768]++;
+    *distinct = 0;
+    for (i = 0; i < 65536; i++)
+        if (histogram[i]) {
+            p = (double)histogram[i] / size;
+            h -= p * log2(p);
+            (*distinct)++;
+        }
+    free(histogram);
+    return h;
+}
+
+static void PrintEval(const char *name, const pipeline_result_t *r, int count)
+{
+    printf("%-8s %9d", name, r->same);
+    PipelinePrintColumns(r, count);
+}
+
+/// @brief Command line front end: [-d dir] [-n max_images] [-o weights.huf]
+int EntropyMain(int argc, char **argv)
+{
+    const char *dir = ENGINE_DEFAULT_DATASET, *output = NULL;
+    long raw, coded, raw_all = 0, coded_all = 0;
+    int max_images = -1, distinct, k, l;
+    pipeline_reference_t reference;
+    pipeline_result_t result;
+    dataset_t dataset;
+    double h, ns_conv2, ns_fc1;
+    FILE *file;
+
+    for (k = 1; k < argc; k++) {
+        if (strcmp(argv[k], "-d") == 0 && k + 1 < argc)
+            dir = argv[++k];
+        else if (strcmp(argv[k], "-n") == 0 && k + 1 < argc)
+            max_images = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-o") == 0 && k + 1 < argc)
+            output = argv[++k];
+        else {
+            printf("Usage: %s [-d dir] [-n max_images] [-o weights.huf]\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    DatasetLoad(dir, max_images, &dataset);
+    PipelineReferenceInit(&reference, dataset.count);
+
+    printf("Huffman-coded Q8 weights of weights.h, one code per array (at most %d-bit codes)\n\n", HUFFMAN_MAX_BITS);
+    printf("%-8s %7s %8s %9s %9s %9s %9s %7s\n", "layer", "weights", "values", "entropy", "bits/w", "raw KB",
+           "coded KB", "ratio");
+    for (l = 0; l < NB_LAYERS; l++) {
+        HuffmanEncode_fixed(layers[l].dense, layers[l].size, &rom[l]);
+        h = Entropy(layers[l].dense, layers[l].size, &distinct);
+        raw = layers[l].size * (long)sizeof(short);
+        coded = HuffmanBytes_fixed(&rom[l]);
+        raw_all += raw;
+        coded_all += coded;
+        printf("%-8s %7d %8d %9.2f %9.2f %9.1f %9.1f %6.2fx\n", layers[l].name, layers[l].size, distinct, h,
+               8.0 * rom[l].nb_bytes / layers[l].size, raw / 1024.0, coded / 1024.0, (double)raw / coded);
+    }
+    printf("%-8s %7ld %8s %9s %9s %9.1f %9.1f %6.2fx\n\n", "total", raw_all / (long)sizeof(short), "", "", "",
+           raw_all / 1024.0, coded_all / 1024.0, (double)raw_all / coded_all);
+    LoadRom();
+
+    // Decode cost per inference: every Conv2 and FC1 weight is decoded once per image
+    ns_conv2 = DecodeTime(&rom[LAYER_CONV2]);
+    ns_fc1 = DecodeTime(&rom[LAYER_FC1]);
+    printf("Decode per inference: Conv2 %.1f us, FC1 %.1f us (%.2f ns/weight), decode tables %ld KB of RAM\n\n",
+           ns_conv2 / 1e3, ns_fc1 / 1e3, (ns_conv2 + ns_fc1) / (rom[LAYER_CONV2].size + rom[LAYER_FC1].size),
+           2 * (long)sizeof(rom[0].table) / 1024);
+
+    printf("%d images, 1 thread\n\n", dataset.count);
+    printf("%-8s %9s", "weights", "same");
+    PipelinePrintHeader();
+    Eval(&dataset, 0, &reference, &result);
+    PrintEval("dense", &result, dataset.count);
+    Eval(&dataset, 1, &reference, &result);
+    PrintEval("coded", &result, dataset.count);
+
+    if (output) {
+        file = fopen(output, "wb");
+        if (!file) {
+            printf("Error: Unable to open file %s.\n", output);
+            exit(1);
+        }
+        for (l = 0; l < NB_LAYERS; l++)
+            HuffmanWrite_fixed(file, &rom[l]);
+        fclose(file);
+        for (l = 0; l < NB_LAYERS; l++)
+            HuffmanFree_fixed(&rom[l]);
+
+        file = fopen(output, "rb");
+        if (!file) {
+            printf("Error: Unable to open file %s.\n", output);
+            exit(1);
+        }
+        for (l = 0; l < NB_LAYERS; l++)
+            HuffmanRead_fixed(file, &rom[l]);
+        fclose(file);
+        LoadRom();
+        Eval(&dataset, 1, &reference, &result);
+        PrintEval("file", &result, dataset.count);
+        printf("ROM written to %s\n", output);
+    }
+
+    for (l = 0; l < NB_LAYERS; l++)
+        HuffmanFree_fixed(&rom[l]);
+    PipelineReferenceFree(&reference);
+    DatasetFree(&dataset);
+    return 0;
+}
@@ -0,0 +1,24 @@
+/**
+ * @file entropy.h
+ * @brief Entropy-coded weight ROM of the fixed model: compression ratio and decode cost per inference
+ *
+ * Each kernel and bias array of weights.h is coded on its own canonical
+ * Huffman code (../FIXED/huffman_fixed.c). Conv1, FC2 and the biases, a few
+ * KB, are decoded once into RAM at load time; the Conv2 and FC1 kernels stay
+ * coded and the _huffman_fixed kernels decode them block by block into a
+ * small buffer, so the weights never exist whole in RAM. The report gives
+ * per layer the distinct values, the zeroth-order entropy, the coded bits per
+ * weight and the sizes against the shorts of weights.h, then the decode time
+ * of Conv2 and FC1 alone and the test set through the dense and the coded
+ * layers in the per-layer harness (pipeline.h), whose predictions must be
+ * identical. The ROM can be written to a file, read back and evaluated again.
+ */
+
+#ifndef ENTROPY_H
+#define ENTROPY_H
+
+#include "engine.h"
+
+int EntropyMain(int argc, char **argv);
+
+#endif // ENTROPY_H
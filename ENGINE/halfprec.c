@@ -0,0 +1,128 @@
+/**
+ * @file halfprec.c
+ * @brief fp16 / bf16 storage sweep of the float model and its command line front end, see halfprec.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../FLOAT/lenet_cnn_float.h"
+#include "../FIXED/weights_float.h"
+#include "pipeline.h"
+#include "halfprec.h"
+
+// Activations written per image: input, Conv1, Pool1, Conv2, Pool2 and FC1 outputs
+#define HALF_ACTIVATIONS (IMG_DEPTH * IMG_HEIGHT * IMG_WIDTH + CONV1_NBOUTPUT * CONV1_HEIGHT * CONV1_WIDTH \
+                          + POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH                                 \
+                          + CONV2_NBOUTPUT * CONV2_HEIGHT * CONV2_WIDTH                                 \
+                          + POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH + FC1_NBOUTPUT)
+
+typedef struct {
+    half_t conv1_kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+    half_t conv2_kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+    half_t fc1_kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+    half_t fc2_kernel[FC2_NBOUTPUT][FC1_NBOUTPUT];
+} half_weights_t;
+
+static lenet_float_weights_t weights;
+static half_weights_t half_weights;
+static half_format_t format;
+
+/// @brief Kernels of the float model rounded to half, the biases are used as they are
+static void HalfWeights(half_format_t half_format)
+{
+    format = half_format;
+    HalfFromFloat(&weights.conv1_kernel[0][0][0][0], &half_weights.conv1_kernel[0][0][0][0],
+                  sizeof(half_weights.conv1_kernel) / sizeof(half_t), format);
+    HalfFromFloat(&weights.conv2_kernel[0][0][0][0], &half_weights.conv2_kernel[0][0][0][0],
+                  sizeof(half_weights.conv2_kernel) / sizeof(half_t), format);
+    HalfFromFloat(&weights.fc1_kernel[0][0][0][0], &half_weights.fc1_kernel[0][0][0][0],
+                  sizeof(half_weights.fc1_kernel) / sizeof(half_t), format);
+    HalfFromFloat(&weights.fc2_kernel[0][0], &half_weights.fc2_kernel[0][0],
+                  sizeof(half_weights.fc2_kernel) / sizeof(half_t), format);
+}
+
+static void Conv1Half(void *input, void *output)
+{
+    Conv1_28x28x1_5x5x20_1_0_half(input, half_weights.conv1_kernel, weights.conv1_bias, output, format);
+}
+
+static void Conv2Half(void *input, void *output)
+{
+    Conv2_12x12x20_5x5x40_1_0_half(input, half_weights.conv2_kernel, weights.conv2_bias, output, format);
+}
+
+static void Fc1Half(void *input, void *output)
+{
+    Fc1_40_400_half(input, half_weights.fc1_kernel, weights.fc1_bias, output, format);
+}
+
+static void Fc2Half(void *input, void *output)
+{
+    Fc2_400_10_half(input, half_weights.fc2_kernel, weights.fc2_bias, output, format);
+}
+
+static void PrintRow(const char *precision, int bytes_per_value, const pipeline_result_t *r, int count)
+{
+    long weight_bytes = (long)(sizeof(half_weights) / sizeof(half_t)) * bytes_per_value;
+
+    printf("%-9s %10.1f %9.1f %8.1f%% %10.2e", precision, weight_bytes / 1024.0,
+           HALF_ACTIVATIONS * bytes_per_value / 1024.0, count ? 100.0 * r->same / count : 0.0, r->max_delta);
+    PipelinePrintColumns(r, count);
+}
+
+/// @brief Command line front end: [-m model] [-d dir] [-n max_images]
+int HalfMain(int argc, char **argv)
+{
+    const char *model = ENGINE_DEFAULT_MODEL, *dir = ENGINE_DEFAULT_DATASET;
+    pipeline_t fp32 = { PIPELINE_FLOAT, &weights, 0, NULL, NULL, NULL, NULL };
+    pipeline_t half = { PIPELINE_HALF, NULL, 0, Conv1Half, Conv2Half, Fc1Half, Fc2Half };
+    pipeline_reference_t reference;
+    pipeline_result_t result;
+    dataset_t dataset;
+    int max_images = -1, k;
+
+    for (k = 1; k < argc; k++) {
+        if (strcmp(argv[k], "-m") == 0 && k + 1 < argc)
+            model = argv[++k];
+        else if (strcmp(argv[k], "-d") == 0 && k + 1 < argc)
+            dir = argv[++k];
+        else if (strcmp(argv[k], "-n") == 0 && k + 1 < argc)
+            max_images = atoi(argv[++k]);
+        else {
+            printf("Usage: %s [-m model] [-d dir] [-n max_images]\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    ReadFloatWeights((char *)model, &weights);
+    DatasetLoad(dir, max_images, &dataset);
+    PipelineReferenceInit(&reference, dataset.count);
+#ifdef __F16C__
+    printf("Half-precision weights and activations (fp16 widened by F16C), %d images, 1 thread\n", dataset.count);
+#else
+    printf("Half-precision weights and activations (portable fp16 widening), %d images, 1 thread\n",
+           dataset.count);
+#endif
+    printf("KB: kernels (biases stay float), act KB: layer outputs per image, agree: same class as fp32\n\n");
+    printf("%-9s %10s %9s %9s %10s", "precision", "KB", "act KB", "agree", "max dlogit");
+    PipelinePrintHeader();
+
+    // The fp32 run records the reference
+    PipelineEval(&fp32, &dataset, &reference, &result);
+    PrintRow("fp32", sizeof(float), &result, dataset.count);
+    HalfWeights(HALF_FP16);
+    half.half_format = HALF_FP16;
+    PipelineEval(&half, &dataset, &reference, &result);
+    PrintRow("fp16", sizeof(half_t), &result, dataset.count);
+    HalfWeights(HALF_BF16);
+    half.half_format = HALF_BF16;
+    PipelineEval(&half, &dataset, &reference, &result);
+    PrintRow("bf16", sizeof(half_t), &result, dataset.count);
+
+    PipelineReferenceFree(&reference);
+    DatasetFree(&dataset);
+    return 0;
+}
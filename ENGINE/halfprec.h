@@ -0,0 +1,23 @@
+/**
+ * @file halfprec.h
+ * @brief Half-precision storage of the float model: accuracy and speed of fp16 and bf16 against fp32
+ *
+ * The float model runs with its weights and its activations stored as fp16
+ * or bf16 (../FLOAT/half.c) and widened to float for the arithmetic: the
+ * kernels are rounded once from the HDF5 model, the input image and every
+ * layer output are rounded as they are written. The biases stay float and
+ * FC2 gives float logits. No retraining. The test set runs through the
+ * per-layer harness (pipeline.h), in the fp32 pipeline and in both halves;
+ * the table gives the weight and activation bytes, the share of predictions
+ * equal to fp32 and the largest logit difference to fp32, then the errors
+ * and the latencies. make F16C=1 builds the F16C widening of fp16.
+ */
+
+#ifndef HALFPREC_H
+#define HALFPREC_H
+
+#include "engine.h"
+
+int HalfMain(int argc, char **argv);
+
+#endif // HALFPREC_H
@@ -0,0 +1,450 @@
+/**
+ * @file lenet.c
+ * @brief Command line driver of the LeNet-5 inference engine
+ *
+ *   lenet eval     [options]              accuracy and throughput on the test set
+ *   lenet classify [options] image.pgm... class of each image
+ *   lenet bench    [bench options]        kernel microbenchmarks (see bench.h)
+ *   lenet roofline [bench options]        kernels against the machine ceilings (see roofline.h)
+ *   lenet prune    [prune options]        Conv2 / FC1 pruning sweep and CSR export (see prune.h)
+ *   lenet lowrank  [lowrank options]      rank sweep of the truncated SVD of FC1 (see lowrank.h)
+ *   lenet cluster  [cluster options]      Conv2 / FC1 k-means weight sharing sweep (see clustering.h)
+ *   lenet pow2     [pow2 options]         per-layer loss of power-of-two fixed weights (see pow2.h)
+ *   lenet xnor     [xnor options]         binarized Conv2 / FC1 against the dense builds (see binarize.h)
+ *   lenet entropy  [entropy options]      Huffman-coded weight ROM of the fixed model (see entropy.h)
+ *   lenet stream   [stream options]       FC1 kernel read from a file in chunks, chunk size sweep (see outofcore.h)
+ *   lenet half     [half options]         fp16 / bf16 weights and activations against fp32 (see halfprec.h)
+ *   lenet mixed    [mixed options]        per-layer precision search at an accuracy floor (see mixed.h)
+ *
+ * eval loads the whole test set first, then classifies it on -j threads that
+ * take -b images at a time from a shared counter. By default it prints only
+ * the aggregate accuracy and throughput; -v adds the load time, the
+ * per-image latency percentiles, the share of Conv1 computed and the density
+ * of the Conv2 and FC1 inputs, -vv one line per image. With -p lanes the
+ * images of a work item are classified ENGINE_LANES at a time, each one
+ * recorded with the latency of its group. Predictions are kept
+ * in memory and written once at the end, as CSV (index,label,predicted,margin)
+ * or, for a .bin/.idx file, in the MNIST idx1 label format.
+ * With make trace, -t writes a Chrome trace of every stage on every thread.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../COMMON/latency.h"
+#include "../COMMON/trace.h"
+#include "engine.h"
+#include "bench.h"
+#include "roofline.h"
+#include "prune.h"
+#include "lowrank.h"
+#include "clustering.h"
+#include "pow2.h"
+#include "binarize.h"
+#include "entropy.h"
+#include "outofcore.h"
+#include "halfprec.h"
+#include "mixed.h"
+
+typedef struct {
+    const char *model;
+    const char *dataset;
+    const char *output;
+    const char *trace;
+    precision_t precision;
+    float       cascade_margin;
+    layer_precision_t layers[ENGINE_NB_LAYERS];    // mixed precision
+    int         fc1_rank;       // 0: dense FC1
+    int         threads;
+    int         batch;
+    int         max_images;
+    int         verbose;
+} options_t;
+
+typedef struct {
+    const options_t     *opt;
+    const dataset_t     *dataset;
+    engine_prediction_t *predictions;
+    struct worker       *workers;
+    int                  next;          // first image of the next batch, atomic
+} eval_t;
+
+typedef struct worker {
+    eval_t          *eval;
+    latency_hist_t   latency;
+    engine_density_t density[2];        // float and fixed host passes of this thread
+    pthread_t        thread;
+} worker_t;
+
+static void Usage(const char *prog)
+{
+    printf("Usage: %s eval     [options]\n", prog);
+    printf("       %s classify [options] image.pgm...\n", prog);
+    printf("       %s bench    [-s samples] [-t sample_ms] [-k kernel_filter] [-o bench.json]\n", prog);
+    printf("       %s roofline [-s samples] [-t sample_ms] [-k kernel_filter] [-o roofline.csv]\n", prog);
+    printf("       %s prune    [-m model] [-d dir] [-n n] [-s sparsity,...] [-t target] [-o pruned.csr]\n", prog);
+    printf("       %s lowrank  [-m model] [-d dir] [-n n] [-r rank,...]\n", prog);
+    printf("       %s cluster  [-m model] [-d dir] [-n n] [-k centroids,...] [-t target] [-o model.cbk]\n", prog);
+    printf("       %s pow2     [-d dir] [-n n] [-t terms] [-o weights_pow2.h]\n", prog);
+    printf("       %s xnor     [-m model] [-d dir] [-n n]\n", prog);
+    printf("       %s entropy  [-d dir] [-n n] [-o weights.huf]\n", prog);
+    printf("       %s stream   [-d dir] [-n n] [-f fc1_kernel.bin] [-c chunk_kb,...] [-r MB/s]\n", prog);
+    printf("       %s half     [-m model] [-d dir] [-n n]\n", prog);
+    printf("       %s mixed    [-m model] [-d dir] [-n n] [-a accuracy_floor] [-k top]\n\n", prog);
+    printf("Options:\n");
+    printf("  -m file   float model (default %s)\n", ENGINE_DEFAULT_MODEL);
+    printf("  -d dir    dataset directory (default %s)\n", ENGINE_DEFAULT_DATASET);
+    printf("  -p name   precision: float, fixed, cascade, mixed, lanes (default float)\n");
+    printf("  -c x      cascade: escalate to float below this fixed top-2 margin (default %.1f)\n",
+           ENGINE_DEFAULT_CASCADE_MARGIN);
+    printf("  -l list   mixed: Conv1,Conv2,FC1,FC2 precisions among fp32, fp16, int16, int8 (default %s)\n",
+           ENGINE_DEFAULT_LAYERS);
+    printf("  -r n      float FC1 as the rank-n factors of its truncated SVD (default 0: dense)\n");
+    printf("  -j n      threads (default 1)\n");
+    printf("  -b n      images per work item (default 64)\n");
+    printf("  -n n      evaluate only the first n images\n");
+    printf("  -o file   write predictions: .csv, or .bin/.idx in MNIST label format\n");
+    printf("  -t file   write a Chrome trace_event JSON (lenet_trace build)\n");
+    printf("  -v        more output, -vv one line per image\n");
+    exit(1);
+}
+
+/// @brief Parse the options common to eval and classify, returns the index of the first operand
+static int ParseOptions(int argc, char **argv, options_t *opt)
+{
+    int k;
+
+    opt->model = ENGINE_DEFAULT_MODEL;
+    opt->dataset = ENGINE_DEFAULT_DATASET;
+    opt->output = NULL;
+    opt->trace = NULL;
+    opt->precision = PRECISION_FLOAT;
+    opt->cascade_margin = ENGINE_DEFAULT_CASCADE_MARGIN;
+    opt->fc1_rank = 0;
+    LayersFromString(ENGINE_DEFAULT_LAYERS, opt->layers);
+    opt->threads = 1;
+    opt->batch = 64;
+    opt->max_images = -1;
+    opt->verbose = 0;
+
+    for (k = 2; k < argc && argv[k][0] == '-'; k++) {
+        const char *arg = (k + 1 < argc) ? argv[k + 1] : NULL;
+
+        if (strcmp(argv[k], "-v") == 0)
+            opt->verbose++;
+        else if (strcmp(argv[k], "-vv") == 0)
+            opt->verbose += 2;
+        else if (!arg)
+            Usage(argv[0]);
+        else if (strcmp(argv[k], "-m") == 0)
+            opt->model = argv[++k];
+        else if (strcmp(argv[k], "-d") == 0)
+            opt->dataset = argv[++k];
+        else if (strcmp(argv[k], "-o") == 0)
+            opt->output = argv[++k];
+        else if (strcmp(argv[k], "-t") == 0)
+            opt->trace = argv[++k];
+        else if (strcmp(argv[k], "-j") == 0)
+            opt->threads = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-b") == 0)
+            opt->batch = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-c") == 0)
+            opt->cascade_margin = atof(argv[++k]);
+        else if (strcmp(argv[k], "-n") == 0)
+            opt->max_images = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-r") == 0)
+            opt->fc1_rank = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-l") == 0) {
+            if (LayersFromString(argv[++k], opt->layers) < 0) {
+                printf("Error: Invalid layer precisions %s.\n", argv[k]);
+                exit(1);
+            }
+        }
+        else if (strcmp(argv[k], "-p") == 0) {
+            if (PrecisionFromName(argv[++k], &opt->precision) < 0) {
+                printf("Error: Unknown precision %s.\n", argv[k]);
+                exit(1);
+            }
+        } else
+            Usage(argv[0]);
+    }
+    if (opt->threads < 1) opt->threads = 1;
+    if (opt->batch < 1)   opt->batch = 1;
+    if (opt->fc1_rank < 0 || opt->fc1_rank > ENGINE_FC1_MAX_RANK) {
+        printf("Error: FC1 rank %d out of [0, %d].\n", opt->fc1_rank, ENGINE_FC1_MAX_RANK);
+        exit(1);
+    }
+    EngineSetCascadeMargin(opt->cascade_margin);
+    EngineSetFc1Rank(opt->fc1_rank);
+    EngineSetLayers(opt->layers);
+#ifndef TRACE
+    if (opt->trace) {
+        printf("Error: -t needs the trace build (make trace, ./lenet_trace).\n");
+        exit(1);
+    }
+#endif
+    return k;
+}
+
+static void *EvalWorker(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    eval_t *e = w->eval;
+    int first, m, n, i, last;
+#ifdef TRACE
+    char name[32];
+
+    snprintf(name, sizeof(name), "worker %d", (int)(w - e->workers));
+    TraceThreadName(name);
+#endif
+
+    for (;;) {
+        first = __atomic_fetch_add(&e->next, e->opt->batch, __ATOMIC_RELAXED);
+        if (first >= e->dataset->count) {
+            EngineFloatDensity(&w->density[0]);
+            EngineFixedDensity(&w->density[1]);
+            return NULL;
+        }
+        last = first + e->opt->batch;
+        if (last > e->dataset->count)
+            last = e->dataset->count;
+
+        TRACE_BEGIN(TRACE_BATCH);
+        for (m = first; m < last; m += n) {
+            unsigned long long t0 = LatencyNow();
+
+            n = e->opt->precision == PRECISION_LANES ? ENGINE_LANES : 1;
+            if (n > last - m)
+                n = last - m;
+            TRACE_IMAGE_INDEX(m);
+            TRACE_BEGIN(TRACE_IMAGE);
+            EngineClassifyBatch(e->opt->precision, e->dataset->images + (size_t)m * ENGINE_IMG_SIZE, n,
+                                &e->predictions[m]);
+            TRACE_END(TRACE_IMAGE);
+            t0 = LatencyNow() - t0;
+            for (i = 0; i < n; i++)
+                LatencyRecord(&w->latency, t0);
+        }
+        TRACE_IMAGE_INDEX(-1);
+        TRACE_END(TRACE_BATCH);
+    }
+}
+
+static void DensityMerge(engine_density_t *total, const engine_density_t *d)
+{
+    total->conv1_values += d->conv1_values;
+    total->conv1_positions += d->conv1_positions;
+    total->conv2_images += d->conv2_images;
+    total->conv2_sparse += d->conv2_sparse;
+    total->pool1_values += d->pool1_values;
+    total->pool1_nonzeros += d->pool1_nonzeros;
+    total->fc1_images += d->fc1_images;
+    total->fc1_sparse += d->fc1_sparse;
+    total->pool2_values += d->pool2_values;
+    total->pool2_nonzeros += d->pool2_nonzeros;
+}
+
+/// @brief Share of Conv1 computed, average density of the Conv2 and FC1 inputs and sparse kernel use of one host pass
+static void DensityReport(const char *precision, const engine_density_t *d)
+{
+    if (d->conv1_values)
+        printf("Density (%s): Conv1 bounding box, %.1f%% of the output positions computed\n", precision,
+               100.0 * d->conv1_positions / d->conv1_values);
+    if (d->conv2_images)
+        printf("Density (%s): pool1 %.1f%%, Conv2 sparse on %ld / %ld images\n", precision,
+               100.0 * d->pool1_nonzeros / d->pool1_values, d->conv2_sparse, d->conv2_images);
+    if (d->fc1_images)
+        printf("Density (%s): pool2 %.1f%%, FC1 sparse on %ld / %ld images\n", precision,
+               100.0 * d->pool2_nonzeros / d->pool2_values, d->fc1_sparse, d->fc1_images);
+}
+
+/// @brief Write all predictions at once: CSV, or idx1 (magic 0x801, big-endian count, one byte per image)
+static void WritePredictions(const char *filename, const dataset_t *dataset, const engine_prediction_t *pred)
+{
+    const char *ext = strrchr(filename, '.');
+    static char buffer[1 << 20];
+    FILE *file;
+    int m;
+
+    file = fopen(filename, "wb");
+    if (!file) {
+        printf("Error: Unable to open file %s.\n", filename);
+        exit(1);
+    }
+    setvbuf(file, buffer, _IOFBF, sizeof(buffer));
+
+    if (ext && (strcmp(ext, ".bin") == 0 || strcmp(ext, ".idx") == 0)) {
+        unsigned char header[8] = { 0, 0, 8, 1,
+                                    (unsigned char)(dataset->count >> 24), (unsigned char)(dataset->count >> 16),
+                                    (unsigned char)(dataset->count >> 8), (unsigned char)dataset->count };
+
+        fwrite(header, 1, sizeof(header), file);
+        for (m = 0; m < dataset->count; m++)
+            fputc(pred[m].number, file);
+    } else {
+        fprintf(file, "index,label,predicted,margin\n");
+        for (m = 0; m < dataset->count; m++)
+            fprintf(file, "%d,%d,%d,%.4f\n", m, dataset->labels[m], pred[m].number, pred[m].margin);
+    }
+    fclose(file);
+}
+
+static int Eval(const options_t *opt)
+{
+    dataset_t dataset;
+    eval_t eval;
+    worker_t *workers;
+    latency_hist_t latency;
+    engine_density_t density[2] = { { 0 }, { 0 } };
+    unsigned long long t0, t_load, t_start, t_end;
+    int m, t, errors = 0, escalated = 0;
+    double seconds;
+
+#ifdef TRACE
+    TraceThreadName("main");
+#endif
+    t0 = LatencyNow();
+    EngineInit(opt->model, opt->precision);
+    TRACE_BEGIN(TRACE_READ);
+    DatasetLoad(opt->dataset, opt->max_images, &dataset);
+    TRACE_END(TRACE_READ);
+    t_load = LatencyNow();
+
+    eval.opt = opt;
+    eval.dataset = &dataset;
+    eval.predictions = calloc(dataset.count + 1, sizeof(engine_prediction_t));
+    eval.next = 0;
+    eval.workers = workers = calloc(opt->threads, sizeof(worker_t));
+    if (!eval.predictions || !workers) {
+        printf("Error: Unable to allocate predictions.\n");
+        exit(1);
+    }
+
+    t_start = LatencyNow();
+    for (t = 0; t < opt->threads; t++) {
+        workers[t].eval = &eval;
+        LatencyInit(&workers[t].latency);
+        pthread_create(&workers[t].thread, NULL, EvalWorker, &workers[t]);
+    }
+    LatencyInit(&latency);
+    for (t = 0; t < opt->threads; t++) {
+        pthread_join(workers[t].thread, NULL);
+        LatencyMerge(&latency, &workers[t].latency);
+        DensityMerge(&density[0], &workers[t].density[0]);
+        DensityMerge(&density[1], &workers[t].density[1]);
+    }
+    t_end = LatencyNow();
+
+    for (m = 0; m < dataset.count; m++) {
+        if (eval.predictions[m].number != dataset.labels[m])
+            errors++;
+        escalated += eval.predictions[m].escalated;
+        if (opt->verbose >= 2)
+            printf("%5d  Predicted: %d  Actual: %d  Margin: %.3f%s%s\n", m, eval.predictions[m].number,
+                   dataset.labels[m], eval.predictions[m].margin,
+                   eval.predictions[m].escalated ? "  (float)" : "",
+                   eval.predictions[m].number != dataset.labels[m] ? "  [ERROR]" : "");
+    }
+
+    seconds = (t_end - t_start) / 1e9;
+    printf("Accuracy: %.2f%% (%d errors / %d images, %s)\n",
+           dataset.count ? 100.0 * (dataset.count - errors) / dataset.count : 0.0,
+           errors, dataset.count, PrecisionName(opt->precision));
+    printf("Throughput: %.1f images/s (%d thread(s), batch %d)\n", dataset.count / seconds, opt->threads, opt->batch);
+    if (opt->precision == PRECISION_CASCADE)
+        printf("Escalated: %.2f%% (%d / %d images to float, fixed margin < %.2f)\n",
+               dataset.count ? 100.0 * escalated / dataset.count : 0.0, escalated, dataset.count,
+               opt->cascade_margin);
+    if (opt->precision == PRECISION_MIXED)
+        printf("Layers: Conv1 %s, Conv2 %s, FC1 %s, FC2 %s\n", LayerPrecisionName(opt->layers[0]),
+               LayerPrecisionName(opt->layers[1]), LayerPrecisionName(opt->layers[2]),
+               LayerPrecisionName(opt->layers[3]));
+    if (opt->fc1_rank > 0 && (opt->precision == PRECISION_FLOAT || opt->precision == PRECISION_CASCADE))
+        printf("FC1: rank %d truncated SVD (%.4f relative Frobenius error)\n", opt->fc1_rank, EngineFc1RankError());
+    if (opt->verbose >= 1) {
+        printf("Load: %.3f s, inference: %.3f s\n\n", (t_load - t0) / 1e9, seconds);
+        LatencyReportHeader(stdout);
+        LatencyReport(stdout, "inference", &latency);
+        DensityReport("float", &density[0]);
+        DensityReport("fixed", &density[1]);
+    }
+
+    if (opt->output)
+        WritePredictions(opt->output, &dataset, eval.predictions);
+#ifdef TRACE
+    if (opt->trace)
+        printf("Trace: %d events written to %s\n", TraceWrite(opt->trace), opt->trace);
+#endif
+
+    free(workers);
+    free(eval.predictions);
+    DatasetFree(&dataset);
+    return 0;
+}
+
+static int Classify(const options_t *opt, int argc, char **argv, int first)
+{
+    unsigned char pixels[ENGINE_IMG_SIZE];
+    float probs[ENGINE_NB_CLASSES];
+    engine_prediction_t pred;
+    int k, c;
+
+    if (first >= argc)
+        Usage(argv[0]);
+    EngineInit(opt->model, opt->precision);
+
+    for (k = first; k < argc; k++) {
+        DatasetReadImage(argv[k], pixels);
+        EngineClassify(opt->precision, pixels, &pred, opt->verbose ? probs : NULL);
+        printf("%s: %d (margin %.3f%s)\n", argv[k], pred.number, pred.margin, pred.escalated ? ", float" : "");
+        if (opt->verbose) {
+            for (c = 0; c < ENGINE_NB_CLASSES; c++)
+                printf("  %d: %6.2f%%\n", c, 100 * probs[c]);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    options_t opt;
+    int first;
+
+    if (argc < 2)
+        Usage(argv[0]);
+    if (strcmp(argv[1], "bench") == 0)
+        return BenchMain(argc - 1, argv + 1);
+    if (strcmp(argv[1], "roofline") == 0)
+        return RooflineMain(argc - 1, argv + 1);
+    if (strcmp(argv[1], "prune") == 0)
+        return PruneMain(argc - 1, argv + 1);
+    if (strcmp(argv[1], "lowrank") == 0)
+        return LowRankMain(argc - 1, argv + 1);
+    if (strcmp(argv[1], "cluster") == 0)
+        return ClusterMain(argc - 1, argv + 1);
+    if (strcmp(argv[1], "pow2") == 0)
+        return Pow2Main(argc - 1, argv + 1);
+    if (strcmp(argv[1], "xnor") == 0)
+        return XnorMain(argc - 1, argv + 1);
+    if (strcmp(argv[1], "entropy") == 0)
+        return EntropyMain(argc - 1, argv + 1);
+    if (strcmp(argv[1], "stream") == 0)
+        return StreamMain(argc - 1, argv + 1);
+    if (strcmp(argv[1], "half") == 0)
+        return HalfMain(argc - 1, argv + 1);
+    if (strcmp(argv[1], "mixed") == 0)
+        return MixedMain(argc - 1, argv + 1);
+
+    first = ParseOptions(argc, argv, &opt);
+    if (strcmp(argv[1], "eval") == 0) {
+        if (first != argc)
+            Usage(argv[0]);
+        return Eval(&opt);
+    }
+    if (strcmp(argv[1], "classify") == 0)
+        return Classify(&opt, argc, argv, first);
+    Usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,13 @@
+/**
+ * @file lenet_bench.c
+ * @brief Kernel microbenchmarks of the float and fixed pipelines
+ *
+ * Usage: ./lenet_bench [-s samples] [-t sample_ms] [-k kernel_filter] [-o bench.json]
+ */
+
+#include "bench.h"
+
+int main(int argc, char **argv)
+{
+    return BenchMain(argc, argv);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file lowrank.c
+ * @brief Rank sweep of the low-rank float FC1 and its command line front end, see lowrank.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../FLOAT/lenet_cnn_float.h"
+#include "../FIXED/weights_float.h"
+#include "../COMMON/latency.h"
+#include "bench.h"
+#include "pipeline.h"
+#include "lowrank.h"
+
+#define FC1_SIZE (POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+#define LOWRANK_MAX_SWEEP 32
+
+static lenet_float_weights_t weights;
+static float fc1_input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static float fc1_output[FC1_NBOUTPUT];
+static fc1_lowrank_t fc1_lowrank;
+
+static void RunFc1(void)        { Fc1_40_400(fc1_input, weights.fc1_kernel, weights.fc1_bias, fc1_output); }
+static void RunFc1LowRank(void) { Fc1_40_400_lowrank(fc1_input, &fc1_lowrank, weights.fc1_bias, fc1_output); }
+
+static void Fc1LowRankLayer(void *input, void *output)
+{
+    Fc1_40_400_lowrank(input, &fc1_lowrank, weights.fc1_bias, output);
+}
+
+static void PrintRow(const char *rank, long macs, double error, double ms_svd, double ns_bench,
+                     const pipeline_result_t *r, int count)
+{
+    printf("%6s %9ld %9.1f %9.4f %8.0f %9.2f", rank, macs, macs * sizeof(float) / 1024.0, error, ms_svd,
+           ns_bench / 1e3);
+    PipelinePrintColumns(r, count);
+}
+
+/// @brief Command line front end: [-m model] [-d dir] [-n max_images] [-r rank,...]
+int LowRankMain(int argc, char **argv)
+{
+    const char *model = ENGINE_DEFAULT_MODEL, *dir = ENGINE_DEFAULT_DATASET;
+    char sweep_list[256] = LOWRANK_DEFAULT_SWEEP, *token;
+    int sweep[LOWRANK_MAX_SWEEP], max_images = -1, nb_sweep = 0, k, i;
+    bench_kernel_t kernel = { "Fc1", "float", 0, 0, NULL };
+    pipeline_t pipeline = { PIPELINE_FLOAT, &weights, 0, NULL, NULL, NULL, NULL };
+    pipeline_result_t r;
+    bench_options_t opt;
+    bench_stats_t st;
+    unsigned long long t0;
+    dataset_t dataset;
+    double ms_svd, error;
+    char label[16];
+
+    for (k = 1; k < argc; k++) {
+        if (strcmp(argv[k], "-m") == 0 && k + 1 < argc)
+            model = argv[++k];
+        else if (strcmp(argv[k], "-d") == 0 && k + 1 < argc)
+            dir = argv[++k];
+        else if (strcmp(argv[k], "-n") == 0 && k + 1 < argc)
+            max_images = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-r") == 0 && k + 1 < argc)
+            snprintf(sweep_list, sizeof(sweep_list), "%s", argv[++k]);
+        else {
+            printf("Usage: %s [-m model] [-d dir] [-n max_images] [-r rank,...]\n", argv[0]);
+            exit(1);
+        }
+    }
+    for (token = strtok(sweep_list, ","); token && nb_sweep < LOWRANK_MAX_SWEEP; token = strtok(NULL, ",")) {
+        sweep[nb_sweep] = atoi(token);
+        if (sweep[nb_sweep] < 1 || sweep[nb_sweep] > FC1_NBOUTPUT) {
+            printf("Error: Rank %s out of [1, %d].\n", token, FC1_NBOUTPUT);
+            exit(1);
+        }
+        nb_sweep++;
+    }
+
+    ReadFloatWeights((char *)model, &weights);
+    DatasetLoad(dir, max_images, &dataset);
+    for (i = 0; i < FC1_SIZE; i++)
+        ((float *)fc1_input)[i] = (float)rand() / RAND_MAX;
+    BenchDefaultOptions(&opt);
+    opt.samples = 11;
+    opt.sample_ms = 1.0;
+    opt.warmup_ms = 10.0;
+
+    printf("FC1 %d x %d by truncated SVD, %d images, 1 thread\n", FC1_NBOUTPUT, FC1_SIZE, dataset.count);
+    printf("SVD ms: factorization at load time, bench us: FC1 on its own (bench.h)\n\n");
+    printf("%6s %9s %9s %9s %8s %9s", "rank", "MACs", "KB", "rel err", "SVD ms", "bench us");
+    PipelinePrintHeader();
+
+    kernel.run = RunFc1;
+    BenchKernel(&kernel, &opt, &st);
+    PipelineEval(&pipeline, &dataset, NULL, &r);
+    PrintRow("dense", (long)FC1_NBOUTPUT * FC1_SIZE, 0.0, 0.0, st.ns_median, &r, dataset.count);
+
+    // One factorization per rank, shared by the kernel benchmark and the test set
+    pipeline.fc1 = Fc1LowRankLayer;
+    for (k = 0; k < nb_sweep; k++) {
+        t0 = LatencyNow();
+        error = Fc1LowRank(weights.fc1_kernel, sweep[k], &fc1_lowrank);
+        ms_svd = (LatencyNow() - t0) / 1e6;
+        kernel.run = RunFc1LowRank;
+        BenchKernel(&kernel, &opt, &st);
+        PipelineEval(&pipeline, &dataset, NULL, &r);
+        Fc1LowRankFree(&fc1_lowrank);
+        snprintf(label, sizeof(label), "%d", sweep[k]);
+        PrintRow(label, (long)sweep[k] * (FC1_SIZE + FC1_NBOUTPUT), error, ms_svd, st.ns_median, &r,
+                 dataset.count);
+    }
+
+    DatasetFree(&dataset);
+    return 0;
+}
@@ -0,0 +1,22 @@
+/**
+ * @file lowrank.h
+ * @brief Rank sweep of the low-rank (truncated SVD) float FC1
+ *
+ * For each rank r, FC1 = U_r (S_r V_r^T) as factorized by ../FLOAT/svd.c.
+ * The sweep reports the MACs and weight bytes of the two thin products,
+ * r * (640 + 400) against 640 * 400 for the dense layer (break-even at
+ * r = 246), the relative Frobenius error of the approximation, the time of
+ * the factorization, the FC1 kernel time on its own (bench.h harness), and
+ * the errors and latencies of the float model with the factors as FC1
+ * (pipeline.h harness). Each rank is factorized once for both. The engine
+ * runs the same factors with EngineSetFc1Rank(r) (lenet eval -r).
+ */
+
+#ifndef LOWRANK_H
+#define LOWRANK_H
+
+#define LOWRANK_DEFAULT_SWEEP "8,16,32,64,96,128,192,256,400"
+
+int LowRankMain(int argc, char **argv);
+
+#endif // LOWRANK_H
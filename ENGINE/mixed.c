@@ -0,0 +1,148 @@
+/**
+ * @file mixed.c
+ * @brief Search of the per-layer precisions of the mixed engine and its command line front end, see mixed.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../COMMON/latency.h"
+#include "mixed.h"
+
+#define MIXED_NB_ASSIGNMENTS (LAYER_PRECISION_NB * LAYER_PRECISION_NB * LAYER_PRECISION_NB * LAYER_PRECISION_NB)
+
+typedef struct {
+    layer_precision_t layers[ENGINE_NB_LAYERS];
+    long              bytes;            // weights of the four layers
+    int               errors, same;     // same: predictions identical to fp32
+    double            ns_image;
+} mixed_result_t;
+
+/// @brief Test set single thread with the current layers; the first call (all fp32) writes the reference
+static void Eval(const dataset_t *dataset, unsigned char *reference, int first, mixed_result_t *r)
+{
+    engine_prediction_t pred;
+    unsigned long long t0;
+    int i, l;
+
+    r->errors = r->same = 0;
+    r->bytes = 0;
+    for (l = 0; l < ENGINE_NB_LAYERS; l++)
+        r->bytes += MixedWeightBytes(l, r->layers[l]);
+    t0 = LatencyNow();
+    for (i = 0; i < dataset->count; i++) {
+        EngineClassify(PRECISION_MIXED, dataset->images + (long)i * ENGINE_IMG_SIZE, &pred, NULL);
+        r->errors += pred.number != dataset->labels[i];
+        if (first)
+            reference[i] = pred.number;
+        r->same += pred.number == reference[i];
+    }
+    r->ns_image = (double)(LatencyNow() - t0) / (dataset->count ? dataset->count : 1);
+}
+
+static double Accuracy(const mixed_result_t *r, int count)
+{
+    return count ? 100.0 * (count - r->errors) / count : 0.0;
+}
+
+/// @brief Comma-separated layer precisions, the -l argument of lenet eval
+static const char *LayersString(const layer_precision_t layers[ENGINE_NB_LAYERS])
+{
+    static char buffer[64];
+    int l, n = 0;
+
+    for (l = 0; l < ENGINE_NB_LAYERS; l++)
+        n += snprintf(buffer + n, sizeof(buffer) - n, "%s%s", l ? "," : "", LayerPrecisionName(layers[l]));
+    return buffer;
+}
+
+static void PrintRow(const mixed_result_t *r, double ns_fp32, int count)
+{
+    printf("%-6s %-6s %-6s %-6s %9.1f %7d %8.2f%% %8.1f%% %10.1f %9.0f %7.2fx\n", LayerPrecisionName(r->layers[0]),
+           LayerPrecisionName(r->layers[1]), LayerPrecisionName(r->layers[2]), LayerPrecisionName(r->layers[3]),
+           r->bytes / 1024.0, r->errors, Accuracy(r, count), count ? 100.0 * r->same / count : 0.0,
+           r->ns_image / 1e3, r->ns_image > 0 ? 1e9 / r->ns_image : 0.0,
+           r->ns_image > 0 ? ns_fp32 / r->ns_image : 0.0);
+    fflush(stdout);
+}
+
+static int CompareThroughput(const void *a, const void *b)
+{
+    double x = ((const mixed_result_t *)a)->ns_image, y = ((const mixed_result_t *)b)->ns_image;
+
+    return (x > y) - (x < y);
+}
+
+/// @brief Command line front end: [-m model] [-d dir] [-n max_images] [-a accuracy_floor] [-k top]
+int MixedMain(int argc, char **argv)
+{
+    const char *model = ENGINE_DEFAULT_MODEL, *dir = ENGINE_DEFAULT_DATASET;
+    mixed_result_t results[MIXED_NB_ASSIGNMENTS], kept[MIXED_NB_ASSIGNMENTS];
+    int max_images = -1, top = MIXED_DEFAULT_TOP, nb_kept = 0, a, l, k, code;
+    double accuracy_floor = -1.0;
+    unsigned char *reference;
+    dataset_t dataset;
+
+    for (k = 1; k < argc; k++) {
+        if (strcmp(argv[k], "-m") == 0 && k + 1 < argc)
+            model = argv[++k];
+        else if (strcmp(argv[k], "-d") == 0 && k + 1 < argc)
+            dir = argv[++k];
+        else if (strcmp(argv[k], "-n") == 0 && k + 1 < argc)
+            max_images = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-a") == 0 && k + 1 < argc)
+            accuracy_floor = atof(argv[++k]);
+        else if (strcmp(argv[k], "-k") == 0 && k + 1 < argc)
+            top = atoi(argv[++k]);
+        else {
+            printf("Usage: %s [-m model] [-d dir] [-n max_images] [-a accuracy_floor] [-k top]\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    EngineInit(model, PRECISION_MIXED);
+    DatasetLoad(dir, max_images, &dataset);
+    reference = malloc(dataset.count ? dataset.count : 1);
+    if (!reference) {
+        printf("Error: Unable to allocate the predictions.\n");
+        exit(1);
+    }
+
+    // Assignment a gives layer l the precision of its base-4 digit l: 0 is all fp32
+    for (a = 0; a < MIXED_NB_ASSIGNMENTS; a++) {
+        for (l = 0, code = a; l < ENGINE_NB_LAYERS; l++, code /= LAYER_PRECISION_NB)
+            results[a].layers[l] = (layer_precision_t)(code % LAYER_PRECISION_NB);
+        EngineSetLayers(results[a].layers);
+        Eval(&dataset, reference, a == 0, &results[a]);
+    }
+    if (accuracy_floor < 0.0)
+        accuracy_floor = Accuracy(&results[0], dataset.count);
+
+    printf("Per-layer precision search, %d assignments, %d images, 1 thread\n", MIXED_NB_ASSIGNMENTS,
+           dataset.count);
+    printf("KB: weights, agree: same class as fp32, speedup: against fp32\n\n");
+    printf("%-6s %-6s %-6s %-6s %9s %7s %9s %9s %10s %9s %8s\n", "Conv1", "Conv2", "FC1", "FC2", "KB", "errors",
+           "accuracy", "agree", "us/image", "images/s", "speedup");
+
+    // Single precision assignments: four equal digits, multiples of 1111 in base 4
+    for (k = 0; k < LAYER_PRECISION_NB; k++)
+        PrintRow(&results[k * (MIXED_NB_ASSIGNMENTS - 1) / (LAYER_PRECISION_NB - 1)], results[0].ns_image,
+                 dataset.count);
+
+    for (a = 0; a < MIXED_NB_ASSIGNMENTS; a++)
+        if (Accuracy(&results[a], dataset.count) >= accuracy_floor - 1e-9)
+            kept[nb_kept++] = results[a];
+    qsort(kept, nb_kept, sizeof(kept[0]), CompareThroughput);
+
+    printf("\n%d of %d assignments reach %.2f%% accuracy, the %d fastest:\n\n", nb_kept, MIXED_NB_ASSIGNMENTS,
+           accuracy_floor, nb_kept < top ? nb_kept : top);
+    for (k = 0; k < nb_kept && k < top; k++)
+        PrintRow(&kept[k], results[0].ns_image, dataset.count);
+    if (nb_kept > 0)
+        printf("\nFastest: lenet eval -p mixed -l %s\n", LayersString(kept[0].layers));
+
+    free(reference);
+    DatasetFree(&dataset);
+    return 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file mixed.h
+ * @brief Mixed precision: one precision per layer, the activations converted between layers
+ *
+ * Each layer of PRECISION_MIXED (Conv1 and Conv2 with their pools, FC1,
+ * FC2) runs in fp32, fp16, int16 or int8 (engine.h). Its weights are those of
+ * the float model: rounded to fp16 (engine_mixed_float.c), to Q8 shorts or to
+ * signed chars on a per-layer power-of-two scale (engine_mixed_fixed.c),
+ * once at load time. The activations are held in a tensor tagged with its
+ * format: fp32 and fp16 layers read and write their own format, int16 and
+ * int8 layers read and write Q8 shorts (an int8 layer requantizes its input
+ * itself, see ../FIXED/int8_fixed.c). Whenever a layer's input format is not
+ * that of the previous output, engine_mixed.c inserts a conversion.
+ * The logits are converted to float for Predict.
+ *
+ * lenet mixed searches the 4^4 assignments: it classifies the test set
+ * single thread with each, and ranks those whose accuracy reaches a floor
+ * (by default that of fp32) by throughput. The table gives the weight
+ * bytes, the accuracy, the share of predictions equal to fp32 and the
+ * latency per image. The fastest assignment runs in lenet eval -p mixed -l.
+ */
+
+#ifndef MIXED_H
+#define MIXED_H
+
+#include "engine.h"
+
+#define MIXED_MAX_TENSOR (20 * 12 * 12)         // Pool1 output, the largest at a layer boundary
+#define MIXED_Q8_ONE     256.0f                 // 1 << FIXED_POINT
+#define MIXED_DEFAULT_TOP 10
+
+typedef enum {
+    TENSOR_FP32,
+    TENSOR_FP16,
+    TENSOR_Q8
+} tensor_format_t;
+
+typedef struct {
+    tensor_format_t format;
+    int             size;
+    union {
+        float          f[MIXED_MAX_TENSOR];
+        unsigned short h[MIXED_MAX_TENSOR];     // half_t of ../FLOAT/lenet_cnn_float.h
+        short          q[MIXED_MAX_TENSOR];
+    } data;
+} mixed_tensor_t;
+
+// Float side (engine_mixed_float.c): normalized image, format conversions, fp32 / fp16 layers, prediction
+void MixedFloatInit(const char *model_filename);
+void MixedFloatInput(const unsigned char *pixels, mixed_tensor_t *output);
+void MixedConvert(const mixed_tensor_t *input, tensor_format_t format, mixed_tensor_t *output);
+void MixedFloatLayer(int layer, layer_precision_t precision, const mixed_tensor_t *input, mixed_tensor_t *output);
+void MixedFloatPredict(const mixed_tensor_t *logits, engine_prediction_t *pred, float *probs);
+long MixedWeightBytes(int layer, layer_precision_t precision);
+
+// Fixed side (engine_mixed_fixed.c): int16 / int8 layers, Q8 input and output
+void MixedFixedInit(const char *model_filename);
+void MixedFixedLayer(int layer, layer_precision_t precision, const mixed_tensor_t *input, mixed_tensor_t *output);
+
+int MixedMain(int argc, char **argv);
+
+#endif // MIXED_H
@@ -0,0 +1,134 @@
+/**
+ * @file outofcore.c
+ * @brief Chunk size sweep of the out-of-core fixed FC1 and its command line front end, see outofcore.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../FIXED/lenet_cnn_fixed.h"
+#include "../COMMON/chunk_reader.h"
+#include "pipeline.h"
+#include "outofcore.h"
+
+#define OUTOFCORE_MAX_SWEEP 32
+
+static chunk_reader_t *stream;         // reader of the streamed FC1
+
+/// @brief FC1 with its kernel read from stream chunk by chunk
+static void Fc1Stream(void *input, void *output)
+{
+    int acc[FC1_NBOUTPUT], first = 0;
+    const void *chunk;
+    long bytes;
+
+    memset(acc, 0, sizeof(acc));
+    while ((bytes = ChunkReaderNext(stream, &chunk)) > 0) {
+        Fc1_40_400_chunk_fixed(input, chunk, first, (int)(bytes / sizeof(short)), acc);
+        first += (int)(bytes / sizeof(short));
+    }
+    // The prefetch thread reads the first chunks of the next image during its convolutions
+    ChunkReaderRewind(stream);
+    Fc1_40_400_finish_fixed(acc, FC1_BIAS, output);
+}
+
+/// @brief Test set with FC1 resident (reader NULL) or streamed, compared with the resident run; mean stall per image
+static double Eval(const dataset_t *dataset, chunk_reader_t *reader, pipeline_reference_t *reference,
+                   pipeline_result_t *result)
+{
+    pipeline_t pipeline = { PIPELINE_FIXED, NULL, 0, NULL, NULL, NULL, NULL };
+
+    stream = reader;
+    if (reader)
+        pipeline.fc1 = Fc1Stream;
+    PipelineEval(&pipeline, dataset, reference, result);
+    return reader ? (double)reader->stall_ns / (dataset->count ? dataset->count : 1) : 0.0;
+}
+
+static void PrintRow(const char *chunk, const char *mode, double ram_kb, int chunks, double ns_stall,
+                     const pipeline_result_t *r, int count)
+{
+    printf("%8s %-9s %8.1f %7d %9.1f %6d", chunk, mode, ram_kb, chunks, ns_stall / 1e3, r->same);
+    PipelinePrintColumns(r, count);
+}
+
+/// @brief Command line front end: [-d dir] [-n max_images] [-f fc1_kernel.bin] [-c chunk_kb,...] [-r MB/s]
+int StreamMain(int argc, char **argv)
+{
+    const char *dir = ENGINE_DEFAULT_DATASET, *filename = OUTOFCORE_DEFAULT_FILE;
+    char sweep_list[256] = OUTOFCORE_DEFAULT_CHUNKS, *token, label[16];
+    int sweep[OUTOFCORE_MAX_SWEEP], max_images = -1, nb_sweep = 0, k, prefetch;
+    const long size = sizeof(FC1_KERNEL);
+    double rate = 0.0;
+    pipeline_reference_t reference;
+    pipeline_result_t result;
+    chunk_reader_t reader;
+    double ns_stall;
+    dataset_t dataset;
+    long chunk_bytes;
+    FILE *file;
+
+    for (k = 1; k < argc; k++) {
+        if (strcmp(argv[k], "-d") == 0 && k + 1 < argc)
+            dir = argv[++k];
+        else if (strcmp(argv[k], "-n") == 0 && k + 1 < argc)
+            max_images = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-f") == 0 && k + 1 < argc)
+            filename = argv[++k];
+        else if (strcmp(argv[k], "-c") == 0 && k + 1 < argc)
+            snprintf(sweep_list, sizeof(sweep_list), "%s", argv[++k]);
+        else if (strcmp(argv[k], "-r") == 0 && k + 1 < argc)
+            rate = atof(argv[++k]);
+        else {
+            printf("Usage: %s [-d dir] [-n max_images] [-f fc1_kernel.bin] [-c chunk_kb,...] [-r MB/s]\n", argv[0]);
+            exit(1);
+        }
+    }
+    for (token = strtok(sweep_list, ","); token && nb_sweep < OUTOFCORE_MAX_SWEEP; token = strtok(NULL, ",")) {
+        sweep[nb_sweep] = atoi(token);
+        if (sweep[nb_sweep] < 1) {
+            printf("Error: Chunk of %s KB.\n", token);
+            exit(1);
+        }
+        nb_sweep++;
+    }
+
+    // The FC1 kernel as it would sit in flash, raw Q8 shorts in row-major order
+    file = fopen(filename, "wb");
+    if (!file || fwrite(FC1_KERNEL, 1, size, file) != (size_t)size) {
+        printf("Error: Unable to write file %s.\n", filename);
+        exit(1);
+    }
+    fclose(file);
+
+    DatasetLoad(dir, max_images, &dataset);
+    PipelineReferenceInit(&reference, dataset.count);
+    if (rate > 0.0)
+        printf("FC1 kernel (%.0f KB) streamed from %s read at %.1f MB/s, %d images, 1 thread\n\n", size / 1024.0,
+               filename, rate, dataset.count);
+    else
+        printf("FC1 kernel (%.0f KB) streamed from %s, %d images, 1 thread\n\n", size / 1024.0, filename,
+               dataset.count);
+    printf("%8s %-9s %8s %7s %9s %6s", "chunk KB", "reads", "RAM KB", "chunks", "stall us", "same");
+    PipelinePrintHeader();
+
+    Eval(&dataset, NULL, &reference, &result);
+    PrintRow("-", "resident", size / 1024.0, 0, 0.0, &result, dataset.count);
+
+    for (k = 0; k < nb_sweep; k++) {
+        chunk_bytes = sweep[k] * 1024L < size ? sweep[k] * 1024L : size;
+        snprintf(label, sizeof(label), "%d", sweep[k]);
+        for (prefetch = 0; prefetch <= 1; prefetch++) {
+            ChunkReaderOpen(&reader, filename, 0, size, chunk_bytes, prefetch, rate);
+            ns_stall = Eval(&dataset, &reader, &reference, &result);
+            ChunkReaderClose(&reader);
+            PrintRow(label, prefetch ? "prefetch" : "sync", (prefetch ? 2 : 1) * chunk_bytes / 1024.0,
+                     (int)((size + chunk_bytes - 1) / chunk_bytes), ns_stall, &result, dataset.count);
+        }
+    }
+
+    PipelineReferenceFree(&reference);
+    DatasetFree(&dataset);
+    return 0;
+}
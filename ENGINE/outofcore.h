@@ -0,0 +1,28 @@
+/**
+ * @file outofcore.h
+ * @brief Out-of-core FC1 of the fixed model: its kernel read from a file in fixed-size chunks
+ *
+ * FC1 holds 500 KB of the 549 KB of Q8 weights. In this mode its kernel is
+ * not resident: it is written once to a file (or a flash region), and every
+ * inference reads it back chunk by chunk through a chunk_reader_t
+ * (../COMMON/chunk_reader.h) while Fc1_40_400_chunk_fixed adds the products
+ * of each chunk to the FC1 sums, so the weight RAM of FC1 is one chunk, or
+ * two with the prefetching reader. The test set runs through the per-layer
+ * harness (pipeline.h) with the resident kernel, then for every chunk size
+ * with synchronous and prefetched reads; the table gives the weight RAM, the
+ * time FC1 waited for its weights, then the errors and the latencies. The outputs
+ * are those of the resident kernel, bit for bit. A rate in MB/s makes the
+ * reads as slow as on the target's flash, where the prefetch pays off.
+ */
+
+#ifndef OUTOFCORE_H
+#define OUTOFCORE_H
+
+#include "engine.h"
+
+#define OUTOFCORE_DEFAULT_FILE   "fc1_kernel.bin"
+#define OUTOFCORE_DEFAULT_CHUNKS "1,4,16,64,256,500"    // KB
+
+int StreamMain(int argc, char **argv);
+
+#endif // OUTOFCORE_H
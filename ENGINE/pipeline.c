@@ -0,0 +1,179 @@
+/**
+ * @file pipeline.c
+ * @brief Float and half passes of the per-layer harness, evaluation and table columns, see pipeline.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../FLOAT/lenet_cnn_float.h"
+#include "../FIXED/weights_float.h"
+#include "../COMMON/alloc.h"
+#include "../COMMON/latency.h"
+#include "pipeline.h"
+
+_Static_assert(ENGINE_IMG_SIZE == IMG_DEPTH * IMG_HEIGHT * IMG_WIDTH, "image size");
+_Static_assert(ENGINE_NB_CLASSES == FC2_NBOUTPUT, "number of classes");
+
+void PipelineReferenceInit(pipeline_reference_t *reference, int count)
+{
+    reference->valid = 0;
+    reference->predictions = Allocate(count);
+    reference->logits = Allocate((size_t)count * ENGINE_NB_CLASSES * sizeof(float));
+}
+
+void PipelineReferenceFree(pipeline_reference_t *reference)
+{
+    free(reference->predictions);
+    free(reference->logits);
+    reference->predictions = NULL;
+    reference->logits = NULL;
+    reference->valid = 0;
+}
+
+/// @brief Float pass, the dense layers from pipeline->weights
+static int ClassifyFloat(const pipeline_t *pipeline, const unsigned char *pixels, float output[FC2_NBOUTPUT],
+                         unsigned long long ns_layer[PIPELINE_NB_LAYERS])
+{
+    lenet_float_weights_t *w = pipeline->weights;
+    float input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+    float conv1_output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH];
+    float pool1_output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH];
+    float conv2_output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH];
+    float pool2_output[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+    float fc1_output[FC1_NBOUTPUT];
+    unsigned long long t0;
+    prediction_t p;
+    bbox_t box;
+
+    NormalizeImg((unsigned char *)pixels, (float *)input, IMG_WIDTH, IMG_HEIGHT);
+    t0 = LatencyNow();
+    if (pipeline->conv1)
+        pipeline->conv1(input, conv1_output);
+    else {
+        InputBoundingBox(input, &box);
+        Conv1_28x28x1_5x5x20_1_0_crop(input, &box, w->conv1_kernel, w->conv1_bias, conv1_output);
+    }
+    ns_layer[PIPELINE_CONV1] += LatencyNow() - t0;
+    Pool1_24x24x20_2x2x20_2_0(conv1_output, pool1_output);
+    t0 = LatencyNow();
+    if (pipeline->conv2)
+        pipeline->conv2(pool1_output, conv2_output);
+    else
+        Conv2_12x12x20_5x5x40_1_0(pool1_output, w->conv2_kernel, w->conv2_bias, conv2_output);
+    ns_layer[PIPELINE_CONV2] += LatencyNow() - t0;
+    Pool2_8x8x40_2x2x40_2_0(conv2_output, pool2_output);
+    t0 = LatencyNow();
+    if (pipeline->fc1)
+        pipeline->fc1(pool2_output, fc1_output);
+    else
+        Fc1_40_400(pool2_output, w->fc1_kernel, w->fc1_bias, fc1_output);
+    ns_layer[PIPELINE_FC1] += LatencyNow() - t0;
+    t0 = LatencyNow();
+    if (pipeline->fc2)
+        pipeline->fc2(fc1_output, output);
+    else
+        Fc2_400_10(fc1_output, w->fc2_kernel, w->fc2_bias, output);
+    ns_layer[PIPELINE_FC2] += LatencyNow() - t0;
+    Predict(output, &p);
+    return p.number;
+}
+
+/// @brief Half pass: the input rounded as it is normalized, every map stored as half_t, the four layers given
+static int ClassifyHalf(const pipeline_t *pipeline, const unsigned char *pixels, float output[FC2_NBOUTPUT],
+                        unsigned long long ns_layer[PIPELINE_NB_LAYERS])
+{
+    float normalized[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+    half_t input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+    half_t conv1_output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH];
+    half_t pool1_output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH];
+    half_t conv2_output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH];
+    half_t pool2_output[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+    half_t fc1_output[FC1_NBOUTPUT];
+    unsigned long long t0;
+    prediction_t p;
+
+    NormalizeImg((unsigned char *)pixels, (float *)normalized, IMG_WIDTH, IMG_HEIGHT);
+    HalfFromFloat(&normalized[0][0][0], &input[0][0][0], IMG_DEPTH * IMG_HEIGHT * IMG_WIDTH,
+                  (half_format_t)pipeline->half_format);
+    t0 = LatencyNow();
+    pipeline->conv1(input, conv1_output);
+    ns_layer[PIPELINE_CONV1] += LatencyNow() - t0;
+    Pool1_24x24x20_2x2x20_2_0_half(conv1_output, pool1_output);
+    t0 = LatencyNow();
+    pipeline->conv2(pool1_output, conv2_output);
+    ns_layer[PIPELINE_CONV2] += LatencyNow() - t0;
+    Pool2_8x8x40_2x2x40_2_0_half(conv2_output, pool2_output);
+    t0 = LatencyNow();
+    pipeline->fc1(pool2_output, fc1_output);
+    ns_layer[PIPELINE_FC1] += LatencyNow() - t0;
+    t0 = LatencyNow();
+    pipeline->fc2(fc1_output, output);
+    ns_layer[PIPELINE_FC2] += LatencyNow() - t0;
+    Predict(output, &p);
+    return p.number;
+}
+
+int PipelineClassify(const pipeline_t *pipeline, const unsigned char *pixels, float logits[ENGINE_NB_CLASSES],
+                     unsigned long long ns_layer[PIPELINE_NB_LAYERS])
+{
+    switch (pipeline->precision) {
+    case PIPELINE_FIXED:
+        return PipelineClassify_fixed(pipeline, pixels, logits, ns_layer);
+    case PIPELINE_HALF:
+        return ClassifyHalf(pipeline, pixels, logits, ns_layer);
+    default:
+        return ClassifyFloat(pipeline, pixels, logits, ns_layer);
+    }
+}
+
+void PipelineEval(const pipeline_t *pipeline, const dataset_t *dataset, pipeline_reference_t *reference,
+                  pipeline_result_t *result)
+{
+    unsigned long long t0, ns_layer[PIPELINE_NB_LAYERS] = { 0 };
+    float logits[ENGINE_NB_CLASSES], *ref;
+    double delta;
+    int i, k, n, count = dataset->count ? dataset->count : 1;
+
+    memset(result, 0, sizeof(*result));
+    t0 = LatencyNow();
+    for (i = 0; i < dataset->count; i++) {
+        n = PipelineClassify(pipeline, dataset->images + (long)i * ENGINE_IMG_SIZE, logits, ns_layer);
+        result->errors += n != dataset->labels[i];
+        if (!reference)
+            continue;
+        ref = reference->logits + (long)i * ENGINE_NB_CLASSES;
+        if (!reference->valid) {
+            reference->predictions[i] = (unsigned char)n;
+            memcpy(ref, logits, sizeof(logits));
+        }
+        result->same += n == reference->predictions[i];
+        for (k = 0; k < ENGINE_NB_CLASSES; k++) {
+            delta = fabs(logits[k] - ref[k]);
+            if (delta > result->max_delta)
+                result->max_delta = delta;
+        }
+    }
+    result->ns_image = (double)(LatencyNow() - t0) / count;
+    for (k = 0; k < PIPELINE_NB_LAYERS; k++)
+        result->ns_layer[k] = (double)ns_layer[k] / count;
+    if (reference)
+        reference->valid = 1;
+}
+
+void PipelinePrintHeader(void)
+{
+    printf(" %7s %9s %10s %9s %9s %9s %9s\n", "errors", "accuracy", "us/image", "Conv1 us", "Conv2 us", "FC1 us",
+           "FC2 us");
+}
+
+void PipelinePrintColumns(const pipeline_result_t *result, int count)
+{
+    printf(" %7d %8.2f%% %10.1f %9.1f %9.1f %9.1f %9.1f\n", result->errors,
+           count ? 100.0 * (count - result->errors) / count : 0.0, result->ns_image / 1e3,
+           result->ns_layer[PIPELINE_CONV1] / 1e3, result->ns_layer[PIPELINE_CONV2] / 1e3,
+           result->ns_layer[PIPELINE_FC1] / 1e3, result->ns_layer[PIPELINE_FC2] / 1e3);
+    fflush(stdout);
+}
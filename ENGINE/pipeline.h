@@ -0,0 +1,74 @@
+/**
+ * @file pipeline.h
+ * @brief Per-layer harness of the sweep tools: one image through the LeNet-5 layers, any weighted layer
+ *        replaced, each one timed, and the test set evaluated against a reference run
+ *
+ * The sweep tools (prune, lowrank, cluster, pow2, xnor, entropy, stream,
+ * half) compare variants of Conv1, Conv2, FC1 or FC2 with the dense model.
+ * A variant is a pipeline_t: the precision it runs in and the layers it
+ * replaces, NULL keeping the dense kernel (float weights given by the tool,
+ * Q8 weights of weights.h for the fixed pipeline). All variants run the same
+ * pass: the input as the engine takes it (float NormalizeImg, fixed raw
+ * pixels), Conv1 cropped to the input bounding box unless replaced, the
+ * pools of the tops, and the four weighted layers each timed on its own, so
+ * that the latencies of all the tools compare. The half precision stores
+ * the activations as fp16 or bf16 and has no dense kernels: its four layers
+ * are always given. PipelineEval classifies the test set single thread, one
+ * image at a time; the first run given a reference records its predictions
+ * and logits, the next ones are compared with them.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "engine.h"
+
+typedef enum {
+    PIPELINE_FLOAT,
+    PIPELINE_FIXED,                     // Q8 shorts, logits in logit units
+    PIPELINE_HALF                       // half_t maps, float logits
+} pipeline_precision_t;
+
+enum { PIPELINE_CONV1, PIPELINE_CONV2, PIPELINE_FC1, PIPELINE_FC2, PIPELINE_NB_LAYERS };
+
+// A weighted layer: input and output are its maps in the precision of the pipeline (FC2 of half: float logits)
+typedef void (*pipeline_layer_t)(void *input, void *output);
+
+typedef struct {
+    pipeline_precision_t precision;
+    void                *weights;       // float: lenet_float_weights_t of the dense layers, NULL otherwise
+    int                  half_format;   // half: half_format_t of the input
+    pipeline_layer_t     conv1, conv2, fc1, fc2;    // NULL: the dense kernel
+} pipeline_t;
+
+typedef struct {
+    int    errors, same;                // same: predictions equal to the reference run's
+    double max_delta;                   // largest |logit - reference logit|
+    double ns_image;                    // mean per image
+    double ns_layer[PIPELINE_NB_LAYERS];
+} pipeline_result_t;
+
+typedef struct {
+    int            valid;               // set by the first run, the next ones are compared with it
+    unsigned char *predictions;         // [count]
+    float         *logits;              // [count][ENGINE_NB_CLASSES]
+} pipeline_reference_t;
+
+void PipelineReferenceInit(pipeline_reference_t *reference, int count);
+void PipelineReferenceFree(pipeline_reference_t *reference);
+
+// One image, returns the class; adds the ns of each weighted layer to ns_layer
+int  PipelineClassify(const pipeline_t *pipeline, const unsigned char *pixels, float logits[ENGINE_NB_CLASSES],
+                      unsigned long long ns_layer[PIPELINE_NB_LAYERS]);
+// Fixed side of PipelineClassify (pipeline_fixed.c)
+int  PipelineClassify_fixed(const pipeline_t *pipeline, const unsigned char *pixels,
+                            float logits[ENGINE_NB_CLASSES], unsigned long long ns_layer[PIPELINE_NB_LAYERS]);
+// The test set; reference may be NULL
+void PipelineEval(const pipeline_t *pipeline, const dataset_t *dataset, pipeline_reference_t *reference,
+                  pipeline_result_t *result);
+
+// Last columns of the tools' tables: errors, accuracy, us per image and per weighted layer, then a new line
+void PipelinePrintHeader(void);
+void PipelinePrintColumns(const pipeline_result_t *result, int count);
+
+#endif // PIPELINE_H
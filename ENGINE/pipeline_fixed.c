@@ -0,0 +1,61 @@
+/**
+ * @file pipeline_fixed.c
+ * @brief Fixed-point pass of the per-layer harness: the Q8 weights of weights.h, see pipeline.h
+ */
+
+#include "../FIXED/lenet_cnn_fixed.h"
+#include "../COMMON/latency.h"
+#include "pipeline.h"
+
+int PipelineClassify_fixed(const pipeline_t *pipeline, const unsigned char *pixels, float logits[ENGINE_NB_CLASSES],
+                           unsigned long long ns_layer[PIPELINE_NB_LAYERS])
+{
+    short input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+    short conv1_output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH];
+    short pool1_output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH];
+    short conv2_output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH];
+    short pool2_output[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+    short fc1_output[FC1_NBOUTPUT];
+    short output[FC2_NBOUTPUT];
+    unsigned long long t0;
+    prediction_fixed_t p;
+    bbox_fixed_t box;
+    int i;
+
+    // Same as the engine: raw pixels, no scaling
+    for (i = 0; i < ENGINE_IMG_SIZE; i++)
+        ((short *)input)[i] = pixels[i];
+    t0 = LatencyNow();
+    if (pipeline->conv1)
+        pipeline->conv1(input, conv1_output);
+    else {
+        InputBoundingBox_fixed(input, &box);
+        Conv1_28x28x1_5x5x20_1_0_crop_fixed(input, &box, CONV1_KERNEL, CONV1_BIAS, conv1_output);
+    }
+    ns_layer[PIPELINE_CONV1] += LatencyNow() - t0;
+    Pool1_24x24x20_2x2x20_2_0_fixed(conv1_output, pool1_output);
+    t0 = LatencyNow();
+    if (pipeline->conv2)
+        pipeline->conv2(pool1_output, conv2_output);
+    else
+        Conv2_12x12x20_5x5x40_1_0_fixed(pool1_output, CONV2_KERNEL, CONV2_BIAS, conv2_output);
+    ns_layer[PIPELINE_CONV2] += LatencyNow() - t0;
+    Pool2_8x8x40_2x2x40_2_0_fixed(conv2_output, pool2_output);
+    t0 = LatencyNow();
+    if (pipeline->fc1)
+        pipeline->fc1(pool2_output, fc1_output);
+    else
+        Fc1_40_400_fixed(pool2_output, FC1_KERNEL, FC1_BIAS, fc1_output);
+    ns_layer[PIPELINE_FC1] += LatencyNow() - t0;
+    t0 = LatencyNow();
+    if (pipeline->fc2)
+        pipeline->fc2(fc1_output, output);
+    else
+        Fc2_400_10_fixed(fc1_output, FC2_KERNEL, FC2_BIAS, output);
+    ns_layer[PIPELINE_FC2] += LatencyNow() - t0;
+
+    for (i = 0; i < FC2_NBOUTPUT; i++)
+        logits[i] = SHORT2FLOAT(output[i]);
+    Predict_fixed(output, &p);
+    return p.number;
+}
@@ -0,0 +1,219 @@
+/**
+ * @file pow2.c
+ * @brief Per-layer power-of-two weight sweep of the fixed model and its command line front end, see pow2.h
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../FIXED/lenet_cnn_fixed.h"
+#include "pipeline.h"
+#include "pow2.h"
+
+#define POW2_CONV1 1
+#define POW2_CONV2 2
+#define POW2_FC1   4
+#define POW2_FC2   8
+#define POW2_ALL   (POW2_CONV1 | POW2_CONV2 | POW2_FC1 | POW2_FC2)
+
+static pow2_fixed_t conv1_kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+static pow2_fixed_t conv2_kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+static pow2_fixed_t fc1_kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+static pow2_fixed_t fc2_kernel[FC2_NBOUTPUT][FC1_NBOUTPUT];
+
+typedef struct {
+    const char *name;
+    const char *declaration;            // of the array in a weights header
+    int dims[4];                        // outer dimensions, 0 past the last
+    int mask;
+    const short *dense;
+    pow2_fixed_t *pow2;
+    int size;
+} pow2_layer_t;
+
+static const pow2_layer_t layers[] = {
+    { "Conv1", "CONV1_KERNEL_POW2[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM]",
+      { CONV1_NBOUTPUT, IMG_DEPTH, CONV1_DIM, CONV1_DIM }, POW2_CONV1,
+      &CONV1_KERNEL[0][0][0][0], &conv1_kernel[0][0][0][0], sizeof(CONV1_KERNEL) / sizeof(short) },
+    { "Conv2", "CONV2_KERNEL_POW2[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM]",
+      { CONV2_NBOUTPUT, POOL1_NBOUTPUT, CONV2_DIM, CONV2_DIM }, POW2_CONV2,
+      &CONV2_KERNEL[0][0][0][0], &conv2_kernel[0][0][0][0], sizeof(CONV2_KERNEL) / sizeof(short) },
+    { "FC1", "FC1_KERNEL_POW2[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH]",
+      { FC1_NBOUTPUT, POOL2_NBOUTPUT, POOL2_HEIGHT, POOL2_WIDTH }, POW2_FC1,
+      &FC1_KERNEL[0][0][0][0], &fc1_kernel[0][0][0][0], sizeof(FC1_KERNEL) / sizeof(short) },
+    { "FC2", "FC2_KERNEL_POW2[FC2_NBOUTPUT][FC1_NBOUTPUT]",
+      { FC2_NBOUTPUT, FC1_NBOUTPUT, 0, 0 }, POW2_FC2,
+      &FC2_KERNEL[0][0], &fc2_kernel[0][0], sizeof(FC2_KERNEL) / sizeof(short) },
+};
+#define NB_LAYERS ((int)(sizeof(layers) / sizeof(layers[0])))
+
+static void Conv1Pow2(void *input, void *output)
+{
+    Conv1_28x28x1_5x5x20_1_0_pow2_fixed(input, conv1_kernel, CONV1_BIAS, output);
+}
+
+static void Conv2Pow2(void *input, void *output)
+{
+    Conv2_12x12x20_5x5x40_1_0_pow2_fixed(input, conv2_kernel, CONV2_BIAS, output);
+}
+
+static void Fc1Pow2(void *input, void *output)
+{
+    Fc1_40_400_pow2_fixed(input, fc1_kernel, FC1_BIAS, output);
+}
+
+static void Fc2Pow2(void *input, void *output)
+{
+    Fc2_400_10_pow2_fixed(input, fc2_kernel, FC2_BIAS, output);
+}
+
+/// @brief The dataset through the fixed pipeline, the layers of mask on power-of-two weights
+static void Eval(const dataset_t *dataset, int mask, pipeline_result_t *result)
+{
+    pipeline_t pipeline = { PIPELINE_FIXED, NULL, 0, NULL, NULL, NULL, NULL };
+
+    if (mask & POW2_CONV1)
+        pipeline.conv1 = Conv1Pow2;
+    if (mask & POW2_CONV2)
+        pipeline.conv2 = Conv2Pow2;
+    if (mask & POW2_FC1)
+        pipeline.fc1 = Fc1Pow2;
+    if (mask & POW2_FC2)
+        pipeline.fc2 = Fc2Pow2;
+    PipelineEval(&pipeline, dataset, NULL, result);
+}
+
+static void PrintRow(int terms, const char *name, double rms, double exact, const pipeline_result_t *r,
+                     int base_errors, int count)
+{
+    double loss = count ? 100.0 * (r->errors - base_errors) / count : 0.0;
+
+    printf("%5d %-6s %9.5f %8.1f%% %+8.2f", terms, name, rms, 100 * exact, loss);
+    PipelinePrintColumns(r, count);
+}
+
+/// @brief Include guard of a header from its file name: WEIGHTS_POW2_H for dir/weights_pow2.h
+static void HeaderGuard(const char *filename, char *guard, int size)
+{
+    const char *base = strrchr(filename, '/') ? strrchr(filename, '/') + 1 : filename;
+    int n;
+
+    for (n = 0; base[n] && n < size - 1; n++)
+        guard[n] = isalnum((unsigned char)base[n]) ? toupper((unsigned char)base[n]) : '_';
+    guard[n] = '\0';
+    if (n == 0 || isdigit((unsigned char)guard[0]))
+        snprintf(guard, size, "WEIGHTS_POW2_H");
+}
+
+/// @brief Write the quantized kernels as C arrays of {hi, lo} terms, one brace level per dimension
+static void WriteHeader(const char *filename, int terms)
+{
+    FILE *file = fopen(filename, "w");
+    int stride[4], nb_dims, l, d, i;
+    char guard[64];
+
+    if (!file) {
+        printf("Error: Unable to open file %s.\n", filename);
+        exit(1);
+    }
+    HeaderGuard(filename, guard, sizeof(guard));
+    fprintf(file, "// Power-of-two kernels (%d term%s) of weights.h, see pow2_fixed_t; biases as in weights.h\n\n",
+            terms, terms > 1 ? "s" : "");
+    fprintf(file, "#ifndef %s\n#define %s\n\n#include \"lenet_cnn_fixed.h\"\n\n", guard, guard);
+    for (l = 0; l < NB_LAYERS; l++) {
+        for (nb_dims = 0; nb_dims < 4 && layers[l].dims[nb_dims]; nb_dims++)
+            ;
+        stride[nb_dims - 1] = 1;
+        for (d = nb_dims - 2; d >= 0; d--)
+            stride[d] = stride[d + 1] * layers[l].dims[d + 1];
+
+        fprintf(file, "const pow2_fixed_t %s = {\n", layers[l].declaration);
+        for (i = 0; i < layers[l].size; i++) {
+            for (d = 0; d < nb_dims - 1; d++)
+                if (i % stride[d] == 0)
+                    fprintf(file, "{");
+            fprintf(file, " { %d, %d },", layers[l].pow2[i].hi, layers[l].pow2[i].lo);
+            for (d = nb_dims - 2; d >= 0; d--)
+                if ((i + 1) % stride[d] == 0)
+                    fprintf(file, " },%s", d == nb_dims - 2 ? "\n" : "");
+        }
+        fprintf(file, "};\n\n");
+    }
+    fprintf(file, "#endif // %s\n", guard);
+    fclose(file);
+}
+
+/// @brief Command line front end: [-d dir] [-n max_images] [-t terms] [-o weights_pow2.h]
+int Pow2Main(int argc, char **argv)
+{
+    const char *dir = ENGINE_DEFAULT_DATASET, *output = NULL;
+    int max_images = -1, header_terms = 2, base_errors, terms, k, l, i, size, exact_all;
+    double sq, sq_all, d;
+    pipeline_result_t r;
+    dataset_t dataset;
+
+    for (k = 1; k < argc; k++) {
+        if (strcmp(argv[k], "-d") == 0 && k + 1 < argc)
+            dir = argv[++k];
+        else if (strcmp(argv[k], "-n") == 0 && k + 1 < argc)
+            max_images = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-t") == 0 && k + 1 < argc)
+            header_terms = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-o") == 0 && k + 1 < argc)
+            output = argv[++k];
+        else {
+            printf("Usage: %s [-d dir] [-n max_images] [-t terms] [-o weights_pow2.h]\n", argv[0]);
+            exit(1);
+        }
+    }
+    if (header_terms < 1 || header_terms > 2) {
+        printf("Error: %d terms out of [1, 2].\n", header_terms);
+        exit(1);
+    }
+
+    DatasetLoad(dir, max_images, &dataset);
+    printf("Power-of-two weights of the fixed model (+-2^a, +-2^a +- 2^b), %d images, 1 thread\n\n", dataset.count);
+    printf("%5s %-6s %9s %9s %8s", "terms", "layers", "rms err", "exact", "loss");
+    PipelinePrintHeader();
+
+    Eval(&dataset, 0, &r);
+    base_errors = r.errors;
+    PrintRow(0, "Q8", 0.0, 1.0, &r, base_errors, dataset.count);
+
+    for (terms = 1; terms <= 2; terms++) {
+        sq_all = 0.0;
+        exact_all = 0;
+        size = 0;
+        for (l = 0; l < NB_LAYERS; l++) {
+            int exact = 0;
+
+            Pow2Quantize_fixed(layers[l].dense, layers[l].size, terms, layers[l].pow2);
+            sq = 0.0;
+            for (i = 0; i < layers[l].size; i++) {
+                d = layers[l].dense[i] - Pow2Value_fixed(layers[l].pow2[i]);
+                sq += d * d;
+                exact += (d == 0.0);
+            }
+            sq_all += sq;
+            exact_all += exact;
+            size += layers[l].size;
+
+            Eval(&dataset, layers[l].mask, &r);
+            PrintRow(terms, layers[l].name, sqrt(sq / layers[l].size) / (1 << FIXED_POINT),   // weight units
+                     (double)exact / layers[l].size, &r, base_errors, dataset.count);
+        }
+        Eval(&dataset, POW2_ALL, &r);
+        PrintRow(terms, "all", sqrt(sq_all / size) / (1 << FIXED_POINT), (double)exact_all / size, &r,
+                 base_errors, dataset.count);
+        if (output && terms == header_terms) {
+            WriteHeader(output, terms);
+            printf("%d-term kernels written to %s\n", terms, output);
+        }
+    }
+
+    DatasetFree(&dataset);
+    return 0;
+}
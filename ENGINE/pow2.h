@@ -0,0 +1,24 @@
+/**
+ * @file pow2.h
+ * @brief Power-of-two weights of the fixed model: per-layer accuracy loss of the shift-add kernels
+ *
+ * The Q8 weights of weights.h are rounded to the nearest +-2^a (1 term) or
+ * +-2^a +- 2^b (2 terms), see ../FIXED/pow2_fixed.c, one layer at a time and
+ * then all four together. Quantized layers run through the multiplier-free
+ * _pow2_fixed kernels, the others through the dense fixed kernels; the
+ * biases stay Q8. For each case the test set runs through the per-layer
+ * harness (pipeline.h), and the table gives the RMS weight change, the
+ * share of weights that were already powers of two, the accuracy lost
+ * against Q8, then the errors and the latency of each layer.
+ * The kernels of one quantization can be written as a C header of
+ * pow2_fixed_t arrays for the HLS top.
+ */
+
+#ifndef POW2_H
+#define POW2_H
+
+#include "engine.h"
+
+int Pow2Main(int argc, char **argv);
+
+#endif // POW2_H
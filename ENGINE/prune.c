@@ -0,0 +1,221 @@
+/**
+ * @file prune.c
+ * @brief Float side of the pruning sweep and its command line front end, see prune.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../FLOAT/lenet_cnn_float.h"
+#include "../FIXED/weights_float.h"
+#include "../COMMON/alloc.h"
+#include "prune.h"
+
+#define CONV2_WEIGHTS (CONV2_NBOUTPUT * POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM)
+#define FC1_WEIGHTS   (FC1_NBOUTPUT * POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+#define PRUNE_MAX_SWEEP 32
+
+static lenet_float_weights_t weights;
+static csr_t conv2_csr, fc1_csr;
+static int dense = 1;
+
+static double ZeroShare(const float *w, int size)
+{
+    int i, zeros = 0;
+
+    for (i = 0; i < size; i++)
+        zeros += (w[i] == 0.0f);
+    return (double)zeros / size;
+}
+
+void PruneFloat(const char *model_filename, float sparsity)
+{
+    static int loaded = 0;
+    float *w;
+
+    if (!loaded) {
+        ReadFloatWeights((char *)model_filename, &weights);
+        loaded = 1;
+    }
+    CsrFree(&conv2_csr);
+    CsrFree(&fc1_csr);
+    dense = (sparsity < 0);
+    if (dense)
+        return;
+
+    // Prune a copy, the model keeps its dense weights for the next sparsity
+    w = Allocate(sizeof(weights.fc1_kernel));
+    memcpy(w, weights.conv2_kernel, sizeof(weights.conv2_kernel));
+    CsrPrune(w, CONV2_WEIGHTS, sparsity);
+    CsrFromDense(w, CONV2_NBOUTPUT, CONV2_WEIGHTS / CONV2_NBOUTPUT, &conv2_csr);
+    memcpy(w, weights.fc1_kernel, sizeof(weights.fc1_kernel));
+    CsrPrune(w, FC1_WEIGHTS, sparsity);
+    CsrFromDense(w, FC1_NBOUTPUT, FC1_WEIGHTS / FC1_NBOUTPUT, &fc1_csr);
+    free(w);
+}
+
+static void Conv2Csr(void *input, void *output)
+{
+    Conv2_12x12x20_5x5x40_1_0_csr(input, &conv2_csr, weights.conv2_bias, output);
+}
+
+static void Fc1Csr(void *input, void *output)
+{
+    Fc1_40_400_csr(input, &fc1_csr, weights.fc1_bias, output);
+}
+
+void PruneFloatEval(const dataset_t *dataset, prune_result_t *result)
+{
+    pipeline_t pipeline = { PIPELINE_FLOAT, &weights, 0, NULL, NULL, NULL, NULL };
+
+    if (!dense) {
+        pipeline.conv2 = Conv2Csr;
+        pipeline.fc1 = Fc1Csr;
+    }
+    PipelineEval(&pipeline, dataset, NULL, &result->eval);
+    if (dense) {
+        result->conv2_zeros = ZeroShare(&weights.conv2_kernel[0][0][0][0], CONV2_WEIGHTS);
+        result->fc1_zeros = ZeroShare(&weights.fc1_kernel[0][0][0][0], FC1_WEIGHTS);
+        result->bytes = sizeof(weights.conv2_kernel) + sizeof(weights.fc1_kernel);
+    } else {
+        result->conv2_zeros = 1.0 - (double)conv2_csr.nnz / CONV2_WEIGHTS;
+        result->fc1_zeros = 1.0 - (double)fc1_csr.nnz / FC1_WEIGHTS;
+        result->bytes = CsrBytes(&conv2_csr) + CsrBytes(&fc1_csr);
+    }
+}
+
+void PruneFloatWrite(FILE *file)
+{
+    CsrWrite(file, &conv2_csr);
+    CsrWrite(file, &fc1_csr);
+}
+
+void PruneFloatRead(FILE *file)
+{
+    CsrFree(&conv2_csr);
+    CsrFree(&fc1_csr);
+    CsrRead(file, &conv2_csr);
+    CsrRead(file, &fc1_csr);
+    if (conv2_csr.rows != CONV2_NBOUTPUT || conv2_csr.cols != CONV2_WEIGHTS / CONV2_NBOUTPUT
+        || fc1_csr.rows != FC1_NBOUTPUT || fc1_csr.cols != FC1_WEIGHTS / FC1_NBOUTPUT) {
+        printf("Error: CSR matrices do not match the Conv2 and FC1 dimensions.\n");
+        exit(1);
+    }
+    dense = 0;
+}
+
+static void PrintHeader(const char *precision)
+{
+    printf("%-6s %7s %11s %10s %12s", precision, "target", "Conv2 zeros", "FC1 zeros", "Conv2+FC1 KB");
+    PipelinePrintHeader();
+}
+
+static void PrintRow(const char *target, const prune_result_t *r, int count)
+{
+    printf("%-6s %7s %10.1f%% %9.1f%% %12.1f", "", target, 100 * r->conv2_zeros, 100 * r->fc1_zeros,
+           r->bytes / 1024.0);
+    PipelinePrintColumns(&r->eval, count);
+}
+
+/// @brief Command line front end: [-m model] [-d dir] [-n max_images] [-s sparsity,...] [-t target] [-o pruned.csr]
+int PruneMain(int argc, char **argv)
+{
+    const char *model = ENGINE_DEFAULT_MODEL, *dir = ENGINE_DEFAULT_DATASET, *output = NULL;
+    char sweep_list[256] = PRUNE_DEFAULT_SWEEP, *token;
+    float sweep[PRUNE_MAX_SWEEP], target = PRUNE_DEFAULT_TARGET;
+    int max_images = -1, nb_sweep = 0, k;
+    prune_result_t r;
+    dataset_t dataset;
+    char label[16];
+    FILE *file;
+
+    for (k = 1; k < argc; k++) {
+        if (strcmp(argv[k], "-m") == 0 && k + 1 < argc)
+            model = argv[++k];
+        else if (strcmp(argv[k], "-d") == 0 && k + 1 < argc)
+            dir = argv[++k];
+        else if (strcmp(argv[k], "-n") == 0 && k + 1 < argc)
+            max_images = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-s") == 0 && k + 1 < argc)
+            snprintf(sweep_list, sizeof(sweep_list), "%s", argv[++k]);
+        else if (strcmp(argv[k], "-t") == 0 && k + 1 < argc)
+            target = atof(argv[++k]);
+        else if (strcmp(argv[k], "-o") == 0 && k + 1 < argc)
+            output = argv[++k];
+        else {
+            printf("Usage: %s [-m model] [-d dir] [-n max_images] [-s sparsity,...] [-t target] [-o pruned.csr]\n",
+                   argv[0]);
+            exit(1);
+        }
+    }
+    for (token = strtok(sweep_list, ","); token && nb_sweep < PRUNE_MAX_SWEEP; token = strtok(NULL, ","))
+        sweep[nb_sweep++] = atof(token);
+    for (k = 0; k < nb_sweep; k++)
+        if (sweep[k] < 0.0f || sweep[k] > 1.0f) {
+            printf("Error: Sparsity %g out of [0, 1].\n", sweep[k]);
+            exit(1);
+        }
+    if (target < 0.0f || target > 1.0f) {
+        printf("Error: Sparsity %g out of [0, 1].\n", target);
+        exit(1);
+    }
+
+    DatasetLoad(dir, max_images, &dataset);
+    printf("Magnitude pruning of Conv2 (%d weights) and FC1 (%d weights), %d images, 1 thread\n\n",
+           CONV2_WEIGHTS, FC1_WEIGHTS, dataset.count);
+
+    PrintHeader("float");
+    PruneFloat(model, -1.0f);
+    PruneFloatEval(&dataset, &r);
+    PrintRow("dense", &r, dataset.count);
+    for (k = 0; k < nb_sweep; k++) {
+        PruneFloat(model, sweep[k]);
+        PruneFloatEval(&dataset, &r);
+        snprintf(label, sizeof(label), "%.0f%%", 100 * sweep[k]);
+        PrintRow(label, &r, dataset.count);
+    }
+
+    printf("\n");
+    PrintHeader("fixed");
+    PruneFixed(-1.0f);
+    PruneFixedEval(&dataset, &r);
+    PrintRow("dense", &r, dataset.count);
+    for (k = 0; k < nb_sweep; k++) {
+        PruneFixed(sweep[k]);
+        PruneFixedEval(&dataset, &r);
+        snprintf(label, sizeof(label), "%.0f%%", 100 * sweep[k]);
+        PrintRow(label, &r, dataset.count);
+    }
+
+    if (output) {
+        file = fopen(output, "wb");
+        if (!file) {
+            printf("Error: Unable to open file %s.\n", output);
+            exit(1);
+        }
+        PruneFloat(model, target);
+        PruneFixed(target);
+        PruneFloatWrite(file);
+        PruneFixedWrite(file);
+        fclose(file);
+
+        // Read back what was written and evaluate it again
+        file = fopen(output, "rb");
+        if (!file) {
+            printf("Error: Unable to open file %s.\n", output);
+            exit(1);
+        }
+        PruneFloatRead(file);
+        PruneFixedRead(file);
+        fclose(file);
+        printf("\nPruned weights at %.0f%% written to %s, read back:\n", 100 * target, output);
+        PruneFloatEval(&dataset, &r);
+        printf("  float: %d errors, Conv2 + FC1 %.1f KB\n", r.eval.errors, r.bytes / 1024.0);
+        PruneFixedEval(&dataset, &r);
+        printf("  fixed: %d errors, Conv2 + FC1 %.1f KB\n", r.eval.errors, r.bytes / 1024.0);
+    }
+
+    DatasetFree(&dataset);
+    return 0;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file prune.h
+ * @brief Magnitude pruning of Conv2 and FC1: sparsity / accuracy / latency sweep and CSR export
+ *
+ * For each target sparsity s, the round(s * size) weights of smallest
+ * magnitude of Conv2 and of FC1 are zeroed, layer by layer, in the float
+ * model and in the Q8 weights of weights.h separately. Both layers are then
+ * stored in compressed sparse rows (../FLOAT/csr.c, ../FIXED/csr_fixed.c) and
+ * the test set runs through the CSR kernels, single thread, one image at a
+ * time, in the harness of pipeline.h: the other layers are those of the tops
+ * (Conv1 cropped to the input bounding box, dense FC2). No retraining: the accuracy is that of the
+ * pruned model as is. The weights of the chosen operating point can be
+ * written to a file (float Conv2, float FC1, fixed Conv2, fixed FC1) and are
+ * read back and evaluated again.
+ */
+
+#ifndef PRUNE_H
+#define PRUNE_H
+
+#include <stdio.h>
+
+#include "pipeline.h"
+
+#define PRUNE_DEFAULT_SWEEP  "0,0.5,0.7,0.8,0.9,0.95,0.98"
+#define PRUNE_DEFAULT_TARGET 0.9f
+
+typedef struct {
+    double conv2_zeros, fc1_zeros;      // share of zero weights
+    long   bytes;                       // Conv2 + FC1 weight storage
+    pipeline_result_t eval;
+} prune_result_t;
+
+// Prune the float model (loaded on first call) to sparsity, or restore the dense kernels when sparsity < 0
+void PruneFloat(const char *model_filename, float sparsity);
+void PruneFloatEval(const dataset_t *dataset, prune_result_t *result);
+void PruneFloatWrite(FILE *file);
+void PruneFloatRead(FILE *file);
+
+// Same on the Q8 weights of weights.h (prune_fixed.c)
+void PruneFixed(float sparsity);
+void PruneFixedEval(const dataset_t *dataset, prune_result_t *result);
+void PruneFixedWrite(FILE *file);
+void PruneFixedRead(FILE *file);
+
+int PruneMain(int argc, char **argv);
+
+#endif // PRUNE_H
@@ -0,0 +1,98 @@
+/**
+ * @file prune_fixed.c
+ * @brief Fixed-point side of the pruning sweep: the Q8 weights of weights.h, see prune.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../FIXED/lenet_cnn_fixed.h"
+#include "../COMMON/alloc.h"
+#include "prune.h"
+
+#define CONV2_WEIGHTS (CONV2_NBOUTPUT * POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM)
+#define FC1_WEIGHTS   (FC1_NBOUTPUT * POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+
+static csr_fixed_t conv2_csr, fc1_csr;
+static int dense = 1;
+
+static double ZeroShare(const short *w, int size)
+{
+    int i, zeros = 0;
+
+    for (i = 0; i < size; i++)
+        zeros += (w[i] == 0);
+    return (double)zeros / size;
+}
+
+void PruneFixed(float sparsity)
+{
+    short *w;
+
+    CsrFree_fixed(&conv2_csr);
+    CsrFree_fixed(&fc1_csr);
+    dense = (sparsity < 0);
+    if (dense)
+        return;
+
+    // Prune a copy, weights.h stays dense for the next sparsity
+    w = Allocate(sizeof(FC1_KERNEL));
+    memcpy(w, CONV2_KERNEL, sizeof(CONV2_KERNEL));
+    CsrPrune_fixed(w, CONV2_WEIGHTS, sparsity);
+    CsrFromDense_fixed(w, CONV2_NBOUTPUT, CONV2_WEIGHTS / CONV2_NBOUTPUT, &conv2_csr);
+    memcpy(w, FC1_KERNEL, sizeof(FC1_KERNEL));
+    CsrPrune_fixed(w, FC1_WEIGHTS, sparsity);
+    CsrFromDense_fixed(w, FC1_NBOUTPUT, FC1_WEIGHTS / FC1_NBOUTPUT, &fc1_csr);
+    free(w);
+}
+
+static void Conv2Csr(void *input, void *output)
+{
+    Conv2_12x12x20_5x5x40_1_0_csr_fixed(input, &conv2_csr, CONV2_BIAS, output);
+}
+
+static void Fc1Csr(void *input, void *output)
+{
+    Fc1_40_400_csr_fixed(input, &fc1_csr, FC1_BIAS, output);
+}
+
+void PruneFixedEval(const dataset_t *dataset, prune_result_t *result)
+{
+    pipeline_t pipeline = { PIPELINE_FIXED, NULL, 0, NULL, NULL, NULL, NULL };
+
+    if (!dense) {
+        pipeline.conv2 = Conv2Csr;
+        pipeline.fc1 = Fc1Csr;
+    }
+    PipelineEval(&pipeline, dataset, NULL, &result->eval);
+    if (dense) {
+        result->conv2_zeros = ZeroShare(&CONV2_KERNEL[0][0][0][0], CONV2_WEIGHTS);
+        result->fc1_zeros = ZeroShare(&FC1_KERNEL[0][0][0][0], FC1_WEIGHTS);
+        result->bytes = sizeof(CONV2_KERNEL) + sizeof(FC1_KERNEL);
+    } else {
+        result->conv2_zeros = 1.0 - (double)conv2_csr.nnz / CONV2_WEIGHTS;
+        result->fc1_zeros = 1.0 - (double)fc1_csr.nnz / FC1_WEIGHTS;
+        result->bytes = CsrBytes_fixed(&conv2_csr) + CsrBytes_fixed(&fc1_csr);
+    }
+}
+
+void PruneFixedWrite(FILE *file)
+{
+    CsrWrite_fixed(file, &conv2_csr);
+    CsrWrite_fixed(file, &fc1_csr);
+}
+
+void PruneFixedRead(FILE *file)
+{
+    CsrFree_fixed(&conv2_csr);
+    CsrFree_fixed(&fc1_csr);
+    CsrRead_fixed(file, &conv2_csr);
+    CsrRead_fixed(file, &fc1_csr);
+    if (conv2_csr.rows != CONV2_NBOUTPUT || conv2_csr.cols != CONV2_WEIGHTS / CONV2_NBOUTPUT
+        || fc1_csr.rows != FC1_NBOUTPUT || fc1_csr.cols != FC1_WEIGHTS / FC1_NBOUTPUT) {
+        printf("Error: CSR matrices do not match the Conv2 and FC1 dimensions.\n");
+        exit(1);
+    }
+    dense = 0;
+}
@@ -0,0 +1,240 @@
+/**
+ * @file roofline.c
+ * @brief Roofline and operational-intensity report of every kernel, see roofline.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../COMMON/latency.h"
+#include "bench.h"
+#include "roofline.h"
+
+#define PEAK_CHAINS     12                  // independent vector chains, enough to hide the add latency
+#define PEAK_ITERATIONS (1L << 20)
+#define PEAK_REPEATS    5
+
+#define TRIAD_DRAM_SIZE  (16L << 20)        // floats per array: 3 x 64 MB, beyond any LLC
+#define TRIAD_CACHE_SIZE (16L << 10)        // 3 x 64 KB, L2 resident
+#define TRIAD_REPEATS    5
+
+typedef float v4sf __attribute__((vector_size(16)));
+typedef short v8hi __attribute__((vector_size(16)));
+
+// Read through volatiles so the compiler cannot fold the measurement loops
+static volatile float peak_a = 0.999f, peak_b = 0.001f, triad_scalar = 3.0f;
+static volatile float sink_float;
+static volatile short sink_short;
+
+/// @brief Best ops/ns of PEAK_CHAINS independent float multiply-add chains
+static double PeakFloat(void)
+{
+    v4sf acc[PEAK_CHAINS], a, b, sum;
+    unsigned long long t0, ns, best = ~0ULL;
+    long it;
+    int r, c;
+
+    a = (v4sf){ peak_a, peak_a, peak_a, peak_a };
+    b = (v4sf){ peak_b, peak_b, peak_b, peak_b };
+    for (r = 0; r < PEAK_REPEATS; r++) {
+        for (c = 0; c < PEAK_CHAINS; c++)
+            acc[c] = (v4sf){ c, c + 1, c + 2, c + 3 };
+        t0 = LatencyNow();
+        for (it = 0; it < PEAK_ITERATIONS; it++)
+            for (c = 0; c < PEAK_CHAINS; c++)
+                acc[c] = acc[c] * a + b;
+        ns = LatencyNow() - t0;
+        if (ns < best)
+            best = ns;
+        sum = acc[0];
+        for (c = 1; c < PEAK_CHAINS; c++)
+            sum += acc[c];
+        sink_float = sum[0] + sum[1] + sum[2] + sum[3];
+    }
+    return 2.0 * 4 * PEAK_CHAINS * PEAK_ITERATIONS / best;
+}
+
+/// @brief Same with 16-bit integer lanes (pmullw + paddw), the fixed-point kernels' arithmetic
+static double PeakInt16(void)
+{
+    v8hi acc[PEAK_CHAINS], a, b, sum;
+    unsigned long long t0, ns, best = ~0ULL;
+    short sa = (short)(peak_a * 3), sb = (short)(peak_b * 1000);
+    long it;
+    int r, c, i;
+
+    a = (v8hi){ sa, sa, sa, sa, sa, sa, sa, sa };
+    b = (v8hi){ sb, sb, sb, sb, sb, sb, sb, sb };
+    for (r = 0; r < PEAK_REPEATS; r++) {
+        for (c = 0; c < PEAK_CHAINS; c++)
+            acc[c] = (v8hi){ c, c, c, c, c, c, c, c };
+        t0 = LatencyNow();
+        for (it = 0; it < PEAK_ITERATIONS; it++)
+            for (c = 0; c < PEAK_CHAINS; c++)
+                acc[c] = acc[c] * a + b;
+        ns = LatencyNow() - t0;
+        if (ns < best)
+            best = ns;
+        sum = acc[0];
+        for (c = 1; c < PEAK_CHAINS; c++)
+            sum += acc[c];
+        for (i = 0; i < 8; i++)
+            sink_short += sum[i];
+    }
+    return 2.0 * 8 * PEAK_CHAINS * PEAK_ITERATIONS / best;
+}
+
+/// @brief STREAM triad, best bytes/ns over TRIAD_REPEATS groups of passes (12 bytes per element, no write-allocate)
+static double Triad(long size, long passes)
+{
+    float *a = malloc(size * sizeof(float));
+    float *b = malloc(size * sizeof(float));
+    float *c = malloc(size * sizeof(float));
+    unsigned long long t0, ns, best = ~0ULL;
+    float s = triad_scalar;
+    long i, p;
+    int r;
+
+    if (!a || !b || !c) {
+        printf("Error: Unable to allocate the triad arrays.\n");
+        exit(1);
+    }
+    for (i = 0; i < size; i++) {
+        a[i] = 0.0f;
+        b[i] = 1.0f;
+        c[i] = 2.0f;
+    }
+    for (r = 0; r < TRIAD_REPEATS; r++) {
+        t0 = LatencyNow();
+        for (p = 0; p < passes; p++) {
+            for (i = 0; i < size; i++)
+                a[i] = b[i] + s * c[i];
+            b[p % size] = a[(p + 1) % size];          // keeps the passes from being merged
+        }
+        ns = LatencyNow() - t0;
+        if (ns < best)
+            best = ns;
+    }
+    sink_float = a[size / 2];
+    free(a);
+    free(b);
+    free(c);
+    return 3.0 * sizeof(float) * size * passes / best;
+}
+
+void RooflineMeasureMachine(roofline_machine_t *machine)
+{
+    machine->gflops = PeakFloat();
+    machine->gops = PeakInt16();
+    machine->dram_gbs = Triad(TRIAD_DRAM_SIZE, 1);
+    machine->cache_gbs = Triad(TRIAD_CACHE_SIZE, 2000);
+}
+
+static double Min(double a, double b)
+{
+    return a < b ? a : b;
+}
+
+static void RooflineTable(const bench_kernel_t *kernels, int count, const bench_options_t *opt,
+                          const roofline_machine_t *m, FILE *csv)
+{
+    bench_stats_t st;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        const bench_kernel_t *k = &kernels[i];
+        double peak = strcmp(k->precision, "float") == 0 ? m->gflops : m->gops;
+        double intensity, achieved, bandwidth, roof_dram, roof_cache, efficiency;
+        const char *bound, *next;
+
+        if (opt->filter && !strstr(k->name, opt->filter))
+            continue;
+        BenchKernel(k, opt, &st);
+
+        intensity = k->ops / k->bytes;
+        achieved = k->ops / st.ns_median;
+        bandwidth = k->bytes / st.ns_median;
+        roof_dram = Min(peak, intensity * m->dram_gbs);
+        roof_cache = Min(peak, intensity * m->cache_gbs);
+        efficiency = achieved / roof_cache;         // the benchmark runs on warm, cache resident data
+
+        if (intensity < peak / m->cache_gbs)
+            bound = "cache bw";
+        else if (intensity < peak / m->dram_gbs)
+            bound = "DRAM bw";
+        else
+            bound = "compute";
+        if (efficiency < 0.25)
+            next = "kernel efficiency (SIMD, layout)";
+        else if (strcmp(bound, "compute") == 0)
+            next = "fewer ops (pruning, low rank)";
+        else
+            next = "fewer bytes (narrow, compress, batch)";
+
+        printf("%-40s %-6s %10.0f %9.0f %7.2f %8.3f %8.2f %8.3f %8.3f %6.1f%% %-9s %s\n",
+               k->name, k->precision, k->ops, k->bytes, intensity, achieved, bandwidth,
+               roof_dram, roof_cache, 100 * efficiency, bound, next);
+        fflush(stdout);
+
+        if (csv)
+            fprintf(csv, "%s,%s,%.0f,%.0f,%.4f,%.1f,%.4f,%.4f,%.4f,%.4f,%.4f,%s,%.3f,%.3f,%.3f\n",
+                    k->name, k->precision, k->ops, k->bytes, intensity, st.ns_median, achieved, bandwidth,
+                    roof_dram, roof_cache, efficiency, bound, peak, m->dram_gbs, m->cache_gbs);
+    }
+}
+
+/// @brief Command line front end: [-s samples] [-t sample_ms] [-k kernel_filter] [-o roofline.csv]
+int RooflineMain(int argc, char **argv)
+{
+    bench_options_t opt;
+    roofline_machine_t machine;
+    const char *csv_filename = "roofline.csv";
+    const bench_kernel_t *kernels;
+    FILE *csv;
+    int k, count;
+
+    BenchDefaultOptions(&opt);
+    for (k = 1; k < argc; k++) {
+        if (strcmp(argv[k], "-s") == 0 && k + 1 < argc)
+            opt.samples = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-t") == 0 && k + 1 < argc)
+            opt.sample_ms = atof(argv[++k]);
+        else if (strcmp(argv[k], "-k") == 0 && k + 1 < argc)
+            opt.filter = argv[++k];
+        else if (strcmp(argv[k], "-o") == 0 && k + 1 < argc)
+            csv_filename = argv[++k];
+        else {
+            printf("Usage: %s [-s samples] [-t sample_ms] [-k kernel_filter] [-o roofline.csv]\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    csv = fopen(csv_filename, "w");
+    if (!csv) {
+        printf("Error: Unable to open file %s.\n", csv_filename);
+        exit(1);
+    }
+    fprintf(csv, "kernel,precision,ops,bytes,intensity,ns_median,achieved_gops,achieved_gbs,"
+                 "roof_dram,roof_cache,efficiency,bound,peak_gops,dram_gbs,cache_gbs\n");
+
+    RooflineMeasureMachine(&machine);
+    printf("Machine ceilings (1 thread, build flags of the kernels)\n");
+    printf("  peak compute: %8.2f GFLOP/s float  %8.2f GOP/s int16\n", machine.gflops, machine.gops);
+    printf("  triad:        %8.2f GB/s DRAM      %8.2f GB/s cache (L2)\n", machine.dram_gbs, machine.cache_gbs);
+    printf("  ridge points: float %.2f (DRAM) %.2f (cache), int16 %.2f (DRAM) %.2f (cache) ops/byte\n\n",
+           machine.gflops / machine.dram_gbs, machine.gflops / machine.cache_gbs,
+           machine.gops / machine.dram_gbs, machine.gops / machine.cache_gbs);
+
+    printf("%-40s %-6s %10s %9s %7s %8s %8s %8s %8s %7s %-9s %s\n",
+           "kernel", "type", "ops/call", "bytes", "ops/B", "G/s", "GB/s", "roof DR", "roof L2", "% L2",
+           "bound", "next");
+    kernels = BenchFloatKernels(&count);
+    RooflineTable(kernels, count, &opt, &machine, csv);
+    kernels = BenchFixedKernels(&count);
+    RooflineTable(kernels, count, &opt, &machine, csv);
+
+    fclose(csv);
+    printf("\nResults written to %s\n", csv_filename);
+    return 0;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file roofline.h
+ * @brief Roofline report: each kernel placed against the measured machine ceilings
+ *
+ * The ceilings are measured on the host, single thread, with the same
+ * compiler flags as the kernels:
+ *   - peak float and int16 throughput: independent multiply-add chains in
+ *     16-byte vectors (the SSE2 baseline of the -O3 build),
+ *   - bandwidth: a STREAM triad a[i] = b[i] + s * c[i] on arrays far larger
+ *     than the last-level cache (DRAM) and on arrays that fit in L2 (cache).
+ * Every kernel of bench.h is then timed, its operational intensity taken from
+ * the ops and bytes of its dimensions, and classified:
+ *   - "cache bw"  below the cache ridge point, bandwidth-bound even from L2,
+ *   - "DRAM bw"   between the two ridge points, bound by DRAM when its
+ *                 weights are not cache resident (cold or large batch sweep),
+ *   - "compute"   above the DRAM ridge point.
+ */
+
+#ifndef ROOFLINE_H
+#define ROOFLINE_H
+
+typedef struct {
+    double gflops;              // peak float, 1e9 ops/s
+    double gops;                // peak int16
+    double dram_gbs;            // triad, 1e9 bytes/s
+    double cache_gbs;
+} roofline_machine_t;
+
+void RooflineMeasureMachine(roofline_machine_t *machine);
+int  RooflineMain(int argc, char **argv);
+
+#endif // ROOFLINE_H
@@ -0,0 +1,210 @@
+/**
+ * @file acc_width.c
+ * @brief Static accumulator bit-width analysis for the fixed-point LeNet-5
+ *
+ * Propagates per-channel value intervals through the network, starting from
+ * the input pixel bounds, using the quantized weights of weights.h:
+ * - Conv / FC: for each output, the worst-case accumulator is the sum of
+ *   w*hi (w > 0) or w*lo (w < 0) over its receptive field
+ * - Rescale, bias, ReLU and the short cast are applied as in the *_fixed kernels
+ * - Max pooling keeps the channel interval unchanged
+ *
+ * The minimal safe accumulator width is the signed width of the final sum:
+ * with two's complement wrap-around (pmullw / vpaddw, or an HLS adder of the
+ * same width) intermediate partial sums may overflow as long as the final
+ * sum fits, provided each product is kept modulo the same width.
+ *
+ * Usage: ./acc_width [input_max] [csv_file]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "lenet_cnn_fixed.h"
+#include "weights.h"
+
+typedef struct {
+    long long lo, hi;
+} interval_t;
+
+typedef struct {
+    const char *name;
+    int         nb_outputs;
+    int         nb_macs;        // MACs per output
+    interval_t  weight;
+    interval_t  input;
+    interval_t  acc;            // worst case over all outputs
+    interval_t  out;            // after rescale, bias and ReLU
+    long long   nb_wraps;       // outputs whose bound exceeds the short range
+} layer_report_t;
+
+static FILE *csv_file = NULL;
+
+
+/// @brief Signed two's complement width needed to hold [lo, hi]
+static int SignedBits(interval_t r)
+{
+    int bits = 1;
+
+    while (r.lo < -(1LL << (bits - 1)) || r.hi > (1LL << (bits - 1)) - 1)
+        bits++;
+    return bits;
+}
+
+static void Widen(interval_t *r, long long lo, long long hi)
+{
+    if (lo < r->lo) r->lo = lo;
+    if (hi > r->hi) r->hi = hi;
+}
+
+/// @brief Worst-case contribution w * [lo, hi] added to acc
+static void MacBound(interval_t *acc, long long w, interval_t in)
+{
+    if (w >= 0) {
+        acc->lo += w * in.lo;
+        acc->hi += w * in.hi;
+    } else {
+        acc->lo += w * in.hi;
+        acc->hi += w * in.lo;
+    }
+}
+
+/// @brief Rescale, bias, ReLU and short cast of one output, as in the *_fixed kernels
+static interval_t OutputBound(layer_report_t *rep, int index, interval_t acc, short bias)
+{
+    interval_t out;
+
+    Widen(&rep->acc, acc.lo, acc.hi);
+    if (csv_file)
+        fprintf(csv_file, "%s,%d,%lld,%lld,%d\n", rep->name, index, acc.lo, acc.hi, SignedBits(acc));
+
+    out.lo = (acc.lo >> FIXED_POINT) + bias;
+    out.hi = (acc.hi >> FIXED_POINT) + bias;
+    if (out.hi > SHRT_MAX) {
+        rep->nb_wraps++;
+        out.hi = SHRT_MAX;      // the real kernel wraps, keep a sane bound downstream
+    }
+    if (out.lo < 0) out.lo = 0;
+    if (out.hi < 0) out.hi = 0;
+    Widen(&rep->out, out.lo, out.hi);
+    return out;
+}
+
+static void InitReport(layer_report_t *rep, const char *name, int nb_outputs, int nb_macs)
+{
+    rep->name = name;
+    rep->nb_outputs = nb_outputs;
+    rep->nb_macs = nb_macs;
+    rep->weight.lo = rep->input.lo = rep->acc.lo = rep->out.lo = LLONG_MAX;
+    rep->weight.hi = rep->input.hi = rep->acc.hi = rep->out.hi = LLONG_MIN;
+    rep->nb_wraps = 0;
+}
+
+static void PrintReport(const layer_report_t *rep)
+{
+    int acc_bits = SignedBits(rep->acc);
+
+    printf("%-6s %8d %6d %5ds %5du %5d %5d %6d %6d   %-4s %s\n",
+           rep->name, rep->nb_outputs, rep->nb_macs,
+           SignedBits(rep->weight), SignedBits(rep->input) - 1,
+           SignedBits(rep->weight) + SignedBits(rep->input) - 1,
+           acc_bits, SignedBits(rep->out) - 1, (int)rep->nb_wraps,
+           acc_bits <= 16 ? "yes" : "no",
+           acc_bits <= 16 ? "16-bit lanes (pmullw/vpaddw)" : (acc_bits <= 32 ? "32-bit lanes" : "64-bit"));
+}
+
+int main(int argc, char **argv)
+{
+    interval_t     img = { 0, 255 };        // NormalizeImg feeds raw 8-bit pixels
+    interval_t     pool1[POOL1_NBOUTPUT], pool2[POOL2_NBOUTPUT], fc1[FC1_NBOUTPUT];
+    layer_report_t rep;
+    int            f, c, ky, kx, n, h, w;
+
+    if (argc > 1)
+        img.hi = atoll(argv[1]);
+    if (argc > 2) {
+        csv_file = fopen(argv[2], "w");
+        if (!csv_file) {
+            printf("Error: Unable to open file %s.\n", argv[2]);
+            exit(1);
+        }
+        fprintf(csv_file, "layer,output,acc_lo,acc_hi,acc_bits\n");
+    }
+
+    printf("Static accumulator analysis (FIXED_POINT = %d, input in [%lld, %lld])\n\n",
+           FIXED_POINT, img.lo, img.hi);
+    printf("%-6s %8s %6s %6s %6s %5s %5s %6s %6s   %-4s %s\n",
+           "layer", "outputs", "MACs", "w", "in", "prod", "acc", "out", "wraps", "16b", "kernel");
+
+    // Conv1: bounds are identical for every position of a filter, Pool1 keeps them
+    InitReport(&rep, "conv1", CONV1_NBOUTPUT * CONV1_HEIGHT * CONV1_WIDTH, IMG_DEPTH * CONV1_DIM * CONV1_DIM);
+    Widen(&rep.input, img.lo, img.hi);
+    for (f = 0; f < CONV1_NBOUTPUT; f++) {
+        interval_t acc = { 0, 0 };
+        for (c = 0; c < IMG_DEPTH; c++)
+            for (ky = 0; ky < CONV1_DIM; ky++)
+                for (kx = 0; kx < CONV1_DIM; kx++) {
+                    Widen(&rep.weight, CONV1_KERNEL[f][c][ky][kx], CONV1_KERNEL[f][c][ky][kx]);
+                    MacBound(&acc, CONV1_KERNEL[f][c][ky][kx], img);
+                }
+        pool1[f] = OutputBound(&rep, f, acc, CONV1_BIAS[f]);
+    }
+    PrintReport(&rep);
+
+    // Conv2, Pool2 keeps the per-channel bounds
+    InitReport(&rep, "conv2", CONV2_NBOUTPUT * CONV2_HEIGHT * CONV2_WIDTH, POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM);
+    for (c = 0; c < POOL1_NBOUTPUT; c++)
+        Widen(&rep.input, pool1[c].lo, pool1[c].hi);
+    for (f = 0; f < CONV2_NBOUTPUT; f++) {
+        interval_t acc = { 0, 0 };
+        for (c = 0; c < POOL1_NBOUTPUT; c++)
+            for (ky = 0; ky < CONV2_DIM; ky++)
+                for (kx = 0; kx < CONV2_DIM; kx++) {
+                    Widen(&rep.weight, CONV2_KERNEL[f][c][ky][kx], CONV2_KERNEL[f][c][ky][kx]);
+                    MacBound(&acc, CONV2_KERNEL[f][c][ky][kx], pool1[c]);
+                }
+        pool2[f] = OutputBound(&rep, f, acc, CONV2_BIAS[f]);
+    }
+    PrintReport(&rep);
+
+    // FC1
+    InitReport(&rep, "fc1", FC1_NBOUTPUT, POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH);
+    for (c = 0; c < POOL2_NBOUTPUT; c++)
+        Widen(&rep.input, pool2[c].lo, pool2[c].hi);
+    for (n = 0; n < FC1_NBOUTPUT; n++) {
+        interval_t acc = { 0, 0 };
+        for (c = 0; c < POOL2_NBOUTPUT; c++)
+            for (h = 0; h < POOL2_HEIGHT; h++)
+                for (w = 0; w < POOL2_WIDTH; w++) {
+                    Widen(&rep.weight, FC1_KERNEL[n][c][h][w], FC1_KERNEL[n][c][h][w]);
+                    MacBound(&acc, FC1_KERNEL[n][c][h][w], pool2[c]);
+                }
+        fc1[n] = OutputBound(&rep, n, acc, FC1_BIAS[n]);
+    }
+    PrintReport(&rep);
+
+    // FC2
+    InitReport(&rep, "fc2", FC2_NBOUTPUT, FC1_NBOUTPUT);
+    for (n = 0; n < FC1_NBOUTPUT; n++)
+        Widen(&rep.input, fc1[n].lo, fc1[n].hi);
+    for (n = 0; n < FC2_NBOUTPUT; n++) {
+        interval_t acc = { 0, 0 };
+        for (c = 0; c < FC1_NBOUTPUT; c++) {
+            Widen(&rep.weight, FC2_KERNEL[n][c], FC2_KERNEL[n][c]);
+            MacBound(&acc, FC2_KERNEL[n][c], fc1[c]);
+        }
+        OutputBound(&rep, n, acc, FC2_BIAS[n]);
+    }
+    PrintReport(&rep);
+
+    printf("\nw/in/prod: operand and product widths (s = signed, u = unsigned), as in mac_muladd_<in>_<w>_<acc>.\n");
+    printf("acc: minimal signed accumulator width for the worst-case input. out: post-ReLU output width.\n");
+    printf("wraps: outputs whose worst case overflows the short cast.\n");
+
+    if (csv_file) {
+        fclose(csv_file);
+        printf("Per-output accumulator bounds written to %s\n", argv[2]);
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+/**
+ * @file ap_fixed_emu.h
+ * @brief Bit-accurate emulation of Vivado HLS ap_fixed<W, I, Q, O> for plain g++
+ *
+ * Lets the fixed-point pipeline be instantiated at arbitrary widths (e.g. 10-bit
+ * weights, 12-bit activations) without the Xilinx headers, to pick the narrowest
+ * formats that keep accuracy before synthesis.
+ *
+ * Semantics follow ap_fixed:
+ * - W total bits, I integer bits including the sign, value = V * 2^(I-W)
+ * - Q quantization mode applied when fractional bits are dropped
+ * - O overflow mode applied when the value does not fit in W bits
+ * - a * b is exact (W1+W2 bits), a + b is exact (one extra integer bit),
+ *   assignment / conversion / += apply the destination Q and O modes
+ *
+ * Fast paths: storage is int32_t up to 32 bits and int64_t up to 64 bits, and
+ * intermediate results use int64_t whenever they provably fit; __int128 is only
+ * used for wide conversions. Widths above 64 bits are not supported.
+ */
+
+#ifndef AP_FIXED_EMU_H
+#define AP_FIXED_EMU_H
+
+#include <stdint.h>
+#include <math.h>
+#include <type_traits>
+
+namespace apemu {
+
+enum ap_q_mode { AP_RND, AP_RND_ZERO, AP_RND_MIN_INF, AP_RND_INF, AP_RND_CONV, AP_TRN, AP_TRN_ZERO };
+enum ap_o_mode { AP_SAT, AP_SAT_ZERO, AP_SAT_SYM, AP_WRAP };
+
+typedef __int128          int128_t;
+typedef unsigned __int128 uint128_t;
+
+/// Native intermediate type able to hold 'bits' signed bits
+template <int bits>
+struct wide_type {
+    typedef typename std::conditional<(bits <= 63), int64_t, int128_t>::type type;
+};
+
+template <class T> struct unsigned_of;
+template <> struct unsigned_of<int32_t>  { typedef uint32_t  type; };
+template <> struct unsigned_of<int64_t>  { typedef uint64_t  type; };
+template <> struct unsigned_of<int128_t> { typedef uint128_t type; };
+
+/// @brief Drop S fractional bits of x (S <= 0 appends -S zero bits) with rounding mode Q
+template <ap_q_mode Q, int S, class T>
+static inline T quantize(T x)
+{
+    if constexpr (S <= 0) {
+        return x * ((T)1 << -S);
+    } else {
+        const T one  = 1;
+        const T half = one << (S - 1);
+        const T fl   = x >> S;                  // floor (arithmetic shift)
+        const T rem  = x - fl * (one << S);     // 0 <= rem < 2^S
+
+        if constexpr (Q == AP_TRN)
+            return fl;
+        if constexpr (Q == AP_TRN_ZERO)
+            return (x < 0 && rem != 0) ? fl + 1 : fl;
+        if (rem != half)
+            return (rem > half) ? fl + 1 : fl;
+        // Exactly halfway
+        if constexpr (Q == AP_RND)         return fl + 1;                       // toward +inf
+        if constexpr (Q == AP_RND_MIN_INF) return fl;                           // toward -inf
+        if constexpr (Q == AP_RND_ZERO)    return (x < 0) ? fl + 1 : fl;        // toward zero
+        if constexpr (Q == AP_RND_INF)     return (x < 0) ? fl : fl + 1;        // away from zero
+        return (fl & 1) ? fl + 1 : fl;                                          // AP_RND_CONV: to even
+    }
+}
+
+/// @brief Fit x into a W-bit signed integer with overflow mode O
+template <ap_o_mode O, int W, class T>
+static inline T overflow(T x)
+{
+    if constexpr (W >= (int)(8 * sizeof(T))) {
+        return x;
+    } else if constexpr (O == AP_WRAP) {
+        typedef typename unsigned_of<T>::type U;
+        const U mask = ((U)1 << W) - 1;
+        U u = (U)x & mask;
+        if (u >> (W - 1))
+            u |= ~mask;                         // sign-extend
+        return (T)u;
+    } else {
+        const T max = ((T)1 << (W - 1)) - 1;
+        const T min = -max - 1;
+        if (x > max)
+            return (O == AP_SAT_ZERO) ? 0 : max;
+        if (x < min || (O == AP_SAT_SYM && x < -max))
+            return (O == AP_SAT_ZERO) ? 0 : ((O == AP_SAT_SYM) ? -max : min);
+        return x;
+    }
+}
+
+template <int W, int I, ap_q_mode Q = AP_TRN, ap_o_mode O = AP_WRAP>
+class ap_fixed {
+    static_assert(W >= 1 && W <= 64, "ap_fixed emulation supports 1 to 64 bits");
+
+public:
+    static const int width  = W;
+    static const int iwidth = I;
+    static const int fwidth = W - I;
+
+    typedef typename std::conditional<(W <= 32), int32_t, int64_t>::type raw_t;
+
+    raw_t V;    // value = V * 2^-fwidth
+
+    ap_fixed() : V(0) {}
+
+    ap_fixed(double d) { V = from_double(d); }
+
+    template <int W2, int I2, ap_q_mode Q2, ap_o_mode O2>
+    ap_fixed(const ap_fixed<W2, I2, Q2, O2> &o) { V = from_raw<W2, W2 - I2>(o.V); }
+
+    /// @brief Convert a raw value with W2 bits, F2 of them fractional, applying Q and O
+    template <int W2, int F2, class T>
+    static raw_t from_raw(T x)
+    {
+        constexpr int S    = F2 - fwidth;                  // fractional bits dropped
+        constexpr int bits = W2 + (S < 0 ? -S : 0);
+        typedef typename wide_type<bits>::type wide_t;
+
+        return (raw_t)overflow<O, W>(quantize<Q, S>((wide_t)x));
+    }
+
+    static raw_t from_double(double d)
+    {
+        double  y   = ldexp(d, fwidth);
+        double  fl  = floor(y);
+        double  rem = y - fl;                          // exact, 0 <= rem < 1
+        int128_t v;
+
+        // Rounding on the real value, same rules as quantize()
+        if (Q == AP_TRN_ZERO && d < 0 && rem != 0)  fl += 1;
+        else if (Q != AP_TRN && Q != AP_TRN_ZERO) {
+            if (rem > 0.5) fl += 1;
+            else if (rem == 0.5) {
+                if (Q == AP_RND || (Q == AP_RND_ZERO && d < 0) || (Q == AP_RND_INF && d >= 0) ||
+                    (Q == AP_RND_CONV && fmod(fl, 2.0) != 0))
+                    fl += 1;
+            }
+        }
+        // Clamp far outside the 64-bit range so the conversion is defined; overflow() does the rest
+        if (fl > 1e30)  fl = 1e30;
+        if (fl < -1e30) fl = -1e30;
+        v = (int128_t)fl;
+        return (raw_t)overflow<O, W>(v);
+    }
+
+    double to_double() const { return ldexp((double)V, -fwidth); }
+    float  to_float()  const { return (float)to_double(); }
+
+    template <int W2, int I2, ap_q_mode Q2, ap_o_mode O2>
+    ap_fixed &operator=(const ap_fixed<W2, I2, Q2, O2> &o) { V = from_raw<W2, W2 - I2>(o.V); return *this; }
+
+    /// @brief Full-precision sum assigned back with this type's Q and O modes
+    template <int W2, int I2, ap_q_mode Q2, ap_o_mode O2>
+    ap_fixed &operator+=(const ap_fixed<W2, I2, Q2, O2> &o)
+    {
+        constexpr int F2   = W2 - I2;
+        constexpr int FM   = (fwidth > F2) ? fwidth : F2;
+        constexpr int IM   = (I > I2) ? I : I2;
+        constexpr int bits = IM + FM + 1;
+        typedef typename wide_type<bits>::type wide_t;
+
+        wide_t a = (wide_t)V   * ((wide_t)1 << (FM - fwidth));
+        wide_t b = (wide_t)o.V * ((wide_t)1 << (FM - F2));
+        V = (raw_t)overflow<O, W>(quantize<Q, FM - fwidth>(a + b));
+        return *this;
+    }
+
+    bool operator>(const ap_fixed &o) const  { return V > o.V; }
+    bool operator<(const ap_fixed &o) const  { return V < o.V; }
+    bool operator>=(const ap_fixed &o) const { return V >= o.V; }
+    bool operator<=(const ap_fixed &o) const { return V <= o.V; }
+    bool operator==(const ap_fixed &o) const { return V == o.V; }
+    bool operator!=(const ap_fixed &o) const { return V != o.V; }
+};
+
+/// @brief Exact product, as ap_fixed: W1+W2 bits, I1+I2 integer bits
+template <int W1, int I1, ap_q_mode Q1, ap_o_mode O1, int W2, int I2, ap_q_mode Q2, ap_o_mode O2>
+static inline ap_fixed<W1 + W2, I1 + I2>
+operator*(const ap_fixed<W1, I1, Q1, O1> &a, const ap_fixed<W2, I2, Q2, O2> &b)
+{
+    static_assert(W1 + W2 <= 64, "product wider than 64 bits");
+    ap_fixed<W1 + W2, I1 + I2> r;
+
+    r.V = (typename ap_fixed<W1 + W2, I1 + I2>::raw_t)((int64_t)a.V * (int64_t)b.V);
+    return r;
+}
+
+/// @brief Exact sum, as ap_fixed: the wider integer and fractional parts plus one carry bit
+template <int W1, int I1, ap_q_mode Q1, ap_o_mode O1, int W2, int I2, ap_q_mode Q2, ap_o_mode O2>
+static inline ap_fixed<((I1 > I2) ? I1 : I2) + ((W1 - I1 > W2 - I2) ? W1 - I1 : W2 - I2) + 1,
+                       ((I1 > I2) ? I1 : I2) + 1>
+operator+(const ap_fixed<W1, I1, Q1, O1> &a, const ap_fixed<W2, I2, Q2, O2> &b)
+{
+    constexpr int IM = (I1 > I2) ? I1 : I2;
+    constexpr int FM = (W1 - I1 > W2 - I2) ? W1 - I1 : W2 - I2;
+    static_assert(IM + FM + 1 <= 64, "sum wider than 64 bits");
+    ap_fixed<IM + FM + 1, IM + 1> r;
+
+    r.V = (typename ap_fixed<IM + FM + 1, IM + 1>::raw_t)((int64_t)a.V * ((int64_t)1 << (FM - (W1 - I1)))
+                                                       + (int64_t)b.V * ((int64_t)1 << (FM - (W2 - I2))));
+    return r;
+}
+
+} // namespace apemu
+
+#endif // AP_FIXED_EMU_H
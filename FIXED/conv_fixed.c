@@ -7,6 +7,7 @@
  */
 
 #include "lenet_cnn_fixed.h"
+#include "profile_fixed.h"
 //#include "fixed_point.h"
 
 
@@ -34,13 +35,14 @@ void Conv1_28x28x1_5x5x20_1_0_fixed(
                     for (ky = 0; ky < CONV1_DIM; ky++) {
                         for (kx = 0; kx < CONV1_DIM; kx++) {
                             temp = kernel[f][c][ky][kx] * input[c][y + ky][x + kx];
-                            acc += temp;
+                            ACC_ADD(PROFILE_CONV1, acc, temp);
                         }
                     }
                 }
 
                 // Fixed-point scaling and adding bias
                 acc = (acc >> FIXED_POINT) + bias[f];
+                PROFILE_FIXED_OUT(PROFILE_CONV1, acc);
 
                 // ReLU activation
                 output[f][y][x] = (short)(acc > 0 ? acc : 0);
@@ -49,6 +51,100 @@ void Conv1_28x28x1_5x5x20_1_0_fixed(
     }
 }
 
+/// @brief Bounding box of the nonzero pixels of the input (all channels)
+/// @param input Input image array of size [IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH]
+/// @param box First and last nonzero row and column, x1 < x0 if the image is empty
+void InputBoundingBox_fixed(short input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH], bbox_fixed_t *box)
+{
+    short rows[IMG_HEIGHT] = { 0 }, cols[IMG_WIDTH] = { 0 };
+    unsigned short c, y, x;
+
+    // Branch-free projections on the rows and columns, then the first and last nonzero of each
+    for (c = 0; c < IMG_DEPTH; c++) {
+        for (y = 0; y < IMG_HEIGHT; y++) {
+            for (x = 0; x < IMG_WIDTH; x++) {
+                rows[y] |= input[c][y][x];
+                cols[x] |= input[c][y][x];
+            }
+        }
+    }
+
+    box->x0 = IMG_WIDTH;
+    box->y0 = IMG_HEIGHT;
+    box->x1 = -1;
+    box->y1 = -1;
+    for (y = 0; y < IMG_HEIGHT; y++)
+        if (rows[y]) {
+            if (box->y0 > y) box->y0 = y;
+            box->y1 = y;
+        }
+    for (x = 0; x < IMG_WIDTH; x++)
+        if (cols[x]) {
+            if (box->x0 > x) box->x0 = x;
+            box->x1 = x;
+        }
+}
+
+/// @brief First convolution layer computed only for the output rows whose receptive field meets the input bounding box
+/// @param input Input image array of size [IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH]
+/// @param box Bounding box of the nonzero pixels of input (InputBoundingBox_fixed)
+/// @param kernel Convolution filters array of size [CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM]
+/// @param bias Bias terms array of size [CONV1_NBOUTPUT]
+/// @param output Output feature maps array of size [CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH]
+/// @return Output positions computed per filter
+/// Outside the box the accumulator stays 0, so the full layer gives relu(bias) there. Rows are computed
+/// over the whole width: a column range breaks the vectorized x loop and costs more than it saves.
+int Conv1_28x28x1_5x5x20_1_0_crop_fixed(
+    short input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
+    const bbox_fixed_t *box,
+    short kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+    short bias[CONV1_NBOUTPUT],
+    short output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH])
+{
+    unsigned short f, c, x, ky, kx;
+    int y;                                          // signed, compared with the int bounds
+    int temp;
+    int acc;
+    short outside;
+
+    // Output rows y .. y + 4 of the input meet [y0, y1] for y in [y0 - 4, y1]
+    int y0 = box->y0 - (CONV1_DIM - 1) > 0 ? box->y0 - (CONV1_DIM - 1) : 0;
+    int y1 = box->y1 < CONV1_HEIGHT - 1 ? box->y1 : CONV1_HEIGHT - 1;
+
+    for (f = 0; f < CONV1_NBOUTPUT; f++) {          // for each filter
+        outside = (short)(bias[f] > 0 ? bias[f] : 0);
+        for (y = 0; y < CONV1_HEIGHT; y++) {
+            if (y >= y0 && y <= y1)
+                continue;
+            for (x = 0; x < CONV1_WIDTH; x++)
+                output[f][y][x] = outside;
+        }
+
+        for (y = y0; y <= y1; y++) {
+            for (x = 0; x < CONV1_WIDTH; x++) {
+                acc = 0;
+
+                for (c = 0; c < IMG_DEPTH; c++) {    // for each input channel
+                    for (ky = 0; ky < CONV1_DIM; ky++) {
+                        for (kx = 0; kx < CONV1_DIM; kx++) {
+                            temp = kernel[f][c][ky][kx] * input[c][y + ky][x + kx];
+                            ACC_ADD(PROFILE_CONV1, acc, temp);
+                        }
+                    }
+                }
+
+                // Fixed-point scaling and adding bias
+                acc = (acc >> FIXED_POINT) + bias[f];
+                PROFILE_FIXED_OUT(PROFILE_CONV1, acc);
+
+                // ReLU activation
+                output[f][y][x] = (short)(acc > 0 ? acc : 0);
+            }
+        }
+    }
+    return y1 >= y0 ? (y1 - y0 + 1) * CONV1_WIDTH : 0;
+}
+
 /// @brief Second convolution layer using fixed-point arithmetic
 /// @param input Input feature maps array of size [POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH]
 /// @param kernel Convolution filters array of size [CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM]
@@ -73,13 +169,14 @@ void Conv2_12x12x20_5x5x40_1_0_fixed(
                     for (ky = 0; ky < CONV2_DIM; ky++) {
                         for (kx = 0; kx < CONV2_DIM; kx++) {
                             temp = kernel[f][c][ky][kx] * input[c][y + ky][x + kx];
-                            acc += temp;
+                            ACC_ADD(PROFILE_CONV2, acc, temp);
                         }
                     }
                 }
 
                 // Fixed-point scaling and adding bias
                 acc = (acc >> FIXED_POINT) + bias[f];
+                PROFILE_FIXED_OUT(PROFILE_CONV2, acc);
 
                 // ReLU activation
                 output[f][y][x] = (short)(acc > 0 ? acc : 0);
@@ -88,3 +185,295 @@ void Conv2_12x12x20_5x5x40_1_0_fixed(
     }
 }
 
+
+/// @brief Conv2 from the nonzero list of its input: each nonzero pixel is scattered to the outputs it reaches
+/// @param input Nonzero entries of the [POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH] input feature maps
+/// @param kernel Convolution filters array of size [CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM]
+/// @param bias Bias terms array of size [CONV2_NBOUTPUT]
+/// @param output Output feature maps array of size [CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH]
+void Conv2_12x12x20_5x5x40_1_0_sparse_fixed(
+    const nonzero_list_fixed_t *input,
+    short kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+    short bias[CONV2_NBOUTPUT],
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH])
+{
+    int acc[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH] = { { { 0 } } };
+    unsigned short f, y, x, ky, kx;
+    int i, c, iy, ix, ky0, ky1, kx0, kx1, v;
+
+    for (i = 0; i < input->count; i++) {
+        c = input->index[i] / (POOL1_HEIGHT * POOL1_WIDTH);
+        iy = input->index[i] / POOL1_WIDTH % POOL1_HEIGHT;
+        ix = input->index[i] % POOL1_WIDTH;
+        v = input->value[i];
+
+        // Kernel taps that land inside the output map
+        ky0 = iy - (CONV2_HEIGHT - 1) > 0 ? iy - (CONV2_HEIGHT - 1) : 0;
+        ky1 = iy < CONV2_DIM - 1 ? iy : CONV2_DIM - 1;
+        kx0 = ix - (CONV2_WIDTH - 1) > 0 ? ix - (CONV2_WIDTH - 1) : 0;
+        kx1 = ix < CONV2_DIM - 1 ? ix : CONV2_DIM - 1;
+
+        for (f = 0; f < CONV2_NBOUTPUT; f++) {
+            for (ky = ky0; ky <= ky1; ky++) {
+                for (kx = kx0; kx <= kx1; kx++) {
+                    ACC_ADD(PROFILE_CONV2, acc[f][iy - ky][ix - kx], kernel[f][c][ky][kx] * v);
+                }
+            }
+        }
+    }
+
+    for (f = 0; f < CONV2_NBOUTPUT; f++) {
+        for (y = 0; y < CONV2_HEIGHT; y++) {
+            for (x = 0; x < CONV2_WIDTH; x++) {
+                // Fixed-point scaling and adding bias
+                int out = (acc[f][y][x] >> FIXED_POINT) + bias[f];
+                PROFILE_FIXED_OUT(PROFILE_CONV2, out);
+
+                // ReLU activation
+                output[f][y][x] = (short)(out > 0 ? out : 0);
+            }
+        }
+    }
+}
+
+/// @brief Conv2 on pruned weights in CSR: each filter only visits its nonzero (c, ky, kx) taps
+/// @param input Input feature maps array of size [POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH]
+/// @param kernel Filters in CSR, CONV2_NBOUTPUT rows of POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM columns
+/// @param bias Bias terms array of size [CONV2_NBOUTPUT]
+/// @param output Output feature maps array of size [CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH]
+/// A tap is added to all the outputs of the filter at once, vectorized over x.
+void Conv2_12x12x20_5x5x40_1_0_csr_fixed(
+    short input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const csr_fixed_t *kernel,
+    short bias[CONV2_NBOUTPUT],
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH])
+{
+    unsigned short f, y, x, c, ky, kx;
+    int i, w;
+    int acc[CONV2_HEIGHT][CONV2_WIDTH];
+
+    for (f = 0; f < CONV2_NBOUTPUT; f++) {          // for each filter
+        for (y = 0; y < CONV2_HEIGHT; y++)
+            for (x = 0; x < CONV2_WIDTH; x++)
+                acc[y][x] = 0;
+
+        for (i = kernel->row_ptr[f]; i < kernel->row_ptr[f + 1]; i++) {
+            c = kernel->col[i] / (CONV2_DIM * CONV2_DIM);
+            ky = kernel->col[i] / CONV2_DIM % CONV2_DIM;
+            kx = kernel->col[i] % CONV2_DIM;
+            w = kernel->val[i];
+
+            for (y = 0; y < CONV2_HEIGHT; y++) {
+                for (x = 0; x < CONV2_WIDTH; x++) {
+                    ACC_ADD(PROFILE_CONV2, acc[y][x], w * input[c][y + ky][x + kx]);
+                }
+            }
+        }
+
+        for (y = 0; y < CONV2_HEIGHT; y++) {
+            for (x = 0; x < CONV2_WIDTH; x++) {
+                // Fixed-point scaling and adding bias
+                int out = (acc[y][x] >> FIXED_POINT) + bias[f];
+                PROFILE_FIXED_OUT(PROFILE_CONV2, out);
+
+                // ReLU activation
+                output[f][y][x] = (short)(out > 0 ? out : 0);
+            }
+        }
+    }
+}
+
+/// @brief Conv2 on clustered Q8 weights: each filter is decoded from the codebook, then computed as the CSR kernel
+/// @param input    Input feature maps array of size [20][12][12]
+/// @param kernel   Codebook and packed indexes of the [40][20][5][5] kernel (ClusterFit_fixed)
+/// @param bias     Bias terms array of size [40]
+/// @param output   Output feature maps array of size [40][8][8], identical to the dense kernel on the decoded weights
+void Conv2_12x12x20_5x5x40_1_0_cluster_fixed(
+    short input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const codebook_fixed_t *kernel,
+    short bias[CONV2_NBOUTPUT],
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH])
+{
+    const int taps = POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM;
+    unsigned short f, y, x, c, ky, kx;
+    int i, w[POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM];
+    int acc[CONV2_HEIGHT][CONV2_WIDTH];
+
+    for (f = 0; f < CONV2_NBOUTPUT; f++) {          // for each filter
+        for (y = 0; y < CONV2_HEIGHT; y++)
+            for (x = 0; x < CONV2_WIDTH; x++)
+                acc[y][x] = 0;
+        for (i = 0; i < taps; i++)
+            w[i] = kernel->centroid[CLUSTER_INDEX(kernel, f * taps + i)];
+
+        for (i = 0; i < taps; i++) {
+            c = i / (CONV2_DIM * CONV2_DIM);
+            ky = i / CONV2_DIM % CONV2_DIM;
+            kx = i % CONV2_DIM;
+
+            for (y = 0; y < CONV2_HEIGHT; y++) {
+                for (x = 0; x < CONV2_WIDTH; x++) {
+                    ACC_ADD(PROFILE_CONV2, acc[y][x], w[i] * input[c][y + ky][x + kx]);
+                }
+            }
+        }
+
+        for (y = 0; y < CONV2_HEIGHT; y++) {
+            for (x = 0; x < CONV2_WIDTH; x++) {
+                // Fixed-point scaling and adding bias
+                int out = (acc[y][x] >> FIXED_POINT) + bias[f];
+                PROFILE_FIXED_OUT(PROFILE_CONV2, out);
+
+                // ReLU activation
+                output[f][y][x] = (short)(out > 0 ? out : 0);
+            }
+        }
+    }
+}
+
+/// @brief Conv2 on entropy-coded Q8 weights: each filter is decoded from the stream, then computed as the CSR kernel
+/// @param input    Input feature maps array of size [20][12][12]
+/// @param kernel   Huffman-coded [40][20][5][5] kernel (HuffmanEncode_fixed)
+/// @param bias     Bias terms array of size [40]
+/// @param output   Output feature maps array of size [40][8][8], identical to the dense kernel
+void Conv2_12x12x20_5x5x40_1_0_huffman_fixed(
+    short input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const huffman_fixed_t *kernel,
+    short bias[CONV2_NBOUTPUT],
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH])
+{
+    const int taps = POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM;
+    unsigned short f, y, x, c, ky, kx;
+    short w[POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM];
+    int i, acc[CONV2_HEIGHT][CONV2_WIDTH];
+    huffman_stream_fixed_t stream;
+
+    HuffmanStreamInit_fixed(kernel, &stream);
+    for (f = 0; f < CONV2_NBOUTPUT; f++) {          // for each filter
+        for (y = 0; y < CONV2_HEIGHT; y++)
+            for (x = 0; x < CONV2_WIDTH; x++)
+                acc[y][x] = 0;
+        HuffmanStreamRead_fixed(&stream, w, taps);
+
+        for (i = 0; i < taps; i++) {
+            c = i / (CONV2_DIM * CONV2_DIM);
+            ky = i / CONV2_DIM % CONV2_DIM;
+            kx = i % CONV2_DIM;
+
+            for (y = 0; y < CONV2_HEIGHT; y++) {
+                for (x = 0; x < CONV2_WIDTH; x++) {
+                    ACC_ADD(PROFILE_CONV2, acc[y][x], w[i] * input[c][y + ky][x + kx]);
+                }
+            }
+        }
+
+        for (y = 0; y < CONV2_HEIGHT; y++) {
+            for (x = 0; x < CONV2_WIDTH; x++) {
+                // Fixed-point scaling and adding bias
+                int out = (acc[y][x] >> FIXED_POINT) + bias[f];
+                PROFILE_FIXED_OUT(PROFILE_CONV2, out);
+
+                // ReLU activation
+                output[f][y][x] = (short)(out > 0 ? out : 0);
+            }
+        }
+    }
+}
+
+/// @brief Conv1 on power-of-two weights: each product is one or two shifts and an add, no multiplier
+/// @param input    Input image array of size [1][28][28]
+/// @param kernel   Convolution filters [20][1][5][5] as sums of powers of two (Pow2Quantize_fixed)
+/// @param bias     Bias terms array of size [20]
+/// @param output   Output feature maps array of size [20][24][24], identical to the dense kernel on the
+///                 Pow2Value_fixed weights
+/// A tap is added to all the outputs at once, so its shifts are the same across a row (vectorized over x).
+void Conv1_28x28x1_5x5x20_1_0_pow2_fixed(
+    short input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
+    const pow2_fixed_t kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+    short bias[CONV1_NBOUTPUT],
+    short output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH])
+{
+    unsigned short f, c, y, x, ky, kx;
+    int acc[CONV1_HEIGHT][CONV1_WIDTH];
+
+    for (f = 0; f < CONV1_NBOUTPUT; f++) {          // for each filter
+        for (y = 0; y < CONV1_HEIGHT; y++)
+            for (x = 0; x < CONV1_WIDTH; x++)
+                acc[y][x] = 0;
+
+        for (c = 0; c < IMG_DEPTH; c++) {           // for each input channel
+            for (ky = 0; ky < CONV1_DIM; ky++) {
+                for (kx = 0; kx < CONV1_DIM; kx++) {
+                    const pow2_fixed_t w = kernel[f][c][ky][kx];
+
+                    for (y = 0; y < CONV1_HEIGHT; y++) {
+                        for (x = 0; x < CONV1_WIDTH; x++) {
+                            short in = input[c][y + ky][x + kx];
+                            ACC_ADD(PROFILE_CONV1, acc[y][x], POW2_TERM(in, w.hi) + POW2_TERM(in, w.lo));
+                        }
+                    }
+                }
+            }
+        }
+
+        for (y = 0; y < CONV1_HEIGHT; y++) {
+            for (x = 0; x < CONV1_WIDTH; x++) {
+                // Fixed-point scaling and adding bias
+                int out = (acc[y][x] >> FIXED_POINT) + bias[f];
+                PROFILE_FIXED_OUT(PROFILE_CONV1, out);
+
+                // ReLU activation
+                output[f][y][x] = (short)(out > 0 ? out : 0);
+            }
+        }
+    }
+}
+
+/// @brief Conv2 on power-of-two weights: each product is one or two shifts and an add, no multiplier
+/// @param input    Input feature maps array of size [20][12][12]
+/// @param kernel   Convolution filters [40][20][5][5] as sums of powers of two (Pow2Quantize_fixed)
+/// @param bias     Bias terms array of size [40]
+/// @param output   Output feature maps array of size [40][8][8], identical to the dense kernel on the
+///                 Pow2Value_fixed weights
+/// A tap is added to all the outputs at once, so its shifts are the same across a row (vectorized over x).
+void Conv2_12x12x20_5x5x40_1_0_pow2_fixed(
+    short input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const pow2_fixed_t kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+    short bias[CONV2_NBOUTPUT],
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH])
+{
+    unsigned short f, c, y, x, ky, kx;
+    int acc[CONV2_HEIGHT][CONV2_WIDTH];
+
+    for (f = 0; f < CONV2_NBOUTPUT; f++) {          // for each filter
+        for (y = 0; y < CONV2_HEIGHT; y++)
+            for (x = 0; x < CONV2_WIDTH; x++)
+                acc[y][x] = 0;
+
+        for (c = 0; c < POOL1_NBOUTPUT; c++) {      // for each input channel
+            for (ky = 0; ky < CONV2_DIM; ky++) {
+                for (kx = 0; kx < CONV2_DIM; kx++) {
+                    const pow2_fixed_t w = kernel[f][c][ky][kx];
+
+                    for (y = 0; y < CONV2_HEIGHT; y++) {
+                        for (x = 0; x < CONV2_WIDTH; x++) {
+                            short in = input[c][y + ky][x + kx];
+                            ACC_ADD(PROFILE_CONV2, acc[y][x], POW2_TERM(in, w.hi) + POW2_TERM(in, w.lo));
+                        }
+                    }
+                }
+            }
+        }
+
+        for (y = 0; y < CONV2_HEIGHT; y++) {
+            for (x = 0; x < CONV2_WIDTH; x++) {
+                // Fixed-point scaling and adding bias
+                int out = (acc[y][x] >> FIXED_POINT) + bias[f];
+                PROFILE_FIXED_OUT(PROFILE_CONV2, out);
+
+                // ReLU activation
+                output[f][y][x] = (short)(out > 0 ? out : 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,158 @@
+/**
+ * @file csr_fixed.c
+ * @brief Magnitude pruning of the Q8 weights and their compressed sparse row (CSR) storage
+ *
+ * CsrPrune_fixed zeroes the smallest weights of a layer in place; CsrFromDense_fixed
+ * then keeps the nonzero weights of each row (one Conv2 filter, one FC1 neuron)
+ * with their column in the dense row. Same file layout as ../FLOAT/csr.c with
+ * 2-byte values.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../COMMON/alloc.h"
+#include "lenet_cnn_fixed.h"
+
+static int CompareShort(const void *a, const void *b)
+{
+    short x = *(const short *)a, y = *(const short *)b;
+
+    return (x > y) - (x < y);
+}
+
+/// @brief Zero the round(sparsity * size) weights of smallest magnitude (ties in index order)
+/// @param weights  Layer weights, modified in place
+/// @param size     Number of weights
+/// @param sparsity Share of the weights to zero, in [0, 1]
+void CsrPrune_fixed(short *weights, int size, float sparsity)
+{
+    short *magnitude, threshold;
+    int i, below, ties, k = (int)(sparsity * size + 0.5f);
+
+    if (k <= 0)
+        return;
+    if (k > size)
+        k = size;
+
+    magnitude = Allocate(size * sizeof(short));
+    for (i = 0; i < size; i++)
+        magnitude[i] = (short)abs(weights[i]);          // |-32768| does not occur in weights.h
+    qsort(magnitude, size, sizeof(short), CompareShort);
+    threshold = magnitude[k - 1];
+    for (below = 0; magnitude[below] < threshold; below++)
+        ;
+    ties = k - below;                           // weights equal to the threshold that go as well
+    free(magnitude);
+
+    for (i = 0; i < size; i++) {
+        if (abs(weights[i]) < threshold)
+            weights[i] = 0;
+        else if (abs(weights[i]) == threshold && ties > 0) {
+            weights[i] = 0;
+            ties--;
+        }
+    }
+}
+
+/// @brief Build the CSR of a dense [rows][cols] matrix, exact zeros dropped
+void CsrFromDense_fixed(const short *dense, int rows, int cols, csr_fixed_t *csr)
+{
+    int r, c, n = 0;
+
+    for (c = 0; c < rows * cols; c++)
+        n += (dense[c] != 0);
+
+    csr->rows = rows;
+    csr->cols = cols;
+    csr->nnz = n;
+    csr->row_ptr = Allocate((rows + 1) * sizeof(int));
+    csr->col = Allocate(n * sizeof(unsigned short));
+    csr->val = Allocate(n * sizeof(short));
+
+    n = 0;
+    for (r = 0; r < rows; r++) {
+        csr->row_ptr[r] = n;
+        for (c = 0; c < cols; c++)
+            if (dense[r * cols + c] != 0) {
+                csr->col[n] = (unsigned short)c;
+                csr->val[n] = dense[r * cols + c];
+                n++;
+            }
+    }
+    csr->row_ptr[rows] = n;
+}
+
+/// @brief Storage of the CSR arrays in bytes
+long CsrBytes_fixed(const csr_fixed_t *csr)
+{
+    return (csr->rows + 1) * (long)sizeof(int) + csr->nnz * (long)(sizeof(unsigned short) + sizeof(short));
+}
+
+void CsrWrite_fixed(FILE *file, const csr_fixed_t *csr)
+{
+    const char magic[4] = { 'C', 'S', 'R', sizeof(short) };
+    int header[3] = { csr->rows, csr->cols, csr->nnz };
+
+    fwrite(magic, 1, sizeof(magic), file);
+    fwrite(header, sizeof(int), 3, file);
+    fwrite(csr->row_ptr, sizeof(int), csr->rows + 1, file);
+    fwrite(csr->col, sizeof(unsigned short), csr->nnz, file);
+    fwrite(csr->val, sizeof(short), csr->nnz, file);
+}
+
+/// @brief row_ptr from 0 to nnz, never decreasing, and every column inside the row: the kernels index with them
+static int CsrIndicesValid(const csr_fixed_t *csr)
+{
+    int r, i;
+
+    if (csr->row_ptr[0] != 0 || csr->row_ptr[csr->rows] != csr->nnz)
+        return 0;
+    for (r = 0; r < csr->rows; r++)
+        if (csr->row_ptr[r + 1] < csr->row_ptr[r])
+            return 0;
+    for (i = 0; i < csr->nnz; i++)
+        if (csr->col[i] >= csr->cols)
+            return 0;
+    return 1;
+}
+
+void CsrRead_fixed(FILE *file, csr_fixed_t *csr)
+{
+    const char expected[4] = { 'C', 'S', 'R', sizeof(short) };
+    char magic[4];
+    int header[3];
+
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, expected, sizeof(magic)) != 0
+        || fread(header, sizeof(int), 3, file) != 3 || header[0] < 0 || header[1] < 0 || header[2] < 0) {
+        printf("Error: Not a fixed-point CSR matrix.\n");
+        exit(1);
+    }
+    csr->rows = header[0];
+    csr->cols = header[1];
+    csr->nnz = header[2];
+    csr->row_ptr = Allocate((csr->rows + 1) * sizeof(int));
+    csr->col = Allocate(csr->nnz * sizeof(unsigned short));
+    csr->val = Allocate(csr->nnz * sizeof(short));
+    if (fread(csr->row_ptr, sizeof(int), csr->rows + 1, file) != (size_t)csr->rows + 1
+        || fread(csr->col, sizeof(unsigned short), csr->nnz, file) != (size_t)csr->nnz
+        || fread(csr->val, sizeof(short), csr->nnz, file) != (size_t)csr->nnz) {
+        printf("Error: Truncated fixed-point CSR matrix.\n");
+        exit(1);
+    }
+    if (!CsrIndicesValid(csr)) {
+        printf("Error: Invalid row pointers or columns in a fixed-point CSR matrix.\n");
+        exit(1);
+    }
+}
+
+void CsrFree_fixed(csr_fixed_t *csr)
+{
+    free(csr->row_ptr);
+    free(csr->col);
+    free(csr->val);
+    csr->row_ptr = NULL;
+    csr->col = NULL;
+    csr->val = NULL;
+    csr->nnz = 0;
+}
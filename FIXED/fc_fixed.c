@@ -7,7 +7,13 @@
  */
 
 #include <math.h>
+#include <string.h>
 #include "lenet_cnn_fixed.h"
+#include "profile_fixed.h"
+
+#if defined(__SSSE3__) && !defined(PROFILE)
+#include <tmmintrin.h>
+#endif
 
 /// @brief First Fully Connected Layer FC1 using fixed-point arithmetic
 /// @param input    Layer input from previous pooling layer [POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH]
@@ -29,13 +35,314 @@ void Fc1_40_400_fixed(
         for (c = 0; c < POOL2_NBOUTPUT; c++) {
             for (h = 0; h < POOL2_HEIGHT; h++) {
                 for (w = 0; w < POOL2_WIDTH; w++) {
-                    acc += (int)input[c][h][w] * (int)kernel[n][c][h][w];
+                    ACC_ADD(PROFILE_FC1, acc, (int)input[c][h][w] * (int)kernel[n][c][h][w]);
+                }
+            }
+        }
+
+        // Fixed-point scaling and bias addition
+        acc = (acc >> FIXED_POINT) + bias[n];
+        PROFILE_FIXED_OUT(PROFILE_FC1, acc);
+
+        // ReLU activation
+        output[n] = (short)(acc > 0 ? acc : 0);
+    }
+}
+
+/// @brief FC1 from the nonzero list of its input: a zero input skips its FC1_NBOUTPUT weights
+/// @param input    Nonzero entries of the pool2 output, built once and shared by all the outputs
+/// @param kernel   Weight matrix [FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH]
+/// @param bias     Bias values [FC1_NBOUTPUT]
+/// @param output   Layer output [FC1_NBOUTPUT], identical to Fc1_40_400_fixed
+void Fc1_40_400_sparse_fixed(
+    const nonzero_list_fixed_t *input,
+    short kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    short bias[FC1_NBOUTPUT],
+    short output[FC1_NBOUTPUT]
+) {
+    unsigned short n;
+    int i, acc;
+
+    for (n = 0; n < FC1_NBOUTPUT; n++) {
+        const short *row = &kernel[n][0][0][0];
+        acc = 0;
+
+        for (i = 0; i < input->count; i++) {
+            ACC_ADD(PROFILE_FC1, acc, (int)input->value[i] * (int)row[input->index[i]]);
+        }
+
+        // Fixed-point scaling and bias addition
+        acc = (acc >> FIXED_POINT) + bias[n];
+        PROFILE_FIXED_OUT(PROFILE_FC1, acc);
+
+        // ReLU activation
+        output[n] = (short)(acc > 0 ? acc : 0);
+    }
+}
+
+/// @brief FC1 on pruned weights in CSR: each output only reads its nonzero weights
+/// @param input    Layer input from previous pooling layer [POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH]
+/// @param kernel   Weights in CSR, FC1_NBOUTPUT rows of POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH columns
+/// @param bias     Bias values [FC1_NBOUTPUT]
+/// @param output   Layer output [FC1_NBOUTPUT], identical to Fc1_40_400_fixed on the pruned dense weights
+void Fc1_40_400_csr_fixed(
+    short input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const csr_fixed_t *kernel,
+    short bias[FC1_NBOUTPUT],
+    short output[FC1_NBOUTPUT]
+) {
+    const short *in = &input[0][0][0];
+    unsigned short n;
+    int i, acc;
+
+    for (n = 0; n < FC1_NBOUTPUT; n++) {
+        acc = 0;
+
+        for (i = kernel->row_ptr[n]; i < kernel->row_ptr[n + 1]; i++) {
+            ACC_ADD(PROFILE_FC1, acc, (int)in[kernel->col[i]] * (int)kernel->val[i]);
+        }
+
+        // Fixed-point scaling and bias addition
+        acc = (acc >> FIXED_POINT) + bias[n];
+        PROFILE_FIXED_OUT(PROFILE_FC1, acc);
+
+        // ReLU activation
+        output[n] = (short)(acc > 0 ? acc : 0);
+    }
+}
+
+#if defined(__SSSE3__) && !defined(PROFILE)
+/// @brief 4-bit rows of Fc1_40_400_cluster_fixed: the low and the high bytes of the 16 centroids are held in two
+///        registers, pshufb looks up 16 weights at a time and pmaddwd multiplies them with the inputs
+static void Fc1Cluster4_fixed(const short *in, const codebook_fixed_t *kernel, const short *bias, short *output)
+{
+    const int size = POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH;
+    const __m128i nibble = _mm_set1_epi8(15);
+    const unsigned char *index;
+    unsigned char low[16], high[16];
+    __m128i lo, hi, acc, pairs, indexes, wl, wh;
+    unsigned short n, i;
+    int sum;
+
+    for (i = 0; i < 16; i++) {
+        low[i] = (unsigned char)kernel->centroid[i];
+        high[i] = (unsigned char)((unsigned short)kernel->centroid[i] >> 8);
+    }
+    lo = _mm_loadu_si128((const __m128i *)low);
+    hi = _mm_loadu_si128((const __m128i *)high);
+
+    for (n = 0; n < FC1_NBOUTPUT; n++) {
+        index = kernel->index + n * size / 2;
+        acc = _mm_setzero_si128();
+
+        for (i = 0; i < size / 2; i += 8) {
+            // 8 index bytes, 16 weights in order: the low nibble of a byte first
+            pairs = _mm_loadl_epi64((const __m128i *)(index + i));
+            indexes = _mm_unpacklo_epi8(_mm_and_si128(pairs, nibble), _mm_and_si128(_mm_srli_epi16(pairs, 4), nibble));
+            wl = _mm_shuffle_epi8(lo, indexes);
+            wh = _mm_shuffle_epi8(hi, indexes);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi8(wl, wh),
+                                                    _mm_loadu_si128((const __m128i *)(in + 2 * i))));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpackhi_epi8(wl, wh),
+                                                    _mm_loadu_si128((const __m128i *)(in + 2 * i + 8))));
+        }
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4e));
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xb1));
+
+        // Fixed-point scaling and bias addition
+        sum = (_mm_cvtsi128_si32(acc) >> FIXED_POINT) + bias[n];
+
+        // ReLU activation
+        output[n] = (short)(sum > 0 ? sum : 0);
+    }
+}
+#endif
+
+/// @brief FC1 on clustered Q8 weights: the centroid of each weight is looked up in the multiply-add loop
+/// @param input    Layer input from previous pooling layer [POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH]
+/// @param kernel   Codebook and packed indexes of the [400][640] weights (ClusterFit_fixed)
+/// @param bias     Bias values [FC1_NBOUTPUT]
+/// @param output   Layer output [FC1_NBOUTPUT], identical to Fc1_40_400_fixed on the decoded weights
+/// A block of FC1_CLUSTER_ROWS rows shares each input load and a 16-entry codebook is copied to a local
+/// table; with SSSE3 (and not in the PROFILE build) 4-bit rows use Fc1Cluster4_fixed. The sums are exact in
+/// either order.
+void Fc1_40_400_cluster_fixed(
+    short input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const codebook_fixed_t *kernel,
+    short bias[FC1_NBOUTPUT],
+    short output[FC1_NBOUTPUT]
+) {
+    const int size = POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH;
+    const int stride = size * kernel->bits / 8;
+    const short *in = &input[0][0][0];
+    const unsigned char *index;
+    int centroid[16], acc[FC1_CLUSTER_ROWS];
+    unsigned short n, r;
+    int i, a, b;
+
+#if defined(__SSSE3__) && !defined(PROFILE)
+    if (kernel->bits == 4) {
+        Fc1Cluster4_fixed(in, kernel, bias, output);
+        return;
+    }
+#endif
+    for (i = 0; i < 16; i++)
+        centroid[i] = kernel->centroid[i];
+    for (n = 0; n < FC1_NBOUTPUT; n += FC1_CLUSTER_ROWS) {
+        index = kernel->index + n * stride;
+        for (r = 0; r < FC1_CLUSTER_ROWS; r++)
+            acc[r] = 0;
+
+        if (kernel->bits == 4) {
+            for (i = 0; i < size / 2; i++) {
+                a = in[2 * i];
+                b = in[2 * i + 1];
+                for (r = 0; r < FC1_CLUSTER_ROWS; r++) {
+                    ACC_ADD(PROFILE_FC1, acc[r], a * centroid[index[r * stride + i] & 15]);
+                    ACC_ADD(PROFILE_FC1, acc[r], b * centroid[index[r * stride + i] >> 4]);
+                }
+            }
+        } else {
+            for (i = 0; i < size; i++) {
+                a = in[i];
+                for (r = 0; r < FC1_CLUSTER_ROWS; r++) {
+                    ACC_ADD(PROFILE_FC1, acc[r], a * (int)kernel->centroid[index[r * stride + i]]);
+                }
+            }
+        }
+
+        for (r = 0; r < FC1_CLUSTER_ROWS; r++) {
+            // Fixed-point scaling and bias addition
+            acc[r] = (acc[r] >> FIXED_POINT) + bias[n + r];
+            PROFILE_FIXED_OUT(PROFILE_FC1, acc[r]);
+
+            // ReLU activation
+            output[n + r] = (short)(acc[r] > 0 ? acc[r] : 0);
+        }
+    }
+}
+
+/// @brief FC1 on entropy-coded Q8 weights: blocks of rows are decoded from the stream, then computed as the
+///        dense kernel
+/// @param input    Layer input from previous pooling layer [POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH]
+/// @param kernel   Huffman-coded [400][640] weights (HuffmanEncode_fixed)
+/// @param bias     Bias values [FC1_NBOUTPUT]
+/// @param output   Layer output [FC1_NBOUTPUT], identical to Fc1_40_400_fixed
+void Fc1_40_400_huffman_fixed(
+    short input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const huffman_fixed_t *kernel,
+    short bias[FC1_NBOUTPUT],
+    short output[FC1_NBOUTPUT]
+) {
+    const int size = POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH;
+    const short *in = &input[0][0][0];
+    short w[FC1_HUFFMAN_ROWS][POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH];
+    huffman_stream_fixed_t stream;
+    unsigned short n, r;
+    int i, acc;
+
+    HuffmanStreamInit_fixed(kernel, &stream);
+    for (n = 0; n < FC1_NBOUTPUT; n += FC1_HUFFMAN_ROWS) {
+        HuffmanStreamRead_fixed(&stream, &w[0][0], FC1_HUFFMAN_ROWS * size);
+
+        for (r = 0; r < FC1_HUFFMAN_ROWS; r++) {
+            acc = 0;
+
+            for (i = 0; i < size; i++) {
+                ACC_ADD(PROFILE_FC1, acc, (int)in[i] * (int)w[r][i]);
+            }
+
+            // Fixed-point scaling and bias addition
+            acc = (acc >> FIXED_POINT) + bias[n + r];
+            PROFILE_FIXED_OUT(PROFILE_FC1, acc);
+
+            // ReLU activation
+            output[n + r] = (short)(acc > 0 ? acc : 0);
+        }
+    }
+}
+
+/// @brief Partial FC1 on a chunk of the weights: count weights starting at weight first of the row-major
+///        [400][640] kernel, the chunk possibly starting and ending inside a row
+/// @param input    Layer input from previous pooling layer [POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH]
+/// @param kernel   The count weights of the chunk
+/// @param first    Index of the first one in the whole kernel
+/// @param count    Number of weights
+/// @param acc      Unscaled sums of the outputs, the products of the chunk added
+void Fc1_40_400_chunk_fixed(
+    short input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const short *kernel,
+    int first,
+    int count,
+    int acc[FC1_NBOUTPUT]
+) {
+    const int size = POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH;
+    const short *in = &input[0][0][0];
+    int n = first / size, i = first % size, k = 0, run, j, sum;
+
+    while (k < count) {
+        run = size - i < count - k ? size - i : count - k;
+        sum = 0;
+
+        for (j = 0; j < run; j++) {
+            ACC_ADD(PROFILE_FC1, sum, (int)in[i + j] * (int)kernel[k + j]);
+        }
+        acc[n] += sum;
+
+        k += run;
+        i = 0;
+        n++;
+    }
+}
+
+/// @brief Output of FC1 from the sums of Fc1_40_400_chunk_fixed over the whole kernel
+/// @param acc      Unscaled sums of the outputs
+/// @param bias     Bias values [FC1_NBOUTPUT]
+/// @param output   Layer output [FC1_NBOUTPUT], identical to Fc1_40_400_fixed
+void Fc1_40_400_finish_fixed(int acc[FC1_NBOUTPUT], short bias[FC1_NBOUTPUT], short output[FC1_NBOUTPUT])
+{
+    unsigned short n;
+    int out;
+
+    for (n = 0; n < FC1_NBOUTPUT; n++) {
+        // Fixed-point scaling and bias addition
+        out = (acc[n] >> FIXED_POINT) + bias[n];
+        PROFILE_FIXED_OUT(PROFILE_FC1, out);
+
+        // ReLU activation
+        output[n] = (short)(out > 0 ? out : 0);
+    }
+}
+
+/// @brief FC1 on power-of-two weights: each product is one or two shifts and an add, no multiplier
+/// @param input    Layer input from previous pooling layer [POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH]
+/// @param kernel   Weights as sums of powers of two (Pow2Quantize_fixed)
+/// @param bias     Bias values [FC1_NBOUTPUT]
+/// @param output   Layer output [FC1_NBOUTPUT], identical to Fc1_40_400_fixed on the Pow2Value_fixed weights
+void Fc1_40_400_pow2_fixed(
+    short input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const pow2_fixed_t kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    short bias[FC1_NBOUTPUT],
+    short output[FC1_NBOUTPUT]
+) {
+    unsigned short n, c, h, w;
+    int acc;
+
+    for (n = 0; n < FC1_NBOUTPUT; n++) {
+        acc = 0;
+
+        for (c = 0; c < POOL2_NBOUTPUT; c++) {
+            for (h = 0; h < POOL2_HEIGHT; h++) {
+                for (w = 0; w < POOL2_WIDTH; w++) {
+                    pow2_fixed_t k = kernel[n][c][h][w];
+                    ACC_ADD(PROFILE_FC1, acc, POW2_TERM(input[c][h][w], k.hi) + POW2_TERM(input[c][h][w], k.lo));
                 }
             }
         }
 
         // Fixed-point scaling and bias addition
         acc = (acc >> FIXED_POINT) + bias[n];
+        PROFILE_FIXED_OUT(PROFILE_FC1, acc);
 
         // ReLU activation
         output[n] = (short)(acc > 0 ? acc : 0);
@@ -60,11 +367,71 @@ void Fc2_400_10_fixed(
         sum = 0;
 
         for (i = 0; i < FC1_NBOUTPUT; i++) {
-            sum += (int)input[i] * (int)kernel[n][i];
+            ACC_ADD(PROFILE_FC2, sum, (int)input[i] * (int)kernel[n][i]);
+        }
+
+        // Fixed-point scaling and bias addition
+        sum = (sum >> FIXED_POINT) + bias[n];
+        PROFILE_FIXED_OUT(PROFILE_FC2, sum);
+
+        // ReLU activation
+        output[n] = (short)(sum > 0 ? sum : 0);
+    }
+}
+
+/// @brief FC2 without ReLU: the logits keep their sign, as those of the float Fc2_400_10
+/// @param input    Layer input (output from FC1) [FC1_NBOUTPUT]
+/// @param kernel   Weight matrix [FC2_NBOUTPUT][FC1_NBOUTPUT]
+/// @param bias     Bias values [FC2_NBOUTPUT]
+/// @param output   Layer output [FC2_NBOUTPUT], Fc2_400_10_fixed before its ReLU
+void Fc2_400_10_linear_fixed(
+    short input[FC1_NBOUTPUT],
+    short kernel[FC2_NBOUTPUT][FC1_NBOUTPUT],
+    short bias[FC2_NBOUTPUT],
+    short output[FC2_NBOUTPUT]
+) {
+    unsigned short n, i;
+    int sum;
+
+    for (n = 0; n < FC2_NBOUTPUT; n++) {
+        sum = 0;
+
+        for (i = 0; i < FC1_NBOUTPUT; i++) {
+            ACC_ADD(PROFILE_FC2, sum, (int)input[i] * (int)kernel[n][i]);
+        }
+
+        // Fixed-point scaling and bias addition
+        sum = (sum >> FIXED_POINT) + bias[n];
+        PROFILE_FIXED_OUT(PROFILE_FC2, sum);
+
+        output[n] = (short)sum;
+    }
+}
+
+/// @brief FC2 on power-of-two weights: each product is one or two shifts and an add, no multiplier
+/// @param input    Layer input (output from FC1) [FC1_NBOUTPUT]
+/// @param kernel   Weights as sums of powers of two (Pow2Quantize_fixed)
+/// @param bias     Bias values [FC2_NBOUTPUT]
+/// @param output   Layer output [FC2_NBOUTPUT], identical to Fc2_400_10_fixed on the Pow2Value_fixed weights
+void Fc2_400_10_pow2_fixed(
+    short input[FC1_NBOUTPUT],
+    const pow2_fixed_t kernel[FC2_NBOUTPUT][FC1_NBOUTPUT],
+    short bias[FC2_NBOUTPUT],
+    short output[FC2_NBOUTPUT]
+) {
+    unsigned short n, i;
+    int sum;
+
+    for (n = 0; n < FC2_NBOUTPUT; n++) {
+        sum = 0;
+
+        for (i = 0; i < FC1_NBOUTPUT; i++) {
+            ACC_ADD(PROFILE_FC2, sum, POW2_TERM(input[i], kernel[n][i].hi) + POW2_TERM(input[i], kernel[n][i].lo));
         }
 
         // Fixed-point scaling and bias addition
         sum = (sum >> FIXED_POINT) + bias[n];
+        PROFILE_FIXED_OUT(PROFILE_FC2, sum);
 
         // ReLU activation
         output[n] = (short)(sum > 0 ? sum : 0);
@@ -97,3 +464,106 @@ void Softmax_fixed(short vector_in[FC2_NBOUTPUT], float vector_out[FC2_NBOUTPUT]
         vector_out[i] /= soft_sum;
     }
 }
+
+// exp(-d) lookup tables in Q15, d = k + h/16 + l/256 split from a Q8 distance
+static const unsigned short EXP_INT_Q15[12] = {
+    32768, 12055, 4435, 1631, 600, 221, 81, 30, 11, 4, 1, 1
+};
+static const unsigned short EXP_HI_Q15[16] = {
+    32768, 30783, 28918, 27166, 25520, 23974, 22521, 21157,
+    19875, 18671, 17539, 16477, 15479, 14541, 13660, 12832
+};
+static const unsigned short EXP_LO_Q15[16] = {
+    32768, 32640, 32513, 32386, 32260, 32134, 32009, 31884,
+    31760, 31636, 31513, 31390, 31267, 31146, 31024, 30903
+};
+
+/// @brief exp(-d) in Q15 for a non-negative distance d in Q(FIXED_POINT)
+/// @param d Distance to the maximum logit, d >= 0
+/// @return  Rounded exp(-d) * 2^15, 0 below e^-12
+static unsigned int ExpNeg_fixed(int d)
+{
+    unsigned int k, e;
+
+#if FIXED_POINT >= 8
+    d >>= (FIXED_POINT - 8);
+#else
+    d <<= (8 - FIXED_POINT);
+#endif
+    k = (unsigned int)d >> 8;
+    if (k >= 12)
+        return 0;
+
+    e = (EXP_INT_Q15[k] * (unsigned int)EXP_HI_Q15[(d >> 4) & 0xF] + (1 << 14)) >> 15;
+    e = (e * EXP_LO_Q15[d & 0xF] + (1 << 14)) >> 15;
+    return e;
+}
+
+/// @brief Integer-only softmax: exp LUT and a single integer reciprocal, no FPU
+/// @param vector_in   Input values [FC2_NBOUTPUT] in fixed-point
+/// @param vector_out  Output probabilities [FC2_NBOUTPUT] in Q15 (SOFTMAX_Q15_ONE = 1.0)
+void Softmax_int_fixed(short vector_in[FC2_NBOUTPUT], unsigned short vector_out[FC2_NBOUTPUT]) {
+    unsigned short i;
+    unsigned int e[FC2_NBOUTPUT];
+    unsigned int sum = 0;
+    unsigned int recip;
+    short max_val = vector_in[Argmax_fixed(vector_in)];
+
+    // exp(x - max) in Q15, the maximum contributes exactly 1.0 so sum >= 2^15
+    for (i = 0; i < FC2_NBOUTPUT; i++) {
+        e[i] = ExpNeg_fixed(max_val - vector_in[i]);
+        sum += e[i];
+    }
+
+    // 2^30 / sum is 1/sum in Q15 scaled by 2^15, at most 2^15
+    recip = (1U << 30) / sum;
+
+    for (i = 0; i < FC2_NBOUTPUT; i++) {
+        vector_out[i] = (unsigned short)((e[i] * recip + (1 << 14)) >> 15);
+    }
+}
+
+/// @brief Index of the largest input, first one on ties
+/// @param vector_in   Input values [FC2_NBOUTPUT] in fixed-point
+/// @return            Predicted class
+unsigned char Argmax_fixed(short vector_in[FC2_NBOUTPUT]) {
+    unsigned char i, best = 0;
+
+    for (i = 1; i < FC2_NBOUTPUT; i++) {
+        if (vector_in[i] > vector_in[best]) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+/// @brief Indices of the k largest inputs, in decreasing order (lower index first on ties)
+/// @param vector_in   Input values [FC2_NBOUTPUT] in fixed-point
+/// @param k           Number of classes to return, at most FC2_NBOUTPUT
+/// @param index       Output class indices [k]
+void TopK_fixed(short vector_in[FC2_NBOUTPUT], unsigned char k, unsigned char index[]) {
+    unsigned char i, j, best;
+    unsigned char taken[FC2_NBOUTPUT] = { 0 };
+
+    for (j = 0; j < k && j < FC2_NBOUTPUT; j++) {
+        best = FC2_NBOUTPUT;
+        for (i = 0; i < FC2_NBOUTPUT; i++) {
+            if (!taken[i] && (best == FC2_NBOUTPUT || vector_in[i] > vector_in[best])) {
+                best = i;
+            }
+        }
+        taken[best] = 1;
+        index[j] = best;
+    }
+}
+
+/// @brief Argmax-only output: predicted class and top-2 logit margin, no softmax
+/// @param vector_in   Input values [FC2_NBOUTPUT] in fixed-point
+/// @param pred        Predicted class and logit(top1) - logit(top2) in fixed-point
+void Predict_fixed(short vector_in[FC2_NBOUTPUT], prediction_fixed_t *pred) {
+    unsigned char top2[2];
+
+    TopK_fixed(vector_in, 2, top2);
+    pred->number = top2[0];
+    pred->margin = vector_in[top2[0]] - vector_in[top2[1]];
+}
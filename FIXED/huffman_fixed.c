@@ -0,0 +1,374 @@
+/**
+ * @file huffman_fixed.c
+ * @brief Entropy coding of a layer's Q8 weights: canonical Huffman code and streaming decoder
+ *
+ * The weights of a layer take a few dozen distinct values, far from evenly
+ * used, so a Huffman code on the values themselves (order 0) takes the 16 bits
+ * of a short down to 5-7 bits. Code lengths are limited to HUFFMAN_MAX_BITS by
+ * lengthening the deepest codes that still have room until the Kraft sum
+ * fits, and the code is canonical: a layer is stored as its symbols in code
+ * order, their code lengths and the bit streams, MSB first. Weight i goes to
+ * stream i % HUFFMAN_STREAMS: one stream is a chain of dependent table
+ * lookups (where the next code starts depends on the length of this one),
+ * several interleaved streams let the CPU run the chains side by side. The
+ * decoder looks the next HUFFMAN_MAX_BITS bits up in a table built in RAM, one
+ * weight per lookup, and can stop and resume anywhere, so a kernel decodes its
+ * weights block by block right before using them. On disk a layer is the 4
+ * bytes "HUF" + the weight size, then size, symbols and the byte size of each
+ * stream (int32), the symbols, the lengths and the streams, native byte order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../COMMON/alloc.h"
+#include "lenet_cnn_fixed.h"
+
+#define NB_VALUES 65536                         // of a short, value + 32768 as index
+#define HUFFMAN_PER_REFILL (56 / HUFFMAN_MAX_BITS)
+
+typedef struct {
+    long count;
+    int  symbol;                                // value + 32768
+    int  length;
+} leaf_t;
+
+static int CompareCount(const void *a, const void *b)
+{
+    const leaf_t *x = a, *y = b;
+
+    return x->count != y->count ? (x->count > y->count) - (x->count < y->count) : x->symbol - y->symbol;
+}
+
+static int CompareCanonical(const void *a, const void *b)
+{
+    const leaf_t *x = a, *y = b;
+
+    return x->length != y->length ? x->length - y->length : x->symbol - y->symbol;
+}
+
+/// @brief Huffman code lengths of the leaves, sorted by increasing count (two-queue construction)
+static void CodeLengths(leaf_t *leaf, int n)
+{
+    long *weight = Allocate(2 * n * sizeof(long));
+    int *parent = Allocate(2 * n * sizeof(int));
+    int i, a, b, next_leaf = 0, next_node = n, nb_nodes = n, kraft, deepest;
+
+    if (n == 1) {
+        leaf[0].length = 1;
+        free(weight);
+        free(parent);
+        return;
+    }
+    for (i = 0; i < n; i++)
+        weight[i] = leaf[i].count;
+
+    // Merge the two lightest of the leaf queue and the node queue, nodes being made in weight order
+    while (nb_nodes < 2 * n - 1) {
+        a = (next_leaf < n && (next_node >= nb_nodes || weight[next_leaf] <= weight[next_node])) ? next_leaf++
+                                                                                               : next_node++;
+        b = (next_leaf < n && (next_node >= nb_nodes || weight[next_leaf] <= weight[next_node])) ? next_leaf++
+                                                                                               : next_node++;
+        weight[nb_nodes] = weight[a] + weight[b];
+        parent[a] = parent[b] = nb_nodes++;
+    }
+
+    // Depths from the root down, parents always come after their children
+    parent[2 * n - 2] = -1;
+    weight[2 * n - 2] = 0;
+    for (i = 2 * n - 3; i >= 0; i--)
+        weight[i] = weight[parent[i]] + 1;
+    for (i = 0; i < n; i++)
+        leaf[i].length = (int)weight[i];
+    free(weight);
+    free(parent);
+
+    // Length limit: clamp, then lengthen the deepest codes below the limit until the Kraft sum is <= 1
+    kraft = 0;
+    for (i = 0; i < n; i++) {
+        if (leaf[i].length > HUFFMAN_MAX_BITS)
+            leaf[i].length = HUFFMAN_MAX_BITS;
+        kraft += 1 << (HUFFMAN_MAX_BITS - leaf[i].length);
+    }
+    while (kraft > 1 << HUFFMAN_MAX_BITS) {
+        deepest = -1;
+        for (i = 0; i < n; i++)
+            if (leaf[i].length < HUFFMAN_MAX_BITS && (deepest < 0 || leaf[i].length > leaf[deepest].length))
+                deepest = i;
+        kraft -= 1 << (HUFFMAN_MAX_BITS - leaf[deepest].length - 1);
+        leaf[deepest].length++;
+    }
+}
+
+/// @brief Decode table of the canonical code of code->symbol / code->length
+static void BuildTable(huffman_fixed_t *code)
+{
+    unsigned int c = 0;
+    int s, i, span;
+
+    memset(code->table, 0, sizeof(code->table));
+    for (s = 0; s < code->nb_symbols; s++) {
+        if (s > 0)
+            c = (c + 1) << (code->length[s] - code->length[s - 1]);
+        span = 1 << (HUFFMAN_MAX_BITS - code->length[s]);
+        for (i = 0; i < span; i++) {
+            code->table[(c << (HUFFMAN_MAX_BITS - code->length[s])) + i].value = code->symbol[s];
+            code->table[(c << (HUFFMAN_MAX_BITS - code->length[s])) + i].length = code->length[s];
+        }
+    }
+}
+
+/// @brief Entropy-code the weights of a layer
+/// @param weights  Layer weights (or biases)
+/// @param size     Number of weights, at least 1
+/// @param code     Symbols, lengths, bit stream and decode table, allocated here (HuffmanFree_fixed)
+void HuffmanEncode_fixed(const short *weights, int size, huffman_fixed_t *code)
+{
+    long *histogram = AllocateZeroed(NB_VALUES * sizeof(long));
+    unsigned int *codeword = Allocate(NB_VALUES * sizeof(unsigned int));
+    unsigned char *length = Allocate(NB_VALUES);
+    unsigned long long buffer = 0;
+    leaf_t *leaf;
+    long lane_bits[HUFFMAN_STREAMS], pos;
+    unsigned int c = 0;
+    int i, l, n = 0, count, v;
+
+    for (i = 0; i < size; i++)
+        histogram[weights[i] + 32768]++;
+    for (v = 0; v < NB_VALUES; v++)
+        n += histogram[v] != 0;
+    if (n > HUFFMAN_MAX_SYMBOLS) {
+        printf("Error: %d distinct weights, at most %d can be coded.\n", n, HUFFMAN_MAX_SYMBOLS);
+        exit(1);
+    }
+    leaf = Allocate(n * sizeof(leaf_t));
+    for (v = 0, i = 0; v < NB_VALUES; v++)
+        if (histogram[v]) {
+            leaf[i].count = histogram[v];
+            leaf[i].symbol = v;
+            i++;
+        }
+    qsort(leaf, n, sizeof(leaf_t), CompareCount);
+    CodeLengths(leaf, n);
+    qsort(leaf, n, sizeof(leaf_t), CompareCanonical);
+
+    code->size = size;
+    code->nb_symbols = n;
+    code->symbol = Allocate(n * sizeof(short));
+    code->length = Allocate(n);
+    for (i = 0; i < n; i++) {
+        if (i > 0)
+            c = (c + 1) << (leaf[i].length - leaf[i - 1].length);
+        code->symbol[i] = (short)(leaf[i].symbol - 32768);
+        code->length[i] = (unsigned char)leaf[i].length;
+        codeword[leaf[i].symbol] = c;
+        length[leaf[i].symbol] = (unsigned char)leaf[i].length;
+    }
+    BuildTable(code);
+
+    // Bit streams, MSB first, the last byte of each padded with zeros
+    for (l = 0; l < HUFFMAN_STREAMS; l++)
+        lane_bits[l] = 0;
+    for (i = 0; i < size; i++)
+        lane_bits[i % HUFFMAN_STREAMS] += length[weights[i] + 32768];
+    code->offset[0] = 0;
+    for (l = 0; l < HUFFMAN_STREAMS; l++)
+        code->offset[l + 1] = code->offset[l] + (lane_bits[l] + 7) / 8;
+    code->nb_bytes = code->offset[HUFFMAN_STREAMS];
+    code->bits = Allocate(code->nb_bytes);
+    for (l = 0; l < HUFFMAN_STREAMS; l++) {
+        buffer = 0;
+        count = 0;
+        pos = code->offset[l];
+        for (i = l; i < size; i += HUFFMAN_STREAMS) {
+            v = weights[i] + 32768;
+            buffer = (buffer << length[v]) | codeword[v];
+            count += length[v];
+            while (count >= 8) {
+                count -= 8;
+                code->bits[pos++] = (unsigned char)(buffer >> count);
+            }
+        }
+        if (count > 0)
+            code->bits[pos] = (unsigned char)(buffer << (8 - count));
+    }
+
+    free(histogram);
+    free(codeword);
+    free(length);
+    free(leaf);
+}
+
+/// @brief ROM size of a coded layer in bytes: header, symbols, lengths and bit stream (not the decode table)
+long HuffmanBytes_fixed(const huffman_fixed_t *code)
+{
+    return 4 + (2 + HUFFMAN_STREAMS) * sizeof(int) + code->nb_symbols * (sizeof(short) + 1) + code->nb_bytes;
+}
+
+void HuffmanWrite_fixed(FILE *file, const huffman_fixed_t *code)
+{
+    const char magic[4] = { 'H', 'U', 'F', sizeof(short) };
+    int header[2 + HUFFMAN_STREAMS] = { code->size, code->nb_symbols }, l;
+
+    for (l = 0; l < HUFFMAN_STREAMS; l++)
+        header[2 + l] = (int)(code->offset[l + 1] - code->offset[l]);
+    fwrite(magic, 1, sizeof(magic), file);
+    fwrite(header, sizeof(int), 2 + HUFFMAN_STREAMS, file);
+    fwrite(code->symbol, sizeof(short), code->nb_symbols, file);
+    fwrite(code->length, 1, code->nb_symbols, file);
+    fwrite(code->bits, 1, code->nb_bytes, file);
+}
+
+void HuffmanRead_fixed(FILE *file, huffman_fixed_t *code)
+{
+    const char expected[4] = { 'H', 'U', 'F', sizeof(short) };
+    char magic[4];
+    int header[2 + HUFFMAN_STREAMS], s, l, kraft = 0;
+
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, expected, sizeof(magic)) != 0
+        || fread(header, sizeof(int), 2 + HUFFMAN_STREAMS, file) != 2 + HUFFMAN_STREAMS || header[0] < 1
+        || header[1] < 1 || header[1] > HUFFMAN_MAX_SYMBOLS) {
+        printf("Error: Not an entropy-coded layer.\n");
+        exit(1);
+    }
+    code->size = header[0];
+    code->nb_symbols = header[1];
+    code->offset[0] = 0;
+    for (l = 0; l < HUFFMAN_STREAMS; l++) {
+        if (header[2 + l] < 0) {
+            printf("Error: Not an entropy-coded layer.\n");
+            exit(1);
+        }
+        code->offset[l + 1] = code->offset[l] + header[2 + l];
+    }
+    code->nb_bytes = code->offset[HUFFMAN_STREAMS];
+    code->symbol = Allocate(code->nb_symbols * sizeof(short));
+    code->length = Allocate(code->nb_symbols);
+    code->bits = Allocate(code->nb_bytes);
+    if (fread(code->symbol, sizeof(short), code->nb_symbols, file) != (size_t)code->nb_symbols
+        || fread(code->length, 1, code->nb_symbols, file) != (size_t)code->nb_symbols
+        || fread(code->bits, 1, code->nb_bytes, file) != (size_t)code->nb_bytes) {
+        printf("Error: Truncated entropy-coded layer.\n");
+        exit(1);
+    }
+
+    // Canonical order and a complete prefix code, or the table would be read out of bounds
+    for (s = 0; s < code->nb_symbols; s++) {
+        if (code->length[s] < 1 || code->length[s] > HUFFMAN_MAX_BITS
+            || (s > 0 && code->length[s] < code->length[s - 1])) {
+            printf("Error: Invalid code lengths in an entropy-coded layer.\n");
+            exit(1);
+        }
+        kraft += 1 << (HUFFMAN_MAX_BITS - code->length[s]);
+    }
+    if (kraft > 1 << HUFFMAN_MAX_BITS) {
+        printf("Error: Invalid code lengths in an entropy-coded layer.\n");
+        exit(1);
+    }
+    BuildTable(code);
+}
+
+void HuffmanFree_fixed(huffman_fixed_t *code)
+{
+    free(code->symbol);
+    free(code->length);
+    free(code->bits);
+    code->symbol = NULL;
+    code->length = NULL;
+    code->bits = NULL;
+    code->size = 0;
+}
+
+/// @brief Start decoding a layer from its first weight
+void HuffmanStreamInit_fixed(const huffman_fixed_t *code, huffman_stream_fixed_t *stream)
+{
+    int l;
+
+    stream->code = code;
+    stream->position = 0;
+    for (l = 0; l < HUFFMAN_STREAMS; l++) {
+        stream->next[l] = code->bits + code->offset[l];
+        stream->end[l] = code->bits + code->offset[l + 1];
+        stream->buffer[l] = 0;
+        stream->count[l] = 0;
+    }
+}
+
+/// @brief Top the bit buffer up to at least 56 bits: 8 bytes at once away from the end of the stream, then
+///        byte by byte, zeros past the end
+static inline void Refill(const unsigned char **next, const unsigned char *end, unsigned long long *buffer,
+                          int *nb_bits)
+{
+    const unsigned char *p = *next;
+
+    if (end - p >= 8) {
+        // Big-endian load; the bits of a partly taken byte are loaded again, at the same place, next time
+        *buffer |= ((unsigned long long)p[0] << 56 | (unsigned long long)p[1] << 48 | (unsigned long long)p[2] << 40
+                    | (unsigned long long)p[3] << 32 | (unsigned long long)p[4] << 24
+                    | (unsigned long long)p[5] << 16 | (unsigned long long)p[6] << 8 | p[7]) >> *nb_bits;
+        *next = p + ((63 - *nb_bits) >> 3);
+        *nb_bits |= 56;
+    } else {
+        while (*nb_bits <= 56) {
+            *buffer |= (unsigned long long)(p < end ? *p++ : 0) << (56 - *nb_bits);
+            *nb_bits += 8;
+        }
+        *next = p;
+    }
+}
+
+/// @brief Decode the next count weights of the stream
+/// A refill leaves at least 56 bits, that is HUFFMAN_PER_REFILL codes, before the next one. The main loop
+/// decodes that many weights from each stream in turn, the streams' lookups being independent.
+void HuffmanStreamRead_fixed(huffman_stream_fixed_t *stream, short *weights, int count)
+{
+    const huffman_entry_fixed_t *table = stream->code->table, *e;
+    const unsigned char *next[HUFFMAN_STREAMS];
+    unsigned long long buffer[HUFFMAN_STREAMS];
+    int i = 0, k, l, nb_bits[HUFFMAN_STREAMS];
+
+    for (l = 0; l < HUFFMAN_STREAMS; l++) {
+        next[l] = stream->next[l];
+        buffer[l] = stream->buffer[l];
+        nb_bits[l] = stream->count[l];
+    }
+
+    // Weight by weight up to the first weight of stream 0, then by rounds over all the streams
+    for (; i < count && (stream->position + i) % HUFFMAN_STREAMS != 0; i++) {
+        l = (stream->position + i) % HUFFMAN_STREAMS;
+        if (nb_bits[l] < HUFFMAN_MAX_BITS)
+            Refill(&next[l], stream->end[l], &buffer[l], &nb_bits[l]);
+        e = &table[buffer[l] >> (64 - HUFFMAN_MAX_BITS)];
+        weights[i] = e->value;
+        buffer[l] <<= e->length;
+        nb_bits[l] -= e->length;
+    }
+    for (; i + HUFFMAN_STREAMS * HUFFMAN_PER_REFILL <= count; i += HUFFMAN_STREAMS * HUFFMAN_PER_REFILL) {
+        for (l = 0; l < HUFFMAN_STREAMS; l++)
+            Refill(&next[l], stream->end[l], &buffer[l], &nb_bits[l]);
+        for (k = 0; k < HUFFMAN_PER_REFILL; k++) {
+            for (l = 0; l < HUFFMAN_STREAMS; l++) {
+                e = &table[buffer[l] >> (64 - HUFFMAN_MAX_BITS)];
+                weights[i + k * HUFFMAN_STREAMS + l] = e->value;
+                buffer[l] <<= e->length;
+                nb_bits[l] -= e->length;
+            }
+        }
+    }
+    for (; i < count; i++) {
+        l = (stream->position + i) % HUFFMAN_STREAMS;
+        if (nb_bits[l] < HUFFMAN_MAX_BITS)
+            Refill(&next[l], stream->end[l], &buffer[l], &nb_bits[l]);
+        e = &table[buffer[l] >> (64 - HUFFMAN_MAX_BITS)];
+        weights[i] = e->value;
+        buffer[l] <<= e->length;
+        nb_bits[l] -= e->length;
+    }
+
+    stream->position += count;
+    for (l = 0; l < HUFFMAN_STREAMS; l++) {
+        stream->next[l] = next[l];
+        stream->buffer[l] = buffer[l];
+        stream->count[l] = nb_bits[l];
+    }
+}
@@ -0,0 +1,179 @@
+/**
+ * @file int8_fixed.c
+ * @brief int8 layers: signed char inputs and weights, int32 sums brought back to Q8
+ *
+ * The weights of an int8 layer are quantized offline on their own
+ * power-of-two scale, w * 2^kernel_bits. Its Q8 input is requantized per
+ * tensor on every call by Int8Quantize_fixed, at the finest power-of-two
+ * scale that holds its largest value: no calibration set is needed. The
+ * products of two signed chars are summed in an int, then the sum is
+ * shifted by input_bits + kernel_bits - FIXED_POINT into Q8 and the Q8 bias
+ * is added, as in the _fixed kernels, which the outputs can feed directly.
+ * The weights take half the bytes of the Q8 shorts, and the MACs operate on
+ * 8-bit lanes.
+ */
+
+#include "lenet_cnn_fixed.h"
+
+#define INT8_MAX_VALUE 127
+
+/// @brief Q8 sum of products at 2^-shift back to Q8, plus bias
+static inline int Rescale(int acc, int shift, short bias)
+{
+    return (shift >= 0 ? acc >> shift : acc * (1 << -shift)) + bias;
+}
+
+/// @brief Requantize a Q8 tensor on signed chars, x * 2^bits rounded, at the largest bits <= FIXED_POINT that
+///        keeps its largest magnitude within 127
+/// @param input  Q8 values
+/// @param size   Number of values
+/// @param output int8 values
+/// @return bits, the fraction bits of output
+int Int8Quantize_fixed(const short *input, int size, signed char *output)
+{
+    int i, bits, shift, max = 0, v;
+
+    for (i = 0; i < size; i++) {
+        v = input[i] < 0 ? -input[i] : input[i];
+        max = v > max ? v : max;
+    }
+    for (bits = FIXED_POINT; bits > 0; bits--) {
+        shift = FIXED_POINT - bits;
+        if (((max + ((1 << shift) >> 1)) >> shift) <= INT8_MAX_VALUE)
+            break;
+    }
+    shift = FIXED_POINT - bits;
+    for (i = 0; i < size; i++) {
+        v = (input[i] + ((1 << shift) >> 1)) >> shift;
+        output[i] = (signed char)(v > INT8_MAX_VALUE ? INT8_MAX_VALUE : v < -INT8_MAX_VALUE ? -INT8_MAX_VALUE : v);
+    }
+    return bits;
+}
+
+/// @brief First convolution layer on int8 operands, one output row of sums at a time
+/// @param input  Input image requantized by Int8Quantize_fixed [IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH]
+/// @param kernel Convolution filters at 2^kernel_bits [CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM]
+/// @param bias   Bias terms (Q8) [CONV1_NBOUTPUT]
+/// @param shift  input_bits + kernel_bits - FIXED_POINT
+/// @param output Output feature maps (Q8) [CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH], ReLU applied
+void Conv1_28x28x1_5x5x20_1_0_int8_fixed(
+    const signed char input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
+    const signed char kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+    short bias[CONV1_NBOUTPUT],
+    int shift,
+    short output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH])
+{
+    int f, c, y, x, ky, kx, w, acc[CONV1_WIDTH];
+
+    for (f = 0; f < CONV1_NBOUTPUT; f++) {
+        for (y = 0; y < CONV1_HEIGHT; y++) {
+            for (x = 0; x < CONV1_WIDTH; x++)
+                acc[x] = 0;
+
+            // Tap-outer order, as in Conv2 below
+            for (c = 0; c < IMG_DEPTH; c++)
+                for (ky = 0; ky < CONV1_DIM; ky++)
+                    for (kx = 0; kx < CONV1_DIM; kx++) {
+                        w = kernel[f][c][ky][kx];
+                        for (x = 0; x < CONV1_WIDTH; x++)
+                            acc[x] += w * input[c][y + ky][x + kx];
+                    }
+
+            for (x = 0; x < CONV1_WIDTH; x++) {
+                int out = Rescale(acc[x], shift, bias[f]);
+
+                output[f][y][x] = (short)(out > 0 ? out : 0);
+            }
+        }
+    }
+}
+
+/// @brief Second convolution layer on int8 operands, one output row of sums at a time
+/// @param input  Pool1 output requantized by Int8Quantize_fixed [POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH]
+/// @param kernel Convolution filters at 2^kernel_bits [CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM]
+/// @param bias   Bias terms (Q8) [CONV2_NBOUTPUT]
+/// @param shift  input_bits + kernel_bits - FIXED_POINT
+/// @param output Output feature maps (Q8) [CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH], ReLU applied
+void Conv2_12x12x20_5x5x40_1_0_int8_fixed(
+    const signed char input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const signed char kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+    short bias[CONV2_NBOUTPUT],
+    int shift,
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH])
+{
+    int f, c, y, x, ky, kx, w, acc[CONV2_WIDTH];
+
+    for (f = 0; f < CONV2_NBOUTPUT; f++) {
+        for (y = 0; y < CONV2_HEIGHT; y++) {
+            for (x = 0; x < CONV2_WIDTH; x++)
+                acc[x] = 0;
+
+            // Tap-outer order: each weight is broadcast over a row of outputs, the inner loop vectorizes
+            for (c = 0; c < POOL1_NBOUTPUT; c++)
+                for (ky = 0; ky < CONV2_DIM; ky++)
+                    for (kx = 0; kx < CONV2_DIM; kx++) {
+                        w = kernel[f][c][ky][kx];
+                        for (x = 0; x < CONV2_WIDTH; x++)
+                            acc[x] += w * input[c][y + ky][x + kx];
+                    }
+
+            for (x = 0; x < CONV2_WIDTH; x++) {
+                int out = Rescale(acc[x], shift, bias[f]);
+
+                output[f][y][x] = (short)(out > 0 ? out : 0);
+            }
+        }
+    }
+}
+
+/// @brief FC1 on int8 operands
+/// @param input  Pool2 output requantized by Int8Quantize_fixed [POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH]
+/// @param kernel Weight matrix at 2^kernel_bits [FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH]
+/// @param bias   Bias values (Q8) [FC1_NBOUTPUT]
+/// @param shift  input_bits + kernel_bits - FIXED_POINT
+/// @param output Layer output (Q8) [FC1_NBOUTPUT], ReLU applied
+void Fc1_40_400_int8_fixed(
+    const signed char input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const signed char kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    short bias[FC1_NBOUTPUT],
+    int shift,
+    short output[FC1_NBOUTPUT])
+{
+    const signed char *in = &input[0][0][0];
+    int n, i, acc;
+
+    for (n = 0; n < FC1_NBOUTPUT; n++) {
+        const signed char *row = &kernel[n][0][0][0];
+
+        acc = 0;
+        for (i = 0; i < POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH; i++)
+            acc += row[i] * in[i];
+
+        acc = Rescale(acc, shift, bias[n]);
+        output[n] = (short)(acc > 0 ? acc : 0);
+    }
+}
+
+/// @brief FC2 on int8 operands, no ReLU: signed logits as Fc2_400_10_linear_fixed
+/// @param input  FC1 output requantized by Int8Quantize_fixed [FC1_NBOUTPUT]
+/// @param kernel Weight matrix at 2^kernel_bits [FC2_NBOUTPUT][FC1_NBOUTPUT]
+/// @param bias   Bias values (Q8) [FC2_NBOUTPUT]
+/// @param shift  input_bits + kernel_bits - FIXED_POINT
+/// @param output Layer output (Q8) [FC2_NBOUTPUT]
+void Fc2_400_10_int8_fixed(
+    const signed char input[FC1_NBOUTPUT],
+    const signed char kernel[FC2_NBOUTPUT][FC1_NBOUTPUT],
+    short bias[FC2_NBOUTPUT],
+    int shift,
+    short output[FC2_NBOUTPUT])
+{
+    int n, i, acc;
+
+    for (n = 0; n < FC2_NBOUTPUT; n++) {
+        acc = 0;
+        for (i = 0; i < FC1_NBOUTPUT; i++)
+            acc += kernel[n][i] * input[i];
+
+        output[n] = (short)Rescale(acc, shift, bias[n]);
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * @file lenet_cnn_apfixed.cpp
+ * @brief MNIST evaluation of the fixed-point pipeline at arbitrary ap_fixed widths
+ *
+ * Formats are chosen at build time (defaults: 10-bit weights, 12-bit activations):
+ *   make lenet_cnn_apfixed APFIXED_FLAGS="-DWEIGHT_W=8 -DACT_W=10 -DACT_I=5"
+ * Weights are quantized from the float HDF5 model, so any number of fractional
+ * bits can be explored, not only the Q8 of weights.h.
+ *
+ * Usage: ./lenet_cnn_apfixed [weights.h5]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ap_fixed_emu.h"
+#include "lenet_cnn_apfixed.h"
+
+#ifndef WEIGHT_W
+#define WEIGHT_W 10
+#endif
+#ifndef WEIGHT_I
+#define WEIGHT_I 1      // |w| < 1 for every layer of the trained model
+#endif
+#ifndef ACT_W
+#define ACT_W 12
+#endif
+#ifndef ACT_I
+#define ACT_I 5         // activations and logits stay below 16 (see make profile in ../FLOAT)
+#endif
+#ifndef ACC_W
+#define ACC_W 32
+#endif
+#ifndef ACC_I
+#define ACC_I 12
+#endif
+
+typedef apemu::ap_fixed<WEIGHT_W, WEIGHT_I, apemu::AP_RND, apemu::AP_SAT> weight_t;
+typedef apemu::ap_fixed<ACT_W, ACT_I, apemu::AP_RND, apemu::AP_SAT>       act_t;
+typedef apemu::ap_fixed<ACC_W, ACC_I, apemu::AP_TRN, apemu::AP_WRAP>      acc_t;
+
+static lenet_float_weights_t                 float_weights;
+static lenet_apfixed_weights<weight_t, act_t> weights;
+
+int main(int argc, char **argv)
+{
+    char *hdf5_filename = (argc > 1) ? argv[1] : (char *)WEIGHTS_FLOAT_DEFAULT_FILE;
+    char *test_labels_filename = (char *)"mnist/t10k-labels-idx1-ubyte";
+    unsigned char ref_img[IMG_DEPTH * IMG_HEIGHT * IMG_WIDTH];
+    act_t input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+    act_t logits[FC2_NBOUTPUT];
+    char img_filename[120];
+    unsigned char label;
+    unsigned int error = 0, m = 0;
+    struct timespec start, end;
+    double tdiff;
+    FILE *label_file;
+
+    printf("Weights: ap_fixed<%d,%d>  Activations: ap_fixed<%d,%d>  Accumulator: ap_fixed<%d,%d>\n",
+           WEIGHT_W, WEIGHT_I, ACT_W, ACT_I, ACC_W, ACC_I);
+
+    ReadFloatWeights(hdf5_filename, &float_weights);
+    QuantizeWeights_ap(&float_weights, &weights);
+
+    label_file = fopen(test_labels_filename, "r");
+    if (!label_file) {
+        printf("Error: Unable to open file %s.\n", test_labels_filename);
+        exit(1);
+    }
+    fseek(label_file, 8, SEEK_SET);     // Skip 8 first header bytes
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (fread(&label, 1, 1, label_file) == 1) {
+        snprintf(img_filename, sizeof(img_filename), "mnist/t10k-images-idx3-ubyte[%05u].pgm", m);
+        ReadPgmFile(img_filename, ref_img);
+        NormalizeImg_ap(ref_img, input);
+
+        lenet_cnn_apfixed<weight_t, act_t, acc_t>(input, &weights, logits);
+
+        if (Argmax_ap(logits) != label)
+            error++;
+        m++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fclose(label_file);
+
+    tdiff = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+    printf("Errors: %u / %u\n", error, m);
+    printf("Success rate: %.2f%%\n", m ? (1 - ((float)error / m)) * 100 : 0.0);
+    printf("Total processing time: %.3f seconds (%.1f images/s)\n", tdiff, m / tdiff);
+    return 0;
+}
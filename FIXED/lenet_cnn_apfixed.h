@@ -0,0 +1,193 @@
+/**
+ * @file lenet_cnn_apfixed.h
+ * @brief LeNet-5 fixed-point pipeline templated on ap_fixed types
+ *
+ * Same layer structure as lenet_cnn_fixed, with the number formats as template
+ * parameters:
+ * - WT  weights
+ * - AT  activations (input, inter-layer buffers, biases and logits)
+ * - ACC MAC accumulator
+ *
+ * With ap_fixed_emu.h this runs on plain g++; with Vivado HLS the same code can
+ * use the real ap_fixed types. FC2 is linear, as in the trained model.
+ */
+
+#ifndef LENET_CNN_APFIXED_H
+#define LENET_CNN_APFIXED_H
+
+extern "C" {
+#include "lenet_cnn_fixed.h"
+#include "weights_float.h"
+}
+
+template <class WT, class AT>
+struct lenet_apfixed_weights {
+    WT conv1_kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+    AT conv1_bias[CONV1_NBOUTPUT];
+    WT conv2_kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+    AT conv2_bias[CONV2_NBOUTPUT];
+    WT fc1_kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+    AT fc1_bias[FC1_NBOUTPUT];
+    WT fc2_kernel[FC2_NBOUTPUT][FC1_NBOUTPUT];
+    AT fc2_bias[FC2_NBOUTPUT];
+};
+
+/// @brief Quantize float weights into WT / AT with their Q and O modes
+template <class T>
+static void QuantizeArray_ap(const float *in, T *out, int size)
+{
+    for (int i = 0; i < size; i++)
+        out[i] = T((double)in[i]);
+}
+
+template <class WT, class AT>
+void QuantizeWeights_ap(const lenet_float_weights_t *in, lenet_apfixed_weights<WT, AT> *out)
+{
+    QuantizeArray_ap((const float *)in->conv1_kernel, (WT *)out->conv1_kernel, sizeof(in->conv1_kernel) / sizeof(float));
+    QuantizeArray_ap(in->conv1_bias, out->conv1_bias, CONV1_NBOUTPUT);
+    QuantizeArray_ap((const float *)in->conv2_kernel, (WT *)out->conv2_kernel, sizeof(in->conv2_kernel) / sizeof(float));
+    QuantizeArray_ap(in->conv2_bias, out->conv2_bias, CONV2_NBOUTPUT);
+    QuantizeArray_ap((const float *)in->fc1_kernel, (WT *)out->fc1_kernel, sizeof(in->fc1_kernel) / sizeof(float));
+    QuantizeArray_ap(in->fc1_bias, out->fc1_bias, FC1_NBOUTPUT);
+    QuantizeArray_ap((const float *)in->fc2_kernel, (WT *)out->fc2_kernel, sizeof(in->fc2_kernel) / sizeof(float));
+    QuantizeArray_ap(in->fc2_bias, out->fc2_bias, FC2_NBOUTPUT);
+}
+
+/// @brief ReLU of an accumulator, converted to the activation format
+template <class AT, class ACC>
+static inline AT Relu_ap(const ACC &acc)
+{
+    return (acc > ACC(0.0)) ? AT(acc) : AT(0.0);
+}
+
+template <class WT, class AT, class ACC>
+void Conv1_28x28x1_5x5x20_1_0_ap(
+    const AT input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
+    const WT kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+    const AT bias[CONV1_NBOUTPUT],
+    AT output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH])
+{
+    for (int f = 0; f < CONV1_NBOUTPUT; f++)
+        for (int y = 0; y < CONV1_HEIGHT; y++)
+            for (int x = 0; x < CONV1_WIDTH; x++) {
+                ACC acc;
+                for (int c = 0; c < IMG_DEPTH; c++)
+                    for (int ky = 0; ky < CONV1_DIM; ky++)
+                        for (int kx = 0; kx < CONV1_DIM; kx++)
+                            acc += kernel[f][c][ky][kx] * input[c][y + ky][x + kx];
+                acc += bias[f];
+                output[f][y][x] = Relu_ap<AT>(acc);
+            }
+}
+
+template <class WT, class AT, class ACC>
+void Conv2_12x12x20_5x5x40_1_0_ap(
+    const AT input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const WT kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+    const AT bias[CONV2_NBOUTPUT],
+    AT output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH])
+{
+    for (int f = 0; f < CONV2_NBOUTPUT; f++)
+        for (int y = 0; y < CONV2_HEIGHT; y++)
+            for (int x = 0; x < CONV2_WIDTH; x++) {
+                ACC acc;
+                for (int c = 0; c < POOL1_NBOUTPUT; c++)
+                    for (int ky = 0; ky < CONV2_DIM; ky++)
+                        for (int kx = 0; kx < CONV2_DIM; kx++)
+                            acc += kernel[f][c][ky][kx] * input[c][y + ky][x + kx];
+                acc += bias[f];
+                output[f][y][x] = Relu_ap<AT>(acc);
+            }
+}
+
+/// @brief 2x2 stride-2 max pooling, shared by Pool1 and Pool2
+template <class AT, int C, int H, int W>
+void Pool_2x2_ap(const AT input[C][H][W], AT output[C][H / 2][W / 2])
+{
+    for (int c = 0; c < C; c++)
+        for (int y = 0; y < H / 2; y++)
+            for (int x = 0; x < W / 2; x++) {
+                AT m = input[c][2 * y][2 * x];
+                if (input[c][2 * y][2 * x + 1] > m)     m = input[c][2 * y][2 * x + 1];
+                if (input[c][2 * y + 1][2 * x] > m)     m = input[c][2 * y + 1][2 * x];
+                if (input[c][2 * y + 1][2 * x + 1] > m) m = input[c][2 * y + 1][2 * x + 1];
+                output[c][y][x] = m;
+            }
+}
+
+template <class WT, class AT, class ACC>
+void Fc1_40_400_ap(
+    const AT input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const WT kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const AT bias[FC1_NBOUTPUT],
+    AT output[FC1_NBOUTPUT])
+{
+    for (int n = 0; n < FC1_NBOUTPUT; n++) {
+        ACC acc;
+        for (int c = 0; c < POOL2_NBOUTPUT; c++)
+            for (int h = 0; h < POOL2_HEIGHT; h++)
+                for (int w = 0; w < POOL2_WIDTH; w++)
+                    acc += kernel[n][c][h][w] * input[c][h][w];
+        acc += bias[n];
+        output[n] = Relu_ap<AT>(acc);
+    }
+}
+
+template <class WT, class AT, class ACC>
+void Fc2_400_10_ap(
+    const AT input[FC1_NBOUTPUT],
+    const WT kernel[FC2_NBOUTPUT][FC1_NBOUTPUT],
+    const AT bias[FC2_NBOUTPUT],
+    AT output[FC2_NBOUTPUT])
+{
+    for (int n = 0; n < FC2_NBOUTPUT; n++) {
+        ACC acc;
+        for (int i = 0; i < FC1_NBOUTPUT; i++)
+            acc += kernel[n][i] * input[i];
+        acc += bias[n];
+        output[n] = AT(acc);
+    }
+}
+
+/// @brief Whole pipeline at the given formats
+template <class WT, class AT, class ACC>
+void lenet_cnn_apfixed(const AT input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
+                       const lenet_apfixed_weights<WT, AT> *w,
+                       AT output[FC2_NBOUTPUT])
+{
+    AT conv1_output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH];
+    AT pool1_output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH];
+    AT conv2_output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH];
+    AT pool2_output[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+    AT fc1_output[FC1_NBOUTPUT];
+
+    Conv1_28x28x1_5x5x20_1_0_ap<WT, AT, ACC>(input, w->conv1_kernel, w->conv1_bias, conv1_output);
+    Pool_2x2_ap<AT, CONV1_NBOUTPUT, CONV1_HEIGHT, CONV1_WIDTH>(conv1_output, pool1_output);
+    Conv2_12x12x20_5x5x40_1_0_ap<WT, AT, ACC>(pool1_output, w->conv2_kernel, w->conv2_bias, conv2_output);
+    Pool_2x2_ap<AT, CONV2_NBOUTPUT, CONV2_HEIGHT, CONV2_WIDTH>(conv2_output, pool2_output);
+    Fc1_40_400_ap<WT, AT, ACC>(pool2_output, w->fc1_kernel, w->fc1_bias, fc1_output);
+    Fc2_400_10_ap<WT, AT, ACC>(fc1_output, w->fc2_kernel, w->fc2_bias, output);
+}
+
+/// @brief Pixels to activations, same 1/255 normalization as the float model
+template <class AT>
+void NormalizeImg_ap(const unsigned char *input, AT output[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH])
+{
+    for (int y = 0; y < IMG_HEIGHT; y++)
+        for (int x = 0; x < IMG_WIDTH; x++)
+            output[0][y][x] = AT((double)input[y * IMG_WIDTH + x] / 255);
+}
+
+/// @brief Index of the largest logit, first one on ties
+template <class AT>
+unsigned char Argmax_ap(const AT logits[FC2_NBOUTPUT])
+{
+    unsigned char best = 0;
+
+    for (unsigned char i = 1; i < FC2_NBOUTPUT; i++)
+        if (logits[i] > logits[best])
+            best = i;
+    return best;
+}
+
+#endif // LENET_CNN_APFIXED_H
@@ -4,6 +4,7 @@
 
 //#include "lenet_cnn_float.h"  // for dimension constants (plus utilise)
 //#include "fixed_point.h"
+#include <stdio.h>
 
 #define IMG_WIDTH	28
 #define IMG_HEIGHT	28
@@ -46,6 +47,123 @@
 #define FLOAT2SHORT(x) ((short) ((x) * (1 << FIXED_POINT)))
 #define SHORT2FLOAT(x) (((float)(x)) / (1 << FIXED_POINT))
 #define RELU_F(x) (x > 0)? x : 0
+#define SOFTMAX_Q15_ONE (1 << 15)     // Softmax_int_fixed output for probability 1.0
+
+// Argmax-only output mode: class and top-2 logit margin in fixed-point
+typedef struct {
+    unsigned char number;
+    short         margin;
+} prediction_fixed_t;
+
+// Bounding box of the nonzero input pixels, bounds included, empty when x1 < x0
+typedef struct {
+    short x0, y0, x1, y1;
+} bbox_fixed_t;
+
+// Sparse activations: nonzero entries of a ReLU / max-pool output, in memory order
+#define NONZERO_MAX_SIZE (POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH)
+
+typedef struct {
+    int   count;
+    short index[NONZERO_MAX_SIZE];      // flat index in the [c][y][x] map
+    short value[NONZERO_MAX_SIZE];
+} nonzero_list_fixed_t;
+
+// The host engine runs the sparse kernel when the input density is below these: dense / sparse crossovers
+// (list build included) measured single thread on random zero masks
+#ifndef CONV2_SPARSE_DENSITY_FIXED
+#define CONV2_SPARSE_DENSITY_FIXED 0.55f
+#endif
+#ifndef FC1_SPARSE_DENSITY_FIXED
+#define FC1_SPARSE_DENSITY_FIXED   0.12f
+#endif
+
+// Pruned weights in compressed sparse rows: row r (one filter or one output neuron) keeps its nonzero
+// weights val[row_ptr[r] .. row_ptr[r + 1] - 1], col[] being their flat index in the dense row
+typedef struct {
+    int             rows, cols, nnz;
+    int            *row_ptr;            // [rows + 1]
+    unsigned short *col;                // [nnz], increasing within a row
+    short          *val;                // [nnz]
+} csr_fixed_t;
+
+// Q8 weights shared on a per-layer codebook of at most CLUSTER_MAX_CENTROIDS values: weight i is
+// centroid[index i], indexes packed on 4 bits (two weights per byte, low nibble first) or 8 bits
+#define CLUSTER_MAX_CENTROIDS 256
+#define FC1_CLUSTER_ROWS      8     // FC1 rows sharing each input load, divides FC1_NBOUTPUT
+#define CLUSTER_INDEX(cb, i) ((cb)->bits == 4 ? ((cb)->index[(i) >> 1] >> (((i) & 1) * 4)) & 15 : (cb)->index[i])
+typedef struct {
+    int            size;                // number of weights
+    int            bits;                // 4 up to 16 centroids, 8 above
+    int            nb_centroids;
+    short          centroid[CLUSTER_MAX_CENTROIDS];
+    unsigned char *index;               // [(size * bits + 7) / 8]
+} codebook_fixed_t;
+
+// Q8 weight as the sum of at most two signed powers of two: a term t is 0 (none) or +-(k + 1) for +-2^k.
+// POW2_TERM(x, t) is x * t's power as a shift, masked to 0 for no term and negated as (v ^ -1) + 1,
+// branch free; x * w = POW2_TERM(x, w.hi) + POW2_TERM(x, w.lo)
+#define POW2_MAX_SHIFT 14
+#define POW2_TERM(x, t) ((((int)((unsigned)(x) << ((((t) < 0 ? -(t) : (t)) - 1) & 15)) & -((t) != 0)) \
+                          ^ -((t) < 0)) + ((t) < 0))
+typedef struct {
+    signed char hi, lo;                 // lo 0 for a single term
+} pow2_fixed_t;
+
+// Binarized Conv2 / FC1 rows (xnor_fixed.c), same bit layout as xnor_t of lenet_cnn_float.h; alpha = mean |w|
+// keeps XNOR_ALPHA_BITS fraction bits more than the Q8 weights
+#define XNOR_CONV2_TAPS_PER_WORD 3
+#define XNOR_CONV2_WORDS ((CONV2_DIM * CONV2_DIM + XNOR_CONV2_TAPS_PER_WORD - 1) / XNOR_CONV2_TAPS_PER_WORD)
+#define XNOR_FC1_WORDS   ((POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH + 63) / 64)
+#define XNOR_ALPHA_BITS  8
+typedef struct {
+    int                 rows, cols, words;  // cols weights per row, packed on words 64-bit words
+    unsigned long long *sign;               // [rows][words], bit set for a positive weight
+    int                *sum;                // [rows] sum of the signs, +1 or -1 per weight
+    int                *alpha;              // [rows] Q(FIXED_POINT + XNOR_ALPHA_BITS)
+} xnor_fixed_t;
+
+// Q8 weights of a layer entropy-coded with a canonical Huffman code (huffman_fixed.c): the symbols in code
+// order, their code lengths (at most HUFFMAN_MAX_BITS) and HUFFMAN_STREAMS bit streams, MSB first, weight i
+// in stream i % HUFFMAN_STREAMS, make up the ROM image. The decode table maps the next HUFFMAN_MAX_BITS bits
+// to a weight and its code length, built in RAM
+#define HUFFMAN_MAX_BITS    11
+#define HUFFMAN_STREAMS     4
+#define HUFFMAN_MAX_SYMBOLS (1 << HUFFMAN_MAX_BITS)
+#define FC1_HUFFMAN_ROWS    8   // FC1 rows sharing each input load, divides FC1_NBOUTPUT
+typedef struct {
+    short         value;
+    unsigned char length;
+} huffman_entry_fixed_t;
+typedef struct {
+    int                   size;         // number of weights
+    int                   nb_symbols;
+    short                *symbol;       // [nb_symbols]
+    unsigned char        *length;       // [nb_symbols], non-decreasing
+    long                  nb_bytes;
+    long                  offset[HUFFMAN_STREAMS + 1];  // stream l is bits[offset[l] .. offset[l + 1] - 1]
+    unsigned char        *bits;         // [nb_bytes]
+    huffman_entry_fixed_t table[1 << HUFFMAN_MAX_BITS];
+} huffman_fixed_t;
+
+// Decoder position in a coded layer: the weights can be read in any number of blocks
+typedef struct {
+    const huffman_fixed_t *code;
+    long                   position;    // weights read so far
+    const unsigned char   *next[HUFFMAN_STREAMS], *end[HUFFMAN_STREAMS];
+    unsigned long long     buffer[HUFFMAN_STREAMS];     // bits read ahead, left aligned
+    int                    count[HUFFMAN_STREAMS];      // number of them
+} huffman_stream_fixed_t;
+
+// Q8 weights compiled from weights.h (lenet_cnn_fixed.c), for the host tools that rework them
+extern short CONV1_KERNEL[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+extern short CONV1_BIAS[CONV1_NBOUTPUT];
+extern short CONV2_KERNEL[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+extern short CONV2_BIAS[CONV2_NBOUTPUT];
+extern short FC1_KERNEL[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+extern short FC1_BIAS[FC1_NBOUTPUT];
+extern short FC2_KERNEL[FC2_NBOUTPUT][FC1_NBOUTPUT];
+extern short FC2_BIAS[FC2_NBOUTPUT];
 
 // Fonctions d'utilite
 void ReadPgmFile(char *filename, unsigned char *pix); 
@@ -58,6 +176,16 @@ void Conv1_28x28x1_5x5x20_1_0_fixed(
     short bias[CONV1_NBOUTPUT],
     short output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH]);
 
+// Conv1 restricted to the outputs whose 5x5 receptive field meets the input bounding box (rows only),
+// relu(bias) elsewhere: identical to the full Conv1
+void InputBoundingBox_fixed(short input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH], bbox_fixed_t *box);
+int  Conv1_28x28x1_5x5x20_1_0_crop_fixed(
+    short input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
+    const bbox_fixed_t *box,
+    short kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+    short bias[CONV1_NBOUTPUT],
+    short output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH]);
+
 void Pool1_24x24x20_2x2x20_2_0_fixed(
     short input[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH],
     short output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH]);
@@ -83,5 +211,177 @@ void Fc2_400_10_fixed(
     short kernel[FC2_NBOUTPUT][FC1_NBOUTPUT],
     short bias[FC2_NBOUTPUT],
     short output[FC2_NBOUTPUT]);
+// Same without the ReLU, signed logits (mixed precision)
+void Fc2_400_10_linear_fixed(
+    short input[FC1_NBOUTPUT],
+    short kernel[FC2_NBOUTPUT][FC1_NBOUTPUT],
+    short bias[FC2_NBOUTPUT],
+    short output[FC2_NBOUTPUT]);
 
 void Softmax_fixed(short input[FC2_NBOUTPUT], float output[FC2_NBOUTPUT]);
+
+// Sparse-input kernels, same results as the dense ones
+int  NonzeroList_fixed(const short *input, int size, nonzero_list_fixed_t *list);
+void Conv2_12x12x20_5x5x40_1_0_sparse_fixed(
+    const nonzero_list_fixed_t *input,
+    short kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+    short bias[CONV2_NBOUTPUT],
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH]);
+void Fc1_40_400_sparse_fixed(
+    const nonzero_list_fixed_t *input,
+    short kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    short bias[FC1_NBOUTPUT],
+    short output[FC1_NBOUTPUT]);
+
+// Magnitude pruning and CSR storage (csr_fixed.c)
+void CsrPrune_fixed(short *weights, int size, float sparsity);
+void CsrFromDense_fixed(const short *dense, int rows, int cols, csr_fixed_t *csr);
+long CsrBytes_fixed(const csr_fixed_t *csr);
+void CsrWrite_fixed(FILE *file, const csr_fixed_t *csr);
+void CsrRead_fixed(FILE *file, csr_fixed_t *csr);
+void CsrFree_fixed(csr_fixed_t *csr);
+
+// Sparse-weight kernels on CSR kernels, same results as the dense ones on the pruned dense weights
+void Conv2_12x12x20_5x5x40_1_0_csr_fixed(
+    short input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const csr_fixed_t *kernel,
+    short bias[CONV2_NBOUTPUT],
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH]);
+void Fc1_40_400_csr_fixed(
+    short input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const csr_fixed_t *kernel,
+    short bias[FC1_NBOUTPUT],
+    short output[FC1_NBOUTPUT]);
+
+// K-means weight clustering (cluster_fixed.c)
+void ClusterFit_fixed(const short *weights, int size, int nb_centroids, codebook_fixed_t *cb);
+void ClusterDecode_fixed(const codebook_fixed_t *cb, short *weights);
+long ClusterBytes_fixed(const codebook_fixed_t *cb);
+void ClusterWrite_fixed(FILE *file, const codebook_fixed_t *cb);
+void ClusterRead_fixed(FILE *file, codebook_fixed_t *cb);
+void ClusterFree_fixed(codebook_fixed_t *cb);
+
+// Clustered-weight kernels, same results as the dense ones on the decoded weights
+void Conv2_12x12x20_5x5x40_1_0_cluster_fixed(
+    short input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const codebook_fixed_t *kernel,
+    short bias[CONV2_NBOUTPUT],
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH]);
+void Fc1_40_400_cluster_fixed(
+    short input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const codebook_fixed_t *kernel,
+    short bias[FC1_NBOUTPUT],
+    short output[FC1_NBOUTPUT]);
+
+// Power-of-two weight quantization (pow2_fixed.c)
+void  Pow2Quantize_fixed(const short *weights, int size, int terms, pow2_fixed_t *pow2);
+int   Pow2Value_fixed(pow2_fixed_t w);
+
+// Multiplier-free kernels on power-of-two weights, same results as the dense ones on Pow2Value_fixed weights
+void Conv1_28x28x1_5x5x20_1_0_pow2_fixed(
+    short input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
+    const pow2_fixed_t kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+    short bias[CONV1_NBOUTPUT],
+    short output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH]);
+void Conv2_12x12x20_5x5x40_1_0_pow2_fixed(
+    short input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const pow2_fixed_t kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+    short bias[CONV2_NBOUTPUT],
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH]);
+void Fc1_40_400_pow2_fixed(
+    short input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const pow2_fixed_t kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    short bias[FC1_NBOUTPUT],
+    short output[FC1_NBOUTPUT]);
+void Fc2_400_10_pow2_fixed(
+    short input[FC1_NBOUTPUT],
+    const pow2_fixed_t kernel[FC2_NBOUTPUT][FC1_NBOUTPUT],
+    short bias[FC2_NBOUTPUT],
+    short output[FC2_NBOUTPUT]);
+
+// Binarized weights (xnor_fixed.c)
+void XnorConv2_fixed(const short kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM], xnor_fixed_t *x);
+void XnorFc1_fixed(const short kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH], xnor_fixed_t *x);
+long XnorBytes_fixed(const xnor_fixed_t *x);
+void XnorFree_fixed(xnor_fixed_t *x);
+
+// 1-bit kernels: input binarized at its mean on two levels, XOR and popcount instead of MACs, Q8 bias
+void Conv2_12x12x20_5x5x40_1_0_xnor_fixed(
+    short input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const xnor_fixed_t *kernel,
+    short bias[CONV2_NBOUTPUT],
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH]);
+void Fc1_40_400_xnor_fixed(
+    short input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const xnor_fixed_t *kernel,
+    short bias[FC1_NBOUTPUT],
+    short output[FC1_NBOUTPUT]);
+
+// Entropy-coded weights (huffman_fixed.c)
+void HuffmanEncode_fixed(const short *weights, int size, huffman_fixed_t *code);
+long HuffmanBytes_fixed(const huffman_fixed_t *code);
+void HuffmanWrite_fixed(FILE *file, const huffman_fixed_t *code);
+void HuffmanRead_fixed(FILE *file, huffman_fixed_t *code);
+void HuffmanFree_fixed(huffman_fixed_t *code);
+void HuffmanStreamInit_fixed(const huffman_fixed_t *code, huffman_stream_fixed_t *stream);
+void HuffmanStreamRead_fixed(huffman_stream_fixed_t *stream, short *weights, int count);
+
+// Kernels on entropy-coded weights, decoding one filter or one block of rows at a time: same results as the
+// dense ones
+void Conv2_12x12x20_5x5x40_1_0_huffman_fixed(
+    short input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const huffman_fixed_t *kernel,
+    short bias[CONV2_NBOUTPUT],
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH]);
+void Fc1_40_400_huffman_fixed(
+    short input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const huffman_fixed_t *kernel,
+    short bias[FC1_NBOUTPUT],
+    short output[FC1_NBOUTPUT]);
+
+// Out-of-core FC1: the row-major weights come in chunks of any size, their products are summed into acc
+// (zeroed by the caller), then finish scales, adds the bias and applies ReLU as Fc1_40_400_fixed
+void Fc1_40_400_chunk_fixed(
+    short input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const short *kernel,
+    int first,
+    int count,
+    int acc[FC1_NBOUTPUT]);
+void Fc1_40_400_finish_fixed(int acc[FC1_NBOUTPUT], short bias[FC1_NBOUTPUT], short output[FC1_NBOUTPUT]);
+
+// int8 layers (int8_fixed.c): a Q8 input is requantized per tensor on signed chars at 2^bits, the weights are
+// signed chars at 2^kernel_bits; the int sums are shifted by bits + kernel_bits - FIXED_POINT back to Q8
+int Int8Quantize_fixed(const short *input, int size, signed char *output);
+void Conv1_28x28x1_5x5x20_1_0_int8_fixed(
+    const signed char input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
+    const signed char kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+    short bias[CONV1_NBOUTPUT],
+    int shift,
+    short output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH]);
+void Conv2_12x12x20_5x5x40_1_0_int8_fixed(
+    const signed char input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const signed char kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+    short bias[CONV2_NBOUTPUT],
+    int shift,
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH]);
+void Fc1_40_400_int8_fixed(
+    const signed char input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const signed char kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    short bias[FC1_NBOUTPUT],
+    int shift,
+    short output[FC1_NBOUTPUT]);
+void Fc2_400_10_int8_fixed(
+    const signed char input[FC1_NBOUTPUT],
+    const signed char kernel[FC2_NBOUTPUT][FC1_NBOUTPUT],
+    short bias[FC2_NBOUTPUT],
+    int shift,
+    short output[FC2_NBOUTPUT]);
+
+// HLS top level, weights from weights.h (lenet_cnn_fixed.c)
+void lenet_cnn_fixed(short input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH], short output[FC2_NBOUTPUT]);
+
+// Integer-only classification (no FPU)
+void Softmax_int_fixed(short input[FC2_NBOUTPUT], unsigned short output[FC2_NBOUTPUT]);
+unsigned char Argmax_fixed(short input[FC2_NBOUTPUT]);
+void TopK_fixed(short input[FC2_NBOUTPUT], unsigned char k, unsigned char index[]);
+void Predict_fixed(short input[FC2_NBOUTPUT], prediction_fixed_t *pred);
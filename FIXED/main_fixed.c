@@ -0,0 +1,192 @@
+/**
+ * @file main_fixed.c
+ * @brief MNIST test driver of the fixed-point LeNet-5 (HLS top lenet_cnn_fixed in lenet_cnn_fixed.c)
+ *
+ * Weights are the Q8 constants of weights.h, compiled into lenet_cnn_fixed.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lenet_cnn_fixed.h"
+#include "profile_fixed.h"
+#include "../COMMON/perf_counters.h"
+#include "../COMMON/latency.h"
+
+// INFO: Fixed version for reading weights.h
+// Fixed version for reading weights.h
+unsigned char REF_IMG[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+short INPUT_NORM_FIXED[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+// int32_t CONV1_KERNEL[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+// int32_t CONV1_BIAS[CONV1_NBOUTPUT];
+// int32_t CONV2_KERNEL[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+// int32_t CONV2_BIAS[CONV2_NBOUTPUT];
+// int32_t FC1_KERNEL[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+// int32_t FC1_BIAS[FC1_NBOUTPUT];
+// int32_t FC2_KERNEL[FC2_NBOUTPUT][FC1_NBOUTPUT];
+// int32_t FC2_BIAS[FC2_NBOUTPUT];
+short FC2_OUTPUT_FIXED[FC2_NBOUTPUT];
+//int32_t SOFTMAX_OUTPUT_FIXED[FC2_NBOUTPUT];
+unsigned short SOFTMAX_OUTPUT_Q15[FC2_NBOUTPUT];
+
+
+
+
+/**
+ * @brief Main function deploying LeNet inference CNN on MNIST dataset using fixed-point arithmetic
+ */
+int main(int argc, char **argv)
+{
+    short x, y, z, k, m;
+
+    char *test_labels_filename = "mnist/t10k-labels-idx1-ubyte";
+    
+    FILE *label_file;
+    int ret;
+    unsigned char label, number = 0;
+    unsigned int error;
+    unsigned char labels_legend[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    char img_filename[120];
+    char img_count[10];
+    unsigned int percent;
+    prediction_fixed_t prediction;
+    int show_probs = 0; // --probs: print the softmax and prediction of every image
+    unsigned long long start, end, t0, t1, t2;
+    latency_hist_t io_hist, inference_hist;    // per image: read + normalize, lenet_cnn_fixed + Predict_fixed
+    double tdiff;
+
+    for (k = 1; k < argc; k++) {
+        if (strcmp(argv[k], "--probs") == 0) {
+            show_probs = 1;
+        } else {
+            printf("Usage: %s [--probs]\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    printf("\nOpening labels file...\n");
+    label_file = fopen(test_labels_filename, "r");
+    if (!label_file)
+    {
+        printf("Error: Unable to open file %s.\n", test_labels_filename);
+        exit(1);
+    }
+
+    for (k = 0; k < 8; k++) // Skip 8 first header bytes
+        ret = fscanf(label_file, "%c", &label);
+
+#ifdef PERF_COUNTERS
+    PerfInit();
+#endif
+
+    printf("\nProcessing MNIST test images with fixed-point arithmetic...\n");
+    printf("========================================\n");
+    
+    m = 0;      // test image counter
+    error = 0;  // number of mispredictions
+    LatencyInit(&io_hist);
+    LatencyInit(&inference_hist);
+
+    // MAIN TEST LOOP
+    start = LatencyNow();
+    while (1)
+    {
+        ret = fscanf(label_file, "%c", &label);
+        if (feof(label_file))
+            break;
+
+        // Build filename
+        strcpy(img_filename, "mnist/t10k-images-idx3-ubyte[");
+        sprintf(img_count, "%d", m);
+        if (m < 10) strcat(img_filename, "0000");
+        else if (m < 100) strcat(img_filename, "000");
+        else if (m < 1000) strcat(img_filename, "00");
+        else if (m < 10000) strcat(img_filename, "0");
+        strcat(img_filename, img_count);
+        strcat(img_filename, "].pgm");
+
+        // Read and normalize image
+        t0 = LatencyNow();
+        ReadPgmFile(img_filename, (unsigned char *)REF_IMG);
+        
+        NormalizeImg((unsigned char *)REF_IMG, (short *)INPUT_NORM_FIXED, IMG_WIDTH, IMG_WIDTH);
+
+        // Run fixed-point inference
+        t1 = LatencyNow();
+        lenet_cnn_fixed(INPUT_NORM_FIXED,
+                        // CONV1_KERNEL_FIXED,
+                        // CONV1_BIAS_FIXED,
+                        // CONV2_KERNEL_FIXED,
+                        // CONV2_BIAS_FIXED,
+                        // FC1_KERNEL_FIXED,
+                        // FC1_BIAS_FIXED,
+                        // FC2_KERNEL_FIXED,
+                        // FC2_BIAS_FIXED,
+                        FC2_OUTPUT_FIXED);
+
+        // Argmax-only by default, integer softmax only when probabilities are requested
+        Predict_fixed(FC2_OUTPUT_FIXED, &prediction);
+        number = prediction.number;
+        t2 = LatencyNow();
+        LatencyRecord(&io_hist, t1 - t0);
+        LatencyRecord(&inference_hist, t2 - t1);
+        
+        if (show_probs) {
+          Softmax_int_fixed(FC2_OUTPUT_FIXED, SOFTMAX_OUTPUT_Q15);
+          printf("\n\nSoftmax output : \n");
+          
+          for (k = 0; k < FC2_NBOUTPUT; k++) {
+            percent = ((unsigned int)SOFTMAX_OUTPUT_Q15[k] * 10000 + SOFTMAX_Q15_ONE / 2) >> 15;
+            printf("%u.%02u%% ", percent / 100, percent % 100);
+          }
+        }
+
+            char pred_str[128];
+            int pred_n = snprintf(pred_str, sizeof(pred_str), "\nPredicted: %d\tActual: %d\tMargin: %d", labels_legend[number], label, prediction.margin);
+            
+            
+            if (labels_legend[number] != label)
+            {
+                strncat(pred_str, " [ERROR]", sizeof(pred_str) - strlen(pred_str) - 1);
+                error = error + 1;
+            }
+            else
+            {
+                strncat(pred_str, " [OK]", sizeof(pred_str) - strlen(pred_str) - 1);
+            }
+            if (show_probs)
+                printf("%s\n", pred_str);
+
+        m++;
+
+    } // END MAIN TEST LOOP
+    
+    end = LatencyNow();
+
+    tdiff = (end - start) / 1e9;
+    
+    printf("\n\n========================================\n");
+    printf("RESULTS\n");
+    printf("========================================\n");
+    printf("Total images processed: %d\n", m);
+    printf("Errors: %d / %d\n", error, m);
+    printf("Success rate: %.2f%%\n", (1 - ((float)error / m)) * 100);
+    printf("Total processing time: %.3f seconds (%.1f images/s end to end)\n", tdiff, m / tdiff);
+    printf("\n");
+    LatencyReportHeader(stdout);
+    LatencyReport(stdout, "inference", &inference_hist);
+    LatencyReport(stdout, "I/O", &io_hist);
+    printf("========================================\n\n");
+
+#ifdef PROFILE
+    ProfileFixedReport(stdout);
+#endif
+#ifdef PERF_COUNTERS
+    PerfReport(stdout);
+#endif
+
+    fclose(label_file);
+
+    return 0;
+}
@@ -74,3 +74,21 @@ void Pool2_8x8x40_2x2x40_2_0_fixed(
 		}
     }
 }
+
+/// @brief Compact list of the nonzero entries of a map, in memory order
+/// @param input  Map of size elements, e.g. pool1_output or pool2_output
+/// @param size   Number of elements, at most NONZERO_MAX_SIZE
+/// @param list   Flat indices and values of the nonzero entries
+/// @return       Number of nonzero entries
+int NonzeroList_fixed(const short *input, int size, nonzero_list_fixed_t *list)
+{
+    int i, count = 0;
+
+    for (i = 0; i < size; i++) {
+        list->index[count] = (short)i;
+        list->value[count] = input[i];
+        count += (input[i] != 0);
+    }
+    list->count = count;
+    return count;
+}
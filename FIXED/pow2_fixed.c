@@ -0,0 +1,69 @@
+/**
+ * @file pow2_fixed.c
+ * @brief Power-of-two quantization of the Q8 weights, for multiplier-free shift-add kernels
+ *
+ * Each weight becomes the nearest value of the form +-2^a (terms = 1) or
+ * +-2^a +- 2^b (terms = 2) that fits a short, zero included. The product by
+ * the input is then one or two shifts and an add, which needs no DSP in the
+ * HLS MAC cores. The shift-add kernels of conv_fixed.c and fc_fixed.c give
+ * the same results as the dense ones on the weights of Pow2Value_fixed.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include "lenet_cnn_fixed.h"
+
+/// @brief Term (0 or +-(k + 1)) of the power of two nearest to value, ties to the smaller power
+static signed char NearestPow2(int value)
+{
+    int m = abs(value), k = 0;
+
+    if (m == 0)
+        return 0;
+    while (k < POW2_MAX_SHIFT && (2 << k) <= m)
+        k++;
+    if (k < POW2_MAX_SHIFT && (2 << k) - m < m - (1 << k))
+        k++;
+    return (signed char)(value > 0 ? k + 1 : -(k + 1));
+}
+
+static int TermValue(signed char t)
+{
+    return t == 0 ? 0 : t > 0 ? 1 << (t - 1) : -(1 << (-t - 1));
+}
+
+/// @brief Value of a quantized weight; two terms reach 2^14 + 2^14, outside a short
+int Pow2Value_fixed(pow2_fixed_t w)
+{
+    return TermValue(w.hi) + TermValue(w.lo);
+}
+
+/// @brief Nearest sum of at most terms signed powers of two of each weight
+/// @param weights  Layer weights (Q8)
+/// @param size     Number of weights
+/// @param terms    1 (+-2^a) or 2 (+-2^a +- 2^b)
+/// @param pow2     Quantized weights [size]
+void Pow2Quantize_fixed(const short *weights, int size, int terms, pow2_fixed_t *pow2)
+{
+    pow2_fixed_t best, w;
+    int i, k, error, best_error;
+
+    for (i = 0; i < size; i++) {
+        best.hi = NearestPow2(weights[i]);
+        best.lo = 0;
+        best_error = abs(weights[i] - Pow2Value_fixed(best));
+
+        // Second term: every first power of the right sign, the residual rounded to a power of two
+        for (k = 0; terms > 1 && best_error > 0 && k <= POW2_MAX_SHIFT; k++) {
+            w.hi = (signed char)(weights[i] > 0 ? k + 1 : -(k + 1));
+            w.lo = NearestPow2(weights[i] - TermValue(w.hi));
+            error = abs(weights[i] - Pow2Value_fixed(w));
+            // Only values that fit the Q8 short, so that the dense kernels can run them as well
+            if (error < best_error && Pow2Value_fixed(w) >= SHRT_MIN && Pow2Value_fixed(w) <= SHRT_MAX) {
+                best = w;
+                best_error = error;
+            }
+        }
+        pow2[i] = best;
+    }
+}
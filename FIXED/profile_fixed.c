@@ -0,0 +1,97 @@
+/**
+ * @file profile_fixed.c
+ * @brief Overflow and saturation counters for the fixed-point kernels
+ *
+ * For each layer:
+ * - accumulator overflows: int accumulations that wrapped (__builtin_add_overflow)
+ * - short wraps: rescaled outputs above SHRT_MAX after ReLU, before the cast
+ * - min/max of the ReLU outputs and the remaining headroom in a short
+ *
+ * Every profiled kernel applies ReLU between the hook and the cast, so a
+ * negative value becomes 0 and never wraps: it is recorded as 0.
+ */
+
+#include <stdio.h>
+#include <limits.h>
+#include "profile_fixed.h"
+
+static const char *profile_layer_names[PROFILE_NB_LAYERS] = {
+    "input", "conv1", "pool1", "conv2", "pool2", "fc1", "fc2"
+};
+
+typedef struct {
+    unsigned long long nb_outputs;
+    unsigned long long nb_acc_overflows;
+    unsigned long long nb_short_wraps;
+    int                min, max;
+} profile_fixed_stats_t;
+
+static profile_fixed_stats_t profile_fixed_stats[PROFILE_NB_LAYERS];
+
+
+/// @brief Count one int accumulator overflow in a layer
+void ProfileFixedOverflow(int layer)
+{
+    profile_fixed_stats[layer].nb_acc_overflows++;
+}
+
+/// @brief Record one rescaled layer output, as cast to short after the kernel's ReLU
+/// @param layer Layer identifier (PROFILE_CONV1 ... PROFILE_FC2)
+/// @param value (acc >> FIXED_POINT) + bias, as computed by the kernel before ReLU
+void ProfileFixedOutput(int layer, int value)
+{
+    profile_fixed_stats_t *s = &profile_fixed_stats[layer];
+
+    value = value > 0 ? value : 0;
+
+    if (s->nb_outputs == 0) {
+        s->min = INT_MAX;
+        s->max = INT_MIN;
+    }
+    if (value < s->min) s->min = value;
+    if (value > s->max) s->max = value;
+    if (value > SHRT_MAX)
+        s->nb_short_wraps++;
+    s->nb_outputs++;
+}
+
+/// @brief Number of magnitude bits of a signed value (sign excluded)
+static int ProfileFixedBits(int value)
+{
+    unsigned int mag = (value < 0) ? -(unsigned int)value : (unsigned int)value;
+    int bits = 0;
+
+    while (mag) {
+        bits++;
+        mag >>= 1;
+    }
+    return bits;
+}
+
+/// @brief Print the per-layer overflow / saturation table
+void ProfileFixedReport(FILE *out)
+{
+    int l;
+
+    fprintf(out, "\n========================================\n");
+    fprintf(out, "FIXED-POINT OVERFLOW PROFILE\n");
+    fprintf(out, "========================================\n");
+    fprintf(out, "%-6s %12s %12s %12s %9s %9s %9s\n",
+            "layer", "outputs", "acc_ovf", "short_wrap", "min", "max", "headroom");
+
+    for (l = 0; l < PROFILE_NB_LAYERS; l++) {
+        const profile_fixed_stats_t *s = &profile_fixed_stats[l];
+        int bits;
+
+        if (s->nb_outputs == 0)
+            continue;
+        bits = ProfileFixedBits(s->max);
+        if (ProfileFixedBits(s->min) > bits)
+            bits = ProfileFixedBits(s->min);
+
+        fprintf(out, "%-6s %12llu %12llu %12llu %9d %9d %8d b\n",
+                profile_layer_names[l], s->nb_outputs, s->nb_acc_overflows, s->nb_short_wraps,
+                s->min, s->max, 15 - bits);
+    }
+    fprintf(out, "\nNegative headroom means the short cast wrapped for some outputs.\n");
+}
@@ -0,0 +1,42 @@
+/**
+ * @file profile_fixed.h
+ * @brief Overflow and saturation counters for the fixed-point kernels
+ *
+ * Built only when PROFILE is defined (make profile). The *_fixed kernels
+ * accumulate into an unchecked int and cast the rescaled result to short,
+ * which silently wraps. With PROFILE, every accumulation is checked for int
+ * overflow and every layer output, after ReLU, is checked against the short
+ * range.
+ * Without PROFILE the hooks expand to the original plain code.
+ */
+
+#ifndef PROFILE_FIXED_H
+#define PROFILE_FIXED_H
+
+#include <stdio.h>
+
+enum {
+    PROFILE_INPUT,
+    PROFILE_CONV1,
+    PROFILE_POOL1,
+    PROFILE_CONV2,
+    PROFILE_POOL2,
+    PROFILE_FC1,
+    PROFILE_FC2,
+    PROFILE_NB_LAYERS
+};
+
+void ProfileFixedOverflow(int layer);
+void ProfileFixedOutput(int layer, int value);
+void ProfileFixedReport(FILE *out);
+
+#ifdef PROFILE
+#define ACC_ADD(layer, acc, term) \
+    do { if (__builtin_add_overflow(acc, term, &(acc))) ProfileFixedOverflow(layer); } while (0)
+#define PROFILE_FIXED_OUT(layer, value) ProfileFixedOutput(layer, value)
+#else
+#define ACC_ADD(layer, acc, term) ((acc) += (term))
+#define PROFILE_FIXED_OUT(layer, value)
+#endif
+
+#endif // PROFILE_FIXED_H
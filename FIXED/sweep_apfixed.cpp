@@ -0,0 +1,275 @@
+/**
+ * @file sweep_apfixed.cpp
+ * @brief Precision sweep: accuracy vs throughput for every Q format of the fixed pipeline
+ *
+ * Instantiates lenet_cnn_apfixed for every combination of
+ * - FIXED_POINT (fractional bits of the weights) from 4 to 14
+ * - weight width WB in {6, 8, 10, 12, 16}, with FIXED_POINT <= WB
+ * - activation width AB in {8, 10, 12, 16}, with ACT_I integer bits
+ * and runs the MNIST test set on each (images are read once and shared).
+ * Weights are quantized from the float HDF5 model, so no weights.h has to be
+ * regenerated. Configurations run in parallel; images/s is measured on the
+ * thread CPU clock so it does not depend on the number of threads.
+ *
+ * Reports errors, images/s and weight storage per configuration, and flags
+ * the Pareto frontiers of (errors, images/s) and (errors, weight bits).
+ *
+ * Usage: ./sweep_apfixed [-j threads] [-n max_images] [-o sweep.csv] [-w weights.h5]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <utility>
+#include <vector>
+
+#include "ap_fixed_emu.h"
+#include "lenet_cnn_apfixed.h"
+
+#ifndef ACT_I
+#define ACT_I 5
+#endif
+#define SWEEP_FP_MIN 4
+#define SWEEP_FP_MAX 14
+
+using namespace apemu;
+
+typedef struct {
+    int          fixed_point, weight_w, act_w;
+    unsigned int errors;
+    double       images_per_s;
+    int          pareto_speed, pareto_bits;
+} sweep_result_t;
+
+typedef void (*sweep_fn_t)(sweep_result_t *);
+
+typedef struct {
+    int        fixed_point, weight_w, act_w;
+    sweep_fn_t run;
+} sweep_config_t;
+
+// Test set, read once
+static std::vector<unsigned char> sweep_images;    // [m][IMG_HEIGHT * IMG_WIDTH]
+static std::vector<unsigned char> sweep_labels;
+static lenet_float_weights_t      sweep_float_weights;
+
+static double ThreadSeconds(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/// @brief Quantize the weights and run the whole test set at one format
+template <int FP, int WB, int AB>
+static void RunConfig(sweep_result_t *r)
+{
+    typedef ap_fixed<WB, WB - FP, AP_RND, AP_SAT> weight_t;
+    typedef ap_fixed<AB, ACT_I, AP_RND, AP_SAT>   act_t;
+    typedef ap_fixed<48, 16, AP_TRN, AP_WRAP>     acc_t;    // exact for every product of the sweep
+
+    lenet_apfixed_weights<weight_t, act_t> *w = new lenet_apfixed_weights<weight_t, act_t>;
+    act_t input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+    act_t logits[FC2_NBOUTPUT];
+    size_t m, nb_images = sweep_labels.size();
+    double start;
+
+    QuantizeWeights_ap(&sweep_float_weights, w);
+
+    r->errors = 0;
+    start = ThreadSeconds();
+    for (m = 0; m < nb_images; m++) {
+        NormalizeImg_ap(&sweep_images[m * IMG_HEIGHT * IMG_WIDTH], input);
+        lenet_cnn_apfixed<weight_t, act_t, acc_t>(input, w, logits);
+        if (Argmax_ap(logits) != sweep_labels[m])
+            r->errors++;
+    }
+    r->images_per_s = nb_images / (ThreadSeconds() - start);
+
+    delete w;
+}
+
+template <int FP, int WB, int AB>
+static void AddConfig(std::vector<sweep_config_t> &configs)
+{
+    if constexpr (FP <= WB)
+        configs.push_back({ FP, WB, AB, RunConfig<FP, WB, AB> });
+}
+
+template <int WB, int AB, int... FPs>
+static void AddFixedPoints(std::vector<sweep_config_t> &configs, std::integer_sequence<int, FPs...>)
+{
+    (AddConfig<SWEEP_FP_MIN + FPs, WB, AB>(configs), ...);
+}
+
+template <int WB, int... ABs>
+static void AddActWidths(std::vector<sweep_config_t> &configs)
+{
+    (AddFixedPoints<WB, ABs>(configs, std::make_integer_sequence<int, SWEEP_FP_MAX - SWEEP_FP_MIN + 1>()), ...);
+}
+
+static void BuildConfigs(std::vector<sweep_config_t> &configs)
+{
+    AddActWidths<6,  8, 10, 12, 16>(configs);
+    AddActWidths<8,  8, 10, 12, 16>(configs);
+    AddActWidths<10, 8, 10, 12, 16>(configs);
+    AddActWidths<12, 8, 10, 12, 16>(configs);
+    AddActWidths<16, 8, 10, 12, 16>(configs);
+}
+
+// Work queue shared by the worker threads
+static std::vector<sweep_config_t> sweep_configs;
+static std::vector<sweep_result_t> sweep_results;
+static size_t                      sweep_next = 0;
+static pthread_mutex_t             sweep_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *SweepWorker(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        size_t i;
+
+        pthread_mutex_lock(&sweep_lock);
+        i = sweep_next++;
+        pthread_mutex_unlock(&sweep_lock);
+        if (i >= sweep_configs.size())
+            return NULL;
+
+        sweep_configs[i].run(&sweep_results[i]);
+
+        pthread_mutex_lock(&sweep_lock);
+        printf("  FP=%2d W=%2d A=%2d  errors %5u  %8.1f img/s\n", sweep_results[i].fixed_point,
+               sweep_results[i].weight_w, sweep_results[i].act_w, sweep_results[i].errors,
+               sweep_results[i].images_per_s);
+        fflush(stdout);
+        pthread_mutex_unlock(&sweep_lock);
+    }
+}
+
+static void ReadTestSet(size_t max_images)
+{
+    const char *test_labels_filename = "mnist/t10k-labels-idx1-ubyte";
+    char img_filename[120];
+    unsigned char label;
+    FILE *label_file;
+
+    label_file = fopen(test_labels_filename, "r");
+    if (!label_file) {
+        printf("Error: Unable to open file %s.\n", test_labels_filename);
+        exit(1);
+    }
+    fseek(label_file, 8, SEEK_SET);     // Skip 8 first header bytes
+    while (sweep_labels.size() < max_images && fread(&label, 1, 1, label_file) == 1) {
+        size_t m = sweep_labels.size();
+
+        sweep_labels.push_back(label);
+        sweep_images.resize((m + 1) * IMG_HEIGHT * IMG_WIDTH);
+        snprintf(img_filename, sizeof(img_filename), "mnist/t10k-images-idx3-ubyte[%05zu].pgm", m);
+        ReadPgmFile(img_filename, &sweep_images[m * IMG_HEIGHT * IMG_WIDTH]);
+    }
+    fclose(label_file);
+}
+
+/// @brief A point is on the frontier if no other point is at least as good on both axes and better on one
+static void MarkPareto(void)
+{
+    size_t i, j;
+
+    for (i = 0; i < sweep_results.size(); i++) {
+        sweep_result_t *a = &sweep_results[i];
+        int bits_a = a->weight_w;
+
+        a->pareto_speed = a->pareto_bits = 1;
+        for (j = 0; j < sweep_results.size(); j++) {
+            const sweep_result_t *b = &sweep_results[j];
+
+            if (b->errors <= a->errors && b->images_per_s >= a->images_per_s &&
+                (b->errors < a->errors || b->images_per_s > a->images_per_s))
+                a->pareto_speed = 0;
+            if (b->errors <= a->errors && b->weight_w <= bits_a &&
+                (b->errors < a->errors || b->weight_w < bits_a))
+                a->pareto_bits = 0;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    char *hdf5_filename = (char *)WEIGHTS_FLOAT_DEFAULT_FILE;
+    const char *csv_filename = "sweep.csv";
+    size_t max_images = (size_t)-1, i;
+    int nb_threads = 1, k;
+    std::vector<pthread_t> threads;
+    long long weight_count = sizeof(lenet_float_weights_t) / sizeof(float);
+    FILE *csv;
+
+    for (k = 1; k < argc; k++) {
+        if (strcmp(argv[k], "-j") == 0 && k + 1 < argc)
+            nb_threads = atoi(argv[++k]);
+        else if (strcmp(argv[k], "-n") == 0 && k + 1 < argc)
+            max_images = strtoul(argv[++k], NULL, 10);
+        else if (strcmp(argv[k], "-o") == 0 && k + 1 < argc)
+            csv_filename = argv[++k];
+        else if (strcmp(argv[k], "-w") == 0 && k + 1 < argc)
+            hdf5_filename = argv[++k];
+        else {
+            printf("Usage: %s [-j threads] [-n max_images] [-o sweep.csv] [-w weights.h5]\n", argv[0]);
+            exit(1);
+        }
+    }
+    if (nb_threads < 1)
+        nb_threads = 1;
+
+    ReadFloatWeights(hdf5_filename, &sweep_float_weights);
+    ReadTestSet(max_images);
+    BuildConfigs(sweep_configs);
+
+    sweep_results.resize(sweep_configs.size());
+    for (i = 0; i < sweep_configs.size(); i++) {
+        sweep_results[i].fixed_point = sweep_configs[i].fixed_point;
+        sweep_results[i].weight_w = sweep_configs[i].weight_w;
+        sweep_results[i].act_w = sweep_configs[i].act_w;
+    }
+
+    printf("Sweeping %zu formats on %zu images with %d thread(s), activations ap_fixed<A,%d>\n",
+           sweep_configs.size(), sweep_labels.size(), nb_threads, ACT_I);
+    threads.resize(nb_threads);
+    for (k = 0; k < nb_threads; k++)
+        pthread_create(&threads[k], NULL, SweepWorker, NULL);
+    for (k = 0; k < nb_threads; k++)
+        pthread_join(threads[k], NULL);
+
+    MarkPareto();
+
+    printf("\n%4s %4s %4s %8s %9s %11s %10s  %s\n",
+           "FP", "W", "A", "errors", "error%", "img/s", "weight KB", "pareto");
+    for (i = 0; i < sweep_results.size(); i++) {
+        const sweep_result_t *r = &sweep_results[i];
+
+        printf("%4d %4d %4d %8u %8.2f%% %11.1f %10.1f  %s%s\n",
+               r->fixed_point, r->weight_w, r->act_w, r->errors,
+               100.0 * r->errors / sweep_labels.size(), r->images_per_s,
+               weight_count * r->weight_w / 8192.0,
+               r->pareto_speed ? "speed " : "", r->pareto_bits ? "bits" : "");
+    }
+
+    csv = fopen(csv_filename, "w");
+    if (!csv) {
+        printf("Error: Unable to open file %s.\n", csv_filename);
+        exit(1);
+    }
+    fprintf(csv, "fixed_point,weight_w,act_w,errors,images,images_per_s,weight_bytes,pareto_speed,pareto_bits\n");
+    for (i = 0; i < sweep_results.size(); i++) {
+        const sweep_result_t *r = &sweep_results[i];
+
+        fprintf(csv, "%d,%d,%d,%u,%zu,%.1f,%lld,%d,%d\n", r->fixed_point, r->weight_w, r->act_w,
+                r->errors, sweep_labels.size(), r->images_per_s, weight_count * r->weight_w / 8,
+                r->pareto_speed, r->pareto_bits);
+    }
+    fclose(csv);
+    printf("\nResults written to %s\n", csv_filename);
+    return 0;
+}
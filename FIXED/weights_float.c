@@ -0,0 +1,25 @@
+/**
+ * @file weights_float.c
+ * @brief Float LeNet-5 weights read from the Keras HDF5 model (../FLOAT)
+ *
+ * Thin wrapper over the HDF5 readers of ../FLOAT/utils.c, with the dataset
+ * names of the FLOAT driver.
+ */
+
+#include "../FLOAT/lenet_cnn_float.h"
+#include "weights_float.h"
+
+/// @brief Read all kernels and biases of the trained model
+/// @param hdf5_filename Keras weights file, e.g. WEIGHTS_FLOAT_DEFAULT_FILE
+/// @param weights       Destination, in the [out][in][y][x] layout of the kernels
+void ReadFloatWeights(char *hdf5_filename, lenet_float_weights_t *weights)
+{
+    ReadConv1Weights(hdf5_filename, "/layers/conv2d/vars/0", weights->conv1_kernel);
+    ReadConv1Bias(hdf5_filename, "/layers/conv2d/vars/1", weights->conv1_bias);
+    ReadConv2Weights(hdf5_filename, "/layers/conv2d_1/vars/0", weights->conv2_kernel);
+    ReadConv2Bias(hdf5_filename, "/layers/conv2d_1/vars/1", weights->conv2_bias);
+    ReadFc1Weights(hdf5_filename, "/layers/dense/vars/0", weights->fc1_kernel);
+    ReadFc1Bias(hdf5_filename, "/layers/dense/vars/1", weights->fc1_bias);
+    ReadFc2Weights(hdf5_filename, "/layers/dense_1/vars/0", weights->fc2_kernel);
+    ReadFc2Bias(hdf5_filename, "/layers/dense_1/vars/1", weights->fc2_bias);
+}
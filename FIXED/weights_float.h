@@ -0,0 +1,28 @@
+/**
+ * @file weights_float.h
+ * @brief Float LeNet-5 weights read from the Keras HDF5 model (../FLOAT)
+ *
+ * Used by host-side tools that quantize the trained weights themselves instead
+ * of relying on the Q8 shorts of weights.h. Include lenet_cnn_fixed.h or
+ * lenet_cnn_float.h first for the dimension constants.
+ */
+
+#ifndef WEIGHTS_FLOAT_H
+#define WEIGHTS_FLOAT_H
+
+#define WEIGHTS_FLOAT_DEFAULT_FILE "../FLOAT/lenet_weights.weights.h5"
+
+typedef struct {
+    float conv1_kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+    float conv1_bias[CONV1_NBOUTPUT];
+    float conv2_kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+    float conv2_bias[CONV2_NBOUTPUT];
+    float fc1_kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+    float fc1_bias[FC1_NBOUTPUT];
+    float fc2_kernel[FC2_NBOUTPUT][FC1_NBOUTPUT];
+    float fc2_bias[FC2_NBOUTPUT];
+} lenet_float_weights_t;
+
+void ReadFloatWeights(char *hdf5_filename, lenet_float_weights_t *weights);
+
+#endif // WEIGHTS_FLOAT_H
@@ -0,0 +1,200 @@
+/**
+ * @file xnor_fixed.c
+ * @brief Binarized Conv2 and FC1 on the Q8 weights: XOR and popcount instead of MACs
+ *
+ * Same scheme as ../FLOAT/xnor.c: w ~ alpha s and x ~ c + h a with s, a = +-1,
+ * so w . x ~ alpha (c S + h (n - 2 popcount(s ^ a))). The input is cut at its
+ * integer mean, lo and hi are the integer means of the two sides, and
+ * 2c = lo + hi, 2h = hi - lo stay exact in Q8. alpha = mean |w| keeps
+ * XNOR_ALPHA_BITS more fraction bits than the weights: the FC1 weights are a
+ * few Q8 steps, and an integer mean would be off by up to 10%.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "../COMMON/alloc.h"
+#include "lenet_cnn_fixed.h"
+#include "profile_fixed.h"
+
+#define CONV2_TAP_BITS POOL1_NBOUTPUT
+#define CONV2_COLS     (POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM)
+#define FC1_COLS       (POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+
+static void XnorAllocate_fixed(int rows, int cols, int words, xnor_fixed_t *x)
+{
+    x->rows = rows;
+    x->cols = cols;
+    x->words = words;
+    x->sign = AllocateZeroed((size_t)rows * words * sizeof(unsigned long long));
+    x->sum = AllocateZeroed(rows * sizeof(int));
+    x->alpha = AllocateZeroed(rows * sizeof(int));
+}
+
+/// @brief Scale (rounded) and sign sum of row r, its sign bits being already set
+static void XnorRow_fixed(const short *w, int r, xnor_fixed_t *x)
+{
+    long sum = 0;
+    int i, positives = 0;
+
+    for (i = 0; i < x->cols; i++) {
+        sum += abs(w[i]);
+        positives += w[i] > 0;
+    }
+    x->alpha[r] = (int)(((sum << XNOR_ALPHA_BITS) + x->cols / 2) / x->cols);
+    x->sum[r] = 2 * positives - x->cols;
+}
+
+/// @brief Binarize the Conv2 filters, tap-major bit order (see ../FLOAT/xnor.c)
+void XnorConv2_fixed(const short kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM], xnor_fixed_t *x)
+{
+    int f, c, t, bit;
+
+    XnorAllocate_fixed(CONV2_NBOUTPUT, CONV2_COLS, XNOR_CONV2_WORDS, x);
+    for (f = 0; f < CONV2_NBOUTPUT; f++) {
+        for (c = 0; c < POOL1_NBOUTPUT; c++)
+            for (t = 0; t < CONV2_DIM * CONV2_DIM; t++)
+                if (kernel[f][c][t / CONV2_DIM][t % CONV2_DIM] > 0) {
+                    bit = (t % XNOR_CONV2_TAPS_PER_WORD) * CONV2_TAP_BITS + c;
+                    x->sign[f * x->words + t / XNOR_CONV2_TAPS_PER_WORD] |= 1ULL << bit;
+                }
+        XnorRow_fixed(&kernel[f][0][0][0], f, x);
+    }
+}
+
+/// @brief Binarize the FC1 rows, input order
+void XnorFc1_fixed(const short kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH], xnor_fixed_t *x)
+{
+    const short *w;
+    int n, i;
+
+    XnorAllocate_fixed(FC1_NBOUTPUT, FC1_COLS, XNOR_FC1_WORDS, x);
+    for (n = 0; n < FC1_NBOUTPUT; n++) {
+        w = &kernel[n][0][0][0];
+        for (i = 0; i < FC1_COLS; i++)
+            if (w[i] > 0)
+                x->sign[n * x->words + i / 64] |= 1ULL << (i % 64);
+        XnorRow_fixed(w, n, x);
+    }
+}
+
+long XnorBytes_fixed(const xnor_fixed_t *x)
+{
+    return (long)x->rows * (x->words * sizeof(unsigned long long) + 2 * sizeof(int));
+}
+
+void XnorFree_fixed(xnor_fixed_t *x)
+{
+    free(x->sign);
+    free(x->sum);
+    free(x->alpha);
+    x->sign = NULL;
+    x->sum = NULL;
+    x->alpha = NULL;
+    x->rows = 0;
+}
+
+/// @brief Threshold t = mean of the input, and twice the center (lo + hi) and half gap (hi - lo) of its levels
+static int InputLevels_fixed(const short *input, int size, int *center2, int *half2)
+{
+    int i, t, above = 0, lo = 0, hi = 0, sum = 0;
+
+    for (i = 0; i < size; i++)
+        sum += input[i];
+    t = sum / size;
+    for (i = 0; i < size; i++) {
+        if (input[i] > t) {
+            hi += input[i];
+            above++;
+        } else {
+            lo += input[i];
+        }
+    }
+    lo = above < size ? lo / (size - above) : 0;
+    hi = above ? hi / above : lo;
+    *center2 = lo + hi;
+    *half2 = hi - lo;
+    return t;
+}
+
+/// @brief Conv2 on 1-bit weights and activations: one XOR and popcount per 64 MACs
+/// @param input  Input feature maps, binarized at their mean
+/// @param kernel Binarized filters (XnorConv2_fixed)
+/// @param bias   Bias terms, kept in Q8
+/// @param output Output feature maps, ReLU applied
+void Conv2_12x12x20_5x5x40_1_0_xnor_fixed(
+    short input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const xnor_fixed_t *kernel,
+    short bias[CONV2_NBOUTPUT],
+    short output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH])
+{
+    unsigned int pixel[POOL1_HEIGHT][POOL1_WIDTH];      // channel mask of each input pixel
+    unsigned long long patch[XNOR_CONV2_WORDS];
+    const unsigned long long *sign;
+    int t, center2, half2, dot2, acc;
+    int f, c, y, x, ky, kx, k, w, differ;
+
+    t = InputLevels_fixed(&input[0][0][0], POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH, &center2, &half2);
+    memset(pixel, 0, sizeof(pixel));
+    for (c = 0; c < POOL1_NBOUTPUT; c++)
+        for (y = 0; y < POOL1_HEIGHT; y++)
+            for (x = 0; x < POOL1_WIDTH; x++)
+                pixel[y][x] |= (unsigned int)(input[c][y][x] > t) << c;
+
+    for (y = 0; y < CONV2_HEIGHT; y++) {
+        for (x = 0; x < CONV2_WIDTH; x++) {
+            memset(patch, 0, sizeof(patch));
+            for (ky = 0; ky < CONV2_DIM; ky++)
+                for (kx = 0; kx < CONV2_DIM; kx++) {
+                    k = ky * CONV2_DIM + kx;
+                    patch[k / XNOR_CONV2_TAPS_PER_WORD] |= (unsigned long long)pixel[y + ky][x + kx]
+                                                           << (k % XNOR_CONV2_TAPS_PER_WORD * CONV2_TAP_BITS);
+                }
+
+            for (f = 0; f < CONV2_NBOUTPUT; f++) {
+                sign = kernel->sign + f * XNOR_CONV2_WORDS;
+                differ = 0;
+                for (w = 0; w < XNOR_CONV2_WORDS; w++)
+                    differ += __builtin_popcountll(patch[w] ^ sign[w]);
+                dot2 = center2 * kernel->sum[f] + half2 * (CONV2_COLS - 2 * differ);
+
+                // Q8 x Q(8 + XNOR_ALPHA_BITS), halved, back to Q8, then the bias
+                acc = (int)(((long long)kernel->alpha[f] * dot2) >> (FIXED_POINT + XNOR_ALPHA_BITS + 1)) + bias[f];
+                PROFILE_FIXED_OUT(PROFILE_CONV2, acc);
+                output[f][y][x] = (short)(acc > 0 ? acc : 0);
+            }
+        }
+    }
+}
+
+/// @brief FC1 on 1-bit weights and activations: 10 XORs and popcounts per neuron instead of 640 MACs
+/// @param input  Layer input from Pool2, binarized at its mean
+/// @param kernel Binarized rows (XnorFc1_fixed)
+/// @param bias   Bias terms, kept in Q8
+/// @param output Layer output, ReLU applied
+void Fc1_40_400_xnor_fixed(
+    short input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+    const xnor_fixed_t *kernel,
+    short bias[FC1_NBOUTPUT],
+    short output[FC1_NBOUTPUT])
+{
+    const short *in = &input[0][0][0];
+    unsigned long long bits[XNOR_FC1_WORDS] = { 0 };
+    const unsigned long long *sign;
+    int t, center2, half2, dot2, acc;
+    int n, i, w, differ;
+
+    t = InputLevels_fixed(in, FC1_COLS, &center2, &half2);
+    for (i = 0; i < FC1_COLS; i++)
+        bits[i / 64] |= (unsigned long long)(in[i] > t) << (i % 64);
+
+    for (n = 0; n < FC1_NBOUTPUT; n++) {
+        sign = kernel->sign + n * XNOR_FC1_WORDS;
+        differ = 0;
+        for (w = 0; w < XNOR_FC1_WORDS; w++)
+            differ += __builtin_popcountll(bits[w] ^ sign[w]);
+        dot2 = center2 * kernel->sum[n] + half2 * (FC1_COLS - 2 * differ);
+        acc = (int)(((long long)kernel->alpha[n] * dot2) >> (FIXED_POINT + XNOR_ALPHA_BITS + 1)) + bias[n];
+        PROFILE_FIXED_OUT(PROFILE_FC1, acc);
+        output[n] = (short)(acc > 0 ? acc : 0);
+    }
+}
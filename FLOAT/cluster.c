@@ -0,0 +1,177 @@
+/**
+ * @file cluster.c
+ * @brief Weight sharing: k-means clustering of a layer's float weights on a small codebook
+ *
+ * ClusterFit runs a 1-D k-means (Lloyd) on the weights of one layer, centroids
+ * initialized evenly between the smallest and the largest weight, and keeps
+ * for each weight the index of its nearest centroid: 4 bits for up to 16
+ * centroids (two weights per byte, the first in the low nibble), 8 bits for
+ * up to 256. The weights are sorted once, so every cluster is a run of the
+ * sorted weights and an iteration costs O(k log n). On disk a codebook is the
+ * 4 bytes "CBK" + the centroid size, then size, bits, centroids (int32), the
+ * centroids and the packed indexes, native byte order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../COMMON/alloc.h"
+#include "lenet_cnn_float.h"
+
+#define CLUSTER_MAX_ITERATIONS 100
+
+static int CompareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/// @brief Index of the centroid nearest to value, centroids sorted
+static int Nearest(const float *centroid, int k, float value)
+{
+    int lo = 0, hi = k - 1, mid;
+
+    // Last centroid whose lower decision boundary is at or below value
+    while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        if (value >= 0.5f * (centroid[mid - 1] + centroid[mid]))
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    return lo;
+}
+
+/// @brief Cluster the weights of a layer on nb_centroids shared values
+/// @param weights       Layer weights
+/// @param size          Number of weights
+/// @param nb_centroids  Codebook size, 2 to CLUSTER_MAX_CENTROIDS (4-bit indexes up to 16)
+/// @param cb            Codebook and packed indexes, allocated here (ClusterFree)
+void ClusterFit(const float *weights, int size, int nb_centroids, codebook_t *cb)
+{
+    double *sorted = Allocate(size * sizeof(double)), *prefix = Allocate((size + 1) * sizeof(double));
+    double c[CLUSTER_MAX_CENTROIDS], mean, boundary;
+    int i, j, lo, hi, a, b, changed, iteration, k = nb_centroids;
+
+    if (k < 2)
+        k = 2;
+    if (k > CLUSTER_MAX_CENTROIDS)
+        k = CLUSTER_MAX_CENTROIDS;
+
+    for (i = 0; i < size; i++)
+        sorted[i] = weights[i];
+    qsort(sorted, size, sizeof(double), CompareDouble);
+    prefix[0] = 0.0;
+    for (i = 0; i < size; i++)
+        prefix[i + 1] = prefix[i] + sorted[i];
+
+    // Linear initialization keeps centroids on the few large weights, which matter most
+    for (j = 0; j < k; j++)
+        c[j] = size ? sorted[0] + (sorted[size - 1] - sorted[0]) * j / (k - 1) : 0.0;
+
+    for (iteration = 0; iteration < CLUSTER_MAX_ITERATIONS; iteration++) {
+        changed = 0;
+        lo = 0;
+        for (j = 0; j < k; j++) {
+            // Cluster j is the run of sorted weights below the midpoint with centroid j + 1
+            hi = size;
+            if (j < k - 1) {
+                boundary = 0.5 * (c[j] + c[j + 1]);
+                a = lo;
+                b = size;
+                while (a < b) {
+                    hi = (a + b) / 2;
+                    if (sorted[hi] < boundary)
+                        a = hi + 1;
+                    else
+                        b = hi;
+                }
+                hi = a;
+            }
+            if (hi > lo) {              // an empty cluster keeps its centroid
+                mean = (prefix[hi] - prefix[lo]) / (hi - lo);
+                changed |= (mean != c[j]);
+                c[j] = mean;
+            }
+            lo = hi;
+        }
+        if (!changed)
+            break;
+    }
+    free(sorted);
+    free(prefix);
+
+    cb->size = size;
+    cb->bits = k <= 16 ? 4 : 8;
+    cb->nb_centroids = k;
+    memset(cb->centroid, 0, sizeof(cb->centroid));
+    for (j = 0; j < k; j++)
+        cb->centroid[j] = (float)c[j];
+    cb->index = Allocate((size * cb->bits + 7) / 8);
+    memset(cb->index, 0, (size * cb->bits + 7) / 8);
+    for (i = 0; i < size; i++) {
+        j = Nearest(cb->centroid, k, weights[i]);
+        if (cb->bits == 4)
+            cb->index[i >> 1] |= (unsigned char)(j << ((i & 1) * 4));
+        else
+            cb->index[i] = (unsigned char)j;
+    }
+}
+
+/// @brief Dense weights of a codebook: weights[i] = centroid[index i]
+void ClusterDecode(const codebook_t *cb, float *weights)
+{
+    int i;
+
+    for (i = 0; i < cb->size; i++)
+        weights[i] = cb->centroid[CLUSTER_INDEX(cb, i)];
+}
+
+/// @brief Storage of the centroids and packed indexes in bytes
+long ClusterBytes(const codebook_t *cb)
+{
+    return cb->nb_centroids * (long)sizeof(float) + ((long)cb->size * cb->bits + 7) / 8;
+}
+
+void ClusterWrite(FILE *file, const codebook_t *cb)
+{
+    const char magic[4] = { 'C', 'B', 'K', sizeof(float) };
+    int header[3] = { cb->size, cb->bits, cb->nb_centroids };
+
+    fwrite(magic, 1, sizeof(magic), file);
+    fwrite(header, sizeof(int), 3, file);
+    fwrite(cb->centroid, sizeof(float), cb->nb_centroids, file);
+    fwrite(cb->index, 1, (cb->size * cb->bits + 7) / 8, file);
+}
+
+void ClusterRead(FILE *file, codebook_t *cb)
+{
+    const char expected[4] = { 'C', 'B', 'K', sizeof(float) };
+    char magic[4];
+    int header[3];
+
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, expected, sizeof(magic)) != 0
+        || fread(header, sizeof(int), 3, file) != 3 || header[0] < 0 || (header[1] != 4 && header[1] != 8)
+        || header[2] < 1 || header[2] > (1 << header[1])) {
+        printf("Error: Not a float codebook.\n");
+        exit(1);
+    }
+    cb->size = header[0];
+    cb->bits = header[1];
+    cb->nb_centroids = header[2];
+    memset(cb->centroid, 0, sizeof(cb->centroid));
+    cb->index = Allocate((cb->size * cb->bits + 7) / 8);
+    if (fread(cb->centroid, sizeof(float), cb->nb_centroids, file) != (size_t)cb->nb_centroids
+        || fread(cb->index, 1, (cb->size * cb->bits + 7) / 8, file) != (size_t)(cb->size * cb->bits + 7) / 8) {
+        printf("Error: Truncated float codebook.\n");
+        exit(1);
+    }
+}
+
+void ClusterFree(codebook_t *cb)
+{
+    free(cb->index);
+    cb->index = NULL;
+    cb->size = 0;
+}
@@ -55,6 +55,104 @@ void Conv1_28x28x1_5x5x20_1_0(
     }
 }
 
+/// @brief Bounding box of the nonzero pixels of the input (all channels)
+/// @param input Input image array of size [1][28][28]
+/// @param box First and last nonzero row and column, x1 < x0 if the image is empty
+void InputBoundingBox(float input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH], bbox_t *box)
+{
+    int rows[IMG_HEIGHT] = { 0 }, cols[IMG_WIDTH] = { 0 };
+
+    // Branch-free projections on the rows and columns, then the first and last nonzero of each
+    for (int c = 0; c < IMG_DEPTH; c++)
+    {
+        for (int y = 0; y < IMG_HEIGHT; y++)
+        {
+            for (int x = 0; x < IMG_WIDTH; x++)
+            {
+                int nonzero = (input[c][y][x] != 0.0f);
+
+                rows[y] |= nonzero;
+                cols[x] |= nonzero;
+            }
+        }
+    }
+
+    box->x0 = IMG_WIDTH;
+    box->y0 = IMG_HEIGHT;
+    box->x1 = -1;
+    box->y1 = -1;
+    for (int y = 0; y < IMG_HEIGHT; y++)
+        if (rows[y])
+        {
+            if (box->y0 > y) box->y0 = y;
+            box->y1 = y;
+        }
+    for (int x = 0; x < IMG_WIDTH; x++)
+        if (cols[x])
+        {
+            if (box->x0 > x) box->x0 = x;
+            box->x1 = x;
+        }
+}
+
+/// @brief First convolution layer computed only where the receptive field meets the input bounding box
+/// @param input Input image array of size [1][28][28]
+/// @param box Bounding box of the nonzero pixels of input (InputBoundingBox)
+/// @param kernel Convolution filters array of size [20][1][5][5]
+/// @param bias Bias terms array of size [20]
+/// @param output Output feature maps array of size [20][24][24]
+/// @return Output positions computed per filter
+/// Outside the box every product is an exact zero, so the full layer gives relu(0 + bias) there.
+int Conv1_28x28x1_5x5x20_1_0_crop(
+    float input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
+    const bbox_t *box,
+    float kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+    float bias[CONV1_NBOUTPUT],
+    float output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH])
+{
+    // Output rows y .. y + 4 of the input meet [y0, y1] for y in [y0 - 4, y1], same for the columns
+    int y0 = box->y0 - (CONV1_DIM - 1) > 0 ? box->y0 - (CONV1_DIM - 1) : 0;
+    int y1 = box->y1 < CONV1_HEIGHT - 1 ? box->y1 : CONV1_HEIGHT - 1;
+    int x0 = box->x0 - (CONV1_DIM - 1) > 0 ? box->x0 - (CONV1_DIM - 1) : 0;
+    int x1 = box->x1 < CONV1_WIDTH - 1 ? box->x1 : CONV1_WIDTH - 1;
+    int full = (y0 == 0 && x0 == 0 && y1 == CONV1_HEIGHT - 1 && x1 == CONV1_WIDTH - 1);
+
+    for (int f = 0; f < CONV1_NBOUTPUT; f++) // for each filter
+    {
+        float outside = 0.0f + bias[f];
+
+        outside = (outside > 0) ? outside : 0;
+        if (!full)
+            for (int y = 0; y < CONV1_HEIGHT; y++)
+                for (int x = 0; x < CONV1_WIDTH; x++)
+                    output[f][y][x] = outside;
+
+        for (int y = y0; y <= y1; y++)
+        {
+            for (int x = x0; x <= x1; x++)
+            {
+                float sum = 0.0f;
+
+                for (int c = 0; c < IMG_DEPTH; c++)
+                {
+                    for (int ky = 0; ky < CONV1_DIM; ky++)
+                    {
+                        for (int kx = 0; kx < CONV1_DIM; kx++)
+                        {
+                            sum += input[c][y + ky][x + kx] * kernel[f][c][ky][kx];
+                        }
+                    }
+                }
+
+                sum += bias[f];
+                // ReLU activation
+                output[f][y][x] = (sum > 0) ? sum : 0;
+            }
+        }
+    }
+    return (y1 >= y0 && x1 >= x0) ? (y1 - y0 + 1) * (x1 - x0 + 1) : 0;
+}
+
 /// @brief Second convolution layer that transforms feature maps (12x12x20) into new feature maps (8x8x40)
 /// @param input Input feature maps array of size [20][12][12]
 /// @param kernel Convolution filters array of size [40][20][5][5]
@@ -92,3 +190,145 @@ void Conv2_12x12x20_5x5x40_1_0(
         }
     }
 }
+
+/// @brief Conv2 from the nonzero list of its input: each nonzero pixel is scattered to the outputs it reaches
+/// @param input Nonzero entries of the [20][12][12] input feature maps
+/// @param kernel Convolution filters array of size [40][20][5][5]
+/// @param bias Bias terms array of size [40]
+/// @param output Output feature maps array of size [40][8][8]
+/// Inputs are visited in memory order, so every output adds its terms in the (c, ky, kx) order of the dense
+/// kernel and the results are identical; the skipped terms are exact zeros.
+void Conv2_12x12x20_5x5x40_1_0_sparse(
+    const nonzero_list_t *input,
+    float kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+    float bias[CONV2_NBOUTPUT],
+    float output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH])
+{
+    for (int f = 0; f < CONV2_NBOUTPUT; f++)
+        for (int y = 0; y < CONV2_HEIGHT; y++)
+            for (int x = 0; x < CONV2_WIDTH; x++)
+                output[f][y][x] = 0.0f;
+
+    for (int i = 0; i < input->count; i++)
+    {
+        int c = input->index[i] / (POOL1_HEIGHT * POOL1_WIDTH);
+        int iy = input->index[i] / POOL1_WIDTH % POOL1_HEIGHT;
+        int ix = input->index[i] % POOL1_WIDTH;
+        float v = input->value[i];
+        // Kernel taps that land inside the output map
+        int ky0 = iy - (CONV2_HEIGHT - 1) > 0 ? iy - (CONV2_HEIGHT - 1) : 0;
+        int ky1 = iy < CONV2_DIM - 1 ? iy : CONV2_DIM - 1;
+        int kx0 = ix - (CONV2_WIDTH - 1) > 0 ? ix - (CONV2_WIDTH - 1) : 0;
+        int kx1 = ix < CONV2_DIM - 1 ? ix : CONV2_DIM - 1;
+
+        for (int f = 0; f < CONV2_NBOUTPUT; f++)
+        {
+            for (int ky = ky0; ky <= ky1; ky++)
+            {
+                for (int kx = kx0; kx <= kx1; kx++)
+                {
+                    output[f][iy - ky][ix - kx] += v * kernel[f][c][ky][kx];
+                }
+            }
+        }
+    }
+
+    for (int f = 0; f < CONV2_NBOUTPUT; f++)
+    {
+        for (int y = 0; y < CONV2_HEIGHT; y++)
+        {
+            for (int x = 0; x < CONV2_WIDTH; x++)
+            {
+                float sum = output[f][y][x] + bias[f];
+                // ReLU activation
+                output[f][y][x] = (sum > 0) ? sum : 0;
+            }
+        }
+    }
+}
+
+/// @brief Conv2 on pruned weights in CSR: each filter only visits its nonzero (c, ky, kx) taps
+/// @param input Input feature maps array of size [20][12][12]
+/// @param kernel Filters in CSR, [40] rows of [20 * 5 * 5] columns (CsrFromDense of the [40][20][5][5] kernel)
+/// @param bias Bias terms array of size [40]
+/// @param output Output feature maps array of size [40][8][8]
+/// A tap is added to all the 8x8 outputs at once (vectorized over x), in the (c, ky, kx) order of the dense
+/// kernel, so the results are identical to Conv2_12x12x20_5x5x40_1_0 on the pruned dense weights.
+void Conv2_12x12x20_5x5x40_1_0_csr(
+    float input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const csr_t *kernel,
+    float bias[CONV2_NBOUTPUT],
+    float output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH])
+{
+    for (int f = 0; f < CONV2_NBOUTPUT; f++)
+    {
+        float sum[CONV2_HEIGHT][CONV2_WIDTH] = { { 0.0f } };
+
+        for (int i = kernel->row_ptr[f]; i < kernel->row_ptr[f + 1]; i++)
+        {
+            int c = kernel->col[i] / (CONV2_DIM * CONV2_DIM);
+            int ky = kernel->col[i] / CONV2_DIM % CONV2_DIM;
+            int kx = kernel->col[i] % CONV2_DIM;
+            float w = kernel->val[i];
+
+            for (int y = 0; y < CONV2_HEIGHT; y++)
+                for (int x = 0; x < CONV2_WIDTH; x++)
+                    sum[y][x] += input[c][y + ky][x + kx] * w;
+        }
+
+        for (int y = 0; y < CONV2_HEIGHT; y++)
+        {
+            for (int x = 0; x < CONV2_WIDTH; x++)
+            {
+                float s = sum[y][x] + bias[f];
+                // ReLU activation
+                output[f][y][x] = (s > 0) ? s : 0;
+            }
+        }
+    }
+}
+
+/// @brief Conv2 on clustered weights: each filter is decoded from the codebook, then computed as the CSR kernel
+/// @param input Input feature maps array of size [20][12][12]
+/// @param kernel Codebook and packed indexes of the [40][20][5][5] kernel (ClusterFit)
+/// @param bias Bias terms array of size [40]
+/// @param output Output feature maps array of size [40][8][8]
+/// Identical to Conv2_12x12x20_5x5x40_1_0 on the decoded weights (same order of the terms).
+void Conv2_12x12x20_5x5x40_1_0_cluster(
+    float input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const codebook_t *kernel,
+    float bias[CONV2_NBOUTPUT],
+    float output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH])
+{
+    const int taps = POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM;
+
+    for (int f = 0; f < CONV2_NBOUTPUT; f++)
+    {
+        float sum[CONV2_HEIGHT][CONV2_WIDTH] = { { 0.0f } };
+        float w[POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM];
+
+        for (int i = 0; i < taps; i++)
+            w[i] = kernel->centroid[CLUSTER_INDEX(kernel, f * taps + i)];
+
+        for (int i = 0; i < taps; i++)
+        {
+            int c = i / (CONV2_DIM * CONV2_DIM);
+            int ky = i / CONV2_DIM % CONV2_DIM;
+            int kx = i % CONV2_DIM;
+
+            for (int y = 0; y < CONV2_HEIGHT; y++)
+                for (int x = 0; x < CONV2_WIDTH; x++)
+                    sum[y][x] += input[c][y + ky][x + kx] * w[i];
+        }
+
+        for (int y = 0; y < CONV2_HEIGHT; y++)
+        {
+            for (int x = 0; x < CONV2_WIDTH; x++)
+            {
+                float s = sum[y][x] + bias[f];
+                // ReLU activation
+                output[f][y][x] = (s > 0) ? s : 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,160 @@
+/**
+ * @file csr.c
+ * @brief Magnitude pruning of float weights and their compressed sparse row (CSR) storage
+ *
+ * CsrPrune zeroes the smallest weights of a layer in place; CsrFromDense then
+ * keeps the nonzero weights of each row (one Conv2 filter, one FC1 neuron) with
+ * their column in the dense row. On disk a matrix is the 4 bytes "CSR" + the
+ * value size, then rows, cols, nnz (int32), row_ptr, col (uint16) and val,
+ * native byte order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../COMMON/alloc.h"
+#include "lenet_cnn_float.h"
+
+static int CompareFloat(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+
+    return (x > y) - (x < y);
+}
+
+/// @brief Zero the round(sparsity * size) weights of smallest magnitude (ties in index order)
+/// @param weights  Layer weights, modified in place
+/// @param size     Number of weights
+/// @param sparsity Share of the weights to zero, in [0, 1]
+void CsrPrune(float *weights, int size, float sparsity)
+{
+    float *magnitude, threshold;
+    int i, below, ties, k = (int)(sparsity * size + 0.5f);
+
+    if (k <= 0)
+        return;
+    if (k > size)
+        k = size;
+
+    magnitude = Allocate(size * sizeof(float));
+    for (i = 0; i < size; i++)
+        magnitude[i] = fabsf(weights[i]);
+    qsort(magnitude, size, sizeof(float), CompareFloat);
+    threshold = magnitude[k - 1];
+    for (below = 0; magnitude[below] < threshold; below++)
+        ;
+    ties = k - below;                           // weights equal to the threshold that go as well
+    free(magnitude);
+
+    for (i = 0; i < size; i++) {
+        if (fabsf(weights[i]) < threshold)
+            weights[i] = 0.0f;
+        else if (fabsf(weights[i]) == threshold && ties > 0) {
+            weights[i] = 0.0f;
+            ties--;
+        }
+    }
+}
+
+/// @brief Build the CSR of a dense [rows][cols] matrix, exact zeros dropped
+void CsrFromDense(const float *dense, int rows, int cols, csr_t *csr)
+{
+    int r, c, n = 0;
+
+    for (c = 0; c < rows * cols; c++)
+        n += (dense[c] != 0.0f);
+
+    csr->rows = rows;
+    csr->cols = cols;
+    csr->nnz = n;
+    csr->row_ptr = Allocate((rows + 1) * sizeof(int));
+    csr->col = Allocate(n * sizeof(unsigned short));
+    csr->val = Allocate(n * sizeof(float));
+
+    n = 0;
+    for (r = 0; r < rows; r++) {
+        csr->row_ptr[r] = n;
+        for (c = 0; c < cols; c++)
+            if (dense[r * cols + c] != 0.0f) {
+                csr->col[n] = (unsigned short)c;
+                csr->val[n] = dense[r * cols + c];
+                n++;
+            }
+    }
+    csr->row_ptr[rows] = n;
+}
+
+/// @brief Storage of the CSR arrays in bytes
+long CsrBytes(const csr_t *csr)
+{
+    return (csr->rows + 1) * (long)sizeof(int) + csr->nnz * (long)(sizeof(unsigned short) + sizeof(float));
+}
+
+void CsrWrite(FILE *file, const csr_t *csr)
+{
+    const char magic[4] = { 'C', 'S', 'R', sizeof(float) };
+    int header[3] = { csr->rows, csr->cols, csr->nnz };
+
+    fwrite(magic, 1, sizeof(magic), file);
+    fwrite(header, sizeof(int), 3, file);
+    fwrite(csr->row_ptr, sizeof(int), csr->rows + 1, file);
+    fwrite(csr->col, sizeof(unsigned short), csr->nnz, file);
+    fwrite(csr->val, sizeof(float), csr->nnz, file);
+}
+
+/// @brief row_ptr from 0 to nnz, never decreasing, and every column inside the row: the kernels index with them
+static int CsrIndicesValid(const csr_t *csr)
+{
+    int r, i;
+
+    if (csr->row_ptr[0] != 0 || csr->row_ptr[csr->rows] != csr->nnz)
+        return 0;
+    for (r = 0; r < csr->rows; r++)
+        if (csr->row_ptr[r + 1] < csr->row_ptr[r])
+            return 0;
+    for (i = 0; i < csr->nnz; i++)
+        if (csr->col[i] >= csr->cols)
+            return 0;
+    return 1;
+}
+
+void CsrRead(FILE *file, csr_t *csr)
+{
+    const char expected[4] = { 'C', 'S', 'R', sizeof(float) };
+    char magic[4];
+    int header[3];
+
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, expected, sizeof(magic)) != 0
+        || fread(header, sizeof(int), 3, file) != 3 || header[0] < 0 || header[1] < 0 || header[2] < 0) {
+        printf("Error: Not a float CSR matrix.\n");
+        exit(1);
+    }
+    csr->rows = header[0];
+    csr->cols = header[1];
+    csr->nnz = header[2];
+    csr->row_ptr = Allocate((csr->rows + 1) * sizeof(int));
+    csr->col = Allocate(csr->nnz * sizeof(unsigned short));
+    csr->val = Allocate(csr->nnz * sizeof(float));
+    if (fread(csr->row_ptr, sizeof(int), csr->rows + 1, file) != (size_t)csr->rows + 1
+        || fread(csr->col, sizeof(unsigned short), csr->nnz, file) != (size_t)csr->nnz
+        || fread(csr->val, sizeof(float), csr->nnz, file) != (size_t)csr->nnz) {
+        printf("Error: Truncated float CSR matrix.\n");
+        exit(1);
+    }
+    if (!CsrIndicesValid(csr)) {
+        printf("Error: Invalid row pointers or columns in a float CSR matrix.\n");
+        exit(1);
+    }
+}
+
+void CsrFree(csr_t *csr)
+{
+    free(csr->row_ptr);
+    free(csr->col);
+    free(csr->val);
+    csr->row_ptr = NULL;
+    csr->col = NULL;
+    csr->val = NULL;
+    csr->nnz = 0;
+}
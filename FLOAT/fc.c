@@ -20,6 +20,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include "lenet_cnn_float.h"
 
@@ -47,6 +48,129 @@ void Fc1_40_400(
     }
 }
 
+/// @brief FC1 from the nonzero list of its input: a zero input skips its 400 weights
+/// @param input    Nonzero entries of the pool2 output, built once and shared by all the outputs
+/// @param kernel   Weight matrix
+/// @param bias     Bias values
+/// @param output   Layer output, identical to Fc1_40_400 (same order of the nonzero terms)
+void Fc1_40_400_sparse(
+    const nonzero_list_t *input,
+                 const float kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                 const float bias[FC1_NBOUTPUT],
+                 float output[FC1_NBOUTPUT]
+) {
+    for (int n = 0; n < FC1_NBOUTPUT; n++) {
+        const float *row = &kernel[n][0][0][0];
+        float sum = bias[n];
+        for (int i = 0; i < input->count; i++) {
+            sum += input->value[i] * row[input->index[i]];
+        }
+        output[n] = fmaxf(0.0f, sum);
+    }
+}
+
+/// @brief FC1 on pruned weights in CSR: each output only reads its nonzero weights
+/// @param input    Layer input from previous pooling layer
+/// @param kernel   Weights in CSR, [400] rows of [40 * 4 * 4] columns
+/// @param bias     Bias values
+/// @param output   Layer output, identical to Fc1_40_400 on the pruned dense weights (same order of the terms)
+void Fc1_40_400_csr(
+    const float input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                 const csr_t *kernel,
+                 const float bias[FC1_NBOUTPUT],
+                 float output[FC1_NBOUTPUT]
+) {
+    const float *in = &input[0][0][0];
+
+    for (int n = 0; n < FC1_NBOUTPUT; n++) {
+        float sum = bias[n];
+        for (int i = kernel->row_ptr[n]; i < kernel->row_ptr[n + 1]; i++) {
+            sum += in[kernel->col[i]] * kernel->val[i];
+        }
+        output[n] = fmaxf(0.0f, sum);
+    }
+}
+
+/// @brief FC1 on clustered weights: the centroid of each weight is looked up in the multiply-add loop
+/// @param input    Layer input from previous pooling layer
+/// @param kernel   Codebook and packed indexes of the [400][640] weights (ClusterFit)
+/// @param bias     Bias values
+/// @param output   Layer output, identical to Fc1_40_400 on the decoded weights (same order of the terms)
+/// A block of FC1_CLUSTER_ROWS rows shares each input load and a 16-entry codebook is copied to a local table,
+/// so no row is decoded to memory.
+void Fc1_40_400_cluster(
+    const float input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                 const codebook_t *kernel,
+                 const float bias[FC1_NBOUTPUT],
+                 float output[FC1_NBOUTPUT]
+) {
+    const int size = POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH;
+    const int stride = size * kernel->bits / 8;
+    const float *in = &input[0][0][0];
+    float centroid[16];
+
+    memcpy(centroid, kernel->centroid, sizeof(centroid));
+    for (int n = 0; n < FC1_NBOUTPUT; n += FC1_CLUSTER_ROWS) {
+        const unsigned char *index = kernel->index + n * stride;
+        float sum[FC1_CLUSTER_ROWS];
+
+        for (int r = 0; r < FC1_CLUSTER_ROWS; r++)
+            sum[r] = bias[n + r];
+        if (kernel->bits == 4) {
+            for (int i = 0; i < size / 2; i++) {
+                float a = in[2 * i], b = in[2 * i + 1];
+                for (int r = 0; r < FC1_CLUSTER_ROWS; r++) {
+                    unsigned char pair = index[r * stride + i];
+                    sum[r] += a * centroid[pair & 15];
+                    sum[r] += b * centroid[pair >> 4];
+                }
+            }
+        } else {
+            for (int i = 0; i < size; i++) {
+                float a = in[i];
+                for (int r = 0; r < FC1_CLUSTER_ROWS; r++) {
+                    sum[r] += a * kernel->centroid[index[r * stride + i]];
+                }
+            }
+        }
+        for (int r = 0; r < FC1_CLUSTER_ROWS; r++)
+            output[n + r] = fmaxf(0.0f, sum[r]);
+    }
+}
+
+/// @brief FC1 from the factors of its truncated SVD: t = v x (rank outputs), then output = relu(bias + u t)
+/// @param input    Layer input from previous pooling layer
+/// @param kernel   Factors u [400][rank] and v [rank][640] (Fc1LowRank)
+/// @param bias     Bias values
+/// @param output   Layer output, approximates Fc1_40_400 (exact at full rank up to rounding)
+void Fc1_40_400_lowrank(
+    const float input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                 const fc1_lowrank_t *kernel,
+                 const float bias[FC1_NBOUTPUT],
+                 float output[FC1_NBOUTPUT]
+) {
+    const int size = POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH;
+    const float *in = &input[0][0][0];
+    float t[FC1_NBOUTPUT];
+
+    for (int k = 0; k < kernel->rank; k++) {
+        const float *row = &kernel->v[k * size];
+        float sum = 0.0f;
+        for (int i = 0; i < size; i++) {
+            sum += row[i] * in[i];
+        }
+        t[k] = sum;
+    }
+    for (int n = 0; n < FC1_NBOUTPUT; n++) {
+        const float *row = &kernel->u[n * kernel->rank];
+        float sum = bias[n];
+        for (int k = 0; k < kernel->rank; k++) {
+            sum += row[k] * t[k];
+        }
+        output[n] = fmaxf(0.0f, sum);
+    }
+}
+
 /// @brief Second Fully Connected Layer FC2: transforms 400 inputs to 10 outputs
 /// @param input    Layer input (output from FC1)
 /// @param kernel   Weight matrix
@@ -90,3 +214,21 @@ void Softmax(float vector_in[FC2_NBOUTPUT], float vector_out[FC2_NBOUTPUT]) {
     }
 
 }
+
+/// @brief Argmax-only output: predicted class and top-2 logit margin, no softmax
+/// @param vector_in   Input values (FC2 logits)
+/// @param pred        Predicted class (first one on ties) and logit(top1) - logit(top2)
+void Predict(float vector_in[FC2_NBOUTPUT], prediction_t *pred) {
+    int best = 0, second = -1;
+
+    for (int i = 1; i < FC2_NBOUTPUT; i++) {
+        if (vector_in[i] > vector_in[best]) {
+            second = best;
+            best = i;
+        } else if (second < 0 || vector_in[i] > vector_in[second]) {
+            second = i;
+        }
+    }
+    pred->number = (unsigned char)best;
+    pred->margin = vector_in[best] - vector_in[second];
+}
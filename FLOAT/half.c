@@ -0,0 +1,284 @@
+/**
+ * @file half.c
+ * @brief Half-precision storage of the weights and activations: fp16 or bf16 in memory, fp32 arithmetic
+ *
+ * A half_t holds the bits of an IEEE binary16 (fp16: 5-bit exponent, 10-bit
+ * mantissa) or of a bfloat16 (bf16: the upper 16 bits of a float, 8-bit
+ * exponent, 7-bit mantissa). Both are rounded to nearest even from float.
+ * The _half kernels widen their input map once and their weights one filter
+ * or one row at a time into small float buffers, then accumulate in float in
+ * the order of the float kernels and round the outputs back to half: the
+ * results are those of the float kernels on the widened values, rounded.
+ * The biases stay float (a few hundred values). fp16 keeps 3 more mantissa
+ * bits than bf16 and covers 6e-8 to 65504, enough for LeNet's weights
+ * (|w| < 2) and activations; bf16 has the range of a float.
+ *
+ * Widening fp16 is exact and branch-free: the exponent is rebased by a
+ * multiplication by 2^112, which also normalizes the subnormals. Built with
+ * -mf16c, HalfToFloat uses the F16C vcvtph2ps instruction, 8 values at a time.
+ * Post-ReLU activations are >= +0, and the bit patterns of non-negative
+ * halves sort as unsigned integers, so the max pools compare them as such.
+ */
+
+#include <string.h>
+#include "lenet_cnn_float.h"
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+#define FC1_SIZE (POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+
+typedef union {
+    unsigned int u;
+    float        f;
+} bits_t;
+
+static inline float Fp16ToFloat(half_t h)
+{
+    const bits_t magic = { .u = (254 - 15) << 23 }, infnan = { .u = (127 + 16) << 23 };
+    bits_t o;
+
+    o.u = (unsigned int)(h & 0x7fff) << 13;
+    o.f *= magic.f;                         // rebase the exponent, normalize the subnormals
+    if (o.f >= infnan.f)
+        o.u |= 255 << 23;
+    o.u |= (unsigned int)(h & 0x8000) << 16;
+    return o.f;
+}
+
+static inline float Bf16ToFloat(half_t h)
+{
+    bits_t o;
+
+    o.u = (unsigned int)h << 16;
+    return o.f;
+}
+
+static inline half_t FloatToFp16(float x)
+{
+    const bits_t infinity = { .u = 255 << 23 }, fp16_max = { .u = (127 + 16) << 23 };
+    const bits_t subnormal = { .u = ((127 - 15) + (23 - 10) + 1) << 23 };
+    bits_t f = { .f = x };
+    unsigned int sign = f.u & 0x80000000u, odd;
+    half_t o;
+
+    f.u ^= sign;
+    if (f.u >= fp16_max.u) {                // overflow to infinity, NaN stays NaN
+        o = f.u > infinity.u ? 0x7e00 : 0x7c00;
+    } else if (f.u < (113u << 23)) {        // subnormal: the addition rounds the mantissa
+        f.f += subnormal.f;
+        o = (half_t)(f.u - subnormal.u);
+    } else {
+        odd = (f.u >> 13) & 1;
+        f.u += ((unsigned int)(15 - 127) << 23) + 0xfff + odd;
+        o = (half_t)(f.u >> 13);
+    }
+    return o | (half_t)(sign >> 16);
+}
+
+static inline half_t FloatToBf16(float x)
+{
+    bits_t f = { .f = x };
+
+    if ((f.u & 0x7fffffffu) > 0x7f800000u)  // NaN, kept quiet
+        return (half_t)((f.u >> 16) | 0x40);
+    return (half_t)((f.u + 0x7fff + ((f.u >> 16) & 1)) >> 16);
+}
+
+static inline half_t Round(float x, half_format_t format)
+{
+    return format == HALF_BF16 ? FloatToBf16(x) : FloatToFp16(x);
+}
+
+/// @brief Round size floats to half
+void HalfFromFloat(const float *input, half_t *output, int size, half_format_t format)
+{
+    int i;
+
+    if (format == HALF_BF16)
+        for (i = 0; i < size; i++)
+            output[i] = FloatToBf16(input[i]);
+    else
+        for (i = 0; i < size; i++)
+            output[i] = FloatToFp16(input[i]);
+}
+
+/// @brief Widen size halves to float, exactly
+void HalfToFloat(const half_t *input, float *output, int size, half_format_t format)
+{
+    int i = 0;
+
+    if (format == HALF_BF16) {
+        for (; i < size; i++)
+            output[i] = Bf16ToFloat(input[i]);
+        return;
+    }
+#ifdef __F16C__
+    for (; i + 8 <= size; i += 8)
+        _mm256_storeu_ps(output + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(input + i))));
+#endif
+    for (; i < size; i++)
+        output[i] = Fp16ToFloat(input[i]);
+}
+
+/// @brief First convolution layer on half storage
+/// @param input  Input image array of size [1][28][28]
+/// @param kernel Convolution filters array of size [20][1][5][5]
+/// @param bias   Bias terms array of size [20], float
+/// @param output Output feature maps array of size [20][24][24], ReLU applied
+/// @param format fp16 or bf16, of input, kernel and output
+void Conv1_28x28x1_5x5x20_1_0_half(
+    const half_t input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
+    const half_t kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+    const float bias[CONV1_NBOUTPUT],
+    half_t output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH],
+    half_format_t format)
+{
+    float in[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+    float k[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+
+    HalfToFloat(&input[0][0][0], &in[0][0][0], IMG_DEPTH * IMG_HEIGHT * IMG_WIDTH, format);
+    HalfToFloat(&kernel[0][0][0][0], &k[0][0][0][0], sizeof(k) / sizeof(float), format);
+
+    for (int f = 0; f < CONV1_NBOUTPUT; f++)
+    {
+        for (int y = 0; y < CONV1_HEIGHT; y++)
+        {
+            for (int x = 0; x < CONV1_WIDTH; x++)
+            {
+                float sum = 0.0f;
+
+                for (int c = 0; c < IMG_DEPTH; c++)
+                    for (int ky = 0; ky < CONV1_DIM; ky++)
+                        for (int kx = 0; kx < CONV1_DIM; kx++)
+                            sum += in[c][y + ky][x + kx] * k[f][c][ky][kx];
+
+                sum += bias[f];
+                output[f][y][x] = Round((sum > 0) ? sum : 0, format);
+            }
+        }
+    }
+}
+
+/// @brief Second convolution layer on half storage, the filters widened one at a time
+/// @param input  Input feature maps array of size [20][12][12]
+/// @param kernel Convolution filters array of size [40][20][5][5]
+/// @param bias   Bias terms array of size [40], float
+/// @param output Output feature maps array of size [40][8][8], ReLU applied
+/// @param format fp16 or bf16, of input, kernel and output
+void Conv2_12x12x20_5x5x40_1_0_half(
+    const half_t input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+    const half_t kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+    const float bias[CONV2_NBOUTPUT],
+    half_t output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH],
+    half_format_t format)
+{
+    float in[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH];
+    float k[POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+
+    HalfToFloat(&input[0][0][0], &in[0][0][0], sizeof(in) / sizeof(float), format);
+
+    for (int f = 0; f < CONV2_NBOUTPUT; f++)
+    {
+        HalfToFloat(&kernel[f][0][0][0], &k[0][0][0], sizeof(k) / sizeof(float), format);
+
+        for (int y = 0; y < CONV2_HEIGHT; y++)
+        {
+            for (int x = 0; x < CONV2_WIDTH; x++)
+            {
+                float sum = 0.0f;
+
+                for (int c = 0; c < POOL1_NBOUTPUT; c++)
+                    for (int ky = 0; ky < CONV2_DIM; ky++)
+                        for (int kx = 0; kx < CONV2_DIM; kx++)
+                            sum += in[c][y + ky][x + kx] * k[c][ky][kx];
+
+                sum += bias[f];
+                output[f][y][x] = Round((sum > 0) ? sum : 0, format);
+            }
+        }
+    }
+}
+
+/// @brief Pool1 on half storage: 2x2 max of non-negative halves, compared as integers
+void Pool1_24x24x20_2x2x20_2_0_half(const half_t input[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH],
+                                    half_t output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH])
+{
+    for (int ch = 0; ch < CONV1_NBOUTPUT; ch++)
+        for (int oy = 0; oy < POOL1_HEIGHT; oy++)
+            for (int ox = 0; ox < POOL1_WIDTH; ox++) {
+                half_t a = input[ch][2 * oy][2 * ox], b = input[ch][2 * oy][2 * ox + 1];
+                half_t c = input[ch][2 * oy + 1][2 * ox], d = input[ch][2 * oy + 1][2 * ox + 1];
+
+                a = a > b ? a : b;
+                c = c > d ? c : d;
+                output[ch][oy][ox] = a > c ? a : c;
+            }
+}
+
+/// @brief Pool2 on half storage: 2x2 max of non-negative halves, compared as integers
+void Pool2_8x8x40_2x2x40_2_0_half(const half_t input[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH],
+                                  half_t output[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH])
+{
+    for (int ch = 0; ch < CONV2_NBOUTPUT; ch++)
+        for (int oy = 0; oy < POOL2_HEIGHT; oy++)
+            for (int ox = 0; ox < POOL2_WIDTH; ox++) {
+                half_t a = input[ch][2 * oy][2 * ox], b = input[ch][2 * oy][2 * ox + 1];
+                half_t c = input[ch][2 * oy + 1][2 * ox], d = input[ch][2 * oy + 1][2 * ox + 1];
+
+                a = a > b ? a : b;
+                c = c > d ? c : d;
+                output[ch][oy][ox] = a > c ? a : c;
+            }
+}
+
+/// @brief FC1 on half storage, the rows widened one at a time
+/// @param input    Layer input from previous pooling layer
+/// @param kernel   Weight matrix
+/// @param bias     Bias values, float
+/// @param output   Layer output, ReLU applied
+/// @param format   fp16 or bf16, of input, kernel and output
+void Fc1_40_400_half(const half_t input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                     const half_t kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                     const float bias[FC1_NBOUTPUT],
+                     half_t output[FC1_NBOUTPUT],
+                     half_format_t format)
+{
+    float in[FC1_SIZE], row[FC1_SIZE];
+
+    HalfToFloat(&input[0][0][0], in, FC1_SIZE, format);
+    for (int n = 0; n < FC1_NBOUTPUT; n++) {
+        float sum = bias[n];
+
+        HalfToFloat(&kernel[n][0][0][0], row, FC1_SIZE, format);
+        for (int i = 0; i < FC1_SIZE; i++)
+            sum += in[i] * row[i];
+        output[n] = Round(sum > 0.0f ? sum : 0.0f, format);
+    }
+}
+
+/// @brief FC2 on half storage, float logits
+/// @param input    Layer input from FC1
+/// @param kernel   Weight matrix
+/// @param bias     Bias values, float
+/// @param output   Logits, float as those of Fc2_400_10
+/// @param format   fp16 or bf16, of input and kernel
+void Fc2_400_10_half(const half_t input[FC1_NBOUTPUT],
+                     const half_t kernel[FC2_NBOUTPUT][FC1_NBOUTPUT],
+                     const float bias[FC2_NBOUTPUT],
+                     float output[FC2_NBOUTPUT],
+                     half_format_t format)
+{
+    float in[FC1_NBOUTPUT], row[FC1_NBOUTPUT];
+
+    HalfToFloat(input, in, FC1_NBOUTPUT, format);
+    for (int n = 0; n < FC2_NBOUTPUT; n++) {
+        float sum = bias[n];
+
+        HalfToFloat(&kernel[n][0], row, FC1_NBOUTPUT, format);
+        for (int i = 0; i < FC1_NBOUTPUT; i++)
+            sum += in[i] * row[i];
+        output[n] = sum;
+    }
+}
@@ -0,0 +1,283 @@
+/**
+ * @file lanes.c
+ * @brief Batch-in-lanes layout: LANES images interleaved, one image per SIMD lane
+ *
+ * Every map of the _lanes kernels has the image as its last index, so the
+ * LANES values of a pixel are contiguous and each SIMD lane holds that pixel
+ * for a different image. The loops of the float kernels are kept, with an
+ * innermost loop over the lanes: the same weight multiplies LANES pixels,
+ * there is no horizontal reduction, and 24x24, 12x12 or 4x4 maps need no
+ * edge handling whatever the vector width. LANES is 16 with AVX-512 and 8
+ * otherwise (one AVX2 register, two SSE2 registers in the default build).
+ *
+ * The convolutions compute LANES_BLOCK filters at a time and FC1
+ * LANES_BLOCK rows at a time, so that LANES_BLOCK x LANES sums stay in
+ * registers and each input vector is loaded once for all of them. Each
+ * output still adds its terms in the order of the float kernel, so every
+ * lane gives the float results bit for bit. The lane loops of the inner
+ * products carry #pragma GCC unroll 1: gcc would otherwise unroll them
+ * completely and vectorize the loop over the terms instead, as an in-order
+ * reduction that is two to three times slower. The kernels are dense: the
+ * crop and sparse paths of lenet_cnn, which skip the zeros of one image, do
+ * not apply when LANES images share the loop.
+ *
+ * Conv1 has a single input channel, so a position only has 25 terms: gcc
+ * compiles the bias and ReLU of the 32 sums of a block to scalar code with
+ * a data-dependent branch each, and with two SSE registers per pixel it
+ * does not keep a larger block in registers. The SSE2 builds with 8 lanes
+ * therefore run Conv1 with intrinsics: one filter and CONV1_LANES_X x
+ * positions at a time, each tap broadcast once for the CONV1_LANES_X
+ * positions, their 2 x CONV1_LANES_X sums in registers, and a branch-free
+ * bias and ReLU. The AVX-512 build vectorizes the loops well as they are.
+ */
+
+#include "lenet_cnn_float.h"
+
+#if defined(__SSE2__) && LANES == 8
+#include <emmintrin.h>
+#endif
+
+#define FC1_SIZE       (POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+#define LANES_BLOCK    4        // filters or FC1 rows at a time, divides CONV1_NBOUTPUT, CONV2_NBOUTPUT, FC1_NBOUTPUT
+#define CONV1_LANES_X  4        // Conv1 x positions at a time with SSE2, divides CONV1_WIDTH
+
+/// @brief Normalized pixels of count consecutive images, interleaved; the lanes from count on are zero
+/// @param pixels Raw 8-bit images [count][IMG_HEIGHT * IMG_WIDTH]
+/// @param count  Number of images, 1 to LANES
+/// @param output Input maps of the _lanes kernels [1][28][28][LANES], as NormalizeImg
+void LanesInterleave(const unsigned char *pixels, int count, float output[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH][LANES])
+{
+    for (int y = 0; y < IMG_HEIGHT; y++)
+        for (int x = 0; x < IMG_WIDTH; x++)
+            for (int l = 0; l < LANES; l++)
+                output[0][y][x][l] = l < count ? (float)pixels[l * IMG_HEIGHT * IMG_WIDTH + y * IMG_WIDTH + x] / 255
+                                               : 0.0f;
+}
+
+#if defined(__SSE2__) && LANES == 8
+/// @brief Conv1_28x28x1_5x5x20_1_0_lanes with SSE2, a pixel of the 8 lanes in two registers: one filter and
+///        CONV1_LANES_X x positions at a time, each tap broadcast once and multiplied with their 2 x CONV1_LANES_X
+///        input registers into as many sums
+static void Conv1LanesSse(
+    const float input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH][LANES],
+    const float kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+    const float bias[CONV1_NBOUTPUT],
+    float output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH][LANES])
+{
+    const __m128 zero = _mm_setzero_ps();
+
+    for (int f = 0; f < CONV1_NBOUTPUT; f++)
+    {
+        for (int y = 0; y < CONV1_HEIGHT; y++)
+        {
+            for (int x = 0; x < CONV1_WIDTH; x += CONV1_LANES_X)
+            {
+                __m128 sum[CONV1_LANES_X][2];
+
+                for (int d = 0; d < CONV1_LANES_X; d++)
+                    sum[d][0] = sum[d][1] = zero;
+
+                for (int c = 0; c < IMG_DEPTH; c++)
+                    for (int ky = 0; ky < CONV1_DIM; ky++)
+                        for (int kx = 0; kx < CONV1_DIM; kx++)
+                        {
+                            const float *in = input[c][y + ky][x + kx];
+                            __m128 w = _mm_set1_ps(kernel[f][c][ky][kx]);
+
+                            for (int d = 0; d < CONV1_LANES_X; d++)
+                                for (int h = 0; h < 2; h++)
+                                    sum[d][h] = _mm_add_ps(sum[d][h],
+                                                           _mm_mul_ps(_mm_loadu_ps(in + d * LANES + 4 * h), w));
+                        }
+
+                // maxps(s, 0) is (s > 0) ? s : 0, for -0 and NaN as well
+                for (int d = 0; d < CONV1_LANES_X; d++)
+                    for (int h = 0; h < 2; h++)
+                        _mm_storeu_ps(&output[f][y][x + d][4 * h],
+                                      _mm_max_ps(_mm_add_ps(sum[d][h], _mm_set1_ps(bias[f])), zero));
+            }
+        }
+    }
+}
+#endif
+
+/// @brief First convolution layer on LANES images, LANES_BLOCK filters at a time (Conv1LanesSse with SSE2 and 8 lanes)
+/// @param input  Input images array of size [1][28][28][LANES]
+/// @param kernel Convolution filters array of size [20][1][5][5]
+/// @param bias   Bias terms array of size [20]
+/// @param output Output feature maps array of size [20][24][24][LANES], ReLU applied
+void Conv1_28x28x1_5x5x20_1_0_lanes(
+    const float input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH][LANES],
+    const float kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+    const float bias[CONV1_NBOUTPUT],
+    float output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH][LANES])
+{
+#if defined(__SSE2__) && LANES == 8
+    Conv1LanesSse(input, kernel, bias, output);
+#else
+    for (int f = 0; f < CONV1_NBOUTPUT; f += LANES_BLOCK)
+    {
+        for (int y = 0; y < CONV1_HEIGHT; y++)
+        {
+            for (int x = 0; x < CONV1_WIDTH; x++)
+            {
+                float sum[LANES_BLOCK][LANES] = { { 0.0f } };
+
+                for (int c = 0; c < IMG_DEPTH; c++)
+                    for (int ky = 0; ky < CONV1_DIM; ky++)
+                        for (int kx = 0; kx < CONV1_DIM; kx++)
+                            for (int r = 0; r < LANES_BLOCK; r++)
+                            {
+                                float w = kernel[f + r][c][ky][kx];
+
+#pragma GCC unroll 1
+                                for (int l = 0; l < LANES; l++)
+                                    sum[r][l] += input[c][y + ky][x + kx][l] * w;
+                            }
+
+                for (int r = 0; r < LANES_BLOCK; r++)
+                    for (int l = 0; l < LANES; l++)
+                    {
+                        float s = sum[r][l] + bias[f + r];
+
+                        output[f + r][y][x][l] = (s > 0) ? s : 0;
+                    }
+            }
+        }
+    }
+#endif
+}
+
+/// @brief Second convolution layer on LANES images, LANES_BLOCK filters at a time
+/// @param input  Input feature maps array of size [20][12][12][LANES]
+/// @param kernel Convolution filters array of size [40][20][5][5]
+/// @param bias   Bias terms array of size [40]
+/// @param output Output feature maps array of size [40][8][8][LANES], ReLU applied
+void Conv2_12x12x20_5x5x40_1_0_lanes(
+    const float input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH][LANES],
+    const float kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+    const float bias[CONV2_NBOUTPUT],
+    float output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH][LANES])
+{
+    for (int f = 0; f < CONV2_NBOUTPUT; f += LANES_BLOCK)
+    {
+        for (int y = 0; y < CONV2_HEIGHT; y++)
+        {
+            for (int x = 0; x < CONV2_WIDTH; x++)
+            {
+                float sum[LANES_BLOCK][LANES] = { { 0.0f } };
+
+                for (int c = 0; c < POOL1_NBOUTPUT; c++)
+                    for (int ky = 0; ky < CONV2_DIM; ky++)
+                        for (int kx = 0; kx < CONV2_DIM; kx++)
+                            for (int r = 0; r < LANES_BLOCK; r++)
+                            {
+                                float w = kernel[f + r][c][ky][kx];
+
+#pragma GCC unroll 1
+                                for (int l = 0; l < LANES; l++)
+                                    sum[r][l] += input[c][y + ky][x + kx][l] * w;
+                            }
+
+                for (int r = 0; r < LANES_BLOCK; r++)
+                    for (int l = 0; l < LANES; l++)
+                    {
+                        float s = sum[r][l] + bias[f + r];
+
+                        output[f + r][y][x][l] = (s > 0) ? s : 0;
+                    }
+            }
+        }
+    }
+}
+
+/// @brief Pool1 on LANES images, the comparisons of Pool1_24x24x20_2x2x20_2_0
+void Pool1_24x24x20_2x2x20_2_0_lanes(const float input[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH][LANES],
+                                     float output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH][LANES])
+{
+    for (int ch = 0; ch < CONV1_NBOUTPUT; ch++)
+        for (int oy = 0; oy < POOL1_HEIGHT; oy++)
+            for (int ox = 0; ox < POOL1_WIDTH; ox++)
+                for (int l = 0; l < LANES; l++) {
+                    float m = input[ch][2 * oy][2 * ox][l];
+
+                    m = input[ch][2 * oy][2 * ox + 1][l] > m ? input[ch][2 * oy][2 * ox + 1][l] : m;
+                    m = input[ch][2 * oy + 1][2 * ox][l] > m ? input[ch][2 * oy + 1][2 * ox][l] : m;
+                    m = input[ch][2 * oy + 1][2 * ox + 1][l] > m ? input[ch][2 * oy + 1][2 * ox + 1][l] : m;
+                    output[ch][oy][ox][l] = m;
+                }
+}
+
+/// @brief Pool2 on LANES images, the comparisons of Pool2_8x8x40_2x2x40_2_0
+void Pool2_8x8x40_2x2x40_2_0_lanes(const float input[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH][LANES],
+                                   float output[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH][LANES])
+{
+    for (int ch = 0; ch < CONV2_NBOUTPUT; ch++)
+        for (int oy = 0; oy < POOL2_HEIGHT; oy++)
+            for (int ox = 0; ox < POOL2_WIDTH; ox++)
+                for (int l = 0; l < LANES; l++) {
+                    float m = input[ch][2 * oy][2 * ox][l];
+
+                    m = input[ch][2 * oy][2 * ox + 1][l] > m ? input[ch][2 * oy][2 * ox + 1][l] : m;
+                    m = input[ch][2 * oy + 1][2 * ox][l] > m ? input[ch][2 * oy + 1][2 * ox][l] : m;
+                    m = input[ch][2 * oy + 1][2 * ox + 1][l] > m ? input[ch][2 * oy + 1][2 * ox + 1][l] : m;
+                    output[ch][oy][ox][l] = m;
+                }
+}
+
+/// @brief FC1 on LANES images, LANES_BLOCK rows at a time
+/// @param input    Layer input from previous pooling layer [40][4][4][LANES]
+/// @param kernel   Weight matrix
+/// @param bias     Bias values
+/// @param output   Layer output [400][LANES], ReLU applied
+void Fc1_40_400_lanes(const float input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH][LANES],
+                      const float kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                      const float bias[FC1_NBOUTPUT],
+                      float output[FC1_NBOUTPUT][LANES])
+{
+    const float (*in)[LANES] = (const float (*)[LANES])&input[0][0][0][0];
+    float sum[LANES_BLOCK][LANES];
+
+    for (int n = 0; n < FC1_NBOUTPUT; n += LANES_BLOCK) {
+        for (int r = 0; r < LANES_BLOCK; r++)
+            for (int l = 0; l < LANES; l++)
+                sum[r][l] = bias[n + r];
+
+        for (int i = 0; i < FC1_SIZE; i++)
+            for (int r = 0; r < LANES_BLOCK; r++) {
+                float w = (&kernel[n + r][0][0][0])[i];
+
+#pragma GCC unroll 1
+                for (int l = 0; l < LANES; l++)
+                    sum[r][l] += in[i][l] * w;
+            }
+
+        for (int r = 0; r < LANES_BLOCK; r++)
+            for (int l = 0; l < LANES; l++)
+                output[n + r][l] = sum[r][l] > 0.0f ? sum[r][l] : 0.0f;
+    }
+}
+
+/// @brief FC2 on LANES images
+/// @param input    Layer input from FC1 [400][LANES]
+/// @param kernel   Weight matrix
+/// @param bias     Bias values
+/// @param output   Logits [10][LANES]
+void Fc2_400_10_lanes(const float input[FC1_NBOUTPUT][LANES],
+                      const float kernel[FC2_NBOUTPUT][FC1_NBOUTPUT],
+                      const float bias[FC2_NBOUTPUT],
+                      float output[FC2_NBOUTPUT][LANES])
+{
+    for (int n = 0; n < FC2_NBOUTPUT; n++) {
+        float sum[LANES];
+
+        for (int l = 0; l < LANES; l++)
+            sum[l] = bias[n];
+        for (int i = 0; i < FC1_NBOUTPUT; i++)
+#pragma GCC unroll 1
+            for (int l = 0; l < LANES; l++)
+                sum[l] += input[i][l] * kernel[n][i];
+        for (int l = 0; l < LANES; l++)
+            output[n][l] = sum[l];
+    }
+}
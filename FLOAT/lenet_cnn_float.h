@@ -8,6 +8,7 @@
   * @brief   Designed to support Vivado HLS synthesis
   */
 
+#include <stdio.h>
 
 #define IMG_WIDTH	28
 #define IMG_HEIGHT	28
@@ -45,6 +46,92 @@
 
 #define FC2_NBOUTPUT	10
 
+// Argmax-only output mode: class and top-2 logit margin
+typedef struct {
+  unsigned char number;
+  float         margin;
+} prediction_t;
+
+// Bounding box of the nonzero input pixels, bounds included, empty when x1 < x0
+typedef struct {
+  short x0, y0, x1, y1;
+} bbox_t;
+
+// Sparse activations: nonzero entries of a ReLU / max-pool output, in memory order
+#define NONZERO_MAX_SIZE (POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH)
+
+typedef struct {
+  int   count;
+  short index[NONZERO_MAX_SIZE];    // flat index in the [c][y][x] map
+  float value[NONZERO_MAX_SIZE];
+} nonzero_list_t;
+
+// The host engine runs the sparse kernel when the input density is below these: dense / sparse crossovers
+// (list build included) measured single thread on random zero masks
+#ifndef CONV2_SPARSE_DENSITY
+#define CONV2_SPARSE_DENSITY 0.40f
+#endif
+#ifndef FC1_SPARSE_DENSITY
+#define FC1_SPARSE_DENSITY   0.60f
+#endif
+
+// Pruned weights in compressed sparse rows: row r (one filter or one output neuron) keeps its nonzero
+// weights val[row_ptr[r] .. row_ptr[r + 1] - 1], col[] being their flat index in the dense row
+typedef struct {
+  int             rows, cols, nnz;
+  int            *row_ptr;          // [rows + 1]
+  unsigned short *col;              // [nnz], increasing within a row
+  float          *val;              // [nnz]
+} csr_t;
+
+// FC1 as the factors of its truncated SVD: FC1(x) = relu(bias + u (v x)), u = U_r, v = S_r V_r^T
+typedef struct {
+  int    rank;
+  float *u;                         // [FC1_NBOUTPUT][rank]
+  float *v;                         // [rank][POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH]
+} fc1_lowrank_t;
+
+// Weights shared on a per-layer codebook of at most CLUSTER_MAX_CENTROIDS values: weight i is
+// centroid[index i], indexes packed on 4 bits (two weights per byte, low nibble first) or 8 bits
+#define CLUSTER_MAX_CENTROIDS 256
+#define FC1_CLUSTER_ROWS      8     // FC1 rows sharing each input load, divides FC1_NBOUTPUT
+#define CLUSTER_INDEX(cb, i) ((cb)->bits == 4 ? ((cb)->index[(i) >> 1] >> (((i) & 1) * 4)) & 15 : (cb)->index[i])
+typedef struct {
+  int            size;              // number of weights
+  int            bits;              // 4 up to 16 centroids, 8 above
+  int            nb_centroids;
+  float          centroid[CLUSTER_MAX_CENTROIDS];
+  unsigned char *index;             // [(size * bits + 7) / 8]
+} codebook_t;
+
+// Conv2 / FC1 rows as the signs of their weights times alpha = mean |w|, one bit per weight (set when
+// positive), 64 per word. A Conv2 filter is stored tap by tap, the 20 channels of a tap on 20 bits,
+// XNOR_CONV2_TAPS_PER_WORD taps per word; an FC1 row keeps the [c][y][x] input order
+#define XNOR_CONV2_TAPS_PER_WORD 3
+#define XNOR_CONV2_WORDS ((CONV2_DIM * CONV2_DIM + XNOR_CONV2_TAPS_PER_WORD - 1) / XNOR_CONV2_TAPS_PER_WORD)
+#define XNOR_FC1_WORDS   ((POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH + 63) / 64)
+typedef struct {
+  int                 rows, cols, words;    // cols weights per row, packed on words 64-bit words
+  unsigned long long *sign;                 // [rows][words]
+  int                *sum;                  // [rows] sum of the signs, +1 or -1 per weight
+  float              *alpha;                // [rows]
+} xnor_t;
+
+// Half-precision storage (half.c): the bits of an fp16 (IEEE binary16) or of a bf16 (upper half of a
+// float), widened to float for the arithmetic
+typedef unsigned short half_t;
+typedef enum {
+  HALF_FP16,
+  HALF_BF16
+} half_format_t;
+
+// Batch-in-lanes layout (lanes.c): LANES images interleaved, the image is the last index of every map
+#ifdef __AVX512F__
+#define LANES 16
+#else
+#define LANES 8
+#endif
+
 void ReadPgmFile(char *filename, unsigned char *pix); 
 void WritePgmFile(char *filename, float *pix, short width, short height); 
 void ReadTestLabels(char *filename, short size); 
@@ -66,6 +153,15 @@ void Conv1_28x28x1_5x5x20_1_0(	float 			input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
 				                float 		    output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH]); 		// OUT
 
 
+// Conv1 restricted to the outputs whose 5x5 receptive field meets the input bounding box,
+// relu(bias) elsewhere: identical to the full Conv1
+void InputBoundingBox(float input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH], bbox_t *box);
+int  Conv1_28x28x1_5x5x20_1_0_crop(float input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
+                                   const bbox_t *box,
+                                   float kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+                                   float bias[CONV1_NBOUTPUT],
+                                   float output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH]);
+
 void Pool1_24x24x20_2x2x20_2_0(	float 	input[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH], 	    // IN
 				                float 	output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH]);		// OUT
 
@@ -87,5 +183,145 @@ void Fc2_400_10(	const float 	input[restrict FC1_NBOUTPUT], 			        // IN
 			        const float 	bias[restrict FC2_NBOUTPUT],			            // IN
 			        float 	output[restrict FC2_NBOUTPUT]); 			        // OUT
 
-void Softmax(float vector_in[FC2_NBOUTPUT], float vector_out[FC2_NBOUTPUT]); 
+void Softmax(float vector_in[FC2_NBOUTPUT], float vector_out[FC2_NBOUTPUT]);
+
+// Sparse-input kernels, same results as the dense ones bit for bit
+int  NonzeroList(const float *input, int size, nonzero_list_t *list);
+void Conv2_12x12x20_5x5x40_1_0_sparse(const nonzero_list_t *input,
+                                      float kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+                                      float bias[CONV2_NBOUTPUT],
+                                      float output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH]);
+void Fc1_40_400_sparse(const nonzero_list_t *input,
+                       const float kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                       const float bias[FC1_NBOUTPUT],
+                       float output[FC1_NBOUTPUT]);
+
+// Magnitude pruning and CSR storage (csr.c)
+void CsrPrune(float *weights, int size, float sparsity);
+void CsrFromDense(const float *dense, int rows, int cols, csr_t *csr);
+long CsrBytes(const csr_t *csr);
+void CsrWrite(FILE *file, const csr_t *csr);
+void CsrRead(FILE *file, csr_t *csr);
+void CsrFree(csr_t *csr);
+
+// Sparse-weight kernels on CSR kernels, same results as the dense ones on the pruned dense weights
+void Conv2_12x12x20_5x5x40_1_0_csr(float input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+                                   const csr_t *kernel,
+                                   float bias[CONV2_NBOUTPUT],
+                                   float output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH]);
+void Fc1_40_400_csr(const float input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                    const csr_t *kernel,
+                    const float bias[FC1_NBOUTPUT],
+                    float output[FC1_NBOUTPUT]);
+
+// Low-rank FC1 (svd.c): two thin matrix-vector products, rank * (640 + 400) MACs instead of 640 * 400
+float Fc1LowRank(const float kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH], int rank,
+                 fc1_lowrank_t *lowrank);
+void  Fc1LowRankFree(fc1_lowrank_t *lowrank);
+void  Fc1_40_400_lowrank(const float input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                         const fc1_lowrank_t *kernel,
+                         const float bias[FC1_NBOUTPUT],
+                         float output[FC1_NBOUTPUT]);
+
+// K-means weight clustering (cluster.c)
+void ClusterFit(const float *weights, int size, int nb_centroids, codebook_t *cb);
+void ClusterDecode(const codebook_t *cb, float *weights);
+long ClusterBytes(const codebook_t *cb);
+void ClusterWrite(FILE *file, const codebook_t *cb);
+void ClusterRead(FILE *file, codebook_t *cb);
+void ClusterFree(codebook_t *cb);
+
+// Clustered-weight kernels, Conv2 decoding one filter at a time, FC1 looking up each centroid as it goes: same
+// results as the dense ones on the decoded weights
+void Conv2_12x12x20_5x5x40_1_0_cluster(float input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+                                       const codebook_t *kernel,
+                                       float bias[CONV2_NBOUTPUT],
+                                       float output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH]);
+void Fc1_40_400_cluster(const float input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                        const codebook_t *kernel,
+                        const float bias[FC1_NBOUTPUT],
+                        float output[FC1_NBOUTPUT]);
+
+// Binarized weights (xnor.c)
+void XnorConv2(const float kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM], xnor_t *x);
+void XnorFc1(const float kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH], xnor_t *x);
+long XnorBytes(const xnor_t *x);
+void XnorFree(xnor_t *x);
+
+// 1-bit kernels: input binarized at its mean on two levels, XOR and popcount instead of MACs, float bias
+void Conv2_12x12x20_5x5x40_1_0_xnor(float input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+                                    const xnor_t *kernel,
+                                    float bias[CONV2_NBOUTPUT],
+                                    float output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH]);
+void Fc1_40_400_xnor(const float input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                     const xnor_t *kernel,
+                     const float bias[FC1_NBOUTPUT],
+                     float output[FC1_NBOUTPUT]);
+
+// Half-precision storage (half.c), rounded to nearest even
+void HalfFromFloat(const float *input, half_t *output, int size, half_format_t format);
+void HalfToFloat(const half_t *input, float *output, int size, half_format_t format);
+
+// Kernels on half weights and activations, float accumulation and biases: the float kernels on the widened
+// values, outputs rounded to half (Fc2: float logits). The pools take non-negative (post-ReLU) inputs
+void Conv1_28x28x1_5x5x20_1_0_half(const half_t input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
+                                   const half_t kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+                                   const float bias[CONV1_NBOUTPUT],
+                                   half_t output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH],
+                                   half_format_t format);
+void Pool1_24x24x20_2x2x20_2_0_half(const half_t input[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH],
+                                    half_t output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH]);
+void Conv2_12x12x20_5x5x40_1_0_half(const half_t input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+                                    const half_t kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+                                    const float bias[CONV2_NBOUTPUT],
+                                    half_t output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH],
+                                    half_format_t format);
+void Pool2_8x8x40_2x2x40_2_0_half(const half_t input[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH],
+                                  half_t output[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH]);
+void Fc1_40_400_half(const half_t input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                     const half_t kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                     const float bias[FC1_NBOUTPUT],
+                     half_t output[FC1_NBOUTPUT],
+                     half_format_t format);
+void Fc2_400_10_half(const half_t input[FC1_NBOUTPUT],
+                     const half_t kernel[FC2_NBOUTPUT][FC1_NBOUTPUT],
+                     const float bias[FC2_NBOUTPUT],
+                     float output[FC2_NBOUTPUT],
+                     half_format_t format);
+
+// Kernels on LANES interleaved images (lanes.c), every lane gives the results of the float kernels
+void LanesInterleave(const unsigned char *pixels, int count, float output[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH][LANES]);
+void Conv1_28x28x1_5x5x20_1_0_lanes(const float input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH][LANES],
+                                    const float kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+                                    const float bias[CONV1_NBOUTPUT],
+                                    float output[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH][LANES]);
+void Pool1_24x24x20_2x2x20_2_0_lanes(const float input[CONV1_NBOUTPUT][CONV1_HEIGHT][CONV1_WIDTH][LANES],
+                                     float output[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH][LANES]);
+void Conv2_12x12x20_5x5x40_1_0_lanes(const float input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH][LANES],
+                                     const float kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+                                     const float bias[CONV2_NBOUTPUT],
+                                     float output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH][LANES]);
+void Pool2_8x8x40_2x2x40_2_0_lanes(const float input[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH][LANES],
+                                   float output[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH][LANES]);
+void Fc1_40_400_lanes(const float input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH][LANES],
+                      const float kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                      const float bias[FC1_NBOUTPUT],
+                      float output[FC1_NBOUTPUT][LANES]);
+void Fc2_400_10_lanes(const float input[FC1_NBOUTPUT][LANES],
+                      const float kernel[FC2_NBOUTPUT][FC1_NBOUTPUT],
+                      const float bias[FC2_NBOUTPUT],
+                      float output[FC2_NBOUTPUT][LANES]);
+
+// Top level HLS function (lenet_cnn_float.c)
+void lenet_cnn(float input[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH],
+               float conv1_kernel[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM],
+               float conv1_bias[CONV1_NBOUTPUT],
+               float conv2_kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM],
+               float conv2_bias[CONV2_NBOUTPUT],
+               float fc1_kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+               float fc1_bias[FC1_NBOUTPUT],
+               float fc2_kernel[FC2_NBOUTPUT][FC1_NBOUTPUT],
+               float fc2_bias[FC2_NBOUTPUT],
+               float output[FC2_NBOUTPUT]);
+void Predict(float vector_in[FC2_NBOUTPUT], prediction_t *pred);
 
@@ -0,0 +1,201 @@
+/**
+ ******************************************************************************
+ * @file    main_float.c
+ * @author  Sébastien Bilavarn, LEAT, CNRS, Université Côte d'Azur, France
+ * @version V1.0
+ * @date    04 february 2019
+ * @brief   MNIST test driver of the float LeNet (top level lenet_cnn in lenet_cnn_float.c)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lenet_cnn_float.h"
+#include "profile.h"
+#include "../COMMON/perf_counters.h"
+#include "../COMMON/latency.h"
+
+// GLOBAL VARIABLES
+unsigned char REF_IMG[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+float INPUT_NORM[IMG_DEPTH][IMG_HEIGHT][IMG_WIDTH];
+float CONV1_KERNEL[CONV1_NBOUTPUT][IMG_DEPTH][CONV1_DIM][CONV1_DIM];
+float CONV1_BIAS[CONV1_NBOUTPUT];
+float CONV2_KERNEL[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM];
+float CONV2_BIAS[CONV2_NBOUTPUT];
+float FC1_KERNEL[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH];
+float FC1_BIAS[FC1_NBOUTPUT];
+float FC2_KERNEL[FC2_NBOUTPUT][FC1_NBOUTPUT];
+float FC2_BIAS[FC2_NBOUTPUT];
+float FC2_OUTPUT[FC2_NBOUTPUT];
+float SOFTMAX_OUTPUT[FC2_NBOUTPUT];
+
+/**
+ ******************************************************************************
+ * @brief   main code deploying a LeNet inference CNN on MNIST dataset
+ */
+
+int main(int argc, char **argv)
+{
+  short x, y, z, k, m;
+  char *hdf5_filename = "lenet_weights.weights.h5";
+  char *conv1_weights = "/layers/conv2d/vars/0"; // (5,5,1,20)
+  char *conv1_bias = "/layers/conv2d/vars/1";    // (20,)
+  char *conv2_weights = "/layers/conv2d_1/vars/0"; // (5,5,20,40)
+  char *conv2_bias = "/layers/conv2d_1/vars/1";    // (40,)
+  char *fc1_weights = "/layers/dense/vars/0"; // (640,400)
+  char *fc1_bias = "/layers/dense/vars/1";    // (400,)
+  char *fc2_weights = "/layers/dense_1/vars/0"; // (400,10)
+  char *fc2_bias = "/layers/dense_1/vars/1";    // (10,)
+  char *test_labels_filename = "mnist/t10k-labels-idx1-ubyte";
+  //  char* 	test_labels_filename = 		"mnist/train-labels-idx1-ubyte";
+  //  char* 	output_filename = 		"output.pgm";
+  FILE *label_file;
+  int ret;
+  unsigned char label, number;
+  unsigned int error;
+  unsigned char labels_legend[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  char img_filename[120];
+  char img_count[10];
+  prediction_t prediction;
+  int show_probs = 0; // --probs: print the softmax and prediction of every image
+  unsigned long long start, end, t0, t1, t2;
+  latency_hist_t io_hist, inference_hist; // per image: read + normalize, lenet_cnn + Predict
+  double tdiff;
+
+  for (k = 1; k < argc; k++)
+  {
+    if (strcmp(argv[k], "--probs") == 0)
+      show_probs = 1;
+    else
+    {
+      printf("Usage: %s [--probs]\n", argv[0]);
+      exit(1);
+    }
+  }
+
+  printf("\nReading weights \n");
+  ReadConv1Weights(hdf5_filename, conv1_weights, CONV1_KERNEL);
+  ReadConv1Bias(hdf5_filename, conv1_bias, CONV1_BIAS);
+  ReadConv2Weights(hdf5_filename, conv2_weights, CONV2_KERNEL);
+  ReadConv2Bias(hdf5_filename, conv2_bias, CONV2_BIAS);
+  ReadFc1Weights(hdf5_filename, fc1_weights, FC1_KERNEL);
+  ReadFc1Bias(hdf5_filename, fc1_bias, FC1_BIAS);
+  ReadFc2Weights(hdf5_filename, fc2_weights, FC2_KERNEL);
+  ReadFc2Bias(hdf5_filename, fc2_bias, FC2_BIAS);
+  // WriteWeights("temp.txt", CONV1_KERNEL);
+
+  printf("\nOpening labels file \n");
+  label_file = fopen(test_labels_filename, "r");
+  if (!label_file)
+  {
+    printf("Error: Unable to open file %s.\n", test_labels_filename);
+    exit(1);
+  }
+
+  for (k = 0; k < 8; k++) // Skip 8 first header bytes
+    ret = fscanf(label_file, "%c", &label);
+
+#ifdef PERF_COUNTERS
+  PerfInit();
+#endif
+
+  printf("\nProcessing \n");
+  m = 0;     // test image counter
+  error = 0; // number of mispredictions
+  LatencyInit(&io_hist);
+  LatencyInit(&inference_hist);
+
+  // MAIN TEST LOOP
+  start = LatencyNow();
+  while (1)
+  {
+    //  for (x = 0; x < 1; x++) {
+
+    ret = fscanf(label_file, "%c", &label);
+    if (feof(label_file))
+      break;
+
+    strcpy(img_filename, "mnist/t10k-images-idx3-ubyte[");
+    //    strcpy(img_filename, "mnist/train-images-idx3-ubyte[");
+    sprintf(img_count, "%d", m);
+    if (m < 10)
+      strcat(img_filename, "0000");
+    else if (m < 100)
+      strcat(img_filename, "000");
+    else if (m < 1000)
+      strcat(img_filename, "00");
+    else if (m < 10000)
+      strcat(img_filename, "0");
+    strcat(img_filename, img_count);
+    strcat(img_filename, "].pgm");
+
+    t0 = LatencyNow();
+    ReadPgmFile(img_filename, (unsigned char *)REF_IMG);
+
+    NormalizeImg((unsigned char *)REF_IMG, (float *)INPUT_NORM, IMG_WIDTH, IMG_WIDTH);
+    /*  for (z = 0; z < IMG_DEPTH; z++)
+        for (y=0; y<IMG_HEIGHT; y++) {
+          for (x=0; x<IMG_WIDTH; x++)
+            printf("%.2f ", INPUT_NORM[z][y][x]);
+          printf("\n");
+        }
+    */
+
+    t1 = LatencyNow();
+    lenet_cnn(INPUT_NORM,
+              CONV1_KERNEL,
+              CONV1_BIAS,
+              CONV2_KERNEL,
+              CONV2_BIAS,
+              FC1_KERNEL,
+              FC1_BIAS,
+              FC2_KERNEL,
+              FC2_BIAS,
+              FC2_OUTPUT);
+
+    // Argmax-only by default, softmax only when probabilities are requested
+    Predict(FC2_OUTPUT, &prediction);
+    t2 = LatencyNow();
+    LatencyRecord(&io_hist, t1 - t0);
+    LatencyRecord(&inference_hist, t2 - t1);
+    number = prediction.number;
+    if (show_probs)
+    {
+      Softmax(FC2_OUTPUT, SOFTMAX_OUTPUT);
+      /**/ printf("\n\nSoftmax output: \n");
+      for (k = 0; k < FC2_NBOUTPUT; k++)
+        /**/ printf("%.2f%% ", SOFTMAX_OUTPUT[k] * 100);
+    }
+
+    if (show_probs)
+      printf("\n%s\nPredicted: %d \t Actual: %d \t Margin: %.3f\n", img_filename, labels_legend[number], label, prediction.margin);
+    if (labels_legend[number] != label)
+      error = error + 1;
+    m++;
+
+  } // END MAIN TEST LOOP
+  end = LatencyNow();
+
+  tdiff = (end - start) / 1e9;
+  printf("\nTOTAL PROCESSING TIME (CLOCK_MONOTONIC): %.3f s (%.1f images/s end to end)\n\n", tdiff, m / tdiff);
+  LatencyReportHeader(stdout);
+  LatencyReport(stdout, "inference", &inference_hist);
+  LatencyReport(stdout, "I/O", &io_hist);
+
+  printf("\n\nErrors : %d / %d", error, m);
+  printf("\n\nSuccess rate = %f%%", (1 - ((float)error / m)) * 100);
+
+#ifdef PROFILE
+  ProfileReport(stdout, "profile_float.csv");
+#endif
+#ifdef PERF_COUNTERS
+  PerfReport(stdout);
+#endif
+
+  printf("\n\n");
+
+  fclose(label_file);
+
+  return 0;
+}
@@ -0,0 +1,195 @@
+/**
+ * @file profile.c
+ * @brief Activation range profiler for quantization calibration (float pipeline)
+ *
+ * Collects, for every layer output of lenet_cnn over the whole dataset:
+ * - per-layer and per-channel min/max
+ * - a log2 magnitude histogram (zeros counted separately)
+ *
+ * The report recommends, for each layer, the Qm.n format that covers the full
+ * observed range and the one that covers 99.99% of the values (clipping the
+ * rare outliers buys extra fractional bits).
+ */
+
+#include <stdio.h>
+#include <float.h>
+#include <math.h>
+#include "profile.h"
+
+static const char *profile_layer_names[PROFILE_NB_LAYERS] = {
+    "input", "conv1", "pool1", "conv2", "pool2", "fc1", "fc2"
+};
+
+typedef struct {
+    int                nb_channels;
+    float              min, max;
+    float              ch_min[PROFILE_MAX_CHANNELS];
+    float              ch_max[PROFILE_MAX_CHANNELS];
+    unsigned long long nb_values;
+    unsigned long long nb_zeros;
+    unsigned long long nb_negatives;
+    unsigned long long hist[PROFILE_NB_BINS];
+} profile_stats_t;
+
+static profile_stats_t profile_stats[PROFILE_NB_LAYERS];
+
+
+/// @brief Histogram bin of a non-zero magnitude, clamped to the histogram range
+static int ProfileBin(float value)
+{
+    int exp;
+    int bin;
+
+    frexpf(fabsf(value), &exp);     // |value| = m * 2^exp, 0.5 <= m < 1
+    bin = exp - PROFILE_MIN_EXP;
+    if (bin < 0) bin = 0;
+    if (bin >= PROFILE_NB_BINS) bin = PROFILE_NB_BINS - 1;
+    return bin;
+}
+
+/// @brief Record one layer output
+/// @param layer        Layer identifier (PROFILE_INPUT ... PROFILE_FC2)
+/// @param data         Layer output, channel-major
+/// @param nb_channels  Number of channels (feature maps, or neurons for FC layers)
+/// @param channel_size Number of values per channel
+void ProfileLayer(int layer, const float *data, int nb_channels, int channel_size)
+{
+    profile_stats_t *s = &profile_stats[layer];
+    int c, i;
+
+    if (s->nb_values == 0) {
+        s->nb_channels = nb_channels;
+        s->min = FLT_MAX;
+        s->max = -FLT_MAX;
+        for (c = 0; c < nb_channels; c++) {
+            s->ch_min[c] = FLT_MAX;
+            s->ch_max[c] = -FLT_MAX;
+        }
+    }
+
+    for (c = 0; c < nb_channels; c++) {
+        for (i = 0; i < channel_size; i++) {
+            float v = data[c * channel_size + i];
+
+            if (v < s->ch_min[c]) s->ch_min[c] = v;
+            if (v > s->ch_max[c]) s->ch_max[c] = v;
+
+            if (v == 0.0f)
+                s->nb_zeros++;
+            else
+                s->hist[ProfileBin(v)]++;
+            if (v < 0.0f)
+                s->nb_negatives++;
+        }
+        if (s->ch_min[c] < s->min) s->min = s->ch_min[c];
+        if (s->ch_max[c] > s->max) s->max = s->ch_max[c];
+    }
+    s->nb_values += (unsigned long long)nb_channels * channel_size;
+}
+
+/// @brief Number of integer bits (sign excluded) needed so that |x| < 2^m
+static int ProfileIntBits(float max_abs)
+{
+    int m = 0;
+
+    while (m < 31 && ldexpf(1.0f, m) <= max_abs)
+        m++;
+    return m;
+}
+
+/// @brief Integer bits covering all but a fraction 'tail' of the non-zero values
+static int ProfileClipIntBits(const profile_stats_t *s, double tail)
+{
+    unsigned long long nonzero = s->nb_values - s->nb_zeros;
+    unsigned long long above = 0;
+    int b;
+
+    for (b = PROFILE_NB_BINS - 1; b > 0; b--) {
+        above += s->hist[b];
+        if ((double)above > tail * (double)nonzero)
+            break;
+    }
+    // Values of bin b are < 2^(b+PROFILE_MIN_EXP)
+    return (b + PROFILE_MIN_EXP > 0) ? b + PROFILE_MIN_EXP : 0;
+}
+
+/// @brief Print the per-layer summary and write per-channel ranges and histograms to CSV
+/// @param out          Stream for the summary table
+/// @param csv_filename Per-channel / histogram dump, NULL to skip
+void ProfileReport(FILE *out, const char *csv_filename)
+{
+    int l, c, b;
+    FILE *csv;
+
+    fprintf(out, "\n========================================\n");
+    fprintf(out, "ACTIVATION PROFILE\n");
+    fprintf(out, "========================================\n");
+    fprintf(out, "%-6s %12s %12s %8s %8s %10s %10s %10s\n",
+            "layer", "min", "max", "zeros%", "neg%", "Q16(full)", "Q16(clip)", "Q8(clip)");
+
+    for (l = 0; l < PROFILE_NB_LAYERS; l++) {
+        const profile_stats_t *s = &profile_stats[l];
+        float max_abs;
+        int m_full, m_clip;
+        char q16_full[16], q16_clip[16], q8_clip[16];
+
+        if (s->nb_values == 0)
+            continue;
+
+        max_abs = fmaxf(fabsf(s->min), fabsf(s->max));
+        m_full = ProfileIntBits(max_abs);
+        m_clip = ProfileClipIntBits(s, 1e-4);
+        if (m_clip > m_full) m_clip = m_full;
+
+        snprintf(q16_full, sizeof(q16_full), "Q%d.%d", m_full, 15 - m_full);
+        snprintf(q16_clip, sizeof(q16_clip), "Q%d.%d", m_clip, 15 - m_clip);
+        if (m_clip <= 7)
+            snprintf(q8_clip, sizeof(q8_clip), "Q%d.%d", m_clip, 7 - m_clip);
+        else
+            snprintf(q8_clip, sizeof(q8_clip), "n/a");
+
+        fprintf(out, "%-6s %12.5f %12.5f %7.2f%% %7.2f%% %10s %10s %10s\n",
+                profile_layer_names[l], s->min, s->max,
+                100.0 * s->nb_zeros / s->nb_values,
+                100.0 * s->nb_negatives / s->nb_values,
+                q16_full, q16_clip, q8_clip);
+    }
+
+    fprintf(out, "\nScale = 2^n for Qm.n. 'clip' formats saturate the top 0.01%% of non-zero magnitudes.\n");
+
+    fprintf(out, "\nlog2|x| histograms (bin: count)\n");
+    for (l = 0; l < PROFILE_NB_LAYERS; l++) {
+        const profile_stats_t *s = &profile_stats[l];
+
+        if (s->nb_values == 0)
+            continue;
+        fprintf(out, "%-6s zero: %llu", profile_layer_names[l], s->nb_zeros);
+        for (b = 0; b < PROFILE_NB_BINS; b++)
+            if (s->hist[b])
+                fprintf(out, "  2^%d: %llu", b + PROFILE_MIN_EXP, s->hist[b]);
+        fprintf(out, "\n");
+    }
+
+    if (csv_filename == NULL)
+        return;
+
+    csv = fopen(csv_filename, "w");
+    if (!csv) {
+        printf("Error: Unable to open file %s.\n", csv_filename);
+        return;
+    }
+    fprintf(csv, "layer,kind,index,min_or_count,max\n");
+    for (l = 0; l < PROFILE_NB_LAYERS; l++) {
+        const profile_stats_t *s = &profile_stats[l];
+
+        if (s->nb_values == 0)
+            continue;
+        for (c = 0; c < s->nb_channels; c++)
+            fprintf(csv, "%s,channel,%d,%g,%g\n", profile_layer_names[l], c, s->ch_min[c], s->ch_max[c]);
+        fprintf(csv, "%s,zero,0,%llu,\n", profile_layer_names[l], s->nb_zeros);
+        for (b = 0; b < PROFILE_NB_BINS; b++)
+            fprintf(csv, "%s,hist,%d,%llu,\n", profile_layer_names[l], b + PROFILE_MIN_EXP, s->hist[b]);
+    }
+    fclose(csv);
+    fprintf(out, "\nPer-channel ranges and histograms written to %s\n", csv_filename);
+}
@@ -0,0 +1,42 @@
+/**
+ * @file profile.h
+ * @brief Activation range profiler for quantization calibration (float pipeline)
+ *
+ * Built only when PROFILE is defined (make profile). Every layer output of
+ * lenet_cnn is recorded: per-layer and per-channel min/max, plus a log2
+ * magnitude histogram per layer. ProfileReport() prints the observed ranges
+ * and recommends a fixed-point Qm.n format for 16-bit and 8-bit storage.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+
+// Histogram bins: bin b holds 2^(b+PROFILE_MIN_EXP-1) <= |x| < 2^(b+PROFILE_MIN_EXP)
+#define PROFILE_NB_BINS     32
+#define PROFILE_MIN_EXP     (-16)
+#define PROFILE_MAX_CHANNELS 400
+
+enum {
+    PROFILE_INPUT,
+    PROFILE_CONV1,
+    PROFILE_POOL1,
+    PROFILE_CONV2,
+    PROFILE_POOL2,
+    PROFILE_FC1,
+    PROFILE_FC2,
+    PROFILE_NB_LAYERS
+};
+
+void ProfileLayer(int layer, const float *data, int nb_channels, int channel_size);
+void ProfileReport(FILE *out, const char *csv_filename);
+
+#ifdef PROFILE
+#define PROFILE_LAYER(layer, data, nb_channels, channel_size) \
+    ProfileLayer(layer, (const float *)(data), nb_channels, channel_size)
+#else
+#define PROFILE_LAYER(layer, data, nb_channels, channel_size)
+#endif
+
+#endif // PROFILE_H
@@ -0,0 +1,252 @@
+/**
+ * @file svd.c
+ * @brief Truncated SVD of the FC1 weight matrix, for the low-rank FC1 kernel
+ *
+ * FC1 is the 400 x 640 matrix W (one row per output neuron). Its left singular
+ * vectors are the eigenvectors of the 400 x 400 Gram matrix W W^T, computed in
+ * double by Householder tridiagonalization and the implicit QL algorithm
+ * (tred2 / tql2 of EISPACK). The r leading ones form U_r and the second factor
+ * is the projection V = U_r^T W = S_r V_r^T, so u v = U_r U_r^T W is the best
+ * rank-r approximation of W without dividing by small singular values.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../COMMON/alloc.h"
+#include "lenet_cnn_float.h"
+
+#define FC1_ROWS FC1_NBOUTPUT
+#define FC1_COLS (POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+
+/// @brief Householder reduction of the symmetric v[n][n] to tridiagonal form (diagonal d, subdiagonal e)
+/// On return v holds the orthogonal transformation.
+static void Tred2(int n, double *v, double *d, double *e)
+{
+    int i, j, k;
+    double f, g, h, hh, scale;
+
+    for (j = 0; j < n; j++)
+        d[j] = v[(n - 1) * n + j];
+
+    for (i = n - 1; i > 0; i--) {
+        scale = 0.0;
+        h = 0.0;
+        for (k = 0; k < i; k++)
+            scale += fabs(d[k]);
+        if (scale == 0.0) {
+            e[i] = d[i - 1];
+            for (j = 0; j < i; j++) {
+                d[j] = v[(i - 1) * n + j];
+                v[i * n + j] = 0.0;
+                v[j * n + i] = 0.0;
+            }
+        } else {
+            for (k = 0; k < i; k++) {
+                d[k] /= scale;
+                h += d[k] * d[k];
+            }
+            f = d[i - 1];
+            g = sqrt(h);
+            if (f > 0)
+                g = -g;
+            e[i] = scale * g;
+            h -= f * g;
+            d[i - 1] = f - g;
+            for (j = 0; j < i; j++)
+                e[j] = 0.0;
+
+            for (j = 0; j < i; j++) {
+                f = d[j];
+                v[j * n + i] = f;
+                g = e[j] + v[j * n + j] * f;
+                for (k = j + 1; k <= i - 1; k++) {
+                    g += v[k * n + j] * d[k];
+                    e[k] += v[k * n + j] * f;
+                }
+                e[j] = g;
+            }
+            f = 0.0;
+            for (j = 0; j < i; j++) {
+                e[j] /= h;
+                f += e[j] * d[j];
+            }
+            hh = f / (h + h);
+            for (j = 0; j < i; j++)
+                e[j] -= hh * d[j];
+            for (j = 0; j < i; j++) {
+                f = d[j];
+                g = e[j];
+                for (k = j; k <= i - 1; k++)
+                    v[k * n + j] -= (f * e[k] + g * d[k]);
+                d[j] = v[(i - 1) * n + j];
+                v[i * n + j] = 0.0;
+            }
+        }
+        d[i] = h;
+    }
+
+    // Accumulate the transformations
+    for (i = 0; i < n - 1; i++) {
+        v[(n - 1) * n + i] = v[i * n + i];
+        v[i * n + i] = 1.0;
+        h = d[i + 1];
+        if (h != 0.0) {
+            for (k = 0; k <= i; k++)
+                d[k] = v[k * n + i + 1] / h;
+            for (j = 0; j <= i; j++) {
+                g = 0.0;
+                for (k = 0; k <= i; k++)
+                    g += v[k * n + i + 1] * v[k * n + j];
+                for (k = 0; k <= i; k++)
+                    v[k * n + j] -= g * d[k];
+            }
+        }
+        for (k = 0; k <= i; k++)
+            v[k * n + i + 1] = 0.0;
+    }
+    for (j = 0; j < n; j++) {
+        d[j] = v[(n - 1) * n + j];
+        v[(n - 1) * n + j] = 0.0;
+    }
+    v[(n - 1) * n + n - 1] = 1.0;
+    e[0] = 0.0;
+}
+
+/// @brief Implicit QL on the tridiagonal (d, e): eigenvalues in d, eigenvectors in the columns of v
+static void Tql2(int n, double *v, double *d, double *e)
+{
+    int i, k, l, m;
+    double f = 0.0, tst1 = 0.0, eps = pow(2.0, -52.0);
+    double c, c2, c3, dl1, el1, g, h, p, r, s, s2;
+
+    for (i = 1; i < n; i++)
+        e[i - 1] = e[i];
+    e[n - 1] = 0.0;
+
+    for (l = 0; l < n; l++) {
+        // Find a small subdiagonal element
+        if (tst1 < fabs(d[l]) + fabs(e[l]))
+            tst1 = fabs(d[l]) + fabs(e[l]);
+        for (m = l; m < n - 1; m++)
+            if (fabs(e[m]) <= eps * tst1)
+                break;
+
+        // d[l] is an eigenvalue when m == l, iterate otherwise
+        if (m > l) {
+            do {
+                g = d[l];
+                p = (d[l + 1] - g) / (2.0 * e[l]);
+                r = hypot(p, 1.0);
+                if (p < 0)
+                    r = -r;
+                d[l] = e[l] / (p + r);
+                d[l + 1] = e[l] * (p + r);
+                dl1 = d[l + 1];
+                h = g - d[l];
+                for (i = l + 2; i < n; i++)
+                    d[i] -= h;
+                f += h;
+
+                p = d[m];
+                c = 1.0;
+                c2 = c;
+                c3 = c;
+                el1 = e[l + 1];
+                s = 0.0;
+                s2 = 0.0;
+                for (i = m - 1; i >= l; i--) {
+                    c3 = c2;
+                    c2 = c;
+                    s2 = s;
+                    g = c * e[i];
+                    h = c * p;
+                    r = hypot(p, e[i]);
+                    e[i + 1] = s * r;
+                    s = e[i] / r;
+                    c = p / r;
+                    p = c * d[i] - s * g;
+                    d[i + 1] = h + s * (c * g + s * d[i]);
+                    for (k = 0; k < n; k++) {
+                        h = v[k * n + i + 1];
+                        v[k * n + i + 1] = s * v[k * n + i] + c * h;
+                        v[k * n + i] = c * v[k * n + i] - s * h;
+                    }
+                }
+                p = -s * s2 * c3 * el1 * e[l] / dl1;
+                e[l] = s * p;
+                d[l] = c * p;
+            } while (fabs(e[l]) > eps * tst1);
+        }
+        d[l] += f;
+        e[l] = 0.0;
+    }
+}
+
+/// @brief Factorize FC1 into u [400][rank] and v [rank][640] by truncated SVD
+/// @param kernel   Dense FC1 weights
+/// @param rank     Number of singular triplets kept, 1 to FC1_NBOUTPUT
+/// @param lowrank  Factors, allocated here (Fc1LowRankFree)
+/// @return Relative approximation error ||W - u v||_F / ||W||_F
+float Fc1LowRank(const float kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH], int rank,
+                 fc1_lowrank_t *lowrank)
+{
+    const float *w = &kernel[0][0][0][0];
+    double *gram = Allocate(FC1_ROWS * FC1_ROWS * sizeof(double));
+    double d[FC1_ROWS], e[FC1_ROWS], sum, kept = 0.0, total = 0.0;
+    int i, j, k, col;
+
+    if (rank < 1)
+        rank = 1;
+    if (rank > FC1_ROWS)
+        rank = FC1_ROWS;
+
+    // Gram matrix W W^T, symmetric
+    for (i = 0; i < FC1_ROWS; i++)
+        for (j = 0; j <= i; j++) {
+            sum = 0.0;
+            for (k = 0; k < FC1_COLS; k++)
+                sum += (double)w[i * FC1_COLS + k] * w[j * FC1_COLS + k];
+            gram[i * FC1_ROWS + j] = sum;
+            gram[j * FC1_ROWS + i] = sum;
+        }
+
+    // Eigenvalues ascending, eigenvectors in the columns of gram
+    Tred2(FC1_ROWS, gram, d, e);
+    Tql2(FC1_ROWS, gram, d, e);
+
+    lowrank->rank = rank;
+    lowrank->u = Allocate(FC1_ROWS * rank * sizeof(float));
+    lowrank->v = Allocate(rank * FC1_COLS * sizeof(float));
+    for (k = 0; k < rank; k++) {
+        col = FC1_ROWS - 1 - k;                     // k-th largest singular value
+        for (i = 0; i < FC1_ROWS; i++)
+            lowrank->u[i * rank + k] = (float)gram[i * FC1_ROWS + col];
+        for (j = 0; j < FC1_COLS; j++) {
+            sum = 0.0;
+            for (i = 0; i < FC1_ROWS; i++)
+                sum += gram[i * FC1_ROWS + col] * w[i * FC1_COLS + j];
+            lowrank->v[k * FC1_COLS + j] = (float)sum;
+        }
+    }
+
+    // ||W||_F^2 is the sum of the eigenvalues of W W^T, the discarded ones give the error
+    for (i = 0; i < FC1_ROWS; i++) {
+        double lambda = d[i] > 0.0 ? d[i] : 0.0;
+
+        total += lambda;
+        if (i >= FC1_ROWS - rank)
+            kept += lambda;
+    }
+    free(gram);
+    return total > 0.0 ? (float)sqrt((total - kept > 0.0 ? total - kept : 0.0) / total) : 0.0f;
+}
+
+void Fc1LowRankFree(fc1_lowrank_t *lowrank)
+{
+    free(lowrank->u);
+    free(lowrank->v);
+    lowrank->u = NULL;
+    lowrank->v = NULL;
+    lowrank->rank = 0;
+}
@@ -0,0 +1,203 @@
+/**
+ * @file xnor.c
+ * @brief Binarized Conv2 and FC1: 1-bit weights and activations, XOR and popcount instead of MACs
+ *
+ * A row of weights (one Conv2 filter, one FC1 neuron) becomes the signs s of
+ * its weights times alpha = mean |w|, the least-squares scale of a sign
+ * vector. The input of the layer is cut at its mean t into two levels, lo
+ * and hi, the means of the inputs below and above t, so x ~ c + h a with
+ * c = (lo + hi) / 2, h = (hi - lo) / 2 and a = +-1. Then
+ *
+ *   w . x ~ alpha (c S + h (n - 2 popcount(s ^ a)))
+ *
+ * S being the sum of the signs of the row, known at load time. One bit is
+ * set for a positive weight and for an input above t, packed 64 per word.
+ * FC1 rows keep the [c][y][x] order of the input. A Conv2 filter is stored
+ * tap by tap, the 20 channels of a tap on 20 consecutive bits and 3 taps per
+ * word, so that a patch is assembled from the 20-bit channel masks of its 25
+ * input pixels. No retraining: the weights are binarized as they are.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../COMMON/alloc.h"
+#include "lenet_cnn_float.h"
+
+#define CONV2_TAP_BITS POOL1_NBOUTPUT
+#define CONV2_COLS     (POOL1_NBOUTPUT * CONV2_DIM * CONV2_DIM)
+#define FC1_COLS       (POOL2_NBOUTPUT * POOL2_HEIGHT * POOL2_WIDTH)
+
+static void XnorAllocate(int rows, int cols, int words, xnor_t *x)
+{
+    x->rows = rows;
+    x->cols = cols;
+    x->words = words;
+    x->sign = AllocateZeroed((size_t)rows * words * sizeof(unsigned long long));
+    x->sum = AllocateZeroed(rows * sizeof(int));
+    x->alpha = AllocateZeroed(rows * sizeof(float));
+}
+
+/// @brief Scale and sign sum of row r, its sign bits being already set
+static void XnorRow(const float *w, int r, xnor_t *x)
+{
+    double sum = 0.0;
+    int i, positives = 0;
+
+    for (i = 0; i < x->cols; i++) {
+        sum += w[i] < 0.0f ? -w[i] : w[i];
+        positives += w[i] > 0.0f;
+    }
+    x->alpha[r] = (float)(sum / x->cols);
+    x->sum[r] = 2 * positives - x->cols;
+}
+
+/// @brief Binarize the Conv2 filters, tap-major bit order (see the file header)
+void XnorConv2(const float kernel[CONV2_NBOUTPUT][POOL1_NBOUTPUT][CONV2_DIM][CONV2_DIM], xnor_t *x)
+{
+    int f, c, t, bit;
+
+    XnorAllocate(CONV2_NBOUTPUT, CONV2_COLS, XNOR_CONV2_WORDS, x);
+    for (f = 0; f < CONV2_NBOUTPUT; f++) {
+        for (c = 0; c < POOL1_NBOUTPUT; c++)
+            for (t = 0; t < CONV2_DIM * CONV2_DIM; t++)
+                if (kernel[f][c][t / CONV2_DIM][t % CONV2_DIM] > 0.0f) {
+                    bit = (t % XNOR_CONV2_TAPS_PER_WORD) * CONV2_TAP_BITS + c;
+                    x->sign[f * x->words + t / XNOR_CONV2_TAPS_PER_WORD] |= 1ULL << bit;
+                }
+        XnorRow(&kernel[f][0][0][0], f, x);
+    }
+}
+
+/// @brief Binarize the FC1 rows, input order
+void XnorFc1(const float kernel[FC1_NBOUTPUT][POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH], xnor_t *x)
+{
+    const float *w;
+    int n, i;
+
+    XnorAllocate(FC1_NBOUTPUT, FC1_COLS, XNOR_FC1_WORDS, x);
+    for (n = 0; n < FC1_NBOUTPUT; n++) {
+        w = &kernel[n][0][0][0];
+        for (i = 0; i < FC1_COLS; i++)
+            if (w[i] > 0.0f)
+                x->sign[n * x->words + i / 64] |= 1ULL << (i % 64);
+        XnorRow(w, n, x);
+    }
+}
+
+/// @brief Storage of the sign bits and of the per-row scales and sign sums in bytes
+long XnorBytes(const xnor_t *x)
+{
+    return (long)x->rows * (x->words * sizeof(unsigned long long) + sizeof(int) + sizeof(float));
+}
+
+void XnorFree(xnor_t *x)
+{
+    free(x->sign);
+    free(x->sum);
+    free(x->alpha);
+    x->sign = NULL;
+    x->sum = NULL;
+    x->alpha = NULL;
+    x->rows = 0;
+}
+
+/// @brief Threshold t = mean of the input, and the center c and half gap h of its two levels
+static float InputLevels(const float *input, int size, float *center, float *half)
+{
+    float t, sum = 0.0f, lo = 0.0f, hi = 0.0f;
+    int i, above = 0;
+
+    for (i = 0; i < size; i++)
+        sum += input[i];
+    t = sum / size;
+    for (i = 0; i < size; i++) {
+        if (input[i] > t) {
+            hi += input[i];
+            above++;
+        } else {
+            lo += input[i];
+        }
+    }
+    lo = above < size ? lo / (size - above) : 0.0f;
+    hi = above ? hi / above : lo;
+    *center = 0.5f * (lo + hi);
+    *half = 0.5f * (hi - lo);
+    return t;
+}
+
+/// @brief Conv2 on 1-bit weights and activations: one XOR and popcount per 64 MACs
+/// @param input  Input feature maps, binarized at their mean
+/// @param kernel Binarized filters (XnorConv2)
+/// @param bias   Bias terms, kept in float
+/// @param output Output feature maps, ReLU applied
+void Conv2_12x12x20_5x5x40_1_0_xnor(float input[POOL1_NBOUTPUT][POOL1_HEIGHT][POOL1_WIDTH],
+                                    const xnor_t *kernel,
+                                    float bias[CONV2_NBOUTPUT],
+                                    float output[CONV2_NBOUTPUT][CONV2_HEIGHT][CONV2_WIDTH])
+{
+    unsigned int pixel[POOL1_HEIGHT][POOL1_WIDTH];      // channel mask of each input pixel
+    unsigned long long patch[XNOR_CONV2_WORDS];
+    const unsigned long long *sign;
+    float t, center, half, acc;
+    int f, c, y, x, ky, kx, k, w, differ;
+
+    t = InputLevels(&input[0][0][0], POOL1_NBOUTPUT * POOL1_HEIGHT * POOL1_WIDTH, &center, &half);
+    memset(pixel, 0, sizeof(pixel));
+    for (c = 0; c < POOL1_NBOUTPUT; c++)
+        for (y = 0; y < POOL1_HEIGHT; y++)
+            for (x = 0; x < POOL1_WIDTH; x++)
+                pixel[y][x] |= (unsigned int)(input[c][y][x] > t) << c;
+
+    for (y = 0; y < CONV2_HEIGHT; y++) {
+        for (x = 0; x < CONV2_WIDTH; x++) {
+            memset(patch, 0, sizeof(patch));
+            for (ky = 0; ky < CONV2_DIM; ky++)
+                for (kx = 0; kx < CONV2_DIM; kx++) {
+                    k = ky * CONV2_DIM + kx;
+                    patch[k / XNOR_CONV2_TAPS_PER_WORD] |= (unsigned long long)pixel[y + ky][x + kx]
+                                                           << (k % XNOR_CONV2_TAPS_PER_WORD * CONV2_TAP_BITS);
+                }
+
+            // The patch stays in registers for the 40 filters
+            for (f = 0; f < CONV2_NBOUTPUT; f++) {
+                sign = kernel->sign + f * XNOR_CONV2_WORDS;
+                differ = 0;
+                for (w = 0; w < XNOR_CONV2_WORDS; w++)
+                    differ += __builtin_popcountll(patch[w] ^ sign[w]);
+                acc = bias[f] + kernel->alpha[f] * (center * kernel->sum[f] + half * (CONV2_COLS - 2 * differ));
+                output[f][y][x] = acc > 0.0f ? acc : 0.0f;
+            }
+        }
+    }
+}
+
+/// @brief FC1 on 1-bit weights and activations: 10 XORs and popcounts per neuron instead of 640 MACs
+/// @param input  Layer input from Pool2, binarized at its mean
+/// @param kernel Binarized rows (XnorFc1)
+/// @param bias   Bias terms, kept in float
+/// @param output Layer output, ReLU applied
+void Fc1_40_400_xnor(const float input[POOL2_NBOUTPUT][POOL2_HEIGHT][POOL2_WIDTH],
+                     const xnor_t *kernel,
+                     const float bias[FC1_NBOUTPUT],
+                     float output[FC1_NBOUTPUT])
+{
+    const float *in = &input[0][0][0];
+    unsigned long long bits[XNOR_FC1_WORDS] = { 0 };
+    const unsigned long long *sign;
+    float t, center, half, acc;
+    int n, i, w, differ;
+
+    t = InputLevels(in, FC1_COLS, &center, &half);
+    for (i = 0; i < FC1_COLS; i++)
+        bits[i / 64] |= (unsigned long long)(in[i] > t) << (i % 64);
+
+    for (n = 0; n < FC1_NBOUTPUT; n++) {
+        sign = kernel->sign + n * XNOR_FC1_WORDS;
+        differ = 0;
+        for (w = 0; w < XNOR_FC1_WORDS; w++)
+            differ += __builtin_popcountll(bits[w] ^ sign[w]);
+        acc = bias[n] + kernel->alpha[n] * (center * kernel->sum[n] + half * (FC1_COLS - 2 * differ));
+        output[n] = acc > 0.0f ? acc : 0.0f;
+    }
+}